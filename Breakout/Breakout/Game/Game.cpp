@@ -1,5 +1,6 @@
 #include "Main.h"
 #include "Helpers.h"
+#include "ParticlePool.h"
 
 // Define variables which determine how big the window will be
 int SCREEN_WIDTH = 800;
@@ -41,6 +42,9 @@ bool brickAlive[MAX_BRICKS];	// Whether the bricks exist
 float brickX[MAX_BRICKS];		// x position of bricks
 float brickY[MAX_BRICKS];		// y position of bricks
 
+// Bits of brick which fly out when a brick is destroyed
+ParticlePool particles(131072);
+
 void ResetBricks()
 {
 	// Calculate offsets for the grid of bricks
@@ -227,6 +231,11 @@ void GameLoop(float elapsedSeconds)
 				brickAlive[i] = false;
 				score++;
 
+				// Break the brick into particles, with some sparks where the ball hit
+				particles.Emit(brickX[i], brickY[i], BRICK_WIDTH, BRICK_HEIGHT, 80, 150, 1.0f, sf::Color::Red);
+				particles.Emit(brickX[i], brickY[i], BRICK_WIDTH, BRICK_HEIGHT, 20, 150, 1.0f, sf::Color::Cyan);
+				particles.Emit(ballX, ballY, 0, 0, 20, 300, 0.4f, sf::Color::Yellow);
+
 				// We know the ball is inside the brick
 				// Work out which side the ball 'penetrates' the least, and treat that as the side which was hit
 
@@ -295,6 +304,10 @@ void GameLoop(float elapsedSeconds)
 		}
 	}
 
+	// Move the particles, and draw them on top of the bricks
+	particles.Update(elapsedSeconds);
+	particles.Draw();
+
 	// Draw lives and score text
 	std::string scoreText = "Lives: " + std::to_string(currLives) + "   Score: " + std::to_string(score);
 	DrawString(scoreText, 8, (float)SCREEN_HEIGHT - 24, 16, sf::Color::Cyan);
@@ -0,0 +1,540 @@
+#include <SFML\System\Clock.hpp>
+#include <algorithm>
+#include <cmath>
+#include <condition_variable>
+#include <cstdio>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include "Helpers.h"
+#include "Game.h"
+#include "World.h"
+#include "Snapshot.h"
+#include "Replay.h"
+#include "Capture.h"
+
+/////////////////////////////////////////////////////////////////////////////
+// DRAWING ON THE CPU
+
+// The built in font, for the score and "Game Over!". Each character is 7 rows of 5 pixels, one row
+// per number, where the lowest 5 bits are the pixels from left to right.
+struct TinyGlyph
+{
+	char character;
+	unsigned char rows[7];
+};
+
+const TinyGlyph tinyFont[] =
+{
+	{ '0', { 0x0E, 0x11, 0x13, 0x15, 0x19, 0x11, 0x0E } },
+	{ '1', { 0x04, 0x0C, 0x04, 0x04, 0x04, 0x04, 0x0E } },
+	{ '2', { 0x0E, 0x11, 0x01, 0x02, 0x04, 0x08, 0x1F } },
+	{ '3', { 0x1F, 0x02, 0x04, 0x02, 0x01, 0x11, 0x0E } },
+	{ '4', { 0x02, 0x06, 0x0A, 0x12, 0x1F, 0x02, 0x02 } },
+	{ '5', { 0x1F, 0x10, 0x1E, 0x01, 0x01, 0x11, 0x0E } },
+	{ '6', { 0x06, 0x08, 0x10, 0x1E, 0x11, 0x11, 0x0E } },
+	{ '7', { 0x1F, 0x01, 0x02, 0x04, 0x08, 0x08, 0x08 } },
+	{ '8', { 0x0E, 0x11, 0x11, 0x0E, 0x11, 0x11, 0x0E } },
+	{ '9', { 0x0E, 0x11, 0x11, 0x0F, 0x01, 0x02, 0x0C } },
+	{ ':', { 0x00, 0x0C, 0x0C, 0x00, 0x0C, 0x0C, 0x00 } },
+	{ '!', { 0x04, 0x04, 0x04, 0x04, 0x04, 0x00, 0x04 } },
+	{ 'G', { 0x0E, 0x11, 0x10, 0x17, 0x11, 0x11, 0x0F } },
+	{ 'L', { 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x1F } },
+	{ 'O', { 0x0E, 0x11, 0x11, 0x11, 0x11, 0x11, 0x0E } },
+	{ 'P', { 0x1E, 0x11, 0x11, 0x1E, 0x10, 0x10, 0x10 } },
+	{ 'S', { 0x0F, 0x10, 0x10, 0x0E, 0x01, 0x01, 0x1E } },
+	{ 'a', { 0x00, 0x00, 0x0E, 0x01, 0x0F, 0x11, 0x0F } },
+	{ 'c', { 0x00, 0x00, 0x0E, 0x10, 0x10, 0x11, 0x0E } },
+	{ 'e', { 0x00, 0x00, 0x0E, 0x11, 0x1F, 0x10, 0x0E } },
+	{ 'g', { 0x00, 0x0F, 0x11, 0x11, 0x0F, 0x01, 0x0E } },
+	{ 'i', { 0x04, 0x00, 0x0C, 0x04, 0x04, 0x04, 0x0E } },
+	{ 'l', { 0x0C, 0x04, 0x04, 0x04, 0x04, 0x04, 0x0E } },
+	{ 'm', { 0x00, 0x00, 0x1A, 0x15, 0x15, 0x11, 0x11 } },
+	{ 'n', { 0x00, 0x00, 0x16, 0x19, 0x11, 0x11, 0x11 } },
+	{ 'o', { 0x00, 0x00, 0x0E, 0x11, 0x11, 0x11, 0x0E } },
+	{ 'p', { 0x00, 0x00, 0x1E, 0x11, 0x1E, 0x10, 0x10 } },
+	{ 'r', { 0x00, 0x00, 0x16, 0x19, 0x10, 0x10, 0x10 } },
+	{ 's', { 0x00, 0x00, 0x0E, 0x10, 0x0E, 0x01, 0x1E } },
+	{ 't', { 0x08, 0x08, 0x1C, 0x08, 0x08, 0x09, 0x06 } },
+	{ 'v', { 0x00, 0x00, 0x11, 0x11, 0x11, 0x0A, 0x04 } },
+	{ 'y', { 0x00, 0x00, 0x11, 0x11, 0x0F, 0x01, 0x0E } },
+};
+const int TINY_GLYPH_ADVANCE = 6;	// 5 pixels and a gap
+
+// A picture drawn by the CPU into an array of pixels, with no window or graphics card needed, so
+// lots of frames can be drawn at once on different threads.
+// Shapes cover the pixels whose centres are inside them, the same as the graphics card does.
+class CaptureCanvas
+{
+public:
+	int width = 0;
+	int height = 0;
+	std::vector<sf::Uint8> pixels;	// 4 bytes per pixel: red, green, blue, alpha
+
+	void Clear(int newWidth, int newHeight, sf::Color color)
+	{
+		width = newWidth;
+		height = newHeight;
+		pixels.resize(width * height * 4);
+		for (int i = 0; i < width * height; i++)
+		{
+			pixels[i * 4 + 0] = color.r;
+			pixels[i * 4 + 1] = color.g;
+			pixels[i * 4 + 2] = color.b;
+			pixels[i * 4 + 3] = color.a;
+		}
+	}
+
+	void FillRect(float left, float top, float rectWidth, float rectHeight, sf::Color color)
+	{
+		int x1 = std::max((int)std::ceil(left - 0.5f), 0);
+		int x2 = std::min((int)std::ceil(left + rectWidth - 0.5f), width);
+		int y1 = std::max((int)std::ceil(top - 0.5f), 0);
+		int y2 = std::min((int)std::ceil(top + rectHeight - 0.5f), height);
+		for (int y = y1; y < y2; y++)
+		{
+			for (int x = x1; x < x2; x++)
+			{
+				BlendPixel(x, y, color);
+			}
+		}
+	}
+
+	void FillCircle(float centerX, float centerY, float radius, sf::Color color)
+	{
+		int y1 = std::max((int)std::floor(centerY - radius), 0);
+		int y2 = std::min((int)std::ceil(centerY + radius), height);
+		int x1 = std::max((int)std::floor(centerX - radius), 0);
+		int x2 = std::min((int)std::ceil(centerX + radius), width);
+		for (int y = y1; y < y2; y++)
+		{
+			for (int x = x1; x < x2; x++)
+			{
+				float dx = x + 0.5f - centerX;
+				float dy = y + 0.5f - centerY;
+				if (dx * dx + dy * dy <= radius * radius)
+				{
+					BlendPixel(x, y, color);
+				}
+			}
+		}
+	}
+
+	// Same position and size as DrawString, near enough. The font's pixels are made
+	// bigger by a whole number, so they stay sharp.
+	void DrawText(const std::string& text, float x, float y, int textHeight, sf::Color color)
+	{
+		int scale = std::max(textHeight / 8, 1);
+		float top = y + textHeight / 4;
+		for (char character : text)
+		{
+			for (const TinyGlyph& glyph : tinyFont)
+			{
+				if (glyph.character != character)
+				{
+					continue;
+				}
+				for (int row = 0; row < 7; row++)
+				{
+					for (int column = 0; column < 5; column++)
+					{
+						if (glyph.rows[row] & (0x10 >> column))
+						{
+							FillRect(x + column * scale, top + row * scale, (float)scale, (float)scale, color);
+						}
+					}
+				}
+				break;
+			}
+			x += TINY_GLYPH_ADVANCE * scale;
+		}
+	}
+
+private:
+	// Mixes color into a pixel by its alpha, the same way the window does
+	void BlendPixel(int x, int y, sf::Color color)
+	{
+		sf::Uint8* pixel = &pixels[(y * width + x) * 4];
+		if (color.a == 255)
+		{
+			pixel[0] = color.r;
+			pixel[1] = color.g;
+			pixel[2] = color.b;
+			pixel[3] = 255;
+			return;
+		}
+		int a = color.a;
+		pixel[0] = (sf::Uint8)((color.r * a + pixel[0] * (255 - a) + 127) / 255);
+		pixel[1] = (sf::Uint8)((color.g * a + pixel[1] * (255 - a) + 127) / 255);
+		pixel[2] = (sf::Uint8)((color.b * a + pixel[2] * (255 - a) + 127) / 255);
+		pixel[3] = (sf::Uint8)(a + (pixel[3] * (255 - a) + 127) / 255);
+	}
+};
+
+// Draws what GameLoop draws, in the same order
+static void DrawWorld(World& world, const std::vector<sf::Vertex>& particleCorners, CaptureCanvas& canvas)
+{
+	canvas.Clear(WORLD_WIDTH, WORLD_HEIGHT, sf::Color::Black);
+
+	// The ball's texture is covered up by the yellow circle, so only the circle is drawn
+	Ball& ball = world.ball;
+	canvas.FillCircle(ToFloat(ball.xPos), ToFloat(ball.yPos), ToFloat(ball.diameter) / 2.0f, sf::Color::Yellow);
+
+	Paddle& paddle = world.paddle;
+	canvas.FillRect(ToFloat(paddle.x), ToFloat(paddle.y), ToFloat(paddle.width), ToFloat(paddle.height), sf::Color::White);
+	if (world.numPlayers == 2)
+	{
+		Paddle& paddle2 = world.paddle2;
+		canvas.FillRect(ToFloat(paddle2.x), ToFloat(paddle2.y), ToFloat(paddle2.width), ToFloat(paddle2.height), sf::Color::Green);
+	}
+
+	for (int i = 0; i < MAX_BRICKS; i++)
+	{
+		Brick& brick = world.bricks[i];
+		if (brick.IsAlive())
+		{
+			float x = ToFloat(brick.GetX());
+			float y = ToFloat(brick.GetY());
+			canvas.FillRect(x, y, ToFloat(BRICK_WIDTH), ToFloat(BRICK_HEIGHT), sf::Color::Cyan);
+			canvas.FillRect(x + 1, y + 1, ToFloat(BRICK_WIDTH) - 2, ToFloat(BRICK_HEIGHT) - 2, sf::Color::Red);
+		}
+	}
+
+	// Each particle is a square, from its first corner to its third
+	for (size_t i = 0; i + 3 < particleCorners.size(); i += 4)
+	{
+		sf::Vector2f topLeft = particleCorners[i].position;
+		sf::Vector2f bottomRight = particleCorners[i + 2].position;
+		canvas.FillRect(topLeft.x, topLeft.y, bottomRight.x - topLeft.x, bottomRight.y - topLeft.y, particleCorners[i].color);
+	}
+
+	std::string scoreText = "Lives: " + std::to_string(world.currLives) + "   Score: " + std::to_string(world.score);
+	canvas.DrawText(scoreText, 8, (float)WORLD_HEIGHT - 24, 16, sf::Color::Cyan);
+
+	if (!world.IsPlayerAlive())
+	{
+		canvas.DrawText("Game Over!", WORLD_WIDTH / 2 - 150.0f, (float)WORLD_HEIGHT / 2, 50, sf::Color::Red);
+		canvas.DrawText("Press P to play again", (WORLD_WIDTH / 2.0f) - 100.0f, (float)WORLD_HEIGHT / 2 + 100, 20, sf::Color::Red);
+	}
+}
+
+/////////////////////////////////////////////////////////////////////////////
+// THE CAPTURE PIPELINE
+
+// One frame on its way through: played, then drawn, then saved
+struct CaptureFrame
+{
+	int number = 0;
+	WorldSnapshot world;
+	std::vector<sf::Vertex> particleCorners;
+	CaptureCanvas canvas;
+};
+
+// The frames waiting at each stage, and the ones free to be used again.
+// Everything is only touched with the mutex locked, and 'changed' wakes up whoever is waiting.
+struct CaptureQueue
+{
+	std::mutex mutex;
+	std::condition_variable changed;
+	std::vector<CaptureFrame*> freeFrames;
+	std::deque<CaptureFrame*> toDraw;
+	std::deque<CaptureFrame*> drawn;
+	int nextToWrite = 0;		// For a raw file, which has to be written in order
+	bool allPlayed = false;
+	int drawThreadsRunning = 0;
+	std::string error;			// The first thing which went wrong
+};
+
+struct CaptureTimes
+{
+	double playSeconds = 0;		// Not counting waiting for free frames
+	double drawSeconds = 0;		// Added up over every thread
+	double saveSeconds = 0;
+	int numFrames = 0;
+};
+
+static bool CaptureReplay(const ReplayHeader& header, const std::vector<ReplayFrame>& replay, const std::string& output,
+	int framesPerSecond, int numThreads, CaptureTimes& times, std::string& error)
+{
+	if (framesPerSecond <= 0)
+	{
+		error = "Nothing to capture";
+		return false;
+	}
+
+	bool raw = output.find('%') == std::string::npos;
+	FILE* rawFile = NULL;
+	if (raw)
+	{
+		rawFile = fopen(output.c_str(), "wb");
+		if (rawFile == NULL)
+		{
+			error = "Can't write " + output;
+			return false;
+		}
+	}
+
+	if (numThreads <= 0)
+	{
+		numThreads = std::max((int)std::thread::hardware_concurrency(), 1);
+	}
+
+	// Squashing PNGs is slower than drawing, so gets as many threads again. A raw file is written
+	// by one thread, in order.
+	int numDrawThreads = numThreads;
+	int numSaveThreads = raw ? 1 : numThreads;
+
+	// Enough frames for every thread to have one, and a few waiting. The game is played in order,
+	// so the frame a raw file is waiting for is always one of these, and never stuck behind them.
+	std::vector<CaptureFrame> frames(numDrawThreads + numSaveThreads + 4);
+	CaptureQueue queue;
+	for (CaptureFrame& frame : frames)
+	{
+		queue.freeFrames.push_back(&frame);
+	}
+	queue.drawThreadsRunning = numDrawThreads;
+
+	std::vector<std::thread> drawThreads;
+	for (int i = 0; i < numDrawThreads; i++)
+	{
+		drawThreads.push_back(std::thread([&]()
+		{
+			// Each thread draws from its own World, which only needs the snapshot loaded into it
+			World world;
+			world.Init(false, 1);
+			while (true)
+			{
+				CaptureFrame* frame;
+				{
+					std::unique_lock<std::mutex> lock(queue.mutex);
+					queue.changed.wait(lock, [&]() { return !queue.toDraw.empty() || queue.allPlayed; });
+					if (queue.toDraw.empty())
+					{
+						queue.drawThreadsRunning--;
+						queue.changed.notify_all();
+						return;
+					}
+					frame = queue.toDraw.front();
+					queue.toDraw.pop_front();
+				}
+
+				sf::Clock clock;
+				LoadSnapshot(world, frame->world);
+				DrawWorld(world, frame->particleCorners, frame->canvas);
+				float frameSeconds = clock.getElapsedTime().asSeconds();
+
+				std::lock_guard<std::mutex> lock(queue.mutex);
+				times.drawSeconds += frameSeconds;
+				queue.drawn.push_back(frame);
+				queue.changed.notify_all();
+			}
+		}));
+	}
+
+	std::vector<std::thread> saveThreads;
+	for (int i = 0; i < numSaveThreads; i++)
+	{
+		saveThreads.push_back(std::thread([&]()
+		{
+			while (true)
+			{
+				CaptureFrame* frame = NULL;
+				{
+					std::unique_lock<std::mutex> lock(queue.mutex);
+					auto nextReady = [&]()
+					{
+						for (auto item = queue.drawn.begin(); item != queue.drawn.end(); ++item)
+						{
+							if (!raw || (*item)->number == queue.nextToWrite)
+							{
+								return item;
+							}
+						}
+						return queue.drawn.end();
+					};
+					queue.changed.wait(lock, [&]() { return nextReady() != queue.drawn.end() || (queue.drawThreadsRunning == 0 && queue.drawn.empty()); });
+					if (queue.drawn.empty())
+					{
+						return;
+					}
+					auto item = nextReady();
+					frame = *item;
+					queue.drawn.erase(item);
+				}
+
+				sf::Clock clock;
+				CaptureCanvas& canvas = frame->canvas;
+				bool ok;
+				std::string path;
+				if (raw)
+				{
+					ok = fwrite(canvas.pixels.data(), 1, canvas.pixels.size(), rawFile) == canvas.pixels.size();
+					path = output;
+				}
+				else
+				{
+					char name[1024];
+					snprintf(name, sizeof(name), output.c_str(), frame->number);
+					path = name;
+
+					// sf::Image is only pixels in memory too, so it's fine without a window
+					sf::Image image;
+					image.create(canvas.width, canvas.height, canvas.pixels.data());
+					ok = image.saveToFile(path);
+				}
+				float frameSeconds = clock.getElapsedTime().asSeconds();
+
+				std::lock_guard<std::mutex> lock(queue.mutex);
+				times.saveSeconds += frameSeconds;
+				if (!ok && queue.error.empty())
+				{
+					queue.error = "Couldn't save " + path;
+				}
+				queue.freeFrames.push_back(frame);
+				queue.nextToWrite++;
+				queue.changed.notify_all();
+			}
+		}));
+	}
+
+	// Play the game on this thread. Whenever it gets to the time of the next picture, the game is
+	// copied into a free frame and handed to the drawing threads.
+	StartReplay(header.seed, header.autopilot != 0);
+	double gameSeconds = 0;
+	int numFrames = 0;
+	sf::Clock playClock;
+	for (const ReplayFrame& input : replay)
+	{
+		playClock.restart();
+		StepGame(input);
+		times.playSeconds += playClock.getElapsedTime().asSeconds();
+		gameSeconds += input.elapsedSeconds;
+
+		while (numFrames <= gameSeconds * framesPerSecond)
+		{
+			CaptureFrame* frame;
+			{
+				std::unique_lock<std::mutex> lock(queue.mutex);
+				queue.changed.wait(lock, [&]() { return !queue.freeFrames.empty(); });
+				frame = queue.freeFrames.back();
+				queue.freeFrames.pop_back();
+			}
+
+			playClock.restart();
+			frame->number = numFrames;
+			SaveGameState(frame->world, frame->particleCorners);
+			numFrames++;
+			times.playSeconds += playClock.getElapsedTime().asSeconds();
+
+			std::lock_guard<std::mutex> lock(queue.mutex);
+			queue.toDraw.push_back(frame);
+			queue.changed.notify_all();
+		}
+	}
+	{
+		std::lock_guard<std::mutex> lock(queue.mutex);
+		queue.allPlayed = true;
+		queue.changed.notify_all();
+	}
+
+	for (std::thread& thread : drawThreads)
+	{
+		thread.join();
+	}
+	for (std::thread& thread : saveThreads)
+	{
+		thread.join();
+	}
+	if (rawFile != NULL && fclose(rawFile) != 0 && queue.error.empty())
+	{
+		queue.error = "Couldn't save " + output;
+	}
+
+	times.numFrames = numFrames;
+	error = queue.error;
+	return error.empty();
+}
+
+bool RunReplayCapture(const char* replayPath, const char* output, int framesPerSecond, int numThreads)
+{
+	ReplayHeader header;
+	std::vector<ReplayFrame> replay;
+	std::string error;
+	if (!LoadReplay(replayPath, header, replay, error))
+	{
+		printf("%s\n", error.c_str());
+		return false;
+	}
+
+	sf::Clock clock;
+	CaptureTimes times;
+	if (!CaptureReplay(header, replay, output, framesPerSecond, numThreads, times, error))
+	{
+		printf("%s\n", error.c_str());
+		return false;
+	}
+	float wallSeconds = clock.getElapsedTime().asSeconds();
+	printf("Saved %d frames in %.2f seconds (%.1f frames a second)\n", times.numFrames, wallSeconds, times.numFrames / wallSeconds);
+	return true;
+}
+
+void RunCaptureBenchmark(float seconds)
+{
+	// A replay of the autopilot, at 240 steps a second like the self-play runner
+	const char* replayPath = "capturebench.bin";
+	const int stepsPerSecond = 240;
+	ReplayRecorder recorder;
+	if (!recorder.Start(replayPath, 12345, true))
+	{
+		printf("Couldn't write %s\n", replayPath);
+		return;
+	}
+	ReplayFrame input;
+	input.elapsedSeconds = 1.0f / stepsPerSecond;
+	for (int i = 0; i < (int)(seconds * stepsPerSecond); i++)
+	{
+		recorder.Record(input);
+	}
+	recorder.Stop();
+
+	ReplayHeader header;
+	std::vector<ReplayFrame> replay;
+	std::string error;
+	if (!LoadReplay(replayPath, header, replay, error))
+	{
+		printf("%s\n", error.c_str());
+		return;
+	}
+
+	const int framesPerSecond = 60;
+	int numCores = (int)std::thread::hardware_concurrency();
+	printf("%.0f seconds of autopilot at %d frames a second, %d cores\n", seconds, framesPerSecond, numCores);
+	const char* outputs[] = { "capturebench_%05d.png", "capturebench.rgba" };
+	const int threadCounts[] = { 1, 0 };
+	int numFrames = 0;
+	for (const char* output : outputs)
+	{
+		for (int numThreads : threadCounts)
+		{
+			CaptureTimes times;
+			sf::Clock clock;
+			bool ok = CaptureReplay(header, replay, output, framesPerSecond, numThreads, times, error);
+			float wallSeconds = clock.getElapsedTime().asSeconds();
+			numFrames = times.numFrames;
+			printf("  %-22s %2d threads: %d frames in %.2f s, %.1f frames a second, a minute in %.1f s (playing %.2f s, drawing %.2f s, saving %.2f s)%s\n",
+				output, numThreads == 0 ? std::max(numCores, 1) : numThreads, times.numFrames, wallSeconds, times.numFrames / wallSeconds,
+				wallSeconds * 60 / seconds, times.playSeconds, times.drawSeconds, times.saveSeconds, ok ? "" : (", FAILED: " + error).c_str());
+		}
+	}
+
+	for (int i = 0; i < numFrames; i++)
+	{
+		char path[64];
+		snprintf(path, sizeof(path), outputs[0], i);
+		remove(path);
+	}
+	remove(outputs[1]);
+	remove(replayPath);
+}
@@ -0,0 +1,17 @@
+#pragma once
+
+// Plays a replay (recorded with "Game.exe -record replay.bin") back without a window, and saves it
+// as pictures, framesPerSecond of them for every second of the game.
+//
+// The game itself is played on one thread, as each frame depends on the one before. Drawing doesn't,
+// so each frame's World and particles are copied out and drawn by the CPU on numThreads threads
+// (0 means one per core), while other threads save the finished frames.
+//
+// If output has a %d in it (like "frames/breakout%05d.png") every frame is saved as its own picture.
+// Otherwise the frames are written one after another into a single file of raw pixels, 4 bytes
+// each (red, green, blue, alpha), which ffmpeg can turn into a video:
+//   ffmpeg -f rawvideo -pixel_format rgba -video_size 800x600 -framerate 60 -i out.rgba out.mp4
+bool RunReplayCapture(const char* replayPath, const char* output, int framesPerSecond, int numThreads);
+
+// Records seconds of the autopilot playing, then times capturing it on one thread and on every core
+void RunCaptureBenchmark(float seconds);
@@ -0,0 +1,427 @@
+#include <SFML\System\Clock.hpp>
+#include <cmath>
+#include <cstring>
+#include "Main.h"
+#include "EndlessWorld.h"
+
+// World y of the bottom of the first chunk, before the camera has moved
+const int CHUNK_START_Y = 250;
+
+void EndlessWorld::Init(bool fastBall, unsigned int seed)
+{
+	if (fastBall)
+	{
+		ball.speedX = 600;
+		ball.speedY = 700;
+	}
+	else
+	{
+		ball.speedX = 300;
+		ball.speedY = 350;
+	}
+	this->seed = seed != 0 ? seed : 1;
+
+	// Enough vertices for every brick in every chunk, so BuildVertices never has to allocate.
+	// Each brick is two quads (a cyan border and a red middle) of 4 corners each.
+	vertices.resize(MAX_CHUNKS * CHUNK_BRICKS * 8);
+
+	Restart();
+}
+
+// Goes back to the bottom of the wall, with full lives
+void EndlessWorld::Restart()
+{
+	for (int i = 0; i < MAX_CHUNKS; i++)
+	{
+		chunks[i].index = -1;
+	}
+	originChunk = 0;
+	cameraY = 0;
+	distance = 0;
+	currLives = initialLives;
+	score = 0;
+
+	ResetBallAndPaddlePosition();
+	StreamChunks();
+}
+
+bool EndlessWorld::IsPlayerAlive()
+{
+	return currLives > 0;
+}
+
+void EndlessWorld::ResetBallAndPaddlePosition()
+{
+	paddle.x = WORLD_WIDTH / 2 - paddle.width / 2;
+	paddle.y = cameraY + WORLD_HEIGHT - paddle.screenBottomOffset;
+
+	ball.SetPos(WORLD_WIDTH / 2, paddle.y - ball.diameter / 2);
+	ball.xVel = ball.speedX;
+	ball.yVel = -ball.speedY;
+}
+
+void EndlessWorld::Step(Real elapsedSeconds, int paddleDirection, bool autopilot)
+{
+	bool playerAlive = IsPlayerAlive();
+	brickHitThisStep = false;
+
+	if (playerAlive)
+	{
+		ball.Move(elapsedSeconds);
+
+		// Scroll up. The paddle stays at the bottom of the screen.
+		cameraY -= scrollSpeed * elapsedSeconds;
+		distance += ToFloat(scrollSpeed * elapsedSeconds);
+		paddle.y = cameraY + WORLD_HEIGHT - paddle.screenBottomOffset;
+	}
+
+	// Bounce off the top of the screen, wherever that is now, and the sides
+	if (ball.yPos < cameraY)
+	{
+		ball.yPos = cameraY;
+		ball.yVel = ball.speedY;
+	}
+	if (ball.xPos >= WORLD_WIDTH)
+	{
+		ball.xPos = WORLD_WIDTH;
+		ball.xVel = -ball.speedX;
+	}
+	if (ball.xPos <= 0)
+	{
+		ball.xPos = 0;
+		ball.xVel = ball.speedX;
+	}
+
+	// Off the bottom of the screen loses a life
+	if (ball.yPos > cameraY + WORLD_HEIGHT)
+	{
+		ResetBallAndPaddlePosition();
+		currLives--;
+	}
+
+	// Move the paddle, the same way World does
+	if (playerAlive)
+	{
+		paddle.x += paddleDirection * paddle.speed * elapsedSeconds;
+	}
+	if (autopilot)
+	{
+		paddle.x = ball.xPos - paddle.width / 2;
+	}
+	if (paddle.x < 0)
+	{
+		paddle.x = 0;
+	}
+	if (paddle.x > WORLD_WIDTH - paddle.width)
+	{
+		paddle.x = WORLD_WIDTH - paddle.width;
+	}
+	if (ball.xPos >= paddle.x &&
+		ball.xPos <= paddle.x + paddle.width &&
+		ball.yPos >= paddle.y &&
+		ball.yPos <= paddle.y + paddle.height)
+	{
+		ball.yVel = -ball.speedY;
+	}
+
+	BounceBallOffBrick();
+	ClearRowsReachingPaddle();
+	Recenter();
+	StreamChunks();
+}
+
+int EndlessWorld::ChunkAt(Real y)
+{
+	return originChunk + (int)std::floor((CHUNK_START_Y - ToFloat(y)) / CHUNK_HEIGHT);
+}
+
+Real EndlessWorld::ChunkTop(int index)
+{
+	return Real(CHUNK_START_Y - (index - originChunk + 1) * CHUNK_HEIGHT);
+}
+
+BrickChunk* EndlessWorld::FindChunk(int index)
+{
+	// Each chunk can only go in one slot, so there's no searching
+	if (index < 0)
+	{
+		return NULL;
+	}
+	BrickChunk& chunk = chunks[index % MAX_CHUNKS];
+	return chunk.index == index ? &chunk : NULL;
+}
+
+// Returns a random number between 0 and 1, and moves the state on
+static float NextRandom(unsigned int& state)
+{
+	state = state * 1664525u + 1013904223u;
+	return (state >> 8) / 16777216.0f;
+}
+
+void EndlessWorld::MakeChunk(int index)
+{
+	BrickChunk& chunk = chunks[index % MAX_CHUNKS];
+	if (chunk.index >= 0)
+	{
+		chunksEvicted++;
+	}
+	chunk.index = index;
+	chunk.aliveCount = 0;
+	memset(chunk.aliveBits, 0, sizeof(chunk.aliveBits));
+	chunksMade++;
+
+	// The random numbers only depend on the seed and the chunk number, so a chunk is the same
+	// every time it's made, whatever order chunks are made in
+	unsigned int randomState = (seed * 0x9E3779B9u) ^ ((unsigned int)index * 0x85EBCA6Bu);
+	NextRandom(randomState);
+
+	// The wall gets thicker the higher you go
+	float chance = 0.3f + index * 0.02f;
+	if (chance > 0.85f)
+	{
+		chance = 0.85f;
+	}
+
+	// Make the left half, and mirror it onto the right half so the pattern looks designed.
+	// The bottom row of each chunk is left empty, to give the ball a way in.
+	for (int row = 0; row < CHUNK_ROWS - 1; row++)
+	{
+		for (int column = 0; column < CHUNK_COLUMNS / 2; column++)
+		{
+			if (NextRandom(randomState) < chance)
+			{
+				int left = row * CHUNK_COLUMNS + column;
+				int right = row * CHUNK_COLUMNS + (CHUNK_COLUMNS - 1 - column);
+				chunk.aliveBits[left / 32] |= 1u << (left % 32);
+				chunk.aliveBits[right / 32] |= 1u << (right % 32);
+				chunk.aliveCount += 2;
+			}
+		}
+	}
+}
+
+void EndlessWorld::StreamChunks()
+{
+	// Throw away chunks which have scrolled off the bottom of the screen
+	int bottomChunk = ChunkAt(cameraY + WORLD_HEIGHT);
+	for (int i = 0; i < MAX_CHUNKS; i++)
+	{
+		if (chunks[i].index >= 0 && chunks[i].index < bottomChunk)
+		{
+			chunks[i].index = -1;
+			chunksEvicted++;
+		}
+	}
+
+	// Make any chunks which are missing, from the bottom of the screen to a little above the top.
+	// Chunks below 0 are the empty space the game starts in.
+	int topChunk = ChunkAt(cameraY) + CHUNKS_AHEAD;
+	for (int index = bottomChunk > 0 ? bottomChunk : 0; index <= topChunk; index++)
+	{
+		if (FindChunk(index) == NULL)
+		{
+			MakeChunk(index);
+		}
+	}
+}
+
+void EndlessWorld::Recenter()
+{
+	if (cameraY <= -CHUNK_HEIGHT)
+	{
+		cameraY += CHUNK_HEIGHT;
+		ball.yPos += CHUNK_HEIGHT;
+		paddle.y += CHUNK_HEIGHT;
+		brickHitY += CHUNK_HEIGHT;
+		originChunk++;
+	}
+}
+
+void EndlessWorld::BounceBallOffBrick()
+{
+	// Work out which brick the ball is over, instead of testing every brick
+	int index = ChunkAt(ball.yPos);
+	BrickChunk* chunk = FindChunk(index);
+	if (chunk == NULL)
+	{
+		return;
+	}
+	Real chunkTop = ChunkTop(index);
+	int row = (int)std::floor(ToFloat(ball.yPos - chunkTop) / ToFloat(BRICK_HEIGHT));
+	int column = (int)std::floor(ToFloat(ball.xPos) / ToFloat(BRICK_WIDTH));
+	if (row < 0 || row >= CHUNK_ROWS || column < 0 || column >= CHUNK_COLUMNS)
+	{
+		return;
+	}
+	int brickIndex = row * CHUNK_COLUMNS + column;
+	unsigned int bit = 1u << (brickIndex % 32);
+	if ((chunk->aliveBits[brickIndex / 32] & bit) == 0)
+	{
+		return;
+	}
+
+	// Use a Brick for the test, so the ball bounces exactly like it does in World
+	Brick brick;
+	brick.Init(column * BRICK_WIDTH, chunkTop + row * BRICK_HEIGHT, true);
+	int hitSide = brick.GetCollisionSide(ball.xPos, ball.yPos);
+	if (hitSide < 0)
+	{
+		return;
+	}
+
+	chunk->aliveBits[brickIndex / 32] &= ~bit;
+	chunk->aliveCount--;
+	score++;
+	brickHitThisStep = true;
+	brickHitX = brick.GetX();
+	brickHitY = brick.GetY();
+
+	switch (hitSide)
+	{
+	case 0:		// Top
+		ball.yVel = -ball.speedY;
+		break;
+	case 1:		// Bottom
+		ball.yVel = ball.speedY;
+		break;
+	case 2:		// Left
+		ball.xVel = -ball.speedX;
+		break;
+	case 3:		// Right
+		ball.xVel = ball.speedX;
+		break;
+	}
+}
+
+// Bricks which scroll down to the paddle crumble away, so they can't trap it
+void EndlessWorld::ClearRowsReachingPaddle()
+{
+	int index = ChunkAt(paddle.y);
+	BrickChunk* chunk = FindChunk(index);
+	if (chunk == NULL || chunk->aliveCount == 0)
+	{
+		return;
+	}
+	int row = (int)std::floor(ToFloat(paddle.y - ChunkTop(index)) / ToFloat(BRICK_HEIGHT));
+	if (row < 0 || row >= CHUNK_ROWS)
+	{
+		return;
+	}
+	for (int column = 0; column < CHUNK_COLUMNS; column++)
+	{
+		int brickIndex = row * CHUNK_COLUMNS + column;
+		unsigned int bit = 1u << (brickIndex % 32);
+		if (chunk->aliveBits[brickIndex / 32] & bit)
+		{
+			chunk->aliveBits[brickIndex / 32] &= ~bit;
+			chunk->aliveCount--;
+		}
+	}
+}
+
+// Sets the 4 corners of a rectangle
+static void SetQuad(sf::Vertex* corners, float x, float y, float width, float height, sf::Color color)
+{
+	corners[0].position = sf::Vector2f(x, y);
+	corners[1].position = sf::Vector2f(x + width, y);
+	corners[2].position = sf::Vector2f(x + width, y + height);
+	corners[3].position = sf::Vector2f(x, y + height);
+	corners[0].color = color;
+	corners[1].color = color;
+	corners[2].color = color;
+	corners[3].color = color;
+}
+
+void EndlessWorld::BuildVertices()
+{
+	float brickWidth = ToFloat(BRICK_WIDTH);
+	float brickHeight = ToFloat(BRICK_HEIGHT);
+
+	// Only the chunks on the screen
+	vertexCount = 0;
+	int bottomChunk = ChunkAt(cameraY + WORLD_HEIGHT);
+	int topChunk = ChunkAt(cameraY);
+	for (int index = bottomChunk; index <= topChunk; index++)
+	{
+		BrickChunk* chunk = FindChunk(index);
+		if (chunk == NULL || chunk->aliveCount == 0)
+		{
+			continue;
+		}
+
+		float chunkTop = ToFloat(ChunkTop(index) - cameraY);
+		for (int brickIndex = 0; brickIndex < CHUNK_BRICKS; brickIndex++)
+		{
+			if (chunk->aliveBits[brickIndex / 32] & (1u << (brickIndex % 32)))
+			{
+				float x = (brickIndex % CHUNK_COLUMNS) * brickWidth;
+				float y = chunkTop + (brickIndex / CHUNK_COLUMNS) * brickHeight;
+				SetQuad(&vertices[vertexCount], x, y, brickWidth, brickHeight, sf::Color::Cyan);
+				SetQuad(&vertices[vertexCount + 4], x + 1, y + 1, brickWidth - 2, brickHeight - 2, sf::Color::Red);
+				vertexCount += 8;
+			}
+		}
+	}
+}
+
+void EndlessWorld::Draw()
+{
+	if (vertexCount > 0)
+	{
+		window->draw(&vertices[0], vertexCount, sf::Quads);
+	}
+}
+
+int EndlessWorld::GetChunkCount()
+{
+	int count = 0;
+	for (int i = 0; i < MAX_CHUNKS; i++)
+	{
+		if (chunks[i].index >= 0)
+		{
+			count++;
+		}
+	}
+	return count;
+}
+
+int EndlessWorld::GetDrawnBrickCount()
+{
+	return vertexCount / 8;
+}
+
+int EndlessWorld::GetMemoryBytes()
+{
+	return (int)(sizeof(chunks) + vertices.capacity() * sizeof(sf::Vertex));
+}
+
+void RunEndlessBenchmark(float minutes)
+{
+	EndlessWorld world;
+	world.Init(false, 12345);
+	world.scrollSpeed = 200;	// 10 times faster than normal, to get a long way up
+	const float elapsedSeconds = 1.0f / 60.0f;
+	const int framesPerMinute = 60 * 60;
+
+	printf("%8s %10s %12s %6s %8s %8s %12s %8s\n",
+		"Minutes", "Height", "Chunks made", "Kept", "Bytes", "Drawn", "ms per frame", "Score");
+
+	for (int minute = 1; minute <= (int)minutes; minute++)
+	{
+		sf::Clock clock;
+		for (int frame = 0; frame < framesPerMinute; frame++)
+		{
+			// The autopilot can't always keep up. Don't let the game end.
+			if (!world.IsPlayerAlive())
+			{
+				world.currLives = initialLives;
+			}
+			world.Step(elapsedSeconds, 0, true);
+			world.BuildVertices();
+		}
+		float seconds = clock.getElapsedTime().asSeconds();
+
+		printf("%8d %10.0f %12d %6d %8d %8d %12.4f %8d\n", minute, world.distance, world.chunksMade,
+			world.GetChunkCount(), world.GetMemoryBytes(), world.GetDrawnBrickCount(), seconds * 1000 / framesPerMinute, world.score);
+	}
+}
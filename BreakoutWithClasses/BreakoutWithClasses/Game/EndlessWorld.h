@@ -0,0 +1,97 @@
+#pragma once
+#include <vector>
+#include <SFML\Graphics.hpp>
+#include "World.h"
+
+// An endless Breakout, where the screen slowly scrolls up through a brick wall that never ends.
+//
+// The wall is split into 'chunks' of a few rows each. A chunk is made from the seed and its
+// number, so it comes out the same whenever it's made, and only the chunks near the screen are
+// kept. There is a fixed number of chunk slots: new chunks are made ('streamed in') just above
+// the top of the screen, and chunks which have scrolled off the bottom are thrown away
+// ('evicted'), so the memory used never grows however far the player gets.
+//
+// The ball only ever tests the one brick it's over, and only the chunks on the screen are drawn,
+// so each frame takes about the same time too.
+
+const int CHUNK_COLUMNS = 20;			// 20 bricks of 40 pixels fill the 800 pixel wide screen
+const int CHUNK_ROWS = 8;
+const int CHUNK_BRICKS = CHUNK_COLUMNS * CHUNK_ROWS;
+const int CHUNK_HEIGHT = CHUNK_ROWS * 20;	// In pixels. Bricks are 20 pixels high.
+const int CHUNKS_AHEAD = 2;				// Chunks made above the top of the screen, before they're needed
+const int MAX_CHUNKS = 8;				// The memory budget: how many chunks can be kept at once
+
+// A screen can show parts of this many chunks, and they all have to fit in the budget
+static_assert(WORLD_HEIGHT / CHUNK_HEIGHT + 2 + CHUNKS_AHEAD <= MAX_CHUNKS, "MAX_CHUNKS is too small");
+
+struct BrickChunk
+{
+	int index = -1;		// Which chunk of the wall this is. -1 means the slot is empty.
+	int aliveCount = 0;
+	unsigned int aliveBits[(CHUNK_BRICKS + 31) / 32];	// One bit per brick, left to right, top to bottom
+};
+
+class EndlessWorld
+{
+public:
+	Ball ball;
+	Paddle paddle;
+	int currLives = initialLives;
+	int score = 0;
+
+	// The wall is 'world' positions, so the camera is moved instead of every brick.
+	// Everything on the screen is drawn at (x, y - cameraY).
+	Real cameraY = 0;		// World y of the top of the screen
+	Real scrollSpeed = 20;	// Pixels per second
+
+	// Set when a brick is destroyed during a Step, with the brick's top left in world positions
+	bool brickHitThisStep = false;
+	Real brickHitX = 0;
+	Real brickHitY = 0;
+
+	// Statistics
+	double distance = 0;	// Pixels scrolled since Init
+	int chunksMade = 0;
+	int chunksEvicted = 0;
+
+	void Init(bool fastBall, unsigned int seed);
+	void Restart();
+	bool IsPlayerAlive();
+
+	// Moves everything forward, like World::Step, and streams chunks in and out
+	void Step(Real elapsedSeconds, int paddleDirection, bool autopilot);
+
+	// Fills in the vertices for the bricks on the screen. Draw draws them.
+	void BuildVertices();
+	void Draw();
+
+	int GetChunkCount();		// Chunks being kept right now
+	int GetDrawnBrickCount();	// Bricks in the vertices made by BuildVertices
+	int GetMemoryBytes();		// Used by the chunks and vertices. Never changes after Init.
+
+private:
+	BrickChunk chunks[MAX_CHUNKS];
+	unsigned int seed = 1;
+
+	// To stop the numbers getting huge (and floats losing accuracy) as the camera climbs,
+	// everything is moved back down by a chunk whenever the camera passes one. originChunk
+	// counts those moves: it's the chunk whose bottom is at y = CHUNK_START_Y.
+	int originChunk = 0;
+
+	std::vector<sf::Vertex> vertices;
+	int vertexCount = 0;
+
+	int ChunkAt(Real y);			// The number of the chunk at world y
+	Real ChunkTop(int index);		// World y of the top of a chunk
+	BrickChunk* FindChunk(int index);	// Returns NULL if the chunk isn't being kept
+	void MakeChunk(int index);
+	void StreamChunks();
+	void Recenter();
+	void ResetBallAndPaddlePosition();
+	void BounceBallOffBrick();
+	void ClearRowsReachingPaddle();
+};
+
+// "Game.exe -endlessbench [minutes]" plays with the autopilot and a fast scroll, and prints how much
+// memory and time each frame takes as the game goes on
+void RunEndlessBenchmark(float minutes);
@@ -0,0 +1,816 @@
+#include <SFML\System\Clock.hpp>
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include "Helpers.h"
+#include "EventPhysics.h"
+
+static const double never = std::numeric_limits<double>::infinity();
+
+static const Paddle eventPaddle = Paddle();
+static const double paddleWidth = ToFloat(eventPaddle.width);
+static const double paddleHeight = ToFloat(eventPaddle.height);
+static const double paddleY = WORLD_HEIGHT - ToFloat(eventPaddle.screenBottomOffset);
+static const double ballRadius = ToFloat(Ball().diameter) / 2;
+static const double brickWidth = ToFloat(BRICK_WIDTH);
+static const double brickHeight = ToFloat(BRICK_HEIGHT);
+static const double bricksLeft = (WORLD_WIDTH / 2) - ((BRICK_COLUMNS / 2) * brickWidth);
+static const double bricksTop = 50;
+static const double bricksRight = bricksLeft + BRICK_COLUMNS * brickWidth;
+static const double bricksBottom = bricksTop + BRICK_ROWS * brickHeight;
+
+/////////////////////////////////////////////////////////////////////////////
+// EVENT WORLD
+
+void EventWorld::Init()
+{
+	for (int i = 0; i < MAX_BRICKS; i++)
+	{
+		brickAlive[i] = true;
+	}
+	bricksAlive = MAX_BRICKS;
+
+	balls.clear();
+	events = std::priority_queue<Event, std::vector<Event>, std::greater<Event>>();
+	now = 0;
+	lastResetTime = -1;
+	paddleX = WORLD_WIDTH / 2 - paddleWidth / 2;
+	paddleTime = 0;
+	paddleVelocity = 0;
+}
+
+void EventWorld::AddBall(float x, float y, float velX, float velY)
+{
+	EventBall ball;
+	ball.x = x;
+	ball.y = y;
+	ball.time = now;
+	ball.velX = velX;
+	ball.velY = velY;
+	ball.spawnX = x;
+	balls.push_back(ball);
+	ScheduleNextEvent((int)balls.size() - 1);
+}
+
+void EventWorld::SetPaddleVelocity(float velocity)
+{
+	if (velocity == paddleVelocity)
+	{
+		return;
+	}
+	paddleX = PaddleXAt(now);
+	paddleTime = now;
+	paddleVelocity = velocity;
+
+	// Balls level with the paddle worked out when it would move into them, and now it won't
+	for (int i = 0; i < (int)balls.size(); i++)
+	{
+		EventBall& ball = balls[i];
+		double y = ball.y + ball.velY * (now - ball.time);
+		if (ball.velY > 0 && y >= paddleY && y <= paddleY + paddleHeight)
+		{
+			MoveBall(ball, now);
+			ScheduleNextEvent(i);
+		}
+	}
+}
+
+void EventWorld::Advance(double time)
+{
+	while (!events.empty() && events.top().time <= time)
+	{
+		Event event = events.top();
+		events.pop();
+		now = event.time;
+		HandleEvent(event);
+	}
+	now = time;
+}
+
+double EventWorld::PaddleXAt(double time)
+{
+	// Moving at a constant speed, but stopping at the sides of the screen
+	double x = paddleX + paddleVelocity * (time - paddleTime);
+	if (x < 0)
+	{
+		x = 0;
+	}
+	if (x > WORLD_WIDTH - paddleWidth)
+	{
+		x = WORLD_WIDTH - paddleWidth;
+	}
+	return x;
+}
+
+void EventWorld::ScheduleNextEvent(int ballIndex)
+{
+	EventBall& ball = balls[ballIndex];
+
+	// Any events already in the queue for this ball are now out of date
+	ball.version++;
+
+	Event event;
+	event.ball = ballIndex;
+	event.version = ball.version;
+	event.brick = -1;
+	event.side = -1;
+	event.type = EVENT_SIDE_WALL;
+	double soonest = never;
+
+	// Sides
+	if (ball.velX > 0)
+	{
+		soonest = (WORLD_WIDTH - ball.x) / ball.velX;
+	}
+	if (ball.velX < 0)
+	{
+		soonest = -ball.x / ball.velX;
+	}
+
+	// Top
+	if (ball.velY < 0 && -ball.y / ball.velY < soonest)
+	{
+		soonest = -ball.y / ball.velY;
+		event.type = EVENT_TOP_WALL;
+	}
+
+	// Paddle, or the bottom if it misses.
+	// Above the paddle, just look again when the ball gets down to it, because by then the paddle may
+	// be going a different way. Level with it, the paddle might still move into the ball from the side.
+	if (ball.velY > 0)
+	{
+		double time = (WORLD_HEIGHT - ball.y) / ball.velY;
+		int type = EVENT_BOTTOM;
+		if (ball.y < paddleY)
+		{
+			time = (paddleY - ball.y) / ball.velY;
+			type = EVENT_PADDLE;
+		}
+		else
+		{
+			double paddleTime = FindPaddleHit(ball);
+			if (paddleTime < never)
+			{
+				time = paddleTime;
+				type = EVENT_PADDLE;
+			}
+		}
+		if (time < soonest)
+		{
+			soonest = time;
+			event.type = type;
+		}
+	}
+
+	// Bricks
+	int brick;
+	int side;
+	double brickTime = FindBrickHit(ball, brick, side);
+	if (brickTime < soonest)
+	{
+		soonest = brickTime;
+		event.type = EVENT_BRICK;
+		event.brick = brick;
+		event.side = side;
+	}
+
+	event.time = ball.time + soonest;
+	ball.nextEventTime = event.time;
+	events.push(event);
+}
+
+// Checks whether the ball will be over the rectangle around all the bricks before 'time'.
+// Balls which won't be don't need to change their plans when the bricks come back.
+bool EventWorld::ReachesBricksBefore(const EventBall& ball, double time)
+{
+	double enterTime = ball.time;
+	double exitTime = time;
+	if (ball.velX != 0)
+	{
+		double time1 = ball.time + (bricksLeft - ball.x) / ball.velX;
+		double time2 = ball.time + (bricksRight - ball.x) / ball.velX;
+		enterTime = std::max(enterTime, std::min(time1, time2));
+		exitTime = std::min(exitTime, std::max(time1, time2));
+	}
+	else if (ball.x < bricksLeft || ball.x > bricksRight)
+	{
+		return false;
+	}
+	if (ball.velY != 0)
+	{
+		double time1 = ball.time + (bricksTop - ball.y) / ball.velY;
+		double time2 = ball.time + (bricksBottom - ball.y) / ball.velY;
+		enterTime = std::max(enterTime, std::min(time1, time2));
+		exitTime = std::min(exitTime, std::max(time1, time2));
+	}
+	else if (ball.y < bricksTop || ball.y > bricksBottom)
+	{
+		return false;
+	}
+	return enterTime < exitTime;
+}
+
+// Follows the ball's path through the grid of bricks, one cell at a time, until it gets inside a live brick.
+// Returns how long until that happens, or 'never'.
+double EventWorld::FindBrickHit(const EventBall& ball, int& brick, int& side)
+{
+	double x = ball.x;
+	double y = ball.y;
+	double velX = ball.velX;
+	double velY = ball.velY;
+
+	// Find when the ball's path is inside the rectangle around all the bricks
+	double enterTime = 0;
+	double exitTime = never;
+	if (velX == 0)
+	{
+		if (x < bricksLeft || x > bricksRight)
+		{
+			return never;
+		}
+	}
+	else
+	{
+		double time1 = (bricksLeft - x) / velX;
+		double time2 = (bricksRight - x) / velX;
+		enterTime = std::max(enterTime, std::min(time1, time2));
+		exitTime = std::min(exitTime, std::max(time1, time2));
+	}
+	if (velY == 0)
+	{
+		if (y < bricksTop || y > bricksBottom)
+		{
+			return never;
+		}
+	}
+	else
+	{
+		double time1 = (bricksTop - y) / velY;
+		double time2 = (bricksBottom - y) / velY;
+		enterTime = std::max(enterTime, std::min(time1, time2));
+		exitTime = std::min(exitTime, std::max(time1, time2));
+	}
+	if (enterTime >= exitTime)
+	{
+		return never;
+	}
+
+	// Which cell the ball is in when it gets there. Look a tiny bit further along the path,
+	// so a ball sitting exactly on the edge between two cells counts as being in the one it's heading into.
+	double lookAhead = enterTime + 1e-9;
+	int column = (int)std::floor((x + velX * lookAhead - bricksLeft) / brickWidth);
+	int row = (int)std::floor((y + velY * lookAhead - bricksTop) / brickHeight);
+	column = std::max(0, std::min(BRICK_COLUMNS - 1, column));
+	row = std::max(0, std::min(BRICK_ROWS - 1, row));
+
+	// Step from cell to cell. Each step crosses whichever edge (side, or top/bottom) the ball reaches first.
+	int stepX = velX > 0 ? 1 : -1;
+	int stepY = velY > 0 ? 1 : -1;
+	double nextX = never;
+	double nextY = never;
+	double deltaX = never;
+	double deltaY = never;
+	if (velX != 0)
+	{
+		nextX = (bricksLeft + (column + (velX > 0 ? 1 : 0)) * brickWidth - x) / velX;
+		deltaX = brickWidth / std::abs(velX);
+	}
+	if (velY != 0)
+	{
+		nextY = (bricksTop + (row + (velY > 0 ? 1 : 0)) * brickHeight - y) / velY;
+		deltaY = brickHeight / std::abs(velY);
+	}
+
+	while (true)
+	{
+		// Each brick is inside its cell, so if the ball hits it, it's while the ball is in this cell
+		if (brickAlive[row * BRICK_COLUMNS + column])
+		{
+			double time = FindBrickBoxHit(ball, column, row, side);
+			if (time < never)
+			{
+				brick = row * BRICK_COLUMNS + column;
+				return time;
+			}
+		}
+
+		if (nextX < nextY)
+		{
+			column += stepX;
+			nextX += deltaX;
+		}
+		else
+		{
+			row += stepY;
+			nextY += deltaY;
+		}
+		if (column < 0 || column >= BRICK_COLUMNS || row < 0 || row >= BRICK_ROWS)
+		{
+			return never;
+		}
+	}
+}
+
+// How long until the ball gets inside the brick in this cell, or 'never'.
+// Like Brick::GetCollisionSide, a brick is only solid between its edges, and a pixel short of the
+// right and bottom ones, so there's a gap between bricks the ball can go along.
+double EventWorld::FindBrickBoxHit(const EventBall& ball, int column, int row, int& side)
+{
+	double left = bricksLeft + column * brickWidth;
+	double right = left + brickWidth - 1;
+	double top = bricksTop + row * brickHeight;
+	double bottom = top + brickHeight - 1;
+
+	// When the ball is between the left and right edges, and between the top and bottom ones.
+	// It's inside the brick when both are true.
+	double enterX = -never;
+	double exitX = never;
+	double enterY = -never;
+	double exitY = never;
+	if (ball.velX != 0)
+	{
+		double time1 = (left - ball.x) / ball.velX;
+		double time2 = (right - ball.x) / ball.velX;
+		enterX = std::min(time1, time2);
+		exitX = std::max(time1, time2);
+	}
+	else if (ball.x <= left || ball.x >= right)
+	{
+		return never;
+	}
+	if (ball.velY != 0)
+	{
+		double time1 = (top - ball.y) / ball.velY;
+		double time2 = (bottom - ball.y) / ball.velY;
+		enterY = std::min(time1, time2);
+		exitY = std::max(time1, time2);
+	}
+	else if (ball.y <= top || ball.y >= bottom)
+	{
+		return never;
+	}
+	double enterTime = std::max(enterX, enterY);
+	double exitTime = std::min(exitX, exitY);
+	if (enterTime >= exitTime || exitTime <= 0)
+	{
+		return never;
+	}
+
+	if (enterTime < 0)
+	{
+		// Already inside, because the bricks came back on top of the ball. World::Step breaks the
+		// brick on its next frame, using the side the ball is nearest, so do the same now.
+		if (!breakBricksBallsAreIn)
+		{
+			return never;
+		}
+		double distances[4] = { ball.y - top, bottom - ball.y, ball.x - left, right - ball.x };
+		side = 0;
+		for (int i = 1; i < 4; i++)
+		{
+			if (distances[i] < distances[side])
+			{
+				side = i;
+			}
+		}
+		return 0;
+	}
+
+	// Whichever edge the ball crossed last is the side it went in through
+	if (enterX > enterY)
+	{
+		side = ball.velX > 0 ? 2 : 3;
+	}
+	else
+	{
+		side = ball.velY > 0 ? 0 : 1;
+	}
+	return enterTime;
+}
+
+// How long until a ball which is level with the paddle, and going down, gets inside it, or 'never'.
+// The paddle moves too, so this follows the gap between them. It only changes speed where it stops
+// at the side of the screen, so there are at most two straight pieces to check.
+double EventWorld::FindPaddleHit(const EventBall& ball)
+{
+	double startTime = ball.time;
+	double endTime = ball.time + (paddleY + paddleHeight - ball.y) / ball.velY;
+	double stopTime = never;
+	if (paddleVelocity != 0)
+	{
+		double wallX = paddleVelocity > 0 ? WORLD_WIDTH - paddleWidth : 0;
+		stopTime = paddleTime + (wallX - paddleX) / paddleVelocity;
+	}
+
+	double pieceStarts[2] = { startTime, std::max(startTime, std::min(stopTime, endTime)) };
+	double pieceEnds[2] = { pieceStarts[1], endTime };
+	for (int piece = 0; piece < 2; piece++)
+	{
+		double start = pieceStarts[piece];
+		double end = pieceEnds[piece];
+		if (end < start || (piece == 1 && end == start))
+		{
+			continue;
+		}
+
+		// How far the ball is from the left of the paddle, and how fast that changes
+		double gap = ball.x + ball.velX * (start - ball.time) - PaddleXAt(start);
+		double paddleSpeed = start < stopTime ? paddleVelocity : 0;
+		double gapSpeed = ball.velX - paddleSpeed;
+		if (gap >= 0 && gap <= paddleWidth)
+		{
+			return start - ball.time;
+		}
+		if (gapSpeed == 0)
+		{
+			continue;
+		}
+		double target = gap < 0 ? 0 : paddleWidth;
+		double time = start + (target - gap) / gapSpeed;
+		if (time >= start && time <= end)
+		{
+			return time - ball.time;
+		}
+	}
+	return never;
+}
+
+void EventWorld::HandleEvent(const Event& event)
+{
+	EventBall& ball = balls[event.ball];
+	if (event.version != ball.version)
+	{
+		staleEvents++;
+		return;
+	}
+	eventsHandled++;
+
+	// Move the ball to where the event happens
+	MoveBall(ball, event.time);
+
+	switch (event.type)
+	{
+	case EVENT_SIDE_WALL:
+		ball.x = ball.velX > 0 ? WORLD_WIDTH : 0;
+		ball.velX = -ball.velX;
+		break;
+
+	case EVENT_TOP_WALL:
+		ball.y = 0;
+		ball.velY = -ball.velY;
+		break;
+
+	case EVENT_PADDLE:
+	{
+		// Like World::BounceBallOffPaddle, it bounces if it's inside the paddle. If it has only got
+		// down to the paddle's height, and the paddle isn't there, it carries on down.
+		if (ball.y < paddleY)
+		{
+			ball.y = paddleY;
+		}
+		double gap = ball.x - PaddleXAt(event.time);
+		if (gap >= -1e-6 && gap <= paddleWidth + 1e-6)
+		{
+			ball.velY = -std::abs(ball.velY);
+			paddleBounces++;
+		}
+		break;
+	}
+
+	case EVENT_BOTTOM:
+		// Lost. Put it back above the paddle, heading up and right like World does.
+		ball.x = ball.spawnX;
+		ball.y = paddleY - ballRadius;
+		ball.velX = std::abs(ball.velX);
+		ball.velY = -std::abs(ball.velY);
+		ballsLost++;
+		break;
+
+	case EVENT_BRICK:
+	{
+		if (!brickAlive[event.brick])
+		{
+			// Another ball got to the brick first. Nothing else can be in the way, because
+			// this was the soonest thing the ball could hit, so it just carries on from here.
+			brickGoneEvents++;
+			break;
+		}
+		// Bounce the way World::Step does, away from the side it hit
+		switch (event.side)
+		{
+		case 0:		// Top
+			ball.velY = -std::abs(ball.velY);
+			break;
+		case 1:		// Bottom
+			ball.velY = std::abs(ball.velY);
+			break;
+		case 2:		// Left
+			ball.velX = -std::abs(ball.velX);
+			break;
+		case 3:		// Right
+			ball.velX = std::abs(ball.velX);
+			break;
+		}
+		brickAlive[event.brick] = false;
+		bricksAlive--;
+		bricksDestroyed++;
+
+		if (bricksAlive == 0)
+		{
+			// Every brick is back, so balls flying over where they were might now hit one
+			// sooner than they planned to
+			roundsCleared++;
+			bricksAlive = MAX_BRICKS;
+			for (int i = 0; i < MAX_BRICKS; i++)
+			{
+				brickAlive[i] = true;
+			}
+			// Move them up to now first. Their position is from their last event, which may have been a
+			// while ago, and they mustn't hit bricks on the part of their path they've already flown.
+			// If the bricks came back twice at this same moment, the balls in them just fly out this time,
+			// or they could break every brick straight away forever.
+			breakBricksBallsAreIn = now > lastResetTime;
+			lastResetTime = now;
+			for (int i = 0; i < (int)balls.size(); i++)
+			{
+				MoveBall(balls[i], now);
+				if (i != event.ball && ReachesBricksBefore(balls[i], balls[i].nextEventTime))
+				{
+					ScheduleNextEvent(i);
+				}
+			}
+			breakBricksBallsAreIn = false;
+		}
+		break;
+	}
+	}
+
+	ScheduleNextEvent(event.ball);
+}
+
+void EventWorld::MoveBall(EventBall& ball, double time)
+{
+	ball.x += ball.velX * (time - ball.time);
+	ball.y += ball.velY * (time - ball.time);
+	ball.time = time;
+}
+
+int EventWorld::GetBallCount()
+{
+	return (int)balls.size();
+}
+
+void EventWorld::GetBallPosition(int ballIndex, float& x, float& y)
+{
+	EventBall& ball = balls[ballIndex];
+	x = (float)(ball.x + ball.velX * (now - ball.time));
+	y = (float)(ball.y + ball.velY * (now - ball.time));
+}
+
+float EventWorld::GetPaddleX()
+{
+	return (float)PaddleXAt(now);
+}
+
+bool EventWorld::IsBrickAlive(int brick)
+{
+	return brickAlive[brick];
+}
+
+/////////////////////////////////////////////////////////////////////////////
+// POLLING WORLD
+
+void PollingWorld::Init()
+{
+	world.Init(true, 1);
+	balls.clear();
+	spawnX.clear();
+	paddleVelocity = 0;
+}
+
+void PollingWorld::AddBall(float x, float y, float velX, float velY)
+{
+	Ball ball;
+	ball.SetPos(x, y);
+	ball.speedX = Real(std::abs(velX));
+	ball.speedY = Real(std::abs(velY));
+	ball.xVel = Real(velX);
+	ball.yVel = Real(velY);
+	balls.push_back(ball);
+	spawnX.push_back(Real(x));
+}
+
+void PollingWorld::Step(Real elapsedSeconds)
+{
+	Paddle& paddle = world.paddle;
+	paddle.x += paddleVelocity * elapsedSeconds;
+	if (paddle.x < 0)
+	{
+		paddle.x = 0;
+	}
+	if (paddle.x > WORLD_WIDTH - paddle.width)
+	{
+		paddle.x = WORLD_WIDTH - paddle.width;
+	}
+
+	// Exactly what World::Step does for its ball, for every ball
+	for (int b = 0; b < (int)balls.size(); b++)
+	{
+		Ball& ball = balls[b];
+		ball.Move(elapsedSeconds);
+
+		if (ball.yPos < 0)
+		{
+			ball.yPos = 0;
+			ball.yVel = ball.speedY;
+		}
+		if (ball.xPos >= WORLD_WIDTH)
+		{
+			ball.xPos = WORLD_WIDTH;
+			ball.xVel = -ball.speedX;
+		}
+		if (ball.xPos <= 0)
+		{
+			ball.xPos = 0;
+			ball.xVel = ball.speedX;
+		}
+
+		if (ball.yPos > WORLD_HEIGHT)
+		{
+			ball.SetPos(spawnX[b], paddle.y - ball.diameter / 2);
+			ball.xVel = ball.speedX;
+			ball.yVel = -ball.speedY;
+			ballsLost++;
+		}
+
+		if (ball.xPos >= paddle.x &&
+			ball.xPos <= paddle.x + paddle.width &&
+			ball.yPos >= paddle.y &&
+			ball.yPos <= paddle.y + paddle.height)
+		{
+			if (ball.yVel > 0)
+			{
+				paddleBounces++;
+			}
+			ball.yVel = -ball.speedY;
+		}
+
+		for (int i = 0; i < MAX_BRICKS; i++)
+		{
+			if (world.bricks[i].IsAlive())
+			{
+				int hitSide = world.bricks[i].GetCollisionSide(ball.xPos, ball.yPos);
+				if (hitSide > -1)
+				{
+					world.bricks[i].TakeDamage();
+					bricksDestroyed++;
+					switch (hitSide)
+					{
+					case 0:		// Top
+						ball.yVel = -ball.speedY;
+						break;
+					case 1:		// Bottom
+						ball.yVel = ball.speedY;
+						break;
+					case 2:		// Left
+						ball.xVel = -ball.speedX;
+						break;
+					case 3:		// Right
+						ball.xVel = ball.speedX;
+						break;
+					}
+
+					if (world.AllBricksDead())
+					{
+						world.ResetBricks();
+						roundsCleared++;
+					}
+				}
+			}
+		}
+	}
+}
+
+/////////////////////////////////////////////////////////////////////////////
+// BENCHMARK
+
+// How much bigger (or smaller, if it's negative) 'a' is than 'b'
+static double PercentDifference(long long a, long long b)
+{
+	return b != 0 ? (a - b) * 100.0 / b : 0.0;
+}
+
+void RunEventBenchmark(int numBalls, float seconds, int framesPerSecond)
+{
+	EventWorld eventWorld;
+	PollingWorld pollingWorld;
+	eventWorld.Init();
+	pollingWorld.Init();
+
+	// Fast balls scattered below the bricks, heading in random diagonal directions
+	unsigned int randomState = 12345;
+	for (int i = 0; i < numBalls; i++)
+	{
+		randomState = randomState * 1664525u + 1013904223u;
+		float x = 10 + (randomState >> 8) % 780;
+		randomState = randomState * 1664525u + 1013904223u;
+		float y = 200 + (randomState >> 8) % 300;
+		float velX = (randomState & 0x100) ? 600.0f : -600.0f;
+		float velY = (randomState & 0x200) ? 700.0f : -700.0f;
+		eventWorld.AddBall(x, y, velX, velY);
+		pollingWorld.AddBall(x, y, velX, velY);
+	}
+
+	// The paddle sweeps left and right, changing direction once a second
+	int numFrames = (int)(seconds * framesPerSecond);
+	float elapsedSeconds = 1.0f / framesPerSecond;
+
+	// Where every ball is at a few times, to see how long the two worlds stay the same
+	const int numCheckpoints = 3;
+	const float checkpointSeconds[numCheckpoints] = { 0.1f, 1, seconds };
+	int checkpointFrames[numCheckpoints];
+	std::vector<float> eventPositions[numCheckpoints];
+	std::vector<float> pollingPositions[numCheckpoints];
+	for (int i = 0; i < numCheckpoints; i++)
+	{
+		checkpointFrames[i] = std::max(0, std::min(numFrames - 1, (int)(checkpointSeconds[i] * framesPerSecond) - 1));
+	}
+
+	sf::Clock clock;
+	for (int frame = 0; frame < numFrames; frame++)
+	{
+		float paddleVelocity = (frame / framesPerSecond) % 2 == 0 ? 600.0f : -600.0f;
+		eventWorld.SetPaddleVelocity(paddleVelocity);
+		eventWorld.Advance((double)(frame + 1) / framesPerSecond);
+
+		for (int i = 0; i < numCheckpoints; i++)
+		{
+			if (frame == checkpointFrames[i])
+			{
+				for (int b = 0; b < numBalls; b++)
+				{
+					float x, y;
+					eventWorld.GetBallPosition(b, x, y);
+					eventPositions[i].push_back(x);
+					eventPositions[i].push_back(y);
+				}
+			}
+		}
+	}
+	float eventSeconds = clock.restart().asSeconds();
+
+	for (int frame = 0; frame < numFrames; frame++)
+	{
+		float paddleVelocity = (frame / framesPerSecond) % 2 == 0 ? 600.0f : -600.0f;
+		pollingWorld.paddleVelocity = paddleVelocity;
+		pollingWorld.Step(elapsedSeconds);
+
+		for (int i = 0; i < numCheckpoints; i++)
+		{
+			if (frame == checkpointFrames[i])
+			{
+				for (int b = 0; b < numBalls; b++)
+				{
+					pollingPositions[i].push_back(ToFloat(pollingWorld.balls[b].xPos));
+					pollingPositions[i].push_back(ToFloat(pollingWorld.balls[b].yPos));
+				}
+			}
+		}
+	}
+	float pollingSeconds = clock.restart().asSeconds();
+
+	printf("%d balls, %d frames at %d frames per second\n", numBalls, numFrames, framesPerSecond);
+	printf("              %12s %12s\n", "Events", "Polling");
+	printf("ms per frame: %12.4f %12.4f\n", eventSeconds * 1000 / numFrames, pollingSeconds * 1000 / numFrames);
+	printf("Bricks:       %12lld %12lld\n", eventWorld.bricksDestroyed, pollingWorld.bricksDestroyed);
+	printf("Rounds:       %12d %12d\n", eventWorld.roundsCleared, pollingWorld.roundsCleared);
+	printf("Paddle hits:  %12lld %12lld\n", eventWorld.paddleBounces, pollingWorld.paddleBounces);
+	printf("Balls lost:   %12lld %12lld\n", eventWorld.ballsLost, pollingWorld.ballsLost);
+	printf("Events handled: %lld (%lld out of date ones skipped, %lld bricks already gone)\n",
+		eventWorld.eventsHandled, eventWorld.staleEvents, eventWorld.brickGoneEvents);
+	printf("Events are %.1fx faster\n", pollingSeconds / eventSeconds);
+
+	// The two follow the same rules, but polling only looks once a frame, so it finds each hit a
+	// little late, and with float rounding. With lots of balls sharing the bricks, those tiny
+	// differences soon grow into a completely different game, so the totals only agree on average.
+	// This shows how long the balls themselves stay together.
+	printf("Difference:   bricks %+.1f%%, paddle hits %+.1f%%, balls lost %+.1f%%\n",
+		PercentDifference(eventWorld.bricksDestroyed, pollingWorld.bricksDestroyed),
+		PercentDifference(eventWorld.paddleBounces, pollingWorld.paddleBounces),
+		PercentDifference(eventWorld.ballsLost, pollingWorld.ballsLost));
+	for (int i = 0; i < numCheckpoints; i++)
+	{
+		int together = 0;
+		for (int b = 0; b < numBalls; b++)
+		{
+			float dx = eventPositions[i][b * 2] - pollingPositions[i][b * 2];
+			float dy = eventPositions[i][b * 2 + 1] - pollingPositions[i][b * 2 + 1];
+			if (dx * dx + dy * dy <= 1)
+			{
+				together++;
+			}
+		}
+		printf("Balls within a pixel of each other after %.1f seconds: %d of %d\n",
+			(checkpointFrames[i] + 1) / (float)framesPerSecond, together, numBalls);
+	}
+}
@@ -0,0 +1,137 @@
+#pragma once
+#include <functional>
+#include <queue>
+#include <vector>
+#include "World.h"
+
+// Lots of balls bouncing around one brick wall, simulated with 'events' instead of frames.
+//
+// World::Step moves the ball a little every frame and then tests it against everything, even
+// when nothing is about to happen. Here each ball instead works out, once, the exact time it
+// will next hit something: a wall, a brick, or the height of the paddle. That 'event' goes into
+// a priority queue, which keeps the soonest event at the front. Moving time forward just takes
+// the events which are due off the front, bounces those balls, and works out their next events.
+// A ball flying through empty space costs nothing until it gets where it's going, however many
+// frames that takes.
+//
+// Balls move in straight lines between events, so a ball's position is only stored at the time
+// of its last event, and worked out for any other time when it's needed.
+//
+// A ball hits a brick or the paddle at the moment its centre first gets inside it, which is what
+// World::Step tests for every frame, and bounces the same way.
+class EventWorld
+{
+public:
+	// Statistics
+	long long eventsHandled = 0;
+	long long staleEvents = 0;		// Thrown away, because the ball's plans changed after they were made
+	long long brickGoneEvents = 0;	// The ball got to a brick another ball had already destroyed
+	long long bricksDestroyed = 0;
+	long long paddleBounces = 0;
+	long long ballsLost = 0;
+	int roundsCleared = 0;
+
+	// Brings back every brick, removes every ball, and puts the paddle in the middle at time 0
+	void Init();
+
+	// Adds a ball at the current time. When it's lost off the bottom, it comes back above the paddle at x.
+	void AddBall(float x, float y, float velX, float velY);
+
+	// Changes how fast the paddle is moving, in pixels per second, from the current time
+	void SetPaddleVelocity(float velocity);
+
+	// Handles every event up to 'time' seconds
+	void Advance(double time);
+
+	int GetBallCount();
+	void GetBallPosition(int ball, float& x, float& y);	// At the current time
+	float GetPaddleX();
+	bool IsBrickAlive(int brick);
+
+private:
+	struct EventBall
+	{
+		double x;		// Position at 'time'
+		double y;
+		double time;
+		double velX;
+		double velY;
+		float spawnX;
+		double nextEventTime = 0;
+		unsigned int version = 0;	// Changes whenever the ball's next event is worked out again
+	};
+
+	enum EventType
+	{
+		EVENT_SIDE_WALL,
+		EVENT_TOP_WALL,
+		EVENT_PADDLE,		// Reaches the height of the paddle, or gets inside it from the side. It bounces if it's inside.
+		EVENT_BOTTOM,		// Lost off the bottom
+		EVENT_BRICK			// Gets inside a brick
+	};
+
+	struct Event
+	{
+		double time;
+		int ball;
+		unsigned int version;	// If this isn't the ball's version any more, the event is out of date
+		int type;
+		int brick;
+		int side;		// Which side of the brick, numbered like Brick::GetCollisionSide
+
+		bool operator>(const Event& other) const
+		{
+			return time > other.time;
+		}
+	};
+
+	std::priority_queue<Event, std::vector<Event>, std::greater<Event>> events;
+	std::vector<EventBall> balls;
+	bool brickAlive[MAX_BRICKS];
+	int bricksAlive = 0;
+	double now = 0;
+
+	// When the bricks last came back. Balls inside a brick when that happens break it straight away,
+	// like World::Step, unless it's the second time at the same moment.
+	double lastResetTime = -1;
+	bool breakBricksBallsAreIn = false;
+
+	// The paddle moves at a constant speed since paddleTime
+	double paddleX = 0;
+	double paddleTime = 0;
+	double paddleVelocity = 0;
+
+	void MoveBall(EventBall& ball, double time);
+	void ScheduleNextEvent(int ball);
+	void HandleEvent(const Event& event);
+	double FindBrickHit(const EventBall& ball, int& brick, int& side);
+	double FindBrickBoxHit(const EventBall& ball, int column, int row, int& side);
+	double FindPaddleHit(const EventBall& ball);
+	bool ReachesBricksBefore(const EventBall& ball, double time);
+	double PaddleXAt(double time);
+};
+
+// The same balls, moved the way World::Step moves its ball: a small step every frame, then a test
+// against the walls, the paddle and every brick. Used to compare against EventWorld.
+class PollingWorld
+{
+public:
+	World world;	// For the bricks and paddle
+	std::vector<Ball> balls;
+	std::vector<Real> spawnX;
+	Real paddleVelocity = 0;
+
+	// Statistics
+	long long bricksDestroyed = 0;
+	long long paddleBounces = 0;
+	long long ballsLost = 0;
+	int roundsCleared = 0;
+
+	void Init();
+	void AddBall(float x, float y, float velX, float velY);
+	void Step(Real elapsedSeconds);
+};
+
+// Runs the same balls through both, and prints how long each took, and how far apart the two ended up.
+// "Game.exe -eventbench [balls] [seconds] [framesPerSecond]"
+void RunEventBenchmark(int numBalls, float seconds, int framesPerSecond);
@@ -0,0 +1,58 @@
+#pragma once
+#include <cstdint>
+
+// A 'fixed point' number: a whole number of 1/65536ths, stored in an int.
+//
+// Floats can give slightly different answers depending on the compiler and its settings,
+// which makes replays and networked games drift apart. Integer maths always gives exactly
+// the same answer, so a simulation using Fixed is identical on every build.
+//
+// The range is about -32768 to 32767, which is plenty for positions and speeds in pixels.
+struct Fixed
+{
+	int32_t raw;	// The value multiplied by 65536
+
+	static const int32_t ONE = 1 << 16;
+
+	Fixed() = default;
+	constexpr Fixed(int i) : raw(i * ONE) {}
+	constexpr Fixed(float f) : raw((int32_t)(f * ONE + (f >= 0 ? 0.5f : -0.5f))) {}	// Rounded to the nearest 1/65536th
+	constexpr Fixed(double d) : raw((int32_t)(d * ONE + (d >= 0 ? 0.5 : -0.5))) {}
+
+	// Makes a Fixed directly from its raw value
+	static constexpr Fixed FromRaw(int32_t r)
+	{
+		Fixed f(0);
+		f.raw = r;
+		return f;
+	}
+
+	// Converting back to float is only for drawing, so it has to be asked for with a cast
+	explicit operator float() const
+	{
+		return raw * (1.0f / ONE);
+	}
+
+	Fixed& operator+=(Fixed b) { raw += b.raw; return *this; }
+	Fixed& operator-=(Fixed b) { raw -= b.raw; return *this; }
+	Fixed& operator*=(Fixed b);
+};
+
+inline Fixed operator+(Fixed a, Fixed b) { return Fixed::FromRaw(a.raw + b.raw); }
+inline Fixed operator-(Fixed a, Fixed b) { return Fixed::FromRaw(a.raw - b.raw); }
+inline Fixed operator-(Fixed a) { return Fixed::FromRaw(-a.raw); }
+
+// Multiply in 64 bits, so the result doesn't overflow before it's scaled back down
+inline Fixed operator*(Fixed a, Fixed b) { return Fixed::FromRaw((int32_t)(((int64_t)a.raw * b.raw) >> 16)); }
+inline Fixed operator/(Fixed a, Fixed b) { return Fixed::FromRaw((int32_t)(((int64_t)a.raw * Fixed::ONE) / b.raw)); }
+inline Fixed& Fixed::operator*=(Fixed b) { *this = *this * b; return *this; }
+
+inline bool operator==(Fixed a, Fixed b) { return a.raw == b.raw; }
+inline bool operator!=(Fixed a, Fixed b) { return a.raw != b.raw; }
+inline bool operator<(Fixed a, Fixed b) { return a.raw < b.raw; }
+inline bool operator<=(Fixed a, Fixed b) { return a.raw <= b.raw; }
+inline bool operator>(Fixed a, Fixed b) { return a.raw > b.raw; }
+inline bool operator>=(Fixed a, Fixed b) { return a.raw >= b.raw; }
+
+inline Fixed Abs(Fixed a) { return a.raw < 0 ? -a : a; }
+inline float ToFloat(Fixed a) { return (float)a; }
@@ -1,214 +1,73 @@
 #include "Main.h"
 #include "Helpers.h"
+#include "World.h"
+#include "ParticlePool.h"
+#include "Snapshot.h"
+#include "NetGame.h"
+#include "EndlessWorld.h"
+#include "Replay.h"
 
 // Define variables which determine how big the window will be
-int SCREEN_WIDTH = 800;
-int SCREEN_HEIGHT = 600;
+int SCREEN_WIDTH = WORLD_WIDTH;
+int SCREEN_HEIGHT = WORLD_HEIGHT;
 
 sf::Texture ballTexture;
 
 const bool debugMode = false;	// Whether to use autopilot
+bool autopilot = debugMode;		// Set from the replay file when playing one back
 
-// Ball
-class Ball
-{
-public:
-	const float diameter = 8;
-	float speedX = 0;	// Speed the ball moves in X
-	float speedY = 0;	// Speed the ball moves in Y
-
-	float xPos;
-	float yPos;
-	float xVel;
-	float yVel;
-
-	Ball()
-	{
-		xPos = 0;
-		yPos = 0;
-		xVel = 0;	// Velocity in pixels per second
-		yVel = 0;
-	}
-
-	// Member function for setting the position of the ball
-	void SetPos(float x, float y)
-	{
-		xPos = (float)x;
-		yPos = (float)y;
-	}
+// The seed a normal game starts with. Recordings save it, so replays start from the same bricks.
+const unsigned int gameSeed = 1;
 
-	// Member function for moving the ball by its velocity
-	void Move(float elapsedSeconds)
-	{
-		xPos += xVel * elapsedSeconds;
-		yPos += yVel * elapsedSeconds;
-	}
-};
-Ball ball;
+World world;
 
-// Paddle variables
-class Paddle
-{
-public:
-	// Constants
-	const float height = 10;
-	const float width = 100;
-	const float screenBottomOffset = 50;
-
-	float x = 0;		// Paddle position (properly initialized in GameInit)
-	float y = 0;
-	float speed = 600;	// Speed in pixels per second
-};
-Paddle paddle;
-
-// Player variables
-const int initialLives = 3;
-int currLives = initialLives;
-int score = 0;
-
-// Brick constants
-const float BRICK_WIDTH = 40;
-const float BRICK_HEIGHT = 20;
-
-class Brick
-{
-private:
-	bool alive;		// Whether the brick is alive (draws a rectangle and can be collided with)
-	float x;		// Pixel position of left side of brick
-	float y;		// Pixel position of top side of brick
+// Bits of brick which fly out when a brick is destroyed
+ParticlePool particles(131072);
 
-public:
-	Brick()
-	{
-		// Initialize brick to be dead, and have a bogus position
-		alive = false;
-		x = -99999;
-		y = -99999;
-	}
+// The last few seconds of the game, so it can be played backwards by holding R.
+// Enough for 10 seconds at 240 frames per second.
+RewindBuffer rewindBuffer(10 * 240);
 
-	bool IsAlive()
-	{
-		return alive;
-	}
+// A saved game. F5 saves, F9 loads.
+WorldSnapshot saveState;
+bool hasSaveState = false;
 
-	void TakeDamage()
-	{
-		alive = false;
-	}
+// Only set when playing on a server
+NetClient* netClient = NULL;
 
-	void Init(float xPos, float yPos, bool isAlive)
-	{
-		x = xPos;
-		y = yPos;
-		alive = isAlive;
-	}
+void StartNetworkGame(const char* host, unsigned short port, float latency, float lossChance)
+{
+	netClient = new NetClient();
 
-	void Draw()
-	{
-		DrawRectangle(x, y, BRICK_WIDTH, BRICK_HEIGHT, sf::Color::Cyan);
-		DrawRectangle(x + 1, y + 1, BRICK_WIDTH - 2, BRICK_HEIGHT - 2, sf::Color::Red);
-	}
+	// Pretend the connection is worse than it is, to see how the game copes
+	netClient->socket.latency = latency;
+	netClient->socket.jitter = latency / 4;
+	netClient->socket.lossChance = lossChance;
 
-	// Returns:
-	// -1 = No collision
-	//  0 = top, 1 = bottom, 2 = left, 3 = right
-	int GetCollisionSide(float xPos, float yPos)
+	if (!netClient->Connect(sf::IpAddress(host), port))
 	{
-		// Calculate the sides of the brick
-		float brickTop = y;
-		float brickBottom = y + BRICK_HEIGHT - 1;
-		float brickLeft = x;
-		float brickRight = x + BRICK_WIDTH - 1;
-
-		if (ball.xPos > brickLeft &&
-			ball.xPos < brickRight &&
-			ball.yPos > brickTop &&
-			ball.yPos < brickBottom)
-		{
-			// We know the ball is inside the brick
-			// Work out which side the ball 'penetrates' the least, and treat that as the side which was hit
-
-			// Use an int variable to store which side was hit
-			int hitSide;	// 0 = top, 1 = bottom, 2 = left, 3 = right
-
-			float shortestPenetration;	// Used for storing the lowest penetration amount we've found
-
-			// Start with the top of the brick
-			// Because it's the first side we're testing, this is the side which has been penetrated least
-			hitSide = 0;
-			shortestPenetration = abs(brickTop - ball.yPos);
-
-			// Test the bottom
-			float currPenetration = abs(brickBottom - ball.yPos);	// I use abs because I'm lazy, and want to avoid getting it the wrong way around
-			if (currPenetration < shortestPenetration)
-			{
-				// The bottom is penetrated less. It's the new 'winner'.
-				hitSide = 1;
-				shortestPenetration = currPenetration;
-			}
-
-			// Test the left
-			currPenetration = abs(brickLeft - ball.xPos);
-			if (currPenetration < shortestPenetration)
-			{
-				// The left is penetrated less. It's the new 'winner'.
-				hitSide = 2;
-				shortestPenetration = currPenetration;
-			}
-
-			// Test the right
-			currPenetration = abs(brickRight - ball.xPos);
-			if (currPenetration < shortestPenetration)
-			{
-				// The right is penetrated less. It's the new 'winner'.
-				hitSide = 3;
-				shortestPenetration = currPenetration;
-			}
-			return hitSide;
-		}
-		else
-		{
-			return -1;	// No collision
-		}
+		printf("Couldn't open a network port\n");
 	}
-};
-const int BRICK_COLUMNS = 18;
-const int BRICK_ROWS = 6;
-const int MAX_BRICKS = BRICK_COLUMNS * BRICK_ROWS;
-Brick bricks[MAX_BRICKS];
+}
 
+// Records what the player does, when started with "-record"
+ReplayRecorder recorder;
 
-void ResetBricks()
+void StartRecording(const char* path)
 {
-	// Calculate offset for top left of the grid of bricks
-	const float xOffset = (SCREEN_WIDTH / 2) - ((BRICK_COLUMNS / 2) * BRICK_WIDTH);
-	const float yOffset = 50;
-
-	// Initialize the bricks to be laid out in a grid
-	int curr = 0;
-	for (int y = 0; y < BRICK_ROWS; y++)
+	if (!recorder.Start(path, gameSeed, debugMode))
 	{
-		for (int x = 0; x < BRICK_COLUMNS; x++)
-		{
-			float xPos = x * BRICK_WIDTH + xOffset;
-			float yPos = y * BRICK_HEIGHT + yOffset;
-			bricks[curr].Init(xPos, yPos, true);
-			curr++;
-		}
+		printf("Couldn't write %s\n", path);
 	}
 }
 
-void ResetBallAndPaddlePosition()
+// Only set when playing the endless scrolling game
+EndlessWorld* endlessWorld = NULL;
+
+void StartEndlessGame(unsigned int seed)
 {
-	// Reset paddle
-	paddle.x = (float)(SCREEN_WIDTH / 2 - paddle.width / 2);
-	paddle.y = (float)SCREEN_HEIGHT - paddle.screenBottomOffset;
-
-	// Reset ball
-	const float centerPosOffset = 200;
-	ball.SetPos(paddle.x + paddle.width / 2, paddle.y - ball.diameter / 2);
-	ball.xVel = ball.speedX;	// Send ball right
-	ball.yVel = -ball.speedY;	// Send ball up
+	endlessWorld = new EndlessWorld();
+	endlessWorld->Init(debugMode, seed);
 }
 
 // Draw a rectangle made of lines. Can be useful for debugging.
@@ -226,196 +85,272 @@ void GameInit()
 	// The numbers are the width and height in pixels. The text is the title of the window.
 	window = new sf::RenderWindow(sf::VideoMode(SCREEN_WIDTH, SCREEN_HEIGHT), "SFML works!");
 
-	if (debugMode)
-	{
-		// Move ball quickly in debug mode
-		ball.speedX = 600;	// Speed the ball moves in X
-		ball.speedY = 700;	// Speed the ball moves in Y
-	}
-	else
-	{
-		// Move ball at normal speed when not in debug mode
-		ball.speedX = 300;	// Speed the ball moves in X
-		ball.speedY = 350;	// Speed the ball moves in Y
-	}
+	// Move ball quickly in debug mode, and at normal speed when not in debug mode
+	// This also resets the ball, paddle and bricks
+	world.Init(debugMode, gameSeed);
 
 	// Load a texture
 	if (!ballTexture.loadFromFile("Ball.png"))
 	{
 		printf("Texture failed to load!\n");
 	}
-
-	// Reset the ball, paddle and bricks
-	ResetBallAndPaddlePosition();
-	ResetBricks();
 }
 
-// GameLoop is called repeatedly. Its job is to update the 'game', and draw the screen.
-void GameLoop(float elapsedSeconds)
+// The endless game's version of GameLoop. Everything is drawn at (x, y - cameraY).
+void EndlessGameLoop(float elapsedSeconds, int paddleDirection)
 {
-	bool playerAlive = currLives > 0;
+	EndlessWorld& endless = *endlessWorld;
+	Ball& ball = endless.ball;
+	Paddle& paddle = endless.paddle;
+
+	bool playerAlive = endless.IsPlayerAlive();
+	endless.Step(elapsedSeconds, paddleDirection, debugMode);
 
-	if (playerAlive)
+	float cameraY = ToFloat(endless.cameraY);
+	if (endless.brickHitThisStep)
 	{
-		// Move ball
-		ball.Move(elapsedSeconds);
+		float brickX = ToFloat(endless.brickHitX);
+		float brickY = ToFloat(endless.brickHitY) - cameraY;
+		particles.Emit(brickX, brickY, ToFloat(BRICK_WIDTH), ToFloat(BRICK_HEIGHT), 80, 150, 1.0f, sf::Color::Red);
+		particles.Emit(brickX, brickY, ToFloat(BRICK_WIDTH), ToFloat(BRICK_HEIGHT), 20, 150, 1.0f, sf::Color::Cyan);
 	}
+	particles.Update(elapsedSeconds);
+
+	// Bricks first, so the ball and paddle are drawn on top
+	endless.BuildVertices();
+	endless.Draw();
+	particles.Draw();
+
+	float ballX = ToFloat(ball.xPos);
+	float ballY = ToFloat(ball.yPos) - cameraY;
+	float ballDiameter = ToFloat(ball.diameter);
+	DrawTexture(ballX - (ballDiameter / 2), ballY - (ballDiameter / 2), ballDiameter, ballDiameter, ballTexture);
+	DrawCircle(ballX, ballY, ballDiameter / 2.0f, sf::Color::Yellow);
+	DrawRectangle(ToFloat(paddle.x), ToFloat(paddle.y) - cameraY, ToFloat(paddle.width), ToFloat(paddle.height), sf::Color::White);
+
+	// Height is in rows of bricks
+	std::string scoreText = "Lives: " + std::to_string(endless.currLives) + "   Score: " + std::to_string(endless.score) +
+		"   Height: " + std::to_string((int)(endless.distance / ToFloat(BRICK_HEIGHT)));
+	DrawString(scoreText, 8, (float)SCREEN_HEIGHT - 24, 16, sf::Color::Cyan);
 
-	// Debug move ball to mouse position when mouse is clicked
-	if (debugMode && IsMouseButtonPressed())
+	if (!playerAlive)
 	{
-		ball.SetPos((float)GetMouseX(), (float)GetMouseY());
+		DrawString("Game Over!", SCREEN_WIDTH / 2 - 150.0f, (float)SCREEN_HEIGHT / 2, 50, sf::Color::Red);
+		DrawString("Press P to play again", (SCREEN_WIDTH / 2.0f) - 100.0f, (float)SCREEN_HEIGHT / 2 + 100, 20, sf::Color::Red);
+		if (IsKeyPressed(sf::Keyboard::P))
+		{
+			endless.Restart();
+		}
 	}
+}
 
+// If a brick was destroyed, break it into particles, with some sparks where the ball hit
+void EmitBrickParticles()
+{
+	if (world.brickHitThisStep >= 0)
+	{
+		Brick& brick = world.bricks[world.brickHitThisStep];
+		float brickX = ToFloat(brick.GetX());
+		float brickY = ToFloat(brick.GetY());
+		float brickWidth = ToFloat(BRICK_WIDTH);
+		float brickHeight = ToFloat(BRICK_HEIGHT);
+		particles.Emit(brickX, brickY, brickWidth, brickHeight, 80, 150, 1.0f, sf::Color::Red);
+		particles.Emit(brickX, brickY, brickWidth, brickHeight, 20, 150, 1.0f, sf::Color::Cyan);
+		particles.Emit(ToFloat(world.ball.xPos), ToFloat(world.ball.yPos), 0, 0, 20, 300, 0.4f, sf::Color::Yellow);
+	}
+}
 
-	// Bounce ball off sides and top of the screen
-	if (ball.yPos < 0)
+// Reads the keyboard and mouse into a ReplayFrame, so the game can be recorded and played back
+ReplayFrame ReadInput(float elapsedSeconds)
+{
+	ReplayFrame input;
+	input.elapsedSeconds = elapsedSeconds;
+
+	// Work out which way the player wants the paddle to move
+	if (IsKeyPressed(sf::Keyboard::Left) || IsKeyPressed(sf::Keyboard::A))
+	{
+		input.paddleDirection -= 1;
+	}
+	if (IsKeyPressed(sf::Keyboard::Right) || IsKeyPressed(sf::Keyboard::D))
+	{
+		input.paddleDirection += 1;
+	}
+
+	if (IsKeyPressed(sf::Keyboard::R))
+	{
+		input.buttons |= INPUT_REWIND;
+	}
+	if (IsKeyPressed(sf::Keyboard::F5))
+	{
+		input.buttons |= INPUT_SAVE;
+	}
+	if (IsKeyPressed(sf::Keyboard::F9))
 	{
-		// Hit top of screen
-		ball.yPos = 0;
-		ball.yVel = ball.speedY;
+		input.buttons |= INPUT_LOAD;
 	}
-	if (ball.xPos >= SCREEN_WIDTH)
+	if (IsKeyPressed(sf::Keyboard::P))
 	{
-		// Hit right side
-		ball.xPos = (float)SCREEN_WIDTH;
-		ball.xVel = -ball.speedX;
+		input.buttons |= INPUT_RESTART;
 	}
-	if (ball.xPos <= 0)
+	if (IsMouseButtonPressed())
 	{
-		// Hit left side
-		ball.xPos = 0;
-		ball.xVel = ball.speedX;
+		input.buttons |= INPUT_MOUSE;
+		input.mouseX = (int16_t)GetMouseX();
+		input.mouseY = (int16_t)GetMouseY();
 	}
+	return input;
+}
+
+void StartReplay(unsigned int seed, bool replayAutopilot)
+{
+	autopilot = replayAutopilot;
+	world.Init(autopilot, seed);
+	particles.Clear();
+	rewindBuffer.Clear();
+	hasSaveState = false;
+}
 
-	// If the ball goes off the bottom, 'lose a life'
-	if (ball.yPos > SCREEN_HEIGHT)
+void SaveGameState(WorldSnapshot& snapshot, std::vector<sf::Vertex>& particleCorners)
+{
+	SaveSnapshot(world, snapshot);
+	const sf::Vertex* corners = particles.GetVertices();
+	particleCorners.assign(corners, corners + particles.GetLiveCount() * 4);
+}
+
+void StepGame(const ReplayFrame& input)
+{
+	Ball& ball = world.ball;
+	bool playerAlive = world.IsPlayerAlive();
+
+	// Debug move ball to mouse position when mouse is clicked
+	if (autopilot && (input.buttons & INPUT_MOUSE))
 	{
-		// Bottom side bounce
-		ResetBallAndPaddlePosition();
-		currLives--;
+		ball.SetPos((float)input.mouseX, (float)input.mouseY);
 	}
 
-	// Move paddle
-	if (playerAlive)
+	// Save and load the game
+	if (input.buttons & INPUT_SAVE)
 	{
-		if (IsKeyPressed(sf::Keyboard::Left) || IsKeyPressed(sf::Keyboard::A))
-		{
-			paddle.x -= paddle.speed * elapsedSeconds;
-		}
-		if (IsKeyPressed(sf::Keyboard::Right) || IsKeyPressed(sf::Keyboard::D))
-		{
-			paddle.x += paddle.speed * elapsedSeconds;
-		}
+		SaveSnapshot(world, saveState);
+		hasSaveState = true;
+	}
+	if ((input.buttons & INPUT_LOAD) && hasSaveState)
+	{
+		LoadSnapshot(world, saveState);
 	}
 
-	// In debug mode, automatically move paddle to always be under the ball
-	if (debugMode)
+	if (input.buttons & INPUT_REWIND)
 	{
-		paddle.x = ball.xPos - paddle.width / 2;
+		// Go back one frame. Once the buffer runs out, the game just stays paused.
+		rewindBuffer.Rewind(world);
 	}
+	else
+	{
+		// Move the ball and paddle, and do all the bouncing
+		// In debug mode, the paddle is automatically moved to always be under the ball
+		world.Step(input.elapsedSeconds, input.paddleDirection, autopilot);
+		rewindBuffer.Record(world);
+	}
+
+	EmitBrickParticles();
+	particles.Update(input.elapsedSeconds);
 
-	// Limit paddle to screen
-	if (paddle.x < 0)
+	if (!playerAlive && (input.buttons & INPUT_RESTART))
 	{
-		paddle.x = 0;
+		world.Restart();
 	}
-	if (paddle.x > SCREEN_WIDTH - paddle.width)
+}
+
+// GameLoop is called repeatedly. Its job is to update the 'game', and draw the screen.
+void GameLoop(float elapsedSeconds)
+{
+	Ball& ball = world.ball;
+	Paddle& paddle = world.paddle;
+
+	ReplayFrame input = ReadInput(elapsedSeconds);
+
+	if (endlessWorld != NULL)
 	{
-		paddle.x = SCREEN_WIDTH - paddle.width;
+		EndlessGameLoop(elapsedSeconds, input.paddleDirection);
+		return;
 	}
 
-	// Bounce ball off paddle
-	if (ball.xPos >= paddle.x &&
-		ball.xPos <= paddle.x + paddle.width &&
-		ball.yPos >= paddle.y &&
-		ball.yPos <= paddle.y + paddle.height)
+	if (netClient != NULL)
 	{
-		ball.yVel = -ball.speedY;
+		// The server moves everything. We just send which way we want to go, and draw what it tells us.
+		netClient->Update(elapsedSeconds, input.paddleDirection);
+		netClient->GetDisplayWorld(world);
+		EmitBrickParticles();
+		particles.Update(elapsedSeconds);
 	}
+	else
+	{
+		// Everything that changes the game happens in StepGame, from just the input, so a recording
+		// of the input is enough to play the whole game again
+		recorder.Record(input);
+		StepGame(input);
+	}
+	bool playerAlive = world.IsPlayerAlive();
 
 	// Draw ball
 	// ballX, ballY is the center of the ball. DrawTexture takes the top left,
 	// so we need to subtract (ball.diameter/2) to calculate the top left.
-	DrawTexture(ball.xPos - (ball.diameter / 2), ball.yPos - (ball.diameter / 2), ball.diameter, ball.diameter, ballTexture);
-	DrawCircle(ball.xPos, ball.yPos, ball.diameter/2.0f, sf::Color::Yellow);
+	float ballX = ToFloat(ball.xPos);
+	float ballY = ToFloat(ball.yPos);
+	float ballDiameter = ToFloat(ball.diameter);
+	DrawTexture(ballX - (ballDiameter / 2), ballY - (ballDiameter / 2), ballDiameter, ballDiameter, ballTexture);
+	DrawCircle(ballX, ballY, ballDiameter/2.0f, sf::Color::Yellow);
 
 	// Draw paddles
-	DrawRectangle(paddle.x, paddle.y, paddle.width, paddle.height, sf::Color::White);
+	DrawRectangle(ToFloat(paddle.x), ToFloat(paddle.y), ToFloat(paddle.width), ToFloat(paddle.height), sf::Color::White);
+	if (world.numPlayers == 2)
+	{
+		Paddle& paddle2 = world.paddle2;
+		DrawRectangle(ToFloat(paddle2.x), ToFloat(paddle2.y), ToFloat(paddle2.width), ToFloat(paddle2.height), sf::Color::Green);
+	}
 
-	// Test collision with bricks and draw them
+	// Draw bricks
 	for (int i = 0; i < MAX_BRICKS; i++)
 	{
-		if (bricks[i].IsAlive())
+		if (world.bricks[i].IsAlive())
 		{
-			int hitSide = bricks[i].GetCollisionSide(ball.xPos, ball.yPos);
-
-			// If the ball hit the brick, kill the brick and increase score.
-			if (hitSide > -1)
-			{
-				bricks[i].TakeDamage();
-				score++;
-
-				// Depending on which side was penetrated most, change the ball velocity
-				switch (hitSide)
-				{
-				case 0:		// Top
-					ball.yVel = -ball.speedY;
-					break;
-				case 1:		// Bottom
-					ball.yVel = ball.speedY;
-					break;
-				case 2:		// Left
-					ball.xVel = -ball.speedX;
-					break;
-				case 3:		// Right
-					ball.xVel = ball.speedX;
-					break;
-				}
-			}
-		}
-
-		// The brick may have just been destroyed, so we need to check if it's alive again
-		if (bricks[i].IsAlive())
-		{
-			bricks[i].Draw();
+			world.bricks[i].Draw();
 		}
 	}
 
+	// Draw particles on top of the bricks
+	particles.Draw();
+
 	// Draw lives and score text
-	std::string scoreText = "Lives: " + std::to_string(currLives) + "   Score: " + std::to_string(score);
+	std::string scoreText = "Lives: " + std::to_string(world.currLives) + "   Score: " + std::to_string(world.score);
 	DrawString(scoreText, 8, (float)SCREEN_HEIGHT - 24, 16, sf::Color::Cyan);
 
-	// Detect all bricks dead
-	// Start assuming there are no bricks, and if one is found, set noBricks to false
-	bool noBricks = true;
-	for (int i = 0; i < MAX_BRICKS; i++)
+	// Show which paddle is ours, and how much data the server is sending
+	if (netClient != NULL)
 	{
-		if (bricks[i].IsAlive())
+		std::string netText = "Waiting for server...";
+		if (netClient->HasState())
 		{
-			noBricks = false;
-			break;
+			int bytesPerSecond = (int)(netClient->bytesReceived / netClient->GetTime());
+			netText = netClient->GetPlayerIndex() == 0 ? "Player 1 (white)" : "Player 2 (green)";
+			netText += "   " + std::to_string(bytesPerSecond) + " bytes/s";
 		}
-	}
-	// If all bricks are dead, reset for next round
-	if (noBricks)
-	{
-		ResetBricks();
-		ResetBallAndPaddlePosition();
+		DrawString(netText, (float)SCREEN_WIDTH - 300, (float)SCREEN_HEIGHT - 24, 16, sf::Color::Cyan);
 	}
 
-
 	// Draw Game Over text
 	if (!playerAlive)
 	{
 		DrawString("Game Over!", SCREEN_WIDTH / 2 - 150.0f, (float)SCREEN_HEIGHT / 2, 50, sf::Color::Red);
-		DrawString("Press P to play again", (SCREEN_WIDTH / 2.0f) - 100.0f, (float)SCREEN_HEIGHT / 2 + 100, 20, sf::Color::Red);
 
-		if (IsKeyPressed(sf::Keyboard::P))
+		// In a network game, the server starts the next game by itself
+		if (netClient != NULL)
+		{
+			DrawString("Next game starting soon", (SCREEN_WIDTH / 2.0f) - 100.0f, (float)SCREEN_HEIGHT / 2 + 100, 20, sf::Color::Red);
+		}
+		else
 		{
-			ResetBricks();
-			ResetBallAndPaddlePosition();
-			currLives = initialLives;
+			DrawString("Press P to play again", (SCREEN_WIDTH / 2.0f) - 100.0f, (float)SCREEN_HEIGHT / 2 + 100, 20, sf::Color::Red);
 		}
 	}
 }
@@ -1,4 +1,27 @@
 #pragma once
+#include <vector>
+#include <SFML\Graphics.hpp>
+#include "Replay.h"
+#include "Snapshot.h"
 
 void GameInit();
 void GameLoop(float elapsedSeconds);
+
+// Call before GameInit to play on a server, instead of on your own
+void StartNetworkGame(const char* host, unsigned short port, float latency, float lossChance);
+
+// Call before GameInit to play the endless scrolling game. The seed picks which bricks you get.
+void StartEndlessGame(unsigned int seed);
+
+// Call before GameInit to record everything the player does into a replay file, for "-capture"
+void StartRecording(const char* path);
+
+// Starts a new game for playing a replay back. Doesn't need GameInit or a window.
+void StartReplay(unsigned int seed, bool autopilot);
+
+// Moves the game on by one frame of input, without drawing anything.
+// GameLoop does the same with the keyboard's input, so a replay plays out exactly as it was played.
+void StepGame(const ReplayFrame& input);
+
+// Copies out what's needed to draw the game: the world, and the corners of the particles' squares
+void SaveGameState(WorldSnapshot& snapshot, std::vector<sf::Vertex>& particleCorners);
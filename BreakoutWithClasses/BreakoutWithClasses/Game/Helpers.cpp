@@ -176,7 +176,7 @@ int GetMouseY()
 // MISC
 
 // This function gets called when you call printf
-// It prints text to the output window in Visual Studio
+// It prints text to the output window in Visual Studio, and to the console
 // This function uses some advanced features of the language, so don't worry
 // about understanding it :)
 int __cdecl printf2(const char* format, ...)
@@ -193,5 +193,8 @@ int __cdecl printf2(const char* format, ...)
     // Print the string to Visual Studio
     OutputDebugStringA(str);
 
+    // Also print it to the console, so programs run from the command line can be seen
+    fputs(str, stdout);
+
     return ret;
 }
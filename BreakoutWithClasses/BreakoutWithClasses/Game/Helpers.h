@@ -20,6 +20,6 @@ int GetMouseY();
 // Misc
 
 // This replaces the standard 'printf' function with one which outputs
-// to the Visual Studio output window.
+// to the Visual Studio output window (and the console).
 #define printf printf2
 int __cdecl printf2(const char* format, ...);
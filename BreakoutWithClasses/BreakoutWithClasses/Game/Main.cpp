@@ -2,12 +2,143 @@
 #include "Main.h"
 #include "Game.h"
 #include "Helpers.h"
+#include "SelfPlay.h"
+#include "ParticlePool.h"
+#include "Snapshot.h"
+#include "NetGame.h"
+#include "EventPhysics.h"
+#include "EndlessWorld.h"
+#include "Capture.h"
+#include <cstdlib>
+#include <cstring>
 
 sf::RenderWindow* window = NULL;    // The window that the game will draw within
 sf::Font defaultFont;               // The font used for text within the window
 
-int main()
+int main(int argc, char* argv[])
 {
+    // "Game.exe -selfplay [games] [threads]" plays lots of games with the autopilot, without a window,
+    // and prints how quickly they ran.
+    if (argc >= 2 && strcmp(argv[1], "-selfplay") == 0)
+    {
+        int numGames = argc >= 3 ? atoi(argv[2]) : 10000;
+        int numThreads = argc >= 4 ? atoi(argv[3]) : 0;
+        SelfPlayStats stats = RunSelfPlay(numGames, numThreads, 12345, 600.0f);
+        PrintSelfPlayStats(stats);
+        return 0;
+    }
+
+    // "Game.exe -lanes [games] [threads]" is the same, but steps several games at once on each thread using SIMD
+    if (argc >= 2 && strcmp(argv[1], "-lanes") == 0)
+    {
+        int numGames = argc >= 3 ? atoi(argv[2]) : 10000;
+        int numThreads = argc >= 4 ? atoi(argv[3]) : 0;
+        SelfPlayStats stats = RunLaneSelfPlay(numGames, numThreads, 12345, 600.0f);
+        PrintSelfPlayStats(stats);
+        return 0;
+    }
+
+    // "Game.exe -verify [games]" checks that playing on one thread and on every core gives identical results
+    if (argc >= 2 && strcmp(argv[1], "-verify") == 0)
+    {
+        int numGames = argc >= 3 ? atoi(argv[2]) : 1000;
+        return VerifySelfPlay(numGames, 12345, 600.0f) ? 0 : 1;
+    }
+
+    // "Game.exe -particles [count]" times how long the particle system takes to update
+    if (argc >= 2 && strcmp(argv[1], "-particles") == 0)
+    {
+        int numParticles = argc >= 3 ? atoi(argv[2]) : 100000;
+        RunParticleBenchmark(numParticles, 600);
+        return 0;
+    }
+
+    // "Game.exe -snapshots [count]" times how long saving and restoring the game takes
+    if (argc >= 2 && strcmp(argv[1], "-snapshots") == 0)
+    {
+        int count = argc >= 3 ? atoi(argv[2]) : 1000000;
+        RunSnapshotBenchmark(count);
+        return 0;
+    }
+
+    // "Game.exe -eventbench [balls] [seconds] [framesPerSecond]" compares event driven physics with
+    // moving every ball every frame
+    if (argc >= 2 && strcmp(argv[1], "-eventbench") == 0)
+    {
+        int numBalls = argc >= 3 ? atoi(argv[2]) : 1000;
+        float seconds = argc >= 4 ? (float)atof(argv[3]) : 10;
+        int framesPerSecond = argc >= 5 ? atoi(argv[4]) : 240;
+        RunEventBenchmark(numBalls, seconds, framesPerSecond);
+        return 0;
+    }
+
+    // "Game.exe -endlessbench [minutes]" checks that memory and frame time stay the same in the endless game
+    if (argc >= 2 && strcmp(argv[1], "-endlessbench") == 0)
+    {
+        float minutes = argc >= 3 ? (float)atof(argv[2]) : 10;
+        RunEndlessBenchmark(minutes);
+        return 0;
+    }
+
+    // "Game.exe -capture replay.bin frames/breakout%05d.png [framesPerSecond] [threads]" saves a recorded game
+    // as PNGs (or as raw pixels, if the name has no %d), without opening a window
+    if (argc >= 4 && strcmp(argv[1], "-capture") == 0)
+    {
+        int framesPerSecond = argc >= 5 ? atoi(argv[4]) : 60;
+        int numThreads = argc >= 6 ? atoi(argv[5]) : 0;
+        return RunReplayCapture(argv[2], argv[3], framesPerSecond, numThreads) ? 0 : 1;
+    }
+
+    // "Game.exe -capturebench [seconds]" times capturing the autopilot playing, on one thread and on every core
+    if (argc >= 2 && strcmp(argv[1], "-capturebench") == 0)
+    {
+        float seconds = argc >= 3 ? (float)atof(argv[2]) : 10;
+        RunCaptureBenchmark(seconds);
+        return 0;
+    }
+
+    // "Game.exe -server [port] [latencyMs] [lossPercent]" runs a two player server, without a window.
+    // The latency and loss make the connection worse on purpose, for testing.
+    if (argc >= 2 && strcmp(argv[1], "-server") == 0)
+    {
+        unsigned short port = argc >= 3 ? (unsigned short)atoi(argv[2]) : NET_DEFAULT_PORT;
+        float latency = argc >= 4 ? (float)atof(argv[3]) / 1000 : 0;
+        float lossChance = argc >= 5 ? (float)atof(argv[4]) / 100 : 0;
+        RunNetServer(port, latency, lossChance);
+        return 0;
+    }
+
+    // "Game.exe -netloopback [seconds] [latencyMs] [lossPercent]" tests the server and two clients on this computer
+    if (argc >= 2 && strcmp(argv[1], "-netloopback") == 0)
+    {
+        float seconds = argc >= 3 ? (float)atof(argv[2]) : 60;
+        float latency = argc >= 4 ? (float)atof(argv[3]) / 1000 : 0.1f;
+        float lossChance = argc >= 5 ? (float)atof(argv[4]) / 100 : 0.05f;
+        return RunNetLoopback(seconds, latency, lossChance) ? 0 : 1;
+    }
+
+    // "Game.exe -client host [port] [latencyMs] [lossPercent]" plays on a server instead of on your own
+    if (argc >= 3 && strcmp(argv[1], "-client") == 0)
+    {
+        unsigned short port = argc >= 4 ? (unsigned short)atoi(argv[3]) : NET_DEFAULT_PORT;
+        float latency = argc >= 5 ? (float)atof(argv[4]) / 1000 : 0;
+        float lossChance = argc >= 6 ? (float)atof(argv[5]) / 100 : 0;
+        StartNetworkGame(argv[2], port, latency, lossChance);
+    }
+
+    // "Game.exe -record replay.bin" plays as normal, and records the game so "-capture" can save it as pictures
+    if (argc >= 3 && strcmp(argv[1], "-record") == 0)
+    {
+        StartRecording(argv[2]);
+    }
+
+    // "Game.exe -endless [seed]" plays the endless scrolling game
+    if (argc >= 2 && strcmp(argv[1], "-endless") == 0)
+    {
+        unsigned int seed = argc >= 3 ? (unsigned int)atoi(argv[2]) : 1;
+        StartEndlessGame(seed);
+    }
+
     // Run our game initialization code
     GameInit();
 
@@ -0,0 +1,888 @@
+#include <SFML\System.hpp>
+#include <algorithm>
+#include <cmath>
+#include <vector>
+#include "Helpers.h"
+#include "NetGame.h"
+
+static_assert((MAX_BRICKS + 31) / 32 == 4, "NetState has room for 4 words of bricks");
+
+// The first byte of every packet says what's in it
+enum NetPacketType
+{
+	NET_PACKET_INPUT = 1,		// Client to server
+	NET_PACKET_SNAPSHOT = 2		// Server to client
+};
+
+// Which fields need 32 bits when they're sent. Everything else fits in 16.
+static const bool netFieldIs32Bit[NET_FIELD_COUNT] =
+{
+	false, false, false, false,	// Ball
+	false, false,				// Paddles
+	false, true,				// Lives, score
+	true, true, true, true		// Bricks
+};
+
+const float netTickSeconds = 1.0f / NET_TICKS_PER_SECOND;
+const float netTimeoutSeconds = 5;
+
+/////////////////////////////////////////////////////////////////////////////
+// SNAPSHOTS
+
+static sf::Int32 Quantize(Real value, float scale)
+{
+	return (sf::Int32)lroundf(ToFloat(value) * scale);
+}
+
+void WorldToNetState(World& world, NetState& state)
+{
+	state.fields[NET_BALL_X] = Quantize(world.ball.xPos, 16);
+	state.fields[NET_BALL_Y] = Quantize(world.ball.yPos, 16);
+	state.fields[NET_BALL_VEL_X] = Quantize(world.ball.xVel, 1);
+	state.fields[NET_BALL_VEL_Y] = Quantize(world.ball.yVel, 1);
+	state.fields[NET_PADDLE_X] = Quantize(world.paddle.x, 16);
+	state.fields[NET_PADDLE2_X] = Quantize(world.paddle2.x, 16);
+	state.fields[NET_LIVES] = world.currLives;
+	state.fields[NET_SCORE] = world.score;
+
+	sf::Uint32 brickBits[4] = {};
+	for (int i = 0; i < MAX_BRICKS; i++)
+	{
+		if (world.bricks[i].IsAlive())
+		{
+			brickBits[i / 32] |= 1u << (i % 32);
+		}
+	}
+	for (int i = 0; i < 4; i++)
+	{
+		state.fields[NET_BRICKS_0 + i] = (sf::Int32)brickBits[i];
+	}
+}
+
+void NetStateToWorld(const NetState& state, World& world)
+{
+	world.numPlayers = 2;
+	world.ball.xPos = Real(state.fields[NET_BALL_X] / 16.0f);
+	world.ball.yPos = Real(state.fields[NET_BALL_Y] / 16.0f);
+	world.ball.xVel = Real((float)state.fields[NET_BALL_VEL_X]);
+	world.ball.yVel = Real((float)state.fields[NET_BALL_VEL_Y]);
+	world.paddle.x = Real(state.fields[NET_PADDLE_X] / 16.0f);
+	world.paddle2.x = Real(state.fields[NET_PADDLE2_X] / 16.0f);
+	world.paddle.y = WORLD_HEIGHT - world.paddle.screenBottomOffset;
+	world.paddle2.y = world.paddle.y;
+	world.currLives = state.fields[NET_LIVES];
+	world.score = state.fields[NET_SCORE];
+
+	world.ResetBricks();
+	for (int i = 0; i < MAX_BRICKS; i++)
+	{
+		sf::Uint32 bits = (sf::Uint32)state.fields[NET_BRICKS_0 + i / 32];
+		if ((bits & (1u << (i % 32))) == 0)
+		{
+			world.bricks[i].TakeDamage();
+		}
+	}
+}
+
+// Sent with every snapshot, so the client can check it rebuilt exactly what the server had
+static sf::Uint16 HashNetState(const NetState& state)
+{
+	sf::Uint32 hash = 2166136261u;
+	for (int i = 0; i < NET_FIELD_COUNT; i++)
+	{
+		hash = (hash ^ (sf::Uint32)state.fields[i]) * 16777619u;
+	}
+	return (sf::Uint16)(hash ^ (hash >> 16));
+}
+
+// Writes one bit per field saying whether it's different from the baseline, then the fields which are
+static void WriteDelta(sf::Packet& packet, const NetState& baseline, const NetState& state)
+{
+	sf::Uint16 changed = 0;
+	for (int i = 0; i < NET_FIELD_COUNT; i++)
+	{
+		if (state.fields[i] != baseline.fields[i])
+		{
+			changed |= 1 << i;
+		}
+	}
+
+	packet << changed;
+	for (int i = 0; i < NET_FIELD_COUNT; i++)
+	{
+		if (changed & (1 << i))
+		{
+			if (netFieldIs32Bit[i])
+			{
+				packet << (sf::Int32)state.fields[i];
+			}
+			else
+			{
+				packet << (sf::Int16)state.fields[i];
+			}
+		}
+	}
+}
+
+// 'state' should already hold the baseline. Returns false if the packet was too short.
+static bool ReadDelta(sf::Packet& packet, NetState& state)
+{
+	sf::Uint16 changed;
+	if (!(packet >> changed))
+	{
+		return false;
+	}
+
+	for (int i = 0; i < NET_FIELD_COUNT; i++)
+	{
+		if (changed & (1 << i))
+		{
+			if (netFieldIs32Bit[i])
+			{
+				sf::Int32 value = 0;
+				packet >> value;
+				state.fields[i] = value;
+			}
+			else
+			{
+				sf::Int16 value = 0;
+				packet >> value;
+				state.fields[i] = value;
+			}
+		}
+	}
+
+	if (!packet)
+	{
+		return false;
+	}
+	return true;
+}
+
+/////////////////////////////////////////////////////////////////////////////
+// SERVER
+
+bool NetServer::Start(unsigned short port)
+{
+	if (!socket.Bind(port))
+	{
+		return false;
+	}
+
+	// The second paddle just sits still until someone joins as player 2
+	world.numPlayers = 2;
+	world.Init(false, 1);
+	return true;
+}
+
+void NetServer::Update(float elapsedSeconds)
+{
+	time += elapsedSeconds;
+	socket.Update(time);
+	ReceivePackets();
+
+	// Forget players we haven't heard from for a while
+	for (int i = 0; i < 2; i++)
+	{
+		if (clients[i].connected && time - clients[i].lastHeardTime > netTimeoutSeconds)
+		{
+			printf("Player %d left\n", i + 1);
+			clients[i].connected = false;
+		}
+	}
+
+	// Step the world at a fixed rate, whatever the frame rate is.
+	// If the server was stuck for a long time, don't try to catch up all at once.
+	tickTimer += elapsedSeconds;
+	if (tickTimer > 0.25f)
+	{
+		tickTimer = 0.25f;
+	}
+	while (tickTimer >= netTickSeconds)
+	{
+		tickTimer -= netTickSeconds;
+		Tick();
+	}
+}
+
+void NetServer::ReceivePackets()
+{
+	sf::Packet packet;
+	sf::IpAddress address;
+	unsigned short port;
+	while (socket.Receive(packet, address, port))
+	{
+		sf::Uint8 type;
+		sf::Uint32 newestInput;
+		sf::Uint32 ackedTick;
+		sf::Uint8 count;
+		if (!(packet >> type >> newestInput >> ackedTick >> count) || type != NET_PACKET_INPUT)
+		{
+			continue;
+		}
+
+		// Find who sent it. New players take the first free slot.
+		int index = -1;
+		for (int i = 0; i < 2; i++)
+		{
+			if (clients[i].connected && clients[i].address == address && clients[i].port == port)
+			{
+				index = i;
+			}
+		}
+		for (int i = 0; i < 2 && index < 0; i++)
+		{
+			if (!clients[i].connected)
+			{
+				index = i;
+				clients[i] = Client();
+				clients[i].connected = true;
+				clients[i].address = address;
+				clients[i].port = port;
+				printf("Player %d joined from %s:%d\n", i + 1, address.toString().c_str(), (int)port);
+			}
+		}
+		if (index < 0)
+		{
+			continue;	// The game is full
+		}
+
+		Client& client = clients[index];
+		client.lastHeardTime = time;
+		if (ackedTick > client.ackedTick)
+		{
+			client.ackedTick = ackedTick;
+		}
+
+		// The packet holds the newest input first, then the ones before it
+		for (sf::Uint32 k = 0; k < count && k < NET_INPUTS_PER_PACKET && k < newestInput; k++)
+		{
+			sf::Int8 direction;
+			if (!(packet >> direction))
+			{
+				break;
+			}
+			sf::Uint32 inputNumber = newestInput - k;
+			if (inputNumber > client.lastInputApplied)
+			{
+				client.inputs[inputNumber % NET_INPUT_HISTORY] = direction;
+			}
+		}
+		if (newestInput > client.newestInput)
+		{
+			client.newestInput = newestInput;
+		}
+	}
+}
+
+void NetServer::Tick()
+{
+	for (int i = 0; i < 2; i++)
+	{
+		Client& client = clients[i];
+		if (!client.connected)
+		{
+			client.paddleDirection = 0;
+			continue;
+		}
+
+		// Use each player's inputs in order, one per tick. If the next one hasn't arrived yet,
+		// keep doing what they did last time. If too many have piled up, skip the oldest.
+		if (client.newestInput > client.lastInputApplied)
+		{
+			if (client.newestInput - client.lastInputApplied > NET_INPUTS_PER_PACKET)
+			{
+				client.lastInputApplied = client.newestInput - NET_INPUTS_PER_PACKET;
+			}
+			client.lastInputApplied++;
+			int direction = client.inputs[client.lastInputApplied % NET_INPUT_HISTORY];
+			client.paddleDirection = direction < 0 ? -1 : (direction > 0 ? 1 : 0);
+		}
+
+		// Earn some more bytes to send. A few snapshots' worth can be saved up, but no more.
+		client.sendBudget += (float)maxBytesPerSecond / NET_TICKS_PER_SECOND;
+		if (client.sendBudget > maxBytesPerSecond / 4.0f)
+		{
+			client.sendBudget = maxBytesPerSecond / 4.0f;
+		}
+	}
+
+	world.Step(Real(netTickSeconds), clients[0].paddleDirection, false, clients[1].paddleDirection);
+	tick++;
+	if (world.brickHitThisStep >= 0)
+	{
+		bricksBroken++;
+	}
+
+	// Start a new game a few seconds after the last one ended
+	if (!world.IsPlayerAlive())
+	{
+		gameOverTicks++;
+		if (gameOverTicks >= 3 * NET_TICKS_PER_SECOND)
+		{
+			world.Restart();
+			world.score = 0;
+			gameOverTicks = 0;
+		}
+	}
+
+	if (tick % NET_SNAPSHOT_INTERVAL == 0)
+	{
+		for (int i = 0; i < 2; i++)
+		{
+			if (clients[i].connected)
+			{
+				SendSnapshot(i);
+			}
+		}
+	}
+}
+
+void NetServer::SendSnapshot(int playerIndex)
+{
+	Client& client = clients[playerIndex];
+
+	NetState state;
+	WorldToNetState(world, state);
+	state.tick = tick;
+
+	// Only send what changed since the newest snapshot the client has.
+	// If we don't know of one, compare against all zeros, which sends everything.
+	NetState baseline;
+	const NetState& acked = client.sent[client.ackedTick % NET_HISTORY];
+	if (client.ackedTick != 0 && acked.tick == client.ackedTick)
+	{
+		baseline = acked;
+	}
+
+	sf::Packet packet;
+	packet << (sf::Uint8)NET_PACKET_SNAPSHOT << (sf::Uint8)playerIndex << state.tick << baseline.tick
+		<< client.lastInputApplied << HashNetState(state);
+	WriteDelta(packet, baseline, state);
+
+	// Skip this snapshot if it would go over the bandwidth limit. The client will
+	// just interpolate over a longer gap.
+	int size = (int)packet.getDataSize() + UDP_HEADER_BYTES;
+	if (size > client.sendBudget)
+	{
+		client.snapshotsSkipped++;
+		return;
+	}
+	client.sendBudget -= size;
+
+	socket.Send(packet, client.address, client.port, time);
+	client.sent[state.tick % NET_HISTORY] = state;
+	client.bytesSent += size;
+	client.snapshotsSent++;
+	if (baseline.tick == 0)
+	{
+		client.fullSnapshotsSent++;
+	}
+}
+
+sf::Uint32 NetServer::GetTick()
+{
+	return tick;
+}
+
+float NetServer::GetTime()
+{
+	return time;
+}
+
+/////////////////////////////////////////////////////////////////////////////
+// CLIENT
+
+// The ball and paddles jump back to the middle when a life is lost, or when the bricks come back
+static bool BallWasReset(const NetState& before, const NetState& after)
+{
+	if (before.fields[NET_LIVES] != after.fields[NET_LIVES])
+	{
+		return true;
+	}
+	for (int i = NET_BRICKS_0; i <= NET_BRICKS_3; i++)
+	{
+		if ((after.fields[i] & ~before.fields[i]) != 0)
+		{
+			return true;
+		}
+	}
+	return false;
+}
+
+// Moves a paddle the same way World::Step does
+static float MovePaddle(float x, int direction, bool playerAlive)
+{
+	static const Paddle paddle = Paddle();
+	if (playerAlive)
+	{
+		x += direction * ToFloat(paddle.speed) * netTickSeconds;
+	}
+	if (x < 0)
+	{
+		x = 0;
+	}
+	if (x > WORLD_WIDTH - ToFloat(paddle.width))
+	{
+		x = WORLD_WIDTH - ToFloat(paddle.width);
+	}
+	return x;
+}
+
+bool NetClient::Connect(const sf::IpAddress& address, unsigned short port)
+{
+	serverAddress = address;
+	serverPort = port;
+	return socket.Bind(sf::Socket::AnyPort);
+}
+
+void NetClient::Update(float elapsedSeconds, int paddleDirection)
+{
+	time += elapsedSeconds;
+	socket.Update(time);
+	ReceivePackets();
+
+	// The server keeps ticking between snapshots
+	serverTick += elapsedSeconds * NET_TICKS_PER_SECOND;
+
+	// Inputs are sent at the same fixed rate the server steps at
+	tickTimer += elapsedSeconds;
+	if (tickTimer > 0.25f)
+	{
+		tickTimer = 0.25f;
+	}
+	while (tickTimer >= netTickSeconds)
+	{
+		tickTimer -= netTickSeconds;
+		Tick(paddleDirection);
+	}
+}
+
+void NetClient::Tick(int paddleDirection)
+{
+	inputNumber++;
+	inputs[inputNumber % NET_INPUT_HISTORY] = (sf::Int8)paddleDirection;
+
+	// Move our paddle straight away, rather than waiting to hear back from the server
+	if (HasState())
+	{
+		const NetState& newest = received[newestTick % NET_HISTORY];
+		predictedPaddleX = MovePaddle(predictedPaddleX, paddleDirection, newest.fields[NET_LIVES] > 0);
+	}
+
+	// Send the last few inputs, in case some of the earlier packets were lost
+	sf::Uint8 count = (sf::Uint8)(inputNumber < NET_INPUTS_PER_PACKET ? inputNumber : NET_INPUTS_PER_PACKET);
+	sf::Packet packet;
+	packet << (sf::Uint8)NET_PACKET_INPUT << inputNumber << newestTick << count;
+	for (sf::Uint32 k = 0; k < count; k++)
+	{
+		packet << inputs[(inputNumber - k) % NET_INPUT_HISTORY];
+	}
+	socket.Send(packet, serverAddress, serverPort, time);
+}
+
+void NetClient::ReceivePackets()
+{
+	sf::Packet packet;
+	sf::IpAddress address;
+	unsigned short port;
+	while (socket.Receive(packet, address, port))
+	{
+		bytesReceived += packet.getDataSize() + UDP_HEADER_BYTES;
+
+		sf::Uint8 type;
+		sf::Uint8 index;
+		sf::Uint32 tick;
+		sf::Uint32 baselineTick;
+		sf::Uint32 lastInputApplied;
+		sf::Uint16 hash;
+		if (!(packet >> type >> index >> tick >> baselineTick >> lastInputApplied >> hash) || type != NET_PACKET_SNAPSHOT)
+		{
+			continue;
+		}
+
+		// Start from the snapshot the delta was made against. If we no longer have it, we can't use this one.
+		NetState state;
+		if (baselineTick != 0)
+		{
+			const NetState& baseline = received[baselineTick % NET_HISTORY];
+			if (baseline.tick != baselineTick)
+			{
+				continue;
+			}
+			state = baseline;
+		}
+		if (!ReadDelta(packet, state) || HashNetState(state) != hash)
+		{
+			badSnapshots++;
+			continue;
+		}
+		state.tick = tick;
+
+		snapshotsReceived++;
+		if (baselineTick == 0)
+		{
+			fullSnapshotsReceived++;
+		}
+
+		// Packets can arrive in the wrong order, so a late one may still fill in a gap
+		NetState& slot = received[tick % NET_HISTORY];
+		if (tick > slot.tick)
+		{
+			slot = state;
+		}
+
+		if (tick > newestTick)
+		{
+			// The paddle jumping back to the middle isn't a wrong prediction, so don't count it as one
+			bool firstSnapshot = newestTick == 0;
+			bool paddlesWereReset = firstSnapshot || BallWasReset(received[newestTick % NET_HISTORY], state);
+			newestTick = tick;
+			playerIndex = index;
+
+			// The snapshot took a while to get here, so the server has moved on since. Our guess at the
+			// server's tick counts up from the newest snapshot, which keeps it a little behind.
+			if (firstSnapshot || serverTick < tick)
+			{
+				serverTick = (float)tick;
+			}
+
+			Reconcile(state, lastInputApplied, !paddlesWereReset);
+		}
+	}
+}
+
+// Starts from where the server says our paddle was, and re-applies every input it hasn't seen yet.
+// If our prediction was right, the paddle ends up exactly where it already is.
+void NetClient::Reconcile(const NetState& state, sf::Uint32 lastInputApplied, bool countCorrection)
+{
+	int field = playerIndex == 0 ? NET_PADDLE_X : NET_PADDLE2_X;
+	float x = state.fields[field] / 16.0f;
+	bool playerAlive = state.fields[NET_LIVES] > 0;
+
+	sf::Uint32 firstInput = lastInputApplied + 1;
+	if (inputNumber - lastInputApplied >= NET_INPUT_HISTORY)
+	{
+		firstInput = inputNumber - NET_INPUT_HISTORY + 1;
+	}
+	for (sf::Uint32 n = firstInput; n <= inputNumber; n++)
+	{
+		x = MovePaddle(x, inputs[n % NET_INPUT_HISTORY], playerAlive);
+	}
+
+	// Positions are sent in 1/16ths of a pixel, so anything smaller than that doesn't count
+	float correction = std::abs(x - predictedPaddleX);
+	if (countCorrection && correction > 1.0f / 16)
+	{
+		predictionErrors++;
+		totalCorrection += correction;
+		if (correction > maxCorrection)
+		{
+			maxCorrection = correction;
+		}
+	}
+	predictedPaddleX = x;
+}
+
+bool NetClient::HasState()
+{
+	return newestTick != 0;
+}
+
+int NetClient::GetPlayerIndex()
+{
+	return playerIndex;
+}
+
+float NetClient::GetDisplayTick()
+{
+	return serverTick - NET_INTERPOLATION_DELAY;
+}
+
+float NetClient::GetTime()
+{
+	return time;
+}
+
+void NetClient::GetDisplayWorld(World& world)
+{
+	if (!HasState())
+	{
+		return;
+	}
+
+	// Find the snapshots just before and just after the tick we're showing
+	float displayTick = GetDisplayTick();
+	const NetState* before = NULL;
+	const NetState* after = NULL;
+	for (int i = 0; i < NET_HISTORY; i++)
+	{
+		const NetState& state = received[i];
+		if (state.tick == 0)
+		{
+			continue;
+		}
+		if (state.tick <= displayTick && (before == NULL || state.tick > before->tick))
+		{
+			before = &state;
+		}
+		if (state.tick > displayTick && (after == NULL || state.tick < after->tick))
+		{
+			after = &state;
+		}
+	}
+
+	// Bricks, lives and score come from the earlier snapshot. Things which move smoothly are
+	// blended between the two. If we've run past the newest snapshot, just show that.
+	NetState state;
+	if (before == NULL)
+	{
+		state = *after;
+	}
+	else
+	{
+		state = *before;
+		if (after != NULL)
+		{
+			float t = (displayTick - before->tick) / (after->tick - before->tick);
+			const int smoothFields[] = { NET_BALL_X, NET_BALL_Y, NET_PADDLE_X, NET_PADDLE2_X };
+			int firstField = BallWasReset(*before, *after) ? 2 : 0;
+			for (int i = firstField; i < 4; i++)
+			{
+				int field = smoothFields[i];
+				state.fields[field] = (sf::Int32)lroundf(before->fields[field] + (after->fields[field] - before->fields[field]) * t);
+			}
+		}
+	}
+	NetStateToWorld(state, world);
+
+	// Snapshots only say which bricks are standing, so compare with the last one shown to find the
+	// bricks which broke. The last brick of a round never shows up broken, because the server puts
+	// every brick back in the same tick, but the score still counts it. So if the bricks came back
+	// and the score went up, the ones which were left have broken too.
+	if (state.tick > shownTick)
+	{
+		bool bricksCameBack = false;
+		for (int i = 0; i < 4; i++)
+		{
+			if (((sf::Uint32)state.fields[NET_BRICKS_0 + i] & ~shownBricks[i]) != 0)
+			{
+				bricksCameBack = true;
+			}
+		}
+		bool roundCleared = shownTick != 0 && bricksCameBack && state.fields[NET_SCORE] > shownScore;
+		for (int i = 0; i < 4; i++)
+		{
+			sf::Uint32 standing = (sf::Uint32)state.fields[NET_BRICKS_0 + i];
+			brokenBricks[i] |= roundCleared ? shownBricks[i] : (shownBricks[i] & ~standing);
+			shownBricks[i] = standing;
+		}
+		shownTick = state.tick;
+		shownScore = state.fields[NET_SCORE];
+	}
+
+	// A snapshot can have more than one new broken brick, but the game only takes one at a time,
+	// so the rest wait for the next frames
+	world.brickHitThisStep = -1;
+	for (int i = 0; i < MAX_BRICKS; i++)
+	{
+		sf::Uint32 bit = 1u << (i % 32);
+		if (brokenBricks[i / 32] & bit)
+		{
+			brokenBricks[i / 32] &= ~bit;
+			world.brickHitThisStep = i;
+			bricksBroken++;
+			break;
+		}
+	}
+
+	// Our own paddle is wherever we predicted it to be
+	if (playerIndex == 0)
+	{
+		world.paddle.x = Real(predictedPaddleX);
+	}
+	else
+	{
+		world.paddle2.x = Real(predictedPaddleX);
+	}
+}
+
+/////////////////////////////////////////////////////////////////////////////
+// COMMAND LINE MODES
+
+void RunNetServer(unsigned short port, float latency, float lossChance)
+{
+	NetServer server;
+	server.socket.latency = latency;
+	server.socket.jitter = latency / 4;
+	server.socket.lossChance = lossChance;
+	if (!server.Start(port))
+	{
+		printf("Couldn't open port %d\n", (int)port);
+		return;
+	}
+	printf("Server running on port %d\n", (int)server.socket.GetLocalPort());
+
+	// Print each player's bandwidth once a second
+	sf::Clock clock;
+	float nextReportTime = 1;
+	long long lastBytesSent[2] = {};
+	while (true)
+	{
+		server.Update(clock.restart().asSeconds());
+
+		if (server.GetTime() >= nextReportTime)
+		{
+			nextReportTime += 1;
+			for (int i = 0; i < 2; i++)
+			{
+				NetServer::Client& client = server.clients[i];
+				if (client.connected)
+				{
+					printf("Player %d: %d bytes/s (limit %d), %d snapshots skipped\n", i + 1,
+						(int)(client.bytesSent - lastBytesSent[i]), server.maxBytesPerSecond, client.snapshotsSkipped);
+				}
+				lastBytesSent[i] = client.bytesSent;
+			}
+		}
+
+		sf::sleep(sf::milliseconds(1));
+	}
+}
+
+bool RunNetLoopback(float seconds, float latency, float lossChance)
+{
+	NetServer server;
+	NetClient clients[2];
+
+	server.socket.randomState = 1;
+	LaggySocket* sockets[3] = { &server.socket, &clients[0].socket, &clients[1].socket };
+	for (int i = 0; i < 3; i++)
+	{
+		sockets[i]->latency = latency;
+		sockets[i]->jitter = latency / 4;
+		sockets[i]->lossChance = lossChance;
+		sockets[i]->randomState = i + 1;
+	}
+
+	if (!server.Start(sf::Socket::AnyPort))
+	{
+		printf("Couldn't open a port for the server\n");
+		return false;
+	}
+	for (int c = 0; c < 2; c++)
+	{
+		if (!clients[c].Connect(sf::IpAddress::LocalHost, server.socket.GetLocalPort()))
+		{
+			printf("Couldn't open a port for client %d\n", c + 1);
+			return false;
+		}
+	}
+
+	// Time is simulated, so the test runs as fast as the computer can go.
+	// Packets still really go through the network, and the shim adds the latency and loss.
+	std::vector<float> serverBallX;
+	std::vector<float> serverBallY;
+	std::vector<int> serverBricksBroken;
+	World display;
+	double interpolationError = 0;
+	int interpolationSamples = 0;
+	int frames = (int)(seconds * NET_TICKS_PER_SECOND);
+	for (int frame = 0; frame < frames; frame++)
+	{
+		server.Update(netTickSeconds);
+
+		// Remember where the ball really was on every tick
+		serverBallX.resize(server.GetTick() + 1);
+		serverBallY.resize(server.GetTick() + 1);
+		serverBallX[server.GetTick()] = ToFloat(server.world.ball.xPos);
+		serverBallY[server.GetTick()] = ToFloat(server.world.ball.yPos);
+		serverBricksBroken.resize(server.GetTick() + 1);
+		serverBricksBroken[server.GetTick()] = server.bricksBroken;
+
+		for (int c = 0; c < 2; c++)
+		{
+			// Each client chases the ball it can see, aiming at slightly different spots
+			int direction = 0;
+			if (clients[c].HasState())
+			{
+				clients[c].GetDisplayWorld(display);
+				Paddle& myPaddle = clients[c].GetPlayerIndex() == 0 ? display.paddle : display.paddle2;
+				float target = ToFloat(display.ball.xPos) + (c == 0 ? -20.0f : 20.0f);
+				float middle = ToFloat(myPaddle.x) + ToFloat(myPaddle.width) / 2;
+				if (target < middle - 5)
+				{
+					direction = -1;
+				}
+				if (target > middle + 5)
+				{
+					direction = 1;
+				}
+
+				// Compare the ball being drawn with where the server had it at that time.
+				// Ticks where the ball was reset are left out.
+				float displayTick = clients[c].GetDisplayTick();
+				int tick = (int)displayTick;
+				if (tick >= 1 && tick + 1 < (int)serverBallX.size())
+				{
+					float t = displayTick - tick;
+					float x = serverBallX[tick] + (serverBallX[tick + 1] - serverBallX[tick]) * t;
+					float y = serverBallY[tick] + (serverBallY[tick + 1] - serverBallY[tick]) * t;
+					float jump = std::abs(serverBallX[tick + 1] - serverBallX[tick]) + std::abs(serverBallY[tick + 1] - serverBallY[tick]);
+					if (jump < 32)
+					{
+						interpolationError += std::hypot(ToFloat(display.ball.xPos) - x, ToFloat(display.ball.yPos) - y);
+						interpolationSamples++;
+					}
+				}
+			}
+			clients[c].Update(netTickSeconds, direction);
+		}
+	}
+
+	printf("Simulated %.0f seconds over loopback, %.0f ms latency each way, %.0f%% packet loss\n",
+		seconds, latency * 1000, lossChance * 100);
+	printf("Score %d, %d rounds cleared, %d lives lost\n", server.world.score, server.world.roundsCleared, server.world.livesLost);
+
+	bool passed = true;
+	for (int c = 0; c < 2; c++)
+	{
+		NetClient& client = clients[c];
+		int playerIndex = client.GetPlayerIndex();
+		if (playerIndex < 0)
+		{
+			printf("Client %d never received a snapshot\n", c + 1);
+			passed = false;
+			continue;
+		}
+		NetServer::Client& serverClient = server.clients[playerIndex];
+		float bytesPerSecond = serverClient.bytesSent / seconds;
+
+		printf("Player %d\n", playerIndex + 1);
+		printf("  Download:   %.0f bytes/s (limit %d), %d snapshots sent, %d full, %d skipped to stay under the limit\n",
+			bytesPerSecond, server.maxBytesPerSecond, serverClient.snapshotsSent, serverClient.fullSnapshotsSent, serverClient.snapshotsSkipped);
+		printf("  Upload:     %.0f bytes/s\n", client.socket.bytesSent / seconds);
+		printf("  Received:   %d snapshots, %d full, %d bad\n", client.snapshotsReceived, client.fullSnapshotsReceived, client.badSnapshots);
+		printf("  Prediction: %d corrections, average %.2f pixels, biggest %.2f pixels\n", client.predictionErrors,
+			client.predictionErrors > 0 ? client.totalCorrection / client.predictionErrors : 0.0f, client.maxCorrection);
+
+		// Every brick the server broke up to the tick being shown should have made particles. The snapshot
+		// being shown can be a little older than that tick (more so if packets were lost), so allow up to a
+		// second behind, but never more than the server broke.
+		int shownTick = std::min((int)client.GetDisplayTick(), (int)serverBricksBroken.size() - 1);
+		int expectedBricks = shownTick >= 0 ? serverBricksBroken[shownTick] : 0;
+		int secondBefore = shownTick - NET_TICKS_PER_SECOND;
+		int fewestBricks = secondBefore >= 0 ? serverBricksBroken[secondBefore] : 0;
+		printf("  Bricks:     %d broken on screen, %d by the server up to the tick shown\n", client.bricksBroken, expectedBricks);
+
+		if (client.badSnapshots > 0 || client.snapshotsReceived == 0 || bytesPerSecond > server.maxBytesPerSecond ||
+			client.bricksBroken > expectedBricks || client.bricksBroken < fewestBricks)
+		{
+			passed = false;
+		}
+	}
+	printf("Ball interpolation error: average %.2f pixels\n", interpolationSamples > 0 ? interpolationError / interpolationSamples : 0.0);
+
+	printf(passed ? "PASSED\n" : "FAILED\n");
+	return passed;
+}
@@ -0,0 +1,174 @@
+#pragma once
+#include <SFML\Network.hpp>
+#include "World.h"
+#include "NetShim.h"
+
+// Two player Breakout over the network.
+//
+// The server owns the only real World, and is the 'authority': clients only send which way
+// their paddle is moving, and the server decides what actually happens. 20 times a second the
+// server sends each client a snapshot of the world. To keep snapshots small, positions are
+// rounded to 1/16th of a pixel ('quantized'), and only the values which changed since a
+// snapshot the client said it received are sent ('delta compressed').
+//
+// Waiting for the server would make the client's own paddle feel laggy, so the client moves it
+// straight away ('prediction'), and corrects it when a snapshot says where the server put it.
+// Everything else is drawn a little in the past, smoothly moving between the two snapshots
+// either side of that time ('interpolation').
+
+const unsigned short NET_DEFAULT_PORT = 53000;
+const int NET_TICKS_PER_SECOND = 60;			// How often the server steps the world
+const int NET_SNAPSHOT_INTERVAL = 3;			// Ticks between snapshots, so 20 a second
+const int NET_INTERPOLATION_DELAY = 6;			// Ticks the client draws behind the newest snapshot
+const int NET_MAX_BYTES_PER_SECOND = 2000;		// Bandwidth limit for each client, including headers
+const int NET_HISTORY = 64;						// Snapshots remembered, for delta compression
+const int NET_INPUT_HISTORY = 64;				// Inputs remembered, for prediction
+const int NET_INPUTS_PER_PACKET = 8;			// Each input is sent 8 times, in case packets are lost
+
+// The values a client needs to draw the world, each rounded to a whole number
+enum NetField
+{
+	NET_BALL_X,			// 1/16ths of a pixel
+	NET_BALL_Y,
+	NET_BALL_VEL_X,		// Pixels per second
+	NET_BALL_VEL_Y,
+	NET_PADDLE_X,
+	NET_PADDLE2_X,
+	NET_LIVES,
+	NET_SCORE,
+	NET_BRICKS_0,		// One bit per brick, 32 bricks per field
+	NET_BRICKS_1,
+	NET_BRICKS_2,
+	NET_BRICKS_3,
+	NET_FIELD_COUNT
+};
+
+struct NetState
+{
+	sf::Uint32 tick = 0;	// Which server tick this is from. 0 means 'no state'.
+	sf::Int32 fields[NET_FIELD_COUNT] = {};
+};
+
+void WorldToNetState(World& world, NetState& state);
+void NetStateToWorld(const NetState& state, World& world);
+
+// The server. It doesn't draw anything, so it can run without a window.
+class NetServer
+{
+public:
+	LaggySocket socket;
+	World world;
+	int maxBytesPerSecond = NET_MAX_BYTES_PER_SECOND;
+	int bricksBroken = 0;			// Statistics, to check the clients saw them all
+
+	struct Client
+	{
+		bool connected = false;
+		sf::IpAddress address;
+		unsigned short port = 0;
+		float lastHeardTime = 0;
+
+		sf::Int8 inputs[NET_INPUT_HISTORY] = {};	// Paddle directions, by input number
+		sf::Uint32 newestInput = 0;			// Newest input number received
+		sf::Uint32 lastInputApplied = 0;	// Newest input number used to move the paddle
+		int paddleDirection = 0;
+
+		sf::Uint32 ackedTick = 0;			// Newest snapshot the client says it has
+		NetState sent[NET_HISTORY];			// Snapshots sent, so deltas can be made against them
+		float sendBudget = 0;				// Bytes which can be sent right now without going over the limit
+
+		// Statistics
+		long long bytesSent = 0;
+		int snapshotsSent = 0;
+		int fullSnapshotsSent = 0;			// Sent without a delta, because there was nothing to compare to
+		int snapshotsSkipped = 0;			// Not sent, to stay under the bandwidth limit
+	};
+	Client clients[2];
+
+	bool Start(unsigned short port);
+
+	// Handles packets, and steps the world once for every tick which fits in the elapsed time
+	void Update(float elapsedSeconds);
+
+	sf::Uint32 GetTick();
+	float GetTime();
+
+private:
+	float time = 0;
+	float tickTimer = 0;
+	sf::Uint32 tick = 0;
+	int gameOverTicks = 0;
+
+	void ReceivePackets();
+	void Tick();
+	void SendSnapshot(int playerIndex);
+};
+
+// A player's connection to the server
+class NetClient
+{
+public:
+	LaggySocket socket;
+
+	// Statistics
+	long long bytesReceived = 0;
+	int snapshotsReceived = 0;
+	int fullSnapshotsReceived = 0;
+	int badSnapshots = 0;			// Didn't decode to what the server sent. Should always be 0.
+	int predictionErrors = 0;		// Snapshots which moved the predicted paddle
+	float totalCorrection = 0;		// Pixels
+	float maxCorrection = 0;
+	int bricksBroken = 0;			// Handed to the game by GetDisplayWorld, for particles
+
+	bool Connect(const sf::IpAddress& address, unsigned short port);
+
+	// Sends the player's input, reads snapshots and moves the predicted paddle.
+	// paddleDirection is -1, 0 or 1, like World::Step.
+	void Update(float elapsedSeconds, int paddleDirection);
+
+	// True once the first snapshot has arrived
+	bool HasState();
+	int GetPlayerIndex();
+
+	// Fills in a world with what should be drawn right now. Like World::Step, it sets
+	// brickHitThisStep when a brick has broken since last time.
+	void GetDisplayWorld(World& world);
+
+	// The (fractional) server tick GetDisplayWorld is showing
+	float GetDisplayTick();
+
+	float GetTime();
+
+private:
+	sf::IpAddress serverAddress;
+	unsigned short serverPort = 0;
+	float time = 0;
+	float tickTimer = 0;
+
+	sf::Int8 inputs[NET_INPUT_HISTORY] = {};
+	sf::Uint32 inputNumber = 0;		// Number of the newest input
+
+	NetState received[NET_HISTORY];	// By tick
+	sf::Uint32 newestTick = 0;
+	float serverTick = 0;			// Guess at the server's current tick
+	int playerIndex = -1;
+	float predictedPaddleX = 0;
+
+	// The bricks standing in the last snapshot GetDisplayWorld showed, to spot which ones broke
+	sf::Uint32 shownTick = 0;
+	sf::Uint32 shownBricks[4] = {};
+	sf::Int32 shownScore = 0;
+	sf::Uint32 brokenBricks[4] = {};	// Broken, but not handed to the game yet
+
+	void ReceivePackets();
+	void Tick(int paddleDirection);
+	void Reconcile(const NetState& state, sf::Uint32 lastInputApplied, bool countCorrection);
+};
+
+// "Game.exe -server [port] [latencyMs] [lossPercent]" runs a server until the program is closed
+void RunNetServer(unsigned short port, float latency, float lossChance);
+
+// "Game.exe -netloopback [seconds] [latencyMs] [lossPercent]" runs a server and two computer controlled
+// clients in one program, over loopback, and checks that the clients saw what the server sent.
+// Returns true if everything worked.
+bool RunNetLoopback(float seconds, float latency, float lossChance);
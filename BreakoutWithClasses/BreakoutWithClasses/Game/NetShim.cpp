@@ -0,0 +1,72 @@
+#include "NetShim.h"
+
+bool LaggySocket::Bind(unsigned short port)
+{
+	// Non-blocking means Receive returns straight away when nothing has arrived,
+	// instead of freezing the game until something does
+	socket.setBlocking(false);
+	return socket.bind(port) == sf::Socket::Done;
+}
+
+unsigned short LaggySocket::GetLocalPort()
+{
+	return socket.getLocalPort();
+}
+
+void LaggySocket::Send(const sf::Packet& packet, const sf::IpAddress& address, unsigned short port, float now)
+{
+	packetsSent++;
+	bytesSent += packet.getDataSize() + UDP_HEADER_BYTES;
+
+	if (RandomFloat() < lossChance)
+	{
+		packetsLost++;
+		return;
+	}
+
+	if (latency <= 0 && jitter <= 0)
+	{
+		socket.send(packet.getData(), packet.getDataSize(), address, port);
+		return;
+	}
+
+	// Keep a copy of the bytes until it's time to send them
+	DelayedPacket delayedPacket;
+	const char* data = (const char*)packet.getData();
+	delayedPacket.data.assign(data, data + packet.getDataSize());
+	delayedPacket.address = address;
+	delayedPacket.port = port;
+	delayedPacket.sendTime = now + latency + RandomFloat() * jitter;
+	delayed.push_back(delayedPacket);
+}
+
+bool LaggySocket::Receive(sf::Packet& packet, sf::IpAddress& address, unsigned short& port)
+{
+	return socket.receive(packet, address, port) == sf::Socket::Done;
+}
+
+void LaggySocket::Update(float now)
+{
+	// Packets are only ever added to the end, so without jitter they stay in the order they were sent
+	int i = 0;
+	while (i < (int)delayed.size())
+	{
+		DelayedPacket& delayedPacket = delayed[i];
+		if (delayedPacket.sendTime <= now)
+		{
+			socket.send(delayedPacket.data.data(), delayedPacket.data.size(), delayedPacket.address, delayedPacket.port);
+			delayed.erase(delayed.begin() + i);
+		}
+		else
+		{
+			i++;
+		}
+	}
+}
+
+float LaggySocket::RandomFloat()
+{
+	// A simple 'linear congruential' random number generator, using the top 24 bits
+	randomState = randomState * 1664525u + 1013904223u;
+	return (randomState >> 8) / 16777216.0f;
+}
@@ -0,0 +1,52 @@
+#pragma once
+#include <vector>
+#include <SFML\Network.hpp>
+
+// Every UDP packet also carries 28 bytes of IP and UDP headers, which count towards bandwidth
+const int UDP_HEADER_BYTES = 28;
+
+// A non-blocking UdpSocket which can pretend to be a bad internet connection, so networking can be
+// tested on one computer over loopback (127.0.0.1).
+// Sent packets are held back for 'latency' seconds, plus a random extra of up to 'jitter' seconds
+// (which can make them arrive in a different order), and some are thrown away on purpose.
+// With everything left at 0 it behaves just like a normal sf::UdpSocket.
+class LaggySocket
+{
+public:
+	float latency = 0;		// Seconds
+	float jitter = 0;		// Seconds
+	float lossChance = 0;	// 0 never loses packets, 1 loses all of them
+	unsigned int randomState = 1;	// Change this to lose a different set of packets
+
+	// Statistics
+	int packetsSent = 0;
+	int packetsLost = 0;		// Thrown away on purpose
+	long long bytesSent = 0;	// Including UDP_HEADER_BYTES per packet
+
+	// Opens the socket. Pass sf::Socket::AnyPort to let the computer pick a free port.
+	bool Bind(unsigned short port);
+	unsigned short GetLocalPort();
+
+	// 'now' is the time in seconds, from whichever clock the caller is using
+	void Send(const sf::Packet& packet, const sf::IpAddress& address, unsigned short port, float now);
+
+	// Returns false when there are no packets waiting
+	bool Receive(sf::Packet& packet, sf::IpAddress& address, unsigned short& port);
+
+	// Sends any held back packets whose time has come. Call this often.
+	void Update(float now);
+
+private:
+	struct DelayedPacket
+	{
+		std::vector<char> data;
+		sf::IpAddress address;
+		unsigned short port;
+		float sendTime;
+	};
+
+	sf::UdpSocket socket;
+	std::vector<DelayedPacket> delayed;
+
+	float RandomFloat();	// Between 0 and 1
+};
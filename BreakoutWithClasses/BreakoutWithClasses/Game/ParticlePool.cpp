@@ -0,0 +1,175 @@
+#include <SFML\System\Clock.hpp>
+#include <cmath>
+#include <emmintrin.h>
+#include "Main.h"
+#include "Helpers.h"
+#include "ParticlePool.h"
+
+const float particleSize = 2;		// Width and height in pixels
+const float particleGravity = 400;	// Pixels per second per second
+
+ParticlePool::ParticlePool(int capacity)
+{
+	this->capacity = capacity;
+
+	// Allocate everything now, so the game never has to allocate memory while it's running
+	x.resize(capacity);
+	y.resize(capacity);
+	velX.resize(capacity);
+	velY.resize(capacity);
+	life.resize(capacity);
+	fadeSpeed.resize(capacity);
+	color.resize(capacity);
+	vertices.resize(capacity * 4);
+}
+
+void ParticlePool::Emit(float left, float top, float width, float height, int count, float speed, float lifeSeconds, sf::Color particleColor)
+{
+	for (int n = 0; n < count; n++)
+	{
+		if (liveCount >= capacity)
+		{
+			droppedCount += count - n;
+			return;
+		}
+
+		// Start somewhere inside the rectangle, flying off in a random direction
+		int i = liveCount;
+		x[i] = left + RandomFloat() * width;
+		y[i] = top + RandomFloat() * height;
+		float angle = RandomFloat() * 6.2831853f;
+		float particleSpeed = speed * (0.25f + RandomFloat());
+		velX[i] = cosf(angle) * particleSpeed;
+		velY[i] = sinf(angle) * particleSpeed;
+		life[i] = 1;
+		fadeSpeed[i] = 1.0f / (lifeSeconds * (0.5f + RandomFloat()));
+		color[i] = particleColor;
+		liveCount++;
+	}
+}
+
+void ParticlePool::Update(float elapsedSeconds)
+{
+	// Move and fade four particles at a time
+	const __m128 dt = _mm_set1_ps(elapsedSeconds);
+	const __m128 gravity = _mm_set1_ps(particleGravity * elapsedSeconds);
+	int i = 0;
+	for (; i + 4 <= liveCount; i += 4)
+	{
+		__m128 vx = _mm_loadu_ps(&velX[i]);
+		__m128 vy = _mm_loadu_ps(&velY[i]);
+		_mm_storeu_ps(&x[i], _mm_add_ps(_mm_loadu_ps(&x[i]), _mm_mul_ps(vx, dt)));
+		_mm_storeu_ps(&y[i], _mm_add_ps(_mm_loadu_ps(&y[i]), _mm_mul_ps(vy, dt)));
+		_mm_storeu_ps(&velY[i], _mm_add_ps(vy, gravity));
+		_mm_storeu_ps(&life[i], _mm_sub_ps(_mm_loadu_ps(&life[i]), _mm_mul_ps(_mm_loadu_ps(&fadeSpeed[i]), dt)));
+	}
+
+	// Any left over particles are done one at a time
+	for (; i < liveCount; i++)
+	{
+		x[i] += velX[i] * elapsedSeconds;
+		y[i] += velY[i] * elapsedSeconds;
+		velY[i] += particleGravity * elapsedSeconds;
+		life[i] -= fadeSpeed[i] * elapsedSeconds;
+	}
+
+	// Remove dead particles, and write a square of 4 vertices for each living one
+	i = 0;
+	while (i < liveCount)
+	{
+		if (life[i] <= 0)
+		{
+			// The last particle is moved into this slot, so check the same slot again
+			Remove(i);
+			continue;
+		}
+
+		sf::Color fadedColor = color[i];
+		fadedColor.a = (sf::Uint8)(life[i] * 255);
+
+		sf::Vertex* corners = &vertices[i * 4];
+		corners[0].position = sf::Vector2f(x[i], y[i]);
+		corners[1].position = sf::Vector2f(x[i] + particleSize, y[i]);
+		corners[2].position = sf::Vector2f(x[i] + particleSize, y[i] + particleSize);
+		corners[3].position = sf::Vector2f(x[i], y[i] + particleSize);
+		corners[0].color = fadedColor;
+		corners[1].color = fadedColor;
+		corners[2].color = fadedColor;
+		corners[3].color = fadedColor;
+		i++;
+	}
+}
+
+void ParticlePool::Draw()
+{
+	if (liveCount > 0)
+	{
+		window->draw(&vertices[0], liveCount * 4, sf::Quads);
+	}
+}
+
+const sf::Vertex* ParticlePool::GetVertices()
+{
+	return vertices.data();
+}
+
+void ParticlePool::Clear()
+{
+	liveCount = 0;
+	droppedCount = 0;
+	randomState = 12345;
+}
+
+int ParticlePool::GetLiveCount()
+{
+	return liveCount;
+}
+
+int ParticlePool::GetCapacity()
+{
+	return capacity;
+}
+
+int ParticlePool::GetDroppedCount()
+{
+	return droppedCount;
+}
+
+void ParticlePool::Remove(int index)
+{
+	int last = liveCount - 1;
+	x[index] = x[last];
+	y[index] = y[last];
+	velX[index] = velX[last];
+	velY[index] = velY[last];
+	life[index] = life[last];
+	fadeSpeed[index] = fadeSpeed[last];
+	color[index] = color[last];
+	liveCount--;
+}
+
+float ParticlePool::RandomFloat()
+{
+	// A simple 'linear congruential' random number generator, using the top 24 bits
+	randomState = randomState * 1664525u + 1013904223u;
+	return (randomState >> 8) / 16777216.0f;
+}
+
+void RunParticleBenchmark(int numParticles, int numFrames)
+{
+	ParticlePool pool(numParticles);
+	const float elapsedSeconds = 1.0f / 60.0f;
+
+	// Keep the pool topped up, so it stays full the whole time
+	sf::Clock clock;
+	for (int frame = 0; frame < numFrames; frame++)
+	{
+		int missing = pool.GetCapacity() - pool.GetLiveCount();
+		pool.Emit(0, 0, 800, 600, missing, 200, 2.0f, sf::Color::Red);
+		pool.Update(elapsedSeconds);
+	}
+	float seconds = clock.getElapsedTime().asSeconds();
+
+	printf("%d particles, %d frames: %.3f ms per frame (%.1f%% of a 60 Hz frame)\n",
+		pool.GetLiveCount(), numFrames, seconds * 1000 / numFrames, seconds / numFrames / elapsedSeconds * 100);
+}
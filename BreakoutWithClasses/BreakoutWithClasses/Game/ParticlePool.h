@@ -0,0 +1,60 @@
+#pragma once
+#include <vector>
+#include <SFML\Graphics.hpp>
+
+// A fixed sized pool of tiny squares which fly out of bricks when they're hit.
+//
+// Every value has its own array (x positions, y positions, ...), and the live particles are
+// always packed at the start of the arrays. That lets Update move four particles per instruction.
+// When a particle dies, the last live particle is copied into its slot ('swap-remove'), so
+// nothing ever needs to be shuffled along. All memory is allocated in the constructor, and
+// every live particle is drawn with a single draw call.
+class ParticlePool
+{
+public:
+	ParticlePool(int capacity);
+
+	// Sprays count particles out of the rectangle (left, top, width, height).
+	// If the pool is full, the extra particles are dropped.
+	void Emit(float left, float top, float width, float height, int count, float speed, float lifeSeconds, sf::Color color);
+
+	// Moves the particles, fades them out, removes dead ones and builds the vertex array
+	void Update(float elapsedSeconds);
+
+	// Draws every live particle
+	void Draw();
+
+	// The corners of the live particles' squares, 4 per particle, as built by the last Update
+	const sf::Vertex* GetVertices();
+
+	// Removes every particle, and starts the random numbers again, as if the pool was new
+	void Clear();
+
+	int GetLiveCount();
+	int GetCapacity();
+	int GetDroppedCount();	// How many particles Emit has had to drop because the pool was full
+
+private:
+	int capacity;
+	int liveCount = 0;
+	int droppedCount = 0;
+
+	std::vector<float> x;
+	std::vector<float> y;
+	std::vector<float> velX;
+	std::vector<float> velY;
+	std::vector<float> life;		// Starts at 1 and counts down to 0
+	std::vector<float> fadeSpeed;	// How much life is lost per second
+	std::vector<sf::Color> color;
+
+	std::vector<sf::Vertex> vertices;	// 4 corners per particle
+
+	unsigned int randomState = 12345;
+
+	float RandomFloat();	// Between 0 and 1
+	void Remove(int index);
+};
+
+// Keeps numParticles particles alive for numFrames frames without drawing them,
+// and prints how long each Update took
+void RunParticleBenchmark(int numParticles, int numFrames);
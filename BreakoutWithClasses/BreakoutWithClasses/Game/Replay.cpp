@@ -0,0 +1,91 @@
+#include <cstring>
+#include <type_traits>
+#include "Replay.h"
+
+static_assert(sizeof(ReplayFrame) == 12, "ReplayFrame is written to files, so its size mustn't change");
+static_assert(std::is_trivially_copyable<ReplayFrame>::value, "ReplayFrame must be plain data");
+
+ReplayRecorder::~ReplayRecorder()
+{
+	Stop();
+}
+
+bool ReplayRecorder::Start(const std::string& path, unsigned int seed, bool autopilot)
+{
+	Stop();
+	file = fopen(path.c_str(), "wb");
+	if (file == NULL)
+	{
+		return false;
+	}
+
+	ReplayHeader header;
+	header.seed = seed;
+	header.autopilot = autopilot ? 1 : 0;
+	fwrite(&header, sizeof(header), 1, file);
+	frameCount = 0;
+	return true;
+}
+
+void ReplayRecorder::Record(const ReplayFrame& frame)
+{
+	if (file != NULL)
+	{
+		fwrite(&frame, sizeof(frame), 1, file);
+		frameCount++;
+	}
+}
+
+void ReplayRecorder::Stop()
+{
+	if (file != NULL)
+	{
+		fclose(file);
+		file = NULL;
+	}
+}
+
+bool ReplayRecorder::IsRecording()
+{
+	return file != NULL;
+}
+
+int ReplayRecorder::GetFrameCount()
+{
+	return frameCount;
+}
+
+bool LoadReplay(const std::string& path, ReplayHeader& header, std::vector<ReplayFrame>& frames, std::string& error)
+{
+	FILE* file = fopen(path.c_str(), "rb");
+	if (file == NULL)
+	{
+		error = "Can't open " + path;
+		return false;
+	}
+
+	ReplayHeader expected;
+	if (fread(&header, sizeof(header), 1, file) != 1 || memcmp(header.magic, expected.magic, 4) != 0)
+	{
+		error = path + " isn't a replay";
+		fclose(file);
+		return false;
+	}
+	if (header.version != expected.version)
+	{
+		error = path + " is from a different version of the game";
+		fclose(file);
+		return false;
+	}
+
+	// Read the frames in big blocks, rather than one at a time
+	frames.clear();
+	ReplayFrame block[4096];
+	size_t count;
+	while ((count = fread(block, sizeof(ReplayFrame), 4096, file)) > 0)
+	{
+		frames.insert(frames.end(), block, block + count);
+	}
+	fclose(file);
+	return true;
+}
@@ -0,0 +1,54 @@
+#pragma once
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+// Everything the player did during one frame. The game only ever changes because of these and the
+// frame's elapsedSeconds, so playing the same frames back into a fresh World gives exactly the same game.
+const uint8_t INPUT_REWIND = 1;		// R
+const uint8_t INPUT_SAVE = 2;		// F5
+const uint8_t INPUT_LOAD = 4;		// F9
+const uint8_t INPUT_RESTART = 8;	// P
+const uint8_t INPUT_MOUSE = 16;		// Mouse button (moves the ball, in debug mode)
+
+struct ReplayFrame
+{
+	float elapsedSeconds = 0;
+	int16_t mouseX = 0;
+	int16_t mouseY = 0;
+	int8_t paddleDirection = 0;		// -1, 0 or 1
+	uint8_t buttons = 0;			// INPUT_ bits
+	uint8_t unused[2] = { 0, 0 };	// So the size is the same with every compiler
+};
+
+// The start of a replay file. The frames follow, one after another.
+struct ReplayHeader
+{
+	char magic[4] = { 'B', 'R', 'P', 'L' };
+	uint32_t version = 1;
+	uint32_t seed = 1;			// Passed to World::Init
+	uint32_t autopilot = 0;		// Whether the autopilot (debug mode) was on
+};
+
+// Writes frames to a replay file as they're played.
+// The file is written through fwrite's buffer, so recording costs next to nothing per frame.
+class ReplayRecorder
+{
+public:
+	~ReplayRecorder();
+
+	bool Start(const std::string& path, unsigned int seed, bool autopilot);
+	void Record(const ReplayFrame& frame);
+	void Stop();
+
+	bool IsRecording();
+	int GetFrameCount();
+
+private:
+	FILE* file = NULL;
+	int frameCount = 0;
+};
+
+// Reads a whole replay file. Returns false, and sets error, if it can't.
+bool LoadReplay(const std::string& path, ReplayHeader& header, std::vector<ReplayFrame>& frames, std::string& error);
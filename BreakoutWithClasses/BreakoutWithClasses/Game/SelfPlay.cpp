@@ -0,0 +1,253 @@
+#include <SFML\System\Clock.hpp>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "Helpers.h"
+#include "SelfPlay.h"
+#include "World.h"
+#include "WorldLanes.h"
+
+// Every game is stepped by the same amount of time, so results don't depend on how fast the computer is
+const float fixedTimeStep = 1.0f / 60.0f;
+
+// How far from the middle of the paddle the autopilot aims (in pixels).
+// Half the paddle is 50 pixels, so a bit more than that means it sometimes misses and loses lives.
+const float selfPlayAutopilotError = 60;
+
+// Each thread has its own list of games to play.
+// When a thread runs out, it 'steals' games from the other end of another thread's list.
+struct WorkQueue
+{
+	std::mutex lock;
+	std::deque<int> games;
+};
+
+// Mixes the bits of a number, so seeds for neighbouring games look unrelated
+static unsigned int HashSeed(unsigned int x)
+{
+	x ^= x >> 16;
+	x *= 0x7feb352du;
+	x ^= x >> 15;
+	x *= 0x846ca68bu;
+	x ^= x >> 16;
+	return x;
+}
+
+// Plays one game from start to finish, adding the results to stats
+static void PlayGame(int gameIndex, unsigned int baseSeed, float maxSeconds, SelfPlayStats& stats)
+{
+	World world;
+	world.autopilotError = selfPlayAutopilotError;
+	world.Init(true, HashSeed(baseSeed + (unsigned int)gameIndex * 2654435761u));
+
+	int maxFrames = (int)(maxSeconds / fixedTimeStep);
+	int frame = 0;
+	unsigned int gameChecksum = 0;
+	while (world.IsPlayerAlive() && frame < maxFrames)
+	{
+		world.Step(fixedTimeStep, 0, true);
+		frame++;
+
+		// Chain every frame's checksum together, so a difference in any frame shows up
+		gameChecksum = HashSeed(gameChecksum ^ world.Checksum());
+	}
+
+	stats.gamesPlayed++;
+	stats.framesSimulated += frame;
+	stats.roundsCleared += world.roundsCleared;
+	stats.livesLost += world.livesLost;
+	stats.bricksDestroyed += world.score;
+	if (world.IsPlayerAlive())
+	{
+		stats.gamesTimedOut++;
+	}
+
+	// Adding is used to combine games, because it gives the same answer in any order
+	stats.checksum += HashSeed(gameChecksum + (unsigned int)gameIndex);
+}
+
+// Takes a game from this thread's own queue, or steals one from another thread.
+// Returns -1 when there are no games left anywhere.
+static int TakeGame(std::vector<WorkQueue>& queues, int threadIndex)
+{
+	// Take from the back of our own queue
+	{
+		WorkQueue& own = queues[threadIndex];
+		std::lock_guard<std::mutex> guard(own.lock);
+		if (!own.games.empty())
+		{
+			int game = own.games.back();
+			own.games.pop_back();
+			return game;
+		}
+	}
+
+	// Steal from the front of someone else's queue, starting with our neighbour
+	int numQueues = (int)queues.size();
+	for (int i = 1; i < numQueues; i++)
+	{
+		WorkQueue& victim = queues[(threadIndex + i) % numQueues];
+		std::lock_guard<std::mutex> guard(victim.lock);
+		if (!victim.games.empty())
+		{
+			int game = victim.games.front();
+			victim.games.pop_front();
+			return game;
+		}
+	}
+
+	// No work is ever added once the threads start, so if every queue is empty we're finished
+	return -1;
+}
+
+// Plays LANE_COUNT games at once with WorldLanes. Lane 'l' of batch 'b' plays the same game (with
+// the same seed) that PlayGame would play for game number b * LANE_COUNT + l.
+static void PlayLaneBatch(int batchIndex, unsigned int baseSeed, float maxSeconds, SelfPlayStats& stats)
+{
+	unsigned int seeds[LANE_COUNT];
+	float paddleDirections[LANE_COUNT];
+	for (int lane = 0; lane < LANE_COUNT; lane++)
+	{
+		unsigned int gameIndex = (unsigned int)(batchIndex * LANE_COUNT + lane);
+		seeds[lane] = HashSeed(baseSeed + gameIndex * 2654435761u);
+		paddleDirections[lane] = 0;
+	}
+
+	WorldLanes lanes;
+	lanes.autopilotError = selfPlayAutopilotError;
+	lanes.Init(true, seeds);
+
+	int maxFrames = (int)(maxSeconds / fixedTimeStep);
+	int frame = 0;
+	int aliveLanes = LANE_COUNT;
+	while (aliveLanes > 0 && frame < maxFrames)
+	{
+		lanes.Step(fixedTimeStep, paddleDirections, true);
+		frame++;
+
+		// Count a frame for every game that was still being played, like PlayGame does
+		stats.framesSimulated += aliveLanes;
+		aliveLanes = 0;
+		for (int lane = 0; lane < LANE_COUNT; lane++)
+		{
+			if (lanes.IsPlayerAlive(lane))
+			{
+				aliveLanes++;
+			}
+		}
+	}
+
+	for (int lane = 0; lane < LANE_COUNT; lane++)
+	{
+		stats.gamesPlayed++;
+		stats.roundsCleared += lanes.roundsCleared[lane];
+		stats.livesLost += lanes.livesLost[lane];
+		stats.bricksDestroyed += lanes.score[lane];
+		if (lanes.IsPlayerAlive(lane))
+		{
+			stats.gamesTimedOut++;
+		}
+	}
+}
+
+// Runs playItem for items 0 to numItems-1, spread across numThreads threads, and adds up the stats
+static SelfPlayStats RunOnAllCores(int numItems, int numThreads, unsigned int baseSeed, float maxSeconds,
+	void (*playItem)(int, unsigned int, float, SelfPlayStats&))
+{
+	if (numThreads <= 0)
+	{
+		numThreads = (int)std::thread::hardware_concurrency();
+		if (numThreads <= 0)
+		{
+			numThreads = 1;
+		}
+	}
+
+	// Deal the items out to the threads in equal sized blocks
+	std::vector<WorkQueue> queues(numThreads);
+	for (int i = 0; i < numItems; i++)
+	{
+		int owner = (int)((long long)i * numThreads / numItems);
+		queues[owner].games.push_back(i);
+	}
+
+	// Each thread keeps its own totals, so they don't have to share (and fight over) one set
+	std::vector<SelfPlayStats> threadStats(numThreads);
+
+	sf::Clock clock;
+
+	std::vector<std::thread> threads;
+	for (int t = 0; t < numThreads; t++)
+	{
+		threads.push_back(std::thread([&, t]()
+		{
+			int item;
+			while ((item = TakeGame(queues, t)) >= 0)
+			{
+				playItem(item, baseSeed, maxSeconds, threadStats[t]);
+			}
+		}));
+	}
+	for (std::thread& thread : threads)
+	{
+		thread.join();
+	}
+
+	// Add up the totals from every thread
+	SelfPlayStats total;
+	for (const SelfPlayStats& stats : threadStats)
+	{
+		total.gamesPlayed += stats.gamesPlayed;
+		total.framesSimulated += stats.framesSimulated;
+		total.roundsCleared += stats.roundsCleared;
+		total.livesLost += stats.livesLost;
+		total.bricksDestroyed += stats.bricksDestroyed;
+		total.gamesTimedOut += stats.gamesTimedOut;
+		total.checksum += stats.checksum;
+	}
+	total.wallSeconds = clock.getElapsedTime().asSeconds();
+	return total;
+}
+
+SelfPlayStats RunSelfPlay(int numGames, int numThreads, unsigned int baseSeed, float maxSeconds)
+{
+	return RunOnAllCores(numGames, numThreads, baseSeed, maxSeconds, PlayGame);
+}
+
+SelfPlayStats RunLaneSelfPlay(int numGames, int numThreads, unsigned int baseSeed, float maxSeconds)
+{
+	int numBatches = (numGames + LANE_COUNT - 1) / LANE_COUNT;
+	return RunOnAllCores(numBatches, numThreads, baseSeed, maxSeconds, PlayLaneBatch);
+}
+
+bool VerifySelfPlay(int numGames, unsigned int baseSeed, float maxSeconds)
+{
+	SelfPlayStats serial = RunSelfPlay(numGames, 1, baseSeed, maxSeconds);
+	SelfPlayStats parallel = RunSelfPlay(numGames, 0, baseSeed, maxSeconds);
+
+	printf("One thread:   checksum %08x, %.3f seconds\n", serial.checksum, serial.wallSeconds);
+	printf("Every core:   checksum %08x, %.3f seconds\n", parallel.checksum, parallel.wallSeconds);
+
+	bool same = serial.checksum == parallel.checksum &&
+		serial.framesSimulated == parallel.framesSimulated &&
+		serial.bricksDestroyed == parallel.bricksDestroyed;
+	printf(same ? "Results are identical\n" : "Results are DIFFERENT\n");
+	return same;
+}
+
+void PrintSelfPlayStats(const SelfPlayStats& stats)
+{
+	float seconds = stats.wallSeconds > 0 ? stats.wallSeconds : 1e-6f;
+	printf("Games played:     %d (%d timed out)\n", stats.gamesPlayed, stats.gamesTimedOut);
+	printf("Time taken:       %.3f seconds\n", stats.wallSeconds);
+	printf("Games per second: %.1f\n", stats.gamesPlayed / seconds);
+	printf("Frames simulated: %lld (%.0f per second)\n", stats.framesSimulated, stats.framesSimulated / seconds);
+	printf("Rounds cleared:   %lld\n", stats.roundsCleared);
+	printf("Lives lost:       %lld\n", stats.livesLost);
+	printf("Bricks destroyed: %lld\n", stats.bricksDestroyed);
+	if (stats.checksum != 0)
+	{
+		printf("Checksum:         %08x\n", stats.checksum);
+	}
+}
@@ -0,0 +1,35 @@
+#pragma once
+
+// Totals collected by the self-play runner
+struct SelfPlayStats
+{
+	int gamesPlayed = 0;
+	long long framesSimulated = 0;
+	long long roundsCleared = 0;
+	long long livesLost = 0;
+	long long bricksDestroyed = 0;
+	int gamesTimedOut = 0;		// Games stopped because they reached maxSeconds
+	float wallSeconds = 0;		// Real time taken to simulate everything
+
+	// Made from the World::Checksum of every frame of every game, and doesn't depend on which
+	// thread played which game. If two runs have the same checksum, they simulated exactly the same thing.
+	// (WorldLanes doesn't make checksums, so it is 0 for RunLaneSelfPlay.)
+	unsigned int checksum = 0;
+};
+
+// Simulates numGames games of Breakout without a window, using the autopilot to play.
+// The games are spread across numThreads threads (0 means one per CPU core).
+// Each game uses a fixed time step, and its own random seed made from baseSeed.
+// Games stop when the autopilot runs out of lives, or after maxSeconds of game time.
+SelfPlayStats RunSelfPlay(int numGames, int numThreads, unsigned int baseSeed, float maxSeconds);
+
+// Same as RunSelfPlay, but plays LANE_COUNT games at a time on each thread using WorldLanes (SIMD).
+// numGames is rounded up to a multiple of LANE_COUNT. Given the same seed, the totals match RunSelfPlay.
+SelfPlayStats RunLaneSelfPlay(int numGames, int numThreads, unsigned int baseSeed, float maxSeconds);
+
+// Plays the same games on one thread and then on every core, and checks the checksums match.
+// Returns true if they do.
+bool VerifySelfPlay(int numGames, unsigned int baseSeed, float maxSeconds);
+
+// Prints the stats, including games per second
+void PrintSelfPlayStats(const SelfPlayStats& stats);
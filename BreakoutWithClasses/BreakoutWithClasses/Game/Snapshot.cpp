@@ -0,0 +1,265 @@
+#include <SFML\System\Clock.hpp>
+#include <cstring>
+#include <type_traits>
+#include "Helpers.h"
+#include "Snapshot.h"
+
+static_assert(std::is_trivially_copyable<WorldSnapshot>::value, "WorldSnapshot must be plain data");
+static_assert(sizeof(WorldSnapshot) % 4 == 0, "WorldSnapshot must be a whole number of words");
+static_assert(SNAPSHOT_WORDS <= 32, "The changed-words mask only has 32 bits");
+
+// Most frames only change a few words, so this is a good guess at the average delta size.
+// The ring is sized from it, which is why it can hold about maxFrames frames.
+const int TYPICAL_DELTA_BYTES = 24;
+
+void SaveSnapshot(World& world, WorldSnapshot& snapshot)
+{
+	snapshot.ballX = world.ball.xPos;
+	snapshot.ballY = world.ball.yPos;
+	snapshot.ballVelX = world.ball.xVel;
+	snapshot.ballVelY = world.ball.yVel;
+	snapshot.ballSpeedX = world.ball.speedX;
+	snapshot.ballSpeedY = world.ball.speedY;
+	snapshot.paddleX = world.paddle.x;
+	snapshot.paddleY = world.paddle.y;
+	snapshot.paddle2X = world.paddle2.x;
+	snapshot.autopilotError = world.autopilotError;
+	snapshot.autopilotOffset = world.autopilotOffset;
+	snapshot.numPlayers = world.numPlayers;
+	snapshot.currLives = world.currLives;
+	snapshot.score = world.score;
+	snapshot.roundsCleared = world.roundsCleared;
+	snapshot.livesLost = world.livesLost;
+	snapshot.randomState = world.randomState;
+
+	memset(snapshot.brickBits, 0, sizeof(snapshot.brickBits));
+	for (int i = 0; i < MAX_BRICKS; i++)
+	{
+		if (world.bricks[i].IsAlive())
+		{
+			snapshot.brickBits[i / 32] |= 1u << (i % 32);
+		}
+	}
+}
+
+void LoadSnapshot(World& world, const WorldSnapshot& snapshot)
+{
+	world.ball.xPos = snapshot.ballX;
+	world.ball.yPos = snapshot.ballY;
+	world.ball.xVel = snapshot.ballVelX;
+	world.ball.yVel = snapshot.ballVelY;
+	world.ball.speedX = snapshot.ballSpeedX;
+	world.ball.speedY = snapshot.ballSpeedY;
+	world.paddle.x = snapshot.paddleX;
+	world.paddle.y = snapshot.paddleY;
+	world.paddle2.x = snapshot.paddle2X;
+	world.paddle2.y = snapshot.paddleY;
+	world.autopilotError = snapshot.autopilotError;
+	world.autopilotOffset = snapshot.autopilotOffset;
+	world.numPlayers = snapshot.numPlayers;
+	world.currLives = snapshot.currLives;
+	world.score = snapshot.score;
+	world.roundsCleared = snapshot.roundsCleared;
+	world.livesLost = snapshot.livesLost;
+	world.randomState = snapshot.randomState;
+	world.brickHitThisStep = -1;
+
+	// Bricks are always laid out in the same grid, so put them back there
+	world.ResetBricks();
+	for (int i = 0; i < MAX_BRICKS; i++)
+	{
+		if ((snapshot.brickBits[i / 32] & (1u << (i % 32))) == 0)
+		{
+			world.bricks[i].TakeDamage();
+		}
+	}
+}
+
+int EncodeDelta(const WorldSnapshot& prev, const WorldSnapshot& curr, uint8_t* out)
+{
+	uint32_t prevWords[SNAPSHOT_WORDS];
+	uint32_t currWords[SNAPSHOT_WORDS];
+	memcpy(prevWords, &prev, sizeof(prevWords));
+	memcpy(currWords, &curr, sizeof(currWords));
+
+	// First word: bit 'i' is set if word 'i' changed. Then the XOR of each changed word.
+	uint32_t changed = 0;
+	int size = 4;
+	for (int i = 0; i < SNAPSHOT_WORDS; i++)
+	{
+		uint32_t difference = prevWords[i] ^ currWords[i];
+		if (difference != 0)
+		{
+			changed |= 1u << i;
+			memcpy(out + size, &difference, 4);
+			size += 4;
+		}
+	}
+	memcpy(out, &changed, 4);
+	return size;
+}
+
+int ApplyDelta(const uint8_t* delta, WorldSnapshot& snapshot)
+{
+	uint32_t words[SNAPSHOT_WORDS];
+	memcpy(words, &snapshot, sizeof(words));
+
+	uint32_t changed;
+	memcpy(&changed, delta, 4);
+	int size = 4;
+	for (int i = 0; i < SNAPSHOT_WORDS; i++)
+	{
+		if (changed & (1u << i))
+		{
+			uint32_t difference;
+			memcpy(&difference, delta + size, 4);
+			words[i] ^= difference;
+			size += 4;
+		}
+	}
+
+	memcpy(&snapshot, words, sizeof(words));
+	return size;
+}
+
+/////////////////////////////////////////////////////////////////////////////
+// REWIND BUFFER
+
+RewindBuffer::RewindBuffer(int maxFrames)
+{
+	// Allocate everything now, so recording never allocates memory
+	bytes.resize(maxFrames * TYPICAL_DELTA_BYTES + MAX_DELTA_BYTES);
+	deltaStart.resize(maxFrames);
+	deltaSize.resize(maxFrames);
+}
+
+void RewindBuffer::Clear()
+{
+	oldestDelta = 0;
+	numDeltas = 0;
+	bytesUsed = 0;
+	hasLatest = false;
+}
+
+void RewindBuffer::RemoveOldest()
+{
+	bytesUsed -= deltaSize[oldestDelta];
+	oldestDelta = (oldestDelta + 1) % (int)deltaStart.size();
+	numDeltas--;
+}
+
+void RewindBuffer::Record(World& world)
+{
+	WorldSnapshot snapshot;
+	SaveSnapshot(world, snapshot);
+
+	if (hasLatest)
+	{
+		uint8_t delta[MAX_DELTA_BYTES];
+		int size = EncodeDelta(latest, snapshot, delta);
+
+		// Make room, by forgetting the oldest frames
+		int maxDeltas = (int)deltaStart.size();
+		int capacity = (int)bytes.size();
+		while (numDeltas > 0 && (numDeltas == maxDeltas || bytesUsed + size > capacity))
+		{
+			RemoveOldest();
+		}
+
+		// The newest delta goes straight after the one before it, wrapping around the end of the ring
+		int start = 0;
+		if (numDeltas > 0)
+		{
+			int newest = (oldestDelta + numDeltas - 1) % maxDeltas;
+			start = (deltaStart[newest] + deltaSize[newest]) % capacity;
+		}
+		for (int i = 0; i < size; i++)
+		{
+			bytes[(start + i) % capacity] = delta[i];
+		}
+
+		int slot = (oldestDelta + numDeltas) % maxDeltas;
+		deltaStart[slot] = start;
+		deltaSize[slot] = size;
+		numDeltas++;
+		bytesUsed += size;
+	}
+
+	latest = snapshot;
+	hasLatest = true;
+}
+
+bool RewindBuffer::Rewind(World& world)
+{
+	if (numDeltas == 0)
+	{
+		return false;
+	}
+
+	// Copy the newest delta out of the ring, and apply it to go back one frame
+	int maxDeltas = (int)deltaStart.size();
+	int capacity = (int)bytes.size();
+	int newest = (oldestDelta + numDeltas - 1) % maxDeltas;
+	uint8_t delta[MAX_DELTA_BYTES];
+	for (int i = 0; i < deltaSize[newest]; i++)
+	{
+		delta[i] = bytes[(deltaStart[newest] + i) % capacity];
+	}
+	ApplyDelta(delta, latest);
+
+	bytesUsed -= deltaSize[newest];
+	numDeltas--;
+
+	LoadSnapshot(world, latest);
+	return true;
+}
+
+int RewindBuffer::GetFrameCount()
+{
+	return numDeltas;
+}
+
+int RewindBuffer::GetMemoryBytes()
+{
+	return (int)(bytes.size() + deltaStart.size() * sizeof(int) + deltaSize.size() * sizeof(int) + sizeof(*this));
+}
+
+void RunSnapshotBenchmark(int count)
+{
+	World world;
+	world.autopilotError = 60;
+	world.Init(true, 1);
+
+	WorldSnapshot snapshot;
+	WorldSnapshot previous;
+	SaveSnapshot(world, previous);
+	uint8_t delta[MAX_DELTA_BYTES];
+
+	// Step between snapshots so each delta is realistic, but only time the snapshot work
+	sf::Time saveTime;
+	sf::Time loadTime;
+	long long deltaBytes = 0;
+	for (int i = 0; i < count; i++)
+	{
+		world.Step(1.0f / 60.0f, 0, true);
+		if (!world.IsPlayerAlive())
+		{
+			world.Restart();
+		}
+
+		sf::Clock clock;
+		SaveSnapshot(world, snapshot);
+		deltaBytes += EncodeDelta(previous, snapshot, delta);
+		saveTime += clock.restart();
+
+		LoadSnapshot(world, snapshot);
+		loadTime += clock.getElapsedTime();
+
+		previous = snapshot;
+	}
+
+	printf("Snapshot size:         %d bytes\n", (int)sizeof(WorldSnapshot));
+	printf("Average delta size:    %.1f bytes\n", (double)deltaBytes / count);
+	printf("Snapshot + delta:      %.1f ns\n", saveTime.asMicroseconds() * 1000.0 / count);
+	printf("Restore:               %.1f ns\n", loadTime.asMicroseconds() * 1000.0 / count);
+}
@@ -0,0 +1,85 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+#include "World.h"
+
+// Everything needed to put a World back exactly how it was.
+// It's plain data with no pointers, so it can be copied with memcpy, saved to a file or sent
+// over the network. Brick positions never change, so only whether each brick is alive is stored.
+struct WorldSnapshot
+{
+	Real ballX;
+	Real ballY;
+	Real ballVelX;
+	Real ballVelY;
+	Real ballSpeedX;
+	Real ballSpeedY;
+	Real paddleX;
+	Real paddleY;
+	Real paddle2X;
+	Real autopilotError;
+	Real autopilotOffset;
+	int32_t numPlayers;
+	int32_t currLives;
+	int32_t score;
+	int32_t roundsCleared;
+	int32_t livesLost;
+	uint32_t randomState;
+	uint32_t brickBits[(MAX_BRICKS + 31) / 32];	// One bit per brick, set if alive
+};
+
+// The snapshot is treated as an array of 32 bit words when working out what changed
+const int SNAPSHOT_WORDS = sizeof(WorldSnapshot) / 4;
+
+// Biggest possible delta: a word saying which words changed, plus every word
+const int MAX_DELTA_BYTES = 4 + SNAPSHOT_WORDS * 4;
+
+void SaveSnapshot(World& world, WorldSnapshot& snapshot);
+void LoadSnapshot(World& world, const WorldSnapshot& snapshot);
+
+// Writes the difference between two snapshots into 'out', and returns how many bytes it used.
+// Only words that changed are written, so a typical frame (where just the ball and paddle moved)
+// takes a handful of bytes instead of the whole snapshot.
+// The difference is stored using XOR, so applying it to 'curr' gives 'prev', and applying it to 'prev' gives 'curr'.
+int EncodeDelta(const WorldSnapshot& prev, const WorldSnapshot& curr, uint8_t* out);
+
+// Applies a delta made by EncodeDelta to a snapshot. Returns how many bytes were read.
+int ApplyDelta(const uint8_t* delta, WorldSnapshot& snapshot);
+
+// Remembers the last few seconds of a game so it can be played backwards.
+// Each recorded frame is stored as a delta, in a fixed amount of memory. When it's full, the
+// oldest frames are forgotten.
+class RewindBuffer
+{
+public:
+	RewindBuffer(int maxFrames);
+
+	// Records the world's current state. Call this once per step.
+	void Record(World& world);
+
+	// Puts the world back one recorded frame. Returns false if there's nothing left to rewind.
+	bool Rewind(World& world);
+
+	// Forgets everything, e.g. when a new game starts
+	void Clear();
+
+	int GetFrameCount();
+	int GetMemoryBytes();
+
+private:
+	// A ring of deltas, each one taking us from a frame back to the one before it
+	std::vector<uint8_t> bytes;
+	std::vector<int> deltaStart;	// Where each delta starts in 'bytes'
+	std::vector<int> deltaSize;
+	int oldestDelta = 0;
+	int numDeltas = 0;
+	int bytesUsed = 0;
+
+	WorldSnapshot latest;			// The most recently recorded (or rewound to) frame
+	bool hasLatest = false;
+
+	void RemoveOldest();
+};
+
+// Times snapshot, delta and restore, and prints how long each takes
+void RunSnapshotBenchmark(int count);
@@ -0,0 +1,299 @@
+#include <cstring>
+#include "World.h"
+
+void World::Init(bool fastBall, unsigned int seed)
+{
+	if (fastBall)
+	{
+		// Move ball quickly
+		ball.speedX = 600;	// Speed the ball moves in X
+		ball.speedY = 700;	// Speed the ball moves in Y
+	}
+	else
+	{
+		// Move ball at normal speed
+		ball.speedX = 300;	// Speed the ball moves in X
+		ball.speedY = 350;	// Speed the ball moves in Y
+	}
+
+	// Zero is not allowed as a random state, because it would only ever produce zeros
+	randomState = seed != 0 ? seed : 1;
+
+	// Reset the ball, paddle, bricks and lives
+	Restart();
+	score = 0;
+	roundsCleared = 0;
+	livesLost = 0;
+}
+
+// Start another game after the player has run out of lives
+void World::Restart()
+{
+	ResetBricks();
+	ResetBallAndPaddlePosition();
+	currLives = initialLives;
+}
+
+void World::ResetBricks()
+{
+	// Calculate offset for top left of the grid of bricks
+	const Real xOffset = (WORLD_WIDTH / 2) - ((BRICK_COLUMNS / 2) * BRICK_WIDTH);
+	const Real yOffset = 50;
+
+	// Initialize the bricks to be laid out in a grid
+	int curr = 0;
+	for (int y = 0; y < BRICK_ROWS; y++)
+	{
+		for (int x = 0; x < BRICK_COLUMNS; x++)
+		{
+			Real xPos = x * BRICK_WIDTH + xOffset;
+			Real yPos = y * BRICK_HEIGHT + yOffset;
+			bricks[curr].Init(xPos, yPos, true);
+			curr++;
+		}
+	}
+}
+
+void World::ResetBallAndPaddlePosition()
+{
+	// Reset paddle
+	// With two players, the paddles start a third of the way in from each side
+	if (numPlayers == 2)
+	{
+		paddle.x = WORLD_WIDTH / 3 - paddle.width / 2;
+		paddle2.x = WORLD_WIDTH * 2 / 3 - paddle2.width / 2;
+	}
+	else
+	{
+		paddle.x = WORLD_WIDTH / 2 - paddle.width / 2;
+	}
+	paddle.y = WORLD_HEIGHT - paddle.screenBottomOffset;
+	paddle2.y = paddle.y;
+
+	// Reset ball, in the middle just above the paddles
+	ball.SetPos(WORLD_WIDTH / 2, paddle.y - ball.diameter / 2);
+	ball.xVel = ball.speedX;	// Send ball right
+	ball.yVel = -ball.speedY;	// Send ball up
+
+	// Pick where the autopilot will aim next
+	autopilotOffset = Real(RandomFloat()) * autopilotError;
+}
+
+bool World::IsPlayerAlive()
+{
+	return currLives > 0;
+}
+
+bool World::AllBricksDead()
+{
+	for (int i = 0; i < MAX_BRICKS; i++)
+	{
+		if (bricks[i].IsAlive())
+		{
+			return false;
+		}
+	}
+	return true;
+}
+
+void World::Step(Real elapsedSeconds, int paddleDirection, bool autopilot, int paddle2Direction)
+{
+	bool playerAlive = IsPlayerAlive();
+	brickHitThisStep = -1;
+
+	if (playerAlive)
+	{
+		// Move ball
+		ball.Move(elapsedSeconds);
+	}
+
+	// Bounce ball off sides and top of the screen
+	if (ball.yPos < 0)
+	{
+		// Hit top of screen
+		ball.yPos = 0;
+		ball.yVel = ball.speedY;
+	}
+	if (ball.xPos >= WORLD_WIDTH)
+	{
+		// Hit right side
+		ball.xPos = WORLD_WIDTH;
+		ball.xVel = -ball.speedX;
+	}
+	if (ball.xPos <= 0)
+	{
+		// Hit left side
+		ball.xPos = 0;
+		ball.xVel = ball.speedX;
+	}
+
+	// If the ball goes off the bottom, 'lose a life'
+	if (ball.yPos > WORLD_HEIGHT)
+	{
+		// Bottom side bounce
+		ResetBallAndPaddlePosition();
+		currLives--;
+		livesLost++;
+	}
+
+	// Move paddle
+	if (playerAlive)
+	{
+		paddle.x += paddleDirection * paddle.speed * elapsedSeconds;
+	}
+
+	// The autopilot moves the paddle to always be under the ball
+	if (autopilot)
+	{
+		paddle.x = ball.xPos + autopilotOffset - paddle.width / 2;
+	}
+
+	LimitPaddleToScreen(paddle);
+	if (BounceBallOffPaddle(paddle))
+	{
+		// Pick where the autopilot will aim next time
+		autopilotOffset = Real(RandomFloat()) * autopilotError;
+	}
+
+	// The second player's paddle works the same way, but never uses the autopilot
+	if (numPlayers == 2)
+	{
+		if (playerAlive)
+		{
+			paddle2.x += paddle2Direction * paddle2.speed * elapsedSeconds;
+		}
+		LimitPaddleToScreen(paddle2);
+		BounceBallOffPaddle(paddle2);
+	}
+
+	// Test collision with bricks
+	for (int i = 0; i < MAX_BRICKS; i++)
+	{
+		if (bricks[i].IsAlive())
+		{
+			int hitSide = bricks[i].GetCollisionSide(ball.xPos, ball.yPos);
+
+			// If the ball hit the brick, kill the brick and increase score.
+			if (hitSide > -1)
+			{
+				bricks[i].TakeDamage();
+				score++;
+				brickHitThisStep = i;
+
+				// Depending on which side was penetrated most, change the ball velocity
+				switch (hitSide)
+				{
+				case 0:		// Top
+					ball.yVel = -ball.speedY;
+					break;
+				case 1:		// Bottom
+					ball.yVel = ball.speedY;
+					break;
+				case 2:		// Left
+					ball.xVel = -ball.speedX;
+					break;
+				case 3:		// Right
+					ball.xVel = ball.speedX;
+					break;
+				}
+			}
+		}
+	}
+
+	// If all bricks are dead, reset for next round
+	if (AllBricksDead())
+	{
+		ResetBricks();
+		ResetBallAndPaddlePosition();
+		roundsCleared++;
+	}
+}
+
+float World::RandomFloat()
+{
+	// A simple 'linear congruential' random number generator.
+	// Unlike rand(), it keeps its state in the world, so it is safe to use from many threads.
+	randomState = randomState * 1664525u + 1013904223u;
+
+	// Use the top 24 bits to make a number between 0 and 1, then stretch it to -1 to 1
+	float zeroToOne = (randomState >> 8) / 16777216.0f;
+	return zeroToOne * 2.0f - 1.0f;
+}
+
+// Adds a 32 bit value to the hash. Mixing a whole word at a time is much quicker than byte by byte.
+static void HashWord(unsigned int& hash, unsigned int word)
+{
+	hash = (hash ^ word) * 0x01000193u;
+	hash ^= hash >> 15;
+}
+
+// Adds the exact bits of a number to the hash, so even the tiniest difference changes it
+static void HashReal(unsigned int& hash, Real value)
+{
+	unsigned int bits;
+	static_assert(sizeof(bits) == sizeof(value), "Real must be 32 bits");
+	memcpy(&bits, &value, sizeof(bits));
+	HashWord(hash, bits);
+}
+
+void World::LimitPaddleToScreen(Paddle& thePaddle)
+{
+	if (thePaddle.x < 0)
+	{
+		thePaddle.x = 0;
+	}
+	if (thePaddle.x > WORLD_WIDTH - thePaddle.width)
+	{
+		thePaddle.x = WORLD_WIDTH - thePaddle.width;
+	}
+}
+
+// Returns true if the ball bounced
+bool World::BounceBallOffPaddle(Paddle& thePaddle)
+{
+	if (ball.xPos >= thePaddle.x &&
+		ball.xPos <= thePaddle.x + thePaddle.width &&
+		ball.yPos >= thePaddle.y &&
+		ball.yPos <= thePaddle.y + thePaddle.height)
+	{
+		ball.yVel = -ball.speedY;
+		return true;
+	}
+	return false;
+}
+
+unsigned int World::Checksum()
+{
+	unsigned int hash = 2166136261u;
+	HashReal(hash, ball.xPos);
+	HashReal(hash, ball.yPos);
+	HashReal(hash, ball.xVel);
+	HashReal(hash, ball.yVel);
+	HashReal(hash, paddle.x);
+	HashReal(hash, paddle.y);
+	if (numPlayers == 2)
+	{
+		HashReal(hash, paddle2.x);
+	}
+	HashReal(hash, autopilotOffset);
+	HashWord(hash, (unsigned int)currLives);
+	HashWord(hash, (unsigned int)score);
+	HashWord(hash, (unsigned int)roundsCleared);
+	HashWord(hash, randomState);
+
+	// One bit per brick, 32 bricks to a word
+	unsigned int aliveBits = 0;
+	for (int i = 0; i < MAX_BRICKS; i++)
+	{
+		if (bricks[i].IsAlive())
+		{
+			aliveBits |= 1u << (i % 32);
+		}
+		if (i % 32 == 31 || i == MAX_BRICKS - 1)
+		{
+			HashWord(hash, aliveBits);
+			aliveBits = 0;
+		}
+	}
+	return hash;
+}
@@ -0,0 +1,249 @@
+#pragma once
+#include <cmath>
+#include "Helpers.h"
+
+// The type of number used for positions and speeds.
+// Add BREAKOUT_FIXED_POINT to the project's preprocessor definitions to use fixed point numbers,
+// which make the simulation give exactly the same results with every compiler and setting.
+#ifdef BREAKOUT_FIXED_POINT
+#include "Fixed.h"
+typedef Fixed Real;
+#else
+typedef float Real;
+inline float Abs(float a) { return std::abs(a); }
+inline float ToFloat(float a) { return a; }
+#endif
+
+// Size of the play area in pixels. The window is created with the same size.
+const int WORLD_WIDTH = 800;
+const int WORLD_HEIGHT = 600;
+
+// Ball
+class Ball
+{
+public:
+	const Real diameter = 8;
+	Real speedX = 0;	// Speed the ball moves in X
+	Real speedY = 0;	// Speed the ball moves in Y
+
+	Real xPos;
+	Real yPos;
+	Real xVel;
+	Real yVel;
+
+	Ball()
+	{
+		xPos = 0;
+		yPos = 0;
+		xVel = 0;	// Velocity in pixels per second
+		yVel = 0;
+	}
+
+	// Member function for setting the position of the ball
+	void SetPos(Real x, Real y)
+	{
+		xPos = x;
+		yPos = y;
+	}
+
+	// Member function for moving the ball by its velocity
+	void Move(Real elapsedSeconds)
+	{
+		xPos += xVel * elapsedSeconds;
+		yPos += yVel * elapsedSeconds;
+	}
+};
+
+// Paddle variables
+class Paddle
+{
+public:
+	// Constants
+	const Real height = 10;
+	const Real width = 100;
+	const Real screenBottomOffset = 50;
+
+	Real x = 0;		// Paddle position (properly initialized in World::Init)
+	Real y = 0;
+	Real speed = 600;	// Speed in pixels per second
+};
+
+// Player constants
+const int initialLives = 3;
+
+// Brick constants
+const Real BRICK_WIDTH = 40;
+const Real BRICK_HEIGHT = 20;
+
+class Brick
+{
+private:
+	bool alive;		// Whether the brick is alive (draws a rectangle and can be collided with)
+	Real x;		// Pixel position of left side of brick
+	Real y;		// Pixel position of top side of brick
+
+public:
+	Brick()
+	{
+		// Initialize brick to be dead, and have a bogus position.
+		// Not -99999: in the fixed point build, Real only reaches about -32768 to 32767 (see Fixed.h).
+		alive = false;
+		x = -9999;
+		y = -9999;
+	}
+
+	bool IsAlive()
+	{
+		return alive;
+	}
+
+	void TakeDamage()
+	{
+		alive = false;
+	}
+
+	Real GetX()
+	{
+		return x;
+	}
+
+	Real GetY()
+	{
+		return y;
+	}
+
+	void Init(Real xPos, Real yPos, bool isAlive)
+	{
+		x = xPos;
+		y = yPos;
+		alive = isAlive;
+	}
+
+	void Draw()
+	{
+		DrawRectangle(ToFloat(x), ToFloat(y), ToFloat(BRICK_WIDTH), ToFloat(BRICK_HEIGHT), sf::Color::Cyan);
+		DrawRectangle(ToFloat(x + 1), ToFloat(y + 1), ToFloat(BRICK_WIDTH - 2), ToFloat(BRICK_HEIGHT - 2), sf::Color::Red);
+	}
+
+	// Returns:
+	// -1 = No collision
+	//  0 = top, 1 = bottom, 2 = left, 3 = right
+	int GetCollisionSide(Real xPos, Real yPos)
+	{
+		// Calculate the sides of the brick
+		Real brickTop = y;
+		Real brickBottom = y + BRICK_HEIGHT - 1;
+		Real brickLeft = x;
+		Real brickRight = x + BRICK_WIDTH - 1;
+
+		if (xPos > brickLeft &&
+			xPos < brickRight &&
+			yPos > brickTop &&
+			yPos < brickBottom)
+		{
+			// We know the ball is inside the brick
+			// Work out which side the ball 'penetrates' the least, and treat that as the side which was hit
+
+			// Use an int variable to store which side was hit
+			int hitSide;	// 0 = top, 1 = bottom, 2 = left, 3 = right
+
+			Real shortestPenetration;	// Used for storing the lowest penetration amount we've found
+
+			// Start with the top of the brick
+			// Because it's the first side we're testing, this is the side which has been penetrated least
+			hitSide = 0;
+			shortestPenetration = Abs(brickTop - yPos);
+
+			// Test the bottom
+			Real currPenetration = Abs(brickBottom - yPos);	// I use abs because I'm lazy, and want to avoid getting it the wrong way around
+			if (currPenetration < shortestPenetration)
+			{
+				// The bottom is penetrated less. It's the new 'winner'.
+				hitSide = 1;
+				shortestPenetration = currPenetration;
+			}
+
+			// Test the left
+			currPenetration = Abs(brickLeft - xPos);
+			if (currPenetration < shortestPenetration)
+			{
+				// The left is penetrated less. It's the new 'winner'.
+				hitSide = 2;
+				shortestPenetration = currPenetration;
+			}
+
+			// Test the right
+			currPenetration = Abs(brickRight - xPos);
+			if (currPenetration < shortestPenetration)
+			{
+				// The right is penetrated less. It's the new 'winner'.
+				hitSide = 3;
+				shortestPenetration = currPenetration;
+			}
+			return hitSide;
+		}
+		else
+		{
+			return -1;	// No collision
+		}
+	}
+};
+const int BRICK_COLUMNS = 18;
+const int BRICK_ROWS = 6;
+const int MAX_BRICKS = BRICK_COLUMNS * BRICK_ROWS;
+
+// Everything needed to simulate one game of Breakout.
+// Keeping it together in one object (instead of in globals) means lots of games
+// can be simulated side by side, for example by the self-play runner.
+class World
+{
+public:
+	Ball ball;
+	Paddle paddle;
+	Paddle paddle2;		// Only used when numPlayers is 2
+	int numPlayers = 1;	// Two players share the ball, the bricks and the lives
+	Brick bricks[MAX_BRICKS];
+
+	// Player variables
+	int currLives = initialLives;
+	int score = 0;
+
+	// Statistics, used by the self-play runner
+	int roundsCleared = 0;	// How many times every brick has been destroyed
+	int livesLost = 0;
+
+	// Autopilot variables
+	// The autopilot aims the middle of the paddle at the ball, plus a random offset.
+	// With an error of 0 it never misses. Errors bigger than half the paddle width make it miss sometimes.
+	Real autopilotError = 0;
+	Real autopilotOffset = 0;	// Offset used until the ball next touches the paddle
+
+	// Which brick was destroyed during the last Step, or -1 if none was.
+	// The ball can only be inside one brick at a time, so at most one brick breaks per step.
+	int brickHitThisStep = -1;
+
+	unsigned int randomState = 1;	// Each world has its own random numbers, so games don't affect each other
+
+	void Init(bool fastBall, unsigned int seed);
+	void Restart();
+	void ResetBricks();
+	void ResetBallAndPaddlePosition();
+	bool IsPlayerAlive();
+	bool AllBricksDead();
+
+	// Moves everything forward by elapsedSeconds.
+	// paddleDirection is -1 to move the paddle left, 1 to move it right, and 0 to keep it still.
+	// paddle2Direction is the same for the second player's paddle.
+	void Step(Real elapsedSeconds, int paddleDirection, bool autopilot, int paddle2Direction = 0);
+
+	// Makes a number from everything in the world. If two worlds have the same checksum,
+	// they are (almost certainly) in exactly the same state.
+	unsigned int Checksum();
+
+	// Returns a random number between -1 and 1
+	float RandomFloat();
+
+private:
+	void LimitPaddleToScreen(Paddle& thePaddle);
+	bool BounceBallOffPaddle(Paddle& thePaddle);
+};
@@ -0,0 +1,412 @@
+#include "WorldLanes.h"
+
+/////////////////////////////////////////////////////////////////////////////
+// SIMD HELPERS
+// Small wrappers so the game code below reads the same whether the compiler
+// is allowed to use AVX2 (8 lanes per instruction) or just SSE2 (4 lanes).
+// A 'mask' has every bit set in the lanes where a test was true, and no bits set elsewhere.
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+
+typedef __m256 LaneFloats;
+typedef __m256i LaneInts;
+const int SIMD_WIDTH = 8;
+
+static inline LaneFloats LoadFloats(const float* p) { return _mm256_load_ps(p); }
+static inline LaneFloats LoadUnalignedFloats(const float* p) { return _mm256_loadu_ps(p); }
+static inline void StoreFloats(float* p, LaneFloats v) { _mm256_store_ps(p, v); }
+static inline LaneFloats SetFloats(float f) { return _mm256_set1_ps(f); }
+static inline LaneFloats Add(LaneFloats a, LaneFloats b) { return _mm256_add_ps(a, b); }
+static inline LaneFloats Sub(LaneFloats a, LaneFloats b) { return _mm256_sub_ps(a, b); }
+static inline LaneFloats Mul(LaneFloats a, LaneFloats b) { return _mm256_mul_ps(a, b); }
+static inline LaneFloats Less(LaneFloats a, LaneFloats b) { return _mm256_cmp_ps(a, b, _CMP_LT_OQ); }
+static inline LaneFloats LessEq(LaneFloats a, LaneFloats b) { return _mm256_cmp_ps(a, b, _CMP_LE_OQ); }
+static inline LaneFloats Greater(LaneFloats a, LaneFloats b) { return _mm256_cmp_ps(a, b, _CMP_GT_OQ); }
+static inline LaneFloats GreaterEq(LaneFloats a, LaneFloats b) { return _mm256_cmp_ps(a, b, _CMP_GE_OQ); }
+static inline LaneFloats And(LaneFloats a, LaneFloats b) { return _mm256_and_ps(a, b); }
+static inline LaneFloats Or(LaneFloats a, LaneFloats b) { return _mm256_or_ps(a, b); }
+static inline LaneFloats AndNot(LaneFloats a, LaneFloats b) { return _mm256_andnot_ps(a, b); }	// (not a) and b
+static inline int MoveMask(LaneFloats mask) { return _mm256_movemask_ps(mask); }
+
+static inline LaneInts LoadInts(const int32_t* p) { return _mm256_load_si256((const __m256i*)p); }
+static inline void StoreInts(int32_t* p, LaneInts v) { _mm256_store_si256((__m256i*)p, v); }
+static inline LaneInts SetInts(int32_t i) { return _mm256_set1_epi32(i); }
+static inline LaneInts AddInts(LaneInts a, LaneInts b) { return _mm256_add_epi32(a, b); }
+static inline LaneInts SubInts(LaneInts a, LaneInts b) { return _mm256_sub_epi32(a, b); }
+static inline LaneInts AndInts(LaneInts a, LaneInts b) { return _mm256_and_si256(a, b); }
+static inline LaneInts OrInts(LaneInts a, LaneInts b) { return _mm256_or_si256(a, b); }
+static inline LaneInts AndNotInts(LaneInts a, LaneInts b) { return _mm256_andnot_si256(a, b); }
+static inline LaneInts EqualInts(LaneInts a, LaneInts b) { return _mm256_cmpeq_epi32(a, b); }
+static inline LaneInts GreaterInts(LaneInts a, LaneInts b) { return _mm256_cmpgt_epi32(a, b); }
+static inline LaneInts ShiftLeft23(LaneInts a) { return _mm256_slli_epi32(a, 23); }
+static inline LaneInts TruncateToInts(LaneFloats a) { return _mm256_cvttps_epi32(a); }
+static inline LaneFloats ToFloats(LaneInts a) { return _mm256_cvtepi32_ps(a); }
+static inline LaneInts AsInts(LaneFloats a) { return _mm256_castps_si256(a); }
+static inline LaneFloats AsFloats(LaneInts a) { return _mm256_castsi256_ps(a); }
+
+#else
+#include <emmintrin.h>
+
+typedef __m128 LaneFloats;
+typedef __m128i LaneInts;
+const int SIMD_WIDTH = 4;
+
+static inline LaneFloats LoadFloats(const float* p) { return _mm_load_ps(p); }
+static inline LaneFloats LoadUnalignedFloats(const float* p) { return _mm_loadu_ps(p); }
+static inline void StoreFloats(float* p, LaneFloats v) { _mm_store_ps(p, v); }
+static inline LaneFloats SetFloats(float f) { return _mm_set1_ps(f); }
+static inline LaneFloats Add(LaneFloats a, LaneFloats b) { return _mm_add_ps(a, b); }
+static inline LaneFloats Sub(LaneFloats a, LaneFloats b) { return _mm_sub_ps(a, b); }
+static inline LaneFloats Mul(LaneFloats a, LaneFloats b) { return _mm_mul_ps(a, b); }
+static inline LaneFloats Less(LaneFloats a, LaneFloats b) { return _mm_cmplt_ps(a, b); }
+static inline LaneFloats LessEq(LaneFloats a, LaneFloats b) { return _mm_cmple_ps(a, b); }
+static inline LaneFloats Greater(LaneFloats a, LaneFloats b) { return _mm_cmpgt_ps(a, b); }
+static inline LaneFloats GreaterEq(LaneFloats a, LaneFloats b) { return _mm_cmpge_ps(a, b); }
+static inline LaneFloats And(LaneFloats a, LaneFloats b) { return _mm_and_ps(a, b); }
+static inline LaneFloats Or(LaneFloats a, LaneFloats b) { return _mm_or_ps(a, b); }
+static inline LaneFloats AndNot(LaneFloats a, LaneFloats b) { return _mm_andnot_ps(a, b); }	// (not a) and b
+static inline int MoveMask(LaneFloats mask) { return _mm_movemask_ps(mask); }
+
+static inline LaneInts LoadInts(const int32_t* p) { return _mm_load_si128((const __m128i*)p); }
+static inline void StoreInts(int32_t* p, LaneInts v) { _mm_store_si128((__m128i*)p, v); }
+static inline LaneInts SetInts(int32_t i) { return _mm_set1_epi32(i); }
+static inline LaneInts AddInts(LaneInts a, LaneInts b) { return _mm_add_epi32(a, b); }
+static inline LaneInts SubInts(LaneInts a, LaneInts b) { return _mm_sub_epi32(a, b); }
+static inline LaneInts AndInts(LaneInts a, LaneInts b) { return _mm_and_si128(a, b); }
+static inline LaneInts OrInts(LaneInts a, LaneInts b) { return _mm_or_si128(a, b); }
+static inline LaneInts AndNotInts(LaneInts a, LaneInts b) { return _mm_andnot_si128(a, b); }
+static inline LaneInts EqualInts(LaneInts a, LaneInts b) { return _mm_cmpeq_epi32(a, b); }
+static inline LaneInts GreaterInts(LaneInts a, LaneInts b) { return _mm_cmpgt_epi32(a, b); }
+static inline LaneInts ShiftLeft23(LaneInts a) { return _mm_slli_epi32(a, 23); }
+static inline LaneInts TruncateToInts(LaneFloats a) { return _mm_cvttps_epi32(a); }
+static inline LaneFloats ToFloats(LaneInts a) { return _mm_cvtepi32_ps(a); }
+static inline LaneInts AsInts(LaneFloats a) { return _mm_castps_si128(a); }
+static inline LaneFloats AsFloats(LaneInts a) { return _mm_castsi128_ps(a); }
+
+#endif
+
+// Picks a where the mask is set, and b everywhere else
+static inline LaneFloats Select(LaneFloats mask, LaneFloats a, LaneFloats b)
+{
+	return Or(And(mask, a), AndNot(mask, b));
+}
+
+static inline LaneFloats Abs(LaneFloats a)
+{
+	return AndNot(SetFloats(-0.0f), a);	// Clear the sign bit
+}
+
+/////////////////////////////////////////////////////////////////////////////
+// WORLD LANES
+
+// These match the values used by World
+static const Paddle lanePaddle = Paddle();
+static const float laneBallRadius = ToFloat(Ball().diameter) / 2;
+static const float paddleWidth = ToFloat(lanePaddle.width);
+static const float paddleResetX = WORLD_WIDTH / 2 - paddleWidth / 2;
+static const float paddleY = WORLD_HEIGHT - ToFloat(lanePaddle.screenBottomOffset);
+static const float brickWidth = ToFloat(BRICK_WIDTH);
+static const float brickHeight = ToFloat(BRICK_HEIGHT);
+static const float bricksLeft = (WORLD_WIDTH / 2) - ((BRICK_COLUMNS / 2) * brickWidth);
+static const float bricksTop = 50;
+static const int32_t fullBrickRow = (1 << BRICK_COLUMNS) - 1;
+
+void WorldLanes::Init(bool fastBall, const unsigned int seeds[LANE_COUNT])
+{
+	// Same speeds as World::Init
+	ballSpeedX = fastBall ? 600.0f : 300.0f;
+	ballSpeedY = fastBall ? 700.0f : 350.0f;
+
+	for (int lane = 0; lane < LANE_COUNT; lane++)
+	{
+		randomState[lane] = seeds[lane] != 0 ? seeds[lane] : 1;
+		autopilotOffset[lane] = 0;
+		ResetBricks(lane);
+		ResetBallAndPaddlePosition(lane);
+		currLives[lane] = initialLives;
+		score[lane] = 0;
+		roundsCleared[lane] = 0;
+		livesLost[lane] = 0;
+	}
+}
+
+void WorldLanes::ResetBricks(int lane)
+{
+	for (int row = 0; row < BRICK_ROWS; row++)
+	{
+		brickRows[row][lane] = fullBrickRow;
+	}
+}
+
+void WorldLanes::ResetBallAndPaddlePosition(int lane)
+{
+	paddleX[lane] = paddleResetX;
+	ballX[lane] = paddleResetX + paddleWidth / 2;
+	ballY[lane] = paddleY - laneBallRadius;
+	ballVelX[lane] = ballSpeedX;
+	ballVelY[lane] = -ballSpeedY;
+	autopilotOffset[lane] = RandomFloat(lane) * autopilotError;
+}
+
+float WorldLanes::RandomFloat(int lane)
+{
+	// Same generator as World::RandomFloat, so each lane gets the same numbers as a World would
+	randomState[lane] = randomState[lane] * 1664525u + 1013904223u;
+	float zeroToOne = (randomState[lane] >> 8) / 16777216.0f;
+	return zeroToOne * 2.0f - 1.0f;
+}
+
+bool WorldLanes::IsPlayerAlive(int lane)
+{
+	return currLives[lane] > 0;
+}
+
+bool WorldLanes::IsBrickAlive(int lane, int brick)
+{
+	int row = brick / BRICK_COLUMNS;
+	int column = brick % BRICK_COLUMNS;
+	return (brickRows[row][lane] & (1 << column)) != 0;
+}
+
+void WorldLanes::CopyLaneToWorld(int lane, World& world)
+{
+	world.ball.speedX = ballSpeedX;
+	world.ball.speedY = ballSpeedY;
+	world.ball.SetPos(ballX[lane], ballY[lane]);
+	world.ball.xVel = ballVelX[lane];
+	world.ball.yVel = ballVelY[lane];
+	world.paddle.x = paddleX[lane];
+	world.paddle.y = paddleY;
+	world.currLives = currLives[lane];
+	world.score = score[lane];
+	world.roundsCleared = roundsCleared[lane];
+	world.livesLost = livesLost[lane];
+	world.autopilotError = autopilotError;
+	world.autopilotOffset = autopilotOffset[lane];
+	world.randomState = randomState[lane];
+
+	int curr = 0;
+	for (int y = 0; y < BRICK_ROWS; y++)
+	{
+		for (int x = 0; x < BRICK_COLUMNS; x++)
+		{
+			world.bricks[curr].Init(x * brickWidth + bricksLeft, y * brickHeight + bricksTop, IsBrickAlive(lane, curr));
+			curr++;
+		}
+	}
+}
+
+void WorldLanes::Step(float elapsedSeconds, const float paddleDirections[LANE_COUNT], bool autopilot)
+{
+	// Values every lane shares
+	const LaneFloats zero = SetFloats(0);
+	const LaneFloats dt = SetFloats(elapsedSeconds);
+	const LaneFloats speedX = SetFloats(ballSpeedX);
+	const LaneFloats speedY = SetFloats(ballSpeedY);
+	const LaneFloats worldWidth = SetFloats((float)WORLD_WIDTH);
+	const LaneFloats worldHeight = SetFloats((float)WORLD_HEIGHT);
+
+	// Remember who was alive at the start of the step, like World::Step does
+	alignas(32) int32_t aliveAtStart[LANE_COUNT];
+
+	// Move ball, bounce it off the sides and top, and find balls that fell off the bottom
+	int lostLifeLanes = 0;
+	for (int i = 0; i < LANE_COUNT; i += SIMD_WIDTH)
+	{
+		LaneInts lives = LoadInts(&currLives[i]);
+		LaneFloats alive = AsFloats(GreaterInts(lives, SetInts(0)));
+		StoreInts(&aliveAtStart[i], AsInts(alive));
+
+		LaneFloats x = LoadFloats(&ballX[i]);
+		LaneFloats y = LoadFloats(&ballY[i]);
+		LaneFloats velX = LoadFloats(&ballVelX[i]);
+		LaneFloats velY = LoadFloats(&ballVelY[i]);
+
+		// Only living players' balls move
+		x = Select(alive, Add(x, Mul(velX, dt)), x);
+		y = Select(alive, Add(y, Mul(velY, dt)), y);
+
+		// Hit top of screen
+		LaneFloats hitTop = Less(y, zero);
+		y = Select(hitTop, zero, y);
+		velY = Select(hitTop, speedY, velY);
+
+		// Hit right side
+		LaneFloats hitRight = GreaterEq(x, worldWidth);
+		x = Select(hitRight, worldWidth, x);
+		velX = Select(hitRight, Sub(zero, speedX), velX);
+
+		// Hit left side
+		LaneFloats hitLeft = LessEq(x, zero);
+		x = Select(hitLeft, zero, x);
+		velX = Select(hitLeft, speedX, velX);
+
+		StoreFloats(&ballX[i], x);
+		StoreFloats(&ballY[i], y);
+		StoreFloats(&ballVelX[i], velX);
+		StoreFloats(&ballVelY[i], velY);
+
+		lostLifeLanes |= MoveMask(Greater(y, worldHeight)) << i;
+	}
+
+	// Losing a life is rare, so it is handled one lane at a time
+	for (int lane = 0; lane < LANE_COUNT; lane++)
+	{
+		if (lostLifeLanes & (1 << lane))
+		{
+			ResetBallAndPaddlePosition(lane);
+			currLives[lane]--;
+			livesLost[lane]++;
+		}
+	}
+
+	// Move the paddles, and bounce balls off them
+	const LaneFloats paddleSpeed = SetFloats(ToFloat(lanePaddle.speed));
+	const LaneFloats paddleHalfWidth = SetFloats(paddleWidth / 2);
+	const LaneFloats paddleWidths = SetFloats(paddleWidth);
+	const LaneFloats paddleMaxX = SetFloats(WORLD_WIDTH - paddleWidth);
+	const LaneFloats paddleTop = SetFloats(paddleY);
+	const LaneFloats paddleBottom = SetFloats(paddleY + ToFloat(lanePaddle.height));
+	int paddleBounceLanes = 0;
+	for (int i = 0; i < LANE_COUNT; i += SIMD_WIDTH)
+	{
+		LaneFloats alive = AsFloats(LoadInts(&aliveAtStart[i]));
+		LaneFloats x = LoadFloats(&ballX[i]);
+		LaneFloats y = LoadFloats(&ballY[i]);
+		LaneFloats px = LoadFloats(&paddleX[i]);
+
+		LaneFloats move = Mul(Mul(LoadUnalignedFloats(&paddleDirections[i]), paddleSpeed), dt);
+		px = Select(alive, Add(px, move), px);
+
+		if (autopilot)
+		{
+			px = Sub(Add(x, LoadFloats(&autopilotOffset[i])), paddleHalfWidth);
+		}
+
+		// Limit paddle to screen
+		px = Select(Less(px, zero), zero, px);
+		px = Select(Greater(px, paddleMaxX), paddleMaxX, px);
+		StoreFloats(&paddleX[i], px);
+
+		// Bounce ball off paddle
+		LaneFloats onPaddle = And(And(GreaterEq(x, px), LessEq(x, Add(px, paddleWidths))),
+			And(GreaterEq(y, paddleTop), LessEq(y, paddleBottom)));
+		StoreFloats(&ballVelY[i], Select(onPaddle, Sub(zero, speedY), LoadFloats(&ballVelY[i])));
+
+		paddleBounceLanes |= MoveMask(onPaddle) << i;
+	}
+
+	// Pick where the autopilot will aim next, for balls that touched the paddle
+	for (int lane = 0; lane < LANE_COUNT; lane++)
+	{
+		if (paddleBounceLanes & (1 << lane))
+		{
+			autopilotOffset[lane] = RandomFloat(lane) * autopilotError;
+		}
+	}
+
+	// Test collision with bricks.
+	// The bricks are in a grid and don't overlap, so instead of testing every brick, work out
+	// which grid cell the ball is in and only test that one.
+	const LaneFloats gridLeft = SetFloats(bricksLeft);
+	const LaneFloats gridTop = SetFloats(bricksTop);
+	const LaneFloats gridRight = SetFloats(bricksLeft + BRICK_COLUMNS * brickWidth);
+	const LaneFloats gridBottom = SetFloats(bricksTop + BRICK_ROWS * brickHeight);
+	const LaneFloats brickWidths = SetFloats(brickWidth);
+	const LaneFloats brickHeights = SetFloats(brickHeight);
+	const LaneFloats one = SetFloats(1);
+	int roundClearedLanes = 0;
+	for (int i = 0; i < LANE_COUNT; i += SIMD_WIDTH)
+	{
+		LaneFloats x = LoadFloats(&ballX[i]);
+		LaneFloats y = LoadFloats(&ballY[i]);
+
+		// Which cell is the ball in? Balls outside the grid are masked off, so the
+		// truncation below only ever sees positive numbers.
+		LaneFloats inGrid = And(And(Greater(x, gridLeft), Less(x, gridRight)),
+			And(Greater(y, gridTop), Less(y, gridBottom)));
+		LaneInts column = TruncateToInts(Mul(Sub(x, gridLeft), SetFloats(1.0f / brickWidth)));
+		LaneInts row = TruncateToInts(Mul(Sub(y, gridTop), SetFloats(1.0f / brickHeight)));
+		column = AndInts(column, AsInts(inGrid));
+		row = AndInts(row, AsInts(inGrid));
+
+		// Sides of the brick in that cell, calculated the same way as World does
+		LaneFloats brickLeft = Add(Mul(ToFloats(column), brickWidths), gridLeft);
+		LaneFloats brickTop = Add(Mul(ToFloats(row), brickHeights), gridTop);
+		LaneFloats brickRight = Sub(Add(brickLeft, brickWidths), one);
+		LaneFloats brickBottom = Sub(Add(brickTop, brickHeights), one);
+		LaneFloats inside = And(inGrid, And(And(Greater(x, brickLeft), Less(x, brickRight)),
+			And(Greater(y, brickTop), Less(y, brickBottom))));
+
+		// Fetch each lane's row of bricks, then make (1 << column) by building the float 2^column
+		LaneInts rowBits = SetInts(0);
+		for (int r = 0; r < BRICK_ROWS; r++)
+		{
+			LaneInts isRow = EqualInts(row, SetInts(r));
+			rowBits = OrInts(rowBits, AndInts(isRow, LoadInts(&brickRows[r][i])));
+		}
+		LaneInts columnBit = TruncateToInts(AsFloats(ShiftLeft23(AddInts(column, SetInts(127)))));
+		LaneInts brickAlive = GreaterInts(AndInts(rowBits, columnBit), SetInts(0));
+		LaneFloats hit = And(inside, AsFloats(brickAlive));
+
+		if (MoveMask(hit) != 0)
+		{
+			// Work out which side the ball penetrates the least, in the same order as Brick::GetCollisionSide
+			LaneFloats shortest = Abs(Sub(brickTop, y));
+			LaneFloats hitBottom = Less(Abs(Sub(brickBottom, y)), shortest);
+			shortest = Select(hitBottom, Abs(Sub(brickBottom, y)), shortest);
+			LaneFloats hitLeft = Less(Abs(Sub(brickLeft, x)), shortest);
+			shortest = Select(hitLeft, Abs(Sub(brickLeft, x)), shortest);
+			LaneFloats hitRight = Less(Abs(Sub(brickRight, x)), shortest);
+
+			// Turn 'the last winner' into exactly one side per lane
+			LaneFloats sideRight = hitRight;
+			LaneFloats sideLeft = AndNot(hitRight, hitLeft);
+			LaneFloats sideBottom = AndNot(Or(hitRight, hitLeft), hitBottom);
+			LaneFloats sideTop = AndNot(Or(Or(hitRight, hitLeft), hitBottom), hit);
+			sideRight = And(sideRight, hit);
+			sideLeft = And(sideLeft, hit);
+			sideBottom = And(sideBottom, hit);
+
+			LaneFloats velX = LoadFloats(&ballVelX[i]);
+			LaneFloats velY = LoadFloats(&ballVelY[i]);
+			velY = Select(sideTop, Sub(zero, speedY), velY);
+			velY = Select(sideBottom, speedY, velY);
+			velX = Select(sideLeft, Sub(zero, speedX), velX);
+			velX = Select(sideRight, speedX, velX);
+			StoreFloats(&ballVelX[i], velX);
+			StoreFloats(&ballVelY[i], velY);
+
+			// Kill the bricks and increase score (a mask is -1 where set, so subtracting it adds one)
+			LaneInts hitInts = AsInts(hit);
+			LaneInts killBit = AndInts(hitInts, columnBit);
+			for (int r = 0; r < BRICK_ROWS; r++)
+			{
+				LaneInts isRow = EqualInts(row, SetInts(r));
+				LaneInts bricks = LoadInts(&brickRows[r][i]);
+				StoreInts(&brickRows[r][i], AndNotInts(AndInts(isRow, killBit), bricks));
+			}
+			StoreInts(&score[i], SubInts(LoadInts(&score[i]), hitInts));
+		}
+
+		// Detect all bricks dead
+		LaneInts anyBricks = SetInts(0);
+		for (int r = 0; r < BRICK_ROWS; r++)
+		{
+			anyBricks = OrInts(anyBricks, LoadInts(&brickRows[r][i]));
+		}
+		roundClearedLanes |= MoveMask(AsFloats(EqualInts(anyBricks, SetInts(0)))) << i;
+	}
+
+	// If all bricks are dead, reset for next round
+	for (int lane = 0; lane < LANE_COUNT; lane++)
+	{
+		if (roundClearedLanes & (1 << lane))
+		{
+			ResetBricks(lane);
+			ResetBallAndPaddlePosition(lane);
+			roundsCleared[lane]++;
+		}
+	}
+}
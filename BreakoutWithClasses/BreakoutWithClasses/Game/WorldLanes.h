@@ -0,0 +1,64 @@
+#pragma once
+#include <cstdint>
+#include "World.h"
+
+// How many worlds are stepped together.
+// Must be a multiple of 8, so it fills whole SSE (4 wide) or AVX2 (8 wide) registers.
+const int LANE_COUNT = 8;
+
+// LANE_COUNT separate games of Breakout, stepped together in lockstep.
+//
+// Instead of an array of World objects, each value is stored in its own array with one
+// entry per world ('lane'). That way the same value for several worlds sits side by side in
+// memory, and one SIMD instruction can move, bounce or test every ball at once.
+// If statements become 'masks' that pick, lane by lane, between the old and new value.
+//
+// Stepping a lane gives exactly the same results as World::Step on a World with the same seed.
+// Lanes always use floats, so with BREAKOUT_FIXED_POINT the results are close, but not identical.
+class WorldLanes
+{
+public:
+	// Ball
+	alignas(32) float ballX[LANE_COUNT];
+	alignas(32) float ballY[LANE_COUNT];
+	alignas(32) float ballVelX[LANE_COUNT];
+	alignas(32) float ballVelY[LANE_COUNT];
+
+	// Paddle
+	alignas(32) float paddleX[LANE_COUNT];
+	alignas(32) float autopilotOffset[LANE_COUNT];
+
+	// Bricks. Bit 'column' of brickRows[row][lane] is set when that brick is alive.
+	alignas(32) int32_t brickRows[BRICK_ROWS][LANE_COUNT];
+
+	// Player variables and statistics
+	alignas(32) int32_t currLives[LANE_COUNT];
+	alignas(32) int32_t score[LANE_COUNT];
+	alignas(32) int32_t roundsCleared[LANE_COUNT];
+	alignas(32) int32_t livesLost[LANE_COUNT];
+	unsigned int randomState[LANE_COUNT];
+
+	// Values shared by every lane
+	float ballSpeedX = 0;
+	float ballSpeedY = 0;
+	float autopilotError = 0;
+
+	// Sets up each lane like World::Init, using seeds[lane] for its random numbers
+	void Init(bool fastBall, const unsigned int seeds[LANE_COUNT]);
+
+	// Moves every world forward by elapsedSeconds.
+	// paddleDirections has one entry per lane, between -1 (left) and 1 (right).
+	// This is where an AI being trained would put its choices.
+	void Step(float elapsedSeconds, const float paddleDirections[LANE_COUNT], bool autopilot);
+
+	bool IsPlayerAlive(int lane);
+	bool IsBrickAlive(int lane, int brick);
+
+	// Copies one lane into a normal World, e.g. to draw it or compare it with World::Step
+	void CopyLaneToWorld(int lane, World& world);
+
+private:
+	void ResetBricks(int lane);
+	void ResetBallAndPaddlePosition(int lane);
+	float RandomFloat(int lane);
+};
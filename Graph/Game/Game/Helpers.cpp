@@ -1,5 +1,7 @@
 #include "Helpers.h"
 #include "Main.h"
+#include "MusicManager.h"
+#include "SoundBank.h"
 #include <cstdarg>
 #include <stdio.h>
 #include <Windows.h>
@@ -204,52 +206,46 @@ int GetMouseY()
 /////////////////////////////////////////////////////////////////////////////
 // AUDIO
 
-// Variables for 'in memory' sound effects
-const int MAX_SOUNDS = 32;
-int numLoadedSounds = 0;
-sf::SoundBuffer soundBuffers[MAX_SOUNDS];
-
-// Variables for music
-sf::Music music;
-
 sf::Sound LoadSound(const char* filePath)
 {
-    // If we've already used all the slots, return an empty sound object
+    // The sound bank loads each file once, however many times it's asked for, and has no limit
+    // on how many files it can hold
     sf::Sound sound;
-    if (numLoadedSounds >= MAX_SOUNDS - 1)
+    const sf::SoundBuffer* buffer = soundBank.GetBuffer(soundBank.Load(filePath));
+    if (buffer == NULL)
     {
+        printf("Failed to load sound %s\n", filePath);
         return sound;
     }
 
-    // Load the audio file into the next sound buffer in the array
-    soundBuffers[numLoadedSounds].loadFromFile(filePath);
-
     // Make our sound player object use the sound buffer
-    sound.setBuffer(soundBuffers[numLoadedSounds]);
-
-    // Increase the counter of how many sounds we've loaded
-    numLoadedSounds++;
+    sound.setBuffer(*buffer);
 
     // Return the sound player
     return sound;
 }
 
-void PlayMusic(const char* filePath)
+SoundHandle LoadSoundEffect(const char* filePath)
 {
-    // Attempt to load the music
-    if (!music.openFromFile(filePath))
-        return; // error
+    return soundBank.Load(filePath);
+}
 
-    // Make it loop
-    music.setLoop(true);
+bool PlaySoundEffect(SoundHandle sound)
+{
+    return soundBank.Play(sound);
+}
 
-    // Start playing
-    music.play();
+void PlayMusic(const char* filePath)
+{
+    // The music manager loads and plays the file in the background, so this is quick.
+    // If the file is already playing, it carries on, rather than starting again.
+    musicManager.AddTrack(filePath, filePath);
+    musicManager.Play(filePath);
 }
 
 void StopMusic()
 {
-    music.stop();
+    musicManager.Stop();
 }
 
 
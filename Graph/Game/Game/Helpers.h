@@ -1,6 +1,7 @@
 #pragma once
 #include <SFML\Graphics.hpp>
 #include <SFML\Audio.hpp>
+#include "SoundBank.h"
 
 // Drawing
 void DrawCircle(float centerX, float centerY, float radius, sf::Color color);
@@ -20,7 +21,16 @@ int GetMouseX();
 int GetMouseY();
 
 // Audio
+// Each sf::Sound plays on its own, so uses up one of the sound card's voices while it plays
 sf::Sound LoadSound(const char* filePath);
+
+// Sound effects share a fixed number of voices, so they can be played as often as you like.
+// See SoundBank.h for priorities, and limits on how often each one plays.
+SoundHandle LoadSoundEffect(const char* filePath);
+bool PlaySoundEffect(SoundHandle sound);
+
+// Fades to the music file, and loops it. It's fine to call every frame, as it does nothing if
+// the file is already playing. See MusicManager.h for named tracks and preloading.
 void PlayMusic(const char* filePath);
 void StopMusic();
 
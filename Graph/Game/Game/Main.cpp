@@ -2,12 +2,42 @@
 #include "Main.h"
 #include "Game.h"
 #include "Helpers.h"
+#include "MusicManager.h"
+#include "SoundBank.h"
+#include "SoundMixer.h"
+#include <cstring>
 
 sf::RenderWindow* window = NULL;    // The window that the game will draw within
 sf::Font defaultFont;               // The font used for text within the window
 
-int main()
+int main(int argc, char** argv)
 {
+    // "Game.exe -musiccheck" checks that playing music every frame only opens the file once
+    if (argc >= 2 && strcmp(argv[1], "-musiccheck") == 0)
+    {
+        return RunMusicCheck() ? 0 : 1;
+    }
+
+    // "Game.exe -soundbench" fires sound effects hundreds of times a second, and prints how many voices they used
+    if (argc >= 2 && strcmp(argv[1], "-soundbench") == 0)
+    {
+        RunSoundBenchmark();
+        return 0;
+    }
+
+    // "Game.exe -mixcheck" checks the software mixer's output, without playing anything
+    if (argc >= 2 && strcmp(argv[1], "-mixcheck") == 0)
+    {
+        return RunMixerCheck() ? 0 : 1;
+    }
+
+    // "Game.exe -mixbench" times mixing hundreds of sounds at once, and saves the mix as mixbench.wav
+    if (argc >= 2 && strcmp(argv[1], "-mixbench") == 0)
+    {
+        RunMixerBenchmark();
+        return 0;
+    }
+
     // Run our game initialization code
     GameInit();
 
@@ -0,0 +1,297 @@
+#include <SFML\System\Clock.hpp>
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+#include "Helpers.h"
+#include "MusicManager.h"
+
+MusicManager musicManager;
+
+MusicManager::~MusicManager()
+{
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		quit = true;
+		changed.notify_all();
+	}
+	if (worker.joinable())
+	{
+		worker.join();
+	}
+}
+
+// The thread is only started when music is first wanted, rather than when the program starts
+void MusicManager::StartWorker()
+{
+	if (!worker.joinable())
+	{
+		worker = std::thread([this]() { WorkerLoop(); });
+	}
+}
+
+MusicManager::Track* MusicManager::FindTrack(const std::string& name)
+{
+	auto found = tracks.find(name);
+	return found != tracks.end() ? found->second.get() : NULL;
+}
+
+void MusicManager::AddTrack(const std::string& name, const std::string& filePath)
+{
+	std::lock_guard<std::mutex> lock(mutex);
+	if (FindTrack(name) == NULL)
+	{
+		tracks[name] = std::unique_ptr<Track>(new Track());
+	}
+	tracks[name]->filePath = filePath;
+}
+
+void MusicManager::Preload(const std::string& name)
+{
+	std::lock_guard<std::mutex> lock(mutex);
+	Track* track = FindTrack(name);
+	if (track != NULL)
+	{
+		track->preload = true;
+		StartWorker();
+		changed.notify_all();
+	}
+}
+
+void MusicManager::Play(const std::string& name, float newFadeSeconds)
+{
+	std::lock_guard<std::mutex> lock(mutex);
+	if (playing == name)
+	{
+		return;
+	}
+	if (FindTrack(name) == NULL)
+	{
+		printf("There's no music track called %s\n", name.c_str());
+		return;
+	}
+	playing = name;
+	fadeSeconds = newFadeSeconds;
+	StartWorker();
+	changed.notify_all();
+}
+
+void MusicManager::Stop(float newFadeSeconds)
+{
+	std::lock_guard<std::mutex> lock(mutex);
+	if (playing.empty())
+	{
+		return;
+	}
+	playing.clear();
+	fadeSeconds = newFadeSeconds;
+	changed.notify_all();
+}
+
+void MusicManager::SetVolume(float newVolume)
+{
+	std::lock_guard<std::mutex> lock(mutex);
+	volume = newVolume;
+
+	// Wake the thread up, as it sleeps once nothing is fading, and it's what sets the music's volume
+	changed.notify_all();
+}
+
+std::string MusicManager::GetPlayingTrack()
+{
+	std::lock_guard<std::mutex> lock(mutex);
+	return playing;
+}
+
+float MusicManager::GetTrackFade(const std::string& name)
+{
+	std::lock_guard<std::mutex> lock(mutex);
+	Track* track = FindTrack(name);
+	return track != NULL ? track->fade : 0;
+}
+
+float MusicManager::GetTrackVolume(const std::string& name)
+{
+	std::lock_guard<std::mutex> lock(mutex);
+	Track* track = FindTrack(name);
+	return track != NULL ? track->playingVolume : 0;
+}
+
+int MusicManager::GetFileOpenCount()
+{
+	std::lock_guard<std::mutex> lock(mutex);
+	return fileOpens;
+}
+
+int MusicManager::GetFileOpenCount(const std::string& name)
+{
+	std::lock_guard<std::mutex> lock(mutex);
+	Track* track = FindTrack(name);
+	return track != NULL ? track->fileOpens : 0;
+}
+
+void MusicManager::WorkerLoop()
+{
+	sf::Clock clock;
+	std::unique_lock<std::mutex> lock(mutex);
+	while (!quit)
+	{
+		// Read any files that are wanted but not in memory yet. The lock is let go while reading,
+		// so the game never has to wait for the disk. (Tracks are never removed from the map, so
+		// it's safe to keep going through it.)
+		for (auto& pair : tracks)
+		{
+			Track& track = *pair.second;
+			bool wanted = pair.first == playing || track.preload;
+			if (!wanted || track.state != TRACK_UNLOADED)
+			{
+				continue;
+			}
+
+			track.state = TRACK_LOADING;
+			track.fileOpens++;
+			fileOpens++;
+			std::string filePath = track.filePath;
+			lock.unlock();
+
+			std::vector<char> bytes;
+			std::ifstream file(filePath, std::ios::binary);
+			if (file)
+			{
+				bytes.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+			}
+
+			// Only this thread uses track.music, and nothing else touches a loading track's bytes
+			track.bytes.swap(bytes);
+			bool ok = !track.bytes.empty() && track.music.openFromMemory(track.bytes.data(), track.bytes.size());
+
+			lock.lock();
+			if (ok)
+			{
+				track.state = TRACK_LOADED;
+				track.music.setLoop(true);
+			}
+			else
+			{
+				printf("Failed to load music %s\n", filePath.c_str());
+				track.state = TRACK_FAILED;
+				track.bytes.clear();
+			}
+		}
+
+		// Move every loaded track's volume towards 1 if it's playing, and 0 if it isn't
+		float elapsedSeconds = clock.restart().asSeconds();
+		float fadeStep = fadeSeconds > 0 ? elapsedSeconds / fadeSeconds : 1;
+		bool busy = false;
+		for (auto& pair : tracks)
+		{
+			Track& track = *pair.second;
+			if (track.state != TRACK_LOADED)
+			{
+				// A track asked for while another was loading still needs reading, next time around
+				bool wanted = pair.first == playing || track.preload;
+				busy = busy || (wanted && track.state == TRACK_UNLOADED);
+				continue;
+			}
+
+			if (pair.first == playing)
+			{
+				track.fade = std::min(track.fade + fadeStep, 1.0f);
+				busy = busy || track.fade < 1;
+			}
+			else
+			{
+				track.fade = std::max(track.fade - fadeStep, 0.0f);
+				busy = busy || track.fade > 0;
+			}
+
+			if (track.fade > 0)
+			{
+				track.playingVolume = track.fade * volume;
+				track.music.setVolume(track.playingVolume);
+				if (track.music.getStatus() != sf::Music::Playing)
+				{
+					track.music.play();
+				}
+			}
+			else if (pair.first != playing)
+			{
+				// Faded out. Let go of the file, unless it's meant to be kept.
+				if (track.music.getStatus() != sf::Music::Stopped)
+				{
+					track.music.stop();
+				}
+				track.playingVolume = 0;
+				if (!track.preload)
+				{
+					track.bytes.clear();
+					track.bytes.shrink_to_fit();
+					track.state = TRACK_UNLOADED;
+				}
+			}
+		}
+
+		// While fading or loading, wake up often enough to make fades smooth. Otherwise sleep until asked for something.
+		if (busy)
+		{
+			changed.wait_for(lock, std::chrono::milliseconds(10));
+		}
+		else
+		{
+			changed.wait(lock);
+			clock.restart();
+		}
+	}
+}
+
+bool RunMusicCheck()
+{
+	MusicManager manager;
+	manager.AddTrack("gunshot", "GunShot.wav");
+	manager.AddTrack("shoot", "Shoot1.wav");
+	bool ok = true;
+
+	// Holding P for a second, at 60 frames a second
+	float slowestPlay = 0;
+	for (int frame = 0; frame < 60; frame++)
+	{
+		sf::Clock playClock;
+		manager.Play("gunshot", 0.1f);
+		slowestPlay = std::max(slowestPlay, playClock.getElapsedTime().asSeconds());
+		sf::sleep(sf::seconds(1.0f / 60));
+	}
+	printf("Play every frame for 1 second: opened %d time(s), fade %.2f, slowest Play call %.3f ms\n",
+		manager.GetFileOpenCount("gunshot"), manager.GetTrackFade("gunshot"), slowestPlay * 1000);
+	ok = ok && manager.GetFileOpenCount("gunshot") == 1 && manager.GetTrackFade("gunshot") == 1;
+
+	// Fade across to the other track. Halfway through, both should be playing.
+	manager.Play("shoot", 0.5f);
+	sf::sleep(sf::seconds(0.25f));
+	float gunshotFade = manager.GetTrackFade("gunshot");
+	float shootFade = manager.GetTrackFade("shoot");
+	printf("Halfway through the crossfade: gunshot %.2f, shoot %.2f\n", gunshotFade, shootFade);
+	ok = ok && gunshotFade > 0 && gunshotFade < 1 && shootFade > 0 && shootFade < 1;
+
+	sf::sleep(sf::seconds(0.5f));
+	gunshotFade = manager.GetTrackFade("gunshot");
+	shootFade = manager.GetTrackFade("shoot");
+	printf("After the crossfade: gunshot %.2f, shoot %.2f, opened %d and %d time(s)\n",
+		gunshotFade, shootFade, manager.GetFileOpenCount("gunshot"), manager.GetFileOpenCount("shoot"));
+	ok = ok && gunshotFade == 0 && shootFade == 1 && manager.GetFileOpenCount("shoot") == 1;
+
+	// Changing the volume once the fade has finished (so the thread is asleep) still takes effect
+	manager.SetVolume(50);
+	sf::sleep(sf::seconds(0.05f));
+	printf("Volume set to 50 after the fade: shoot playing at %.0f\n", manager.GetTrackVolume("shoot"));
+	ok = ok && manager.GetTrackVolume("shoot") == 50;
+	manager.SetVolume(100);
+
+	// Playing the first track again is a new play session, so its file is read again
+	manager.Play("gunshot", 0.1f);
+	sf::sleep(sf::seconds(0.3f));
+	printf("Played gunshot again: opened %d time(s)\n", manager.GetFileOpenCount("gunshot"));
+	ok = ok && manager.GetFileOpenCount("gunshot") == 2;
+
+	manager.Stop(0);
+	printf(ok ? "Music check passed\n" : "Music check FAILED\n");
+	return ok;
+}
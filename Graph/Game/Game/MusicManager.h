@@ -0,0 +1,97 @@
+#pragma once
+#include <condition_variable>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include <SFML\Audio.hpp>
+
+// Plays music tracks by name, fading from one to the next.
+//
+// The game only ever says which track it wants. A background thread does everything slow: it reads
+// each file into memory once, opens the music from there, and raises and lowers the volumes for the
+// fades. So asking for music never touches the disk on the game's thread, and asking for the track
+// that's already playing does nothing at all. That makes it safe to call Play every frame, e.g. for
+// as long as a key is held.
+//
+// A track's file is read when it's first played and let go of once it has faded out, so each time a
+// track is played (a 'play session') its file is opened once. Preload keeps a track in memory for good.
+class MusicManager
+{
+public:
+	~MusicManager();
+
+	// Gives a music file a name to play it by
+	void AddTrack(const std::string& name, const std::string& filePath);
+
+	// Reads the track's file in the background now, and keeps it, so it starts straight away when played
+	void Preload(const std::string& name);
+
+	// Fades the playing track out and this one in, over fadeSeconds. Does nothing if it's already playing.
+	void Play(const std::string& name, float fadeSeconds = 0.5f);
+
+	// Fades out whatever is playing
+	void Stop(float fadeSeconds = 0.5f);
+
+	// 0 to 100, like sf::Music::setVolume
+	void SetVolume(float volume);
+
+	// The name of the track being played (or faded in), or "" if none is
+	std::string GetPlayingTrack();
+
+	// How loud the track is right now, from 0 (silent, or not loaded) to 1 (fully faded in)
+	float GetTrackFade(const std::string& name);
+
+	// The volume the track's music is playing at right now, from 0 to 100, including its fade
+	float GetTrackVolume(const std::string& name);
+
+	// How many times music files have been opened, in total or for one track
+	int GetFileOpenCount();
+	int GetFileOpenCount(const std::string& name);
+
+private:
+	enum TrackState
+	{
+		TRACK_UNLOADED,
+		TRACK_LOADING,
+		TRACK_LOADED,
+		TRACK_FAILED
+	};
+
+	struct Track
+	{
+		std::string filePath;
+		bool preload = false;
+		TrackState state = TRACK_UNLOADED;
+		std::vector<char> bytes;	// The whole file. sf::Music streams from here, instead of from the disk.
+		sf::Music music;			// Only ever used by the background thread
+		float fade = 0;
+		float playingVolume = 0;	// What the music's volume was last set to
+		int fileOpens = 0;
+	};
+
+	// Everything below is shared with the background thread, so is only used with the mutex locked
+	std::mutex mutex;
+	std::condition_variable changed;
+	std::thread worker;
+	bool quit = false;
+
+	std::map<std::string, std::unique_ptr<Track>> tracks;
+	std::string playing;
+	float fadeSeconds = 0.5f;
+	float volume = 100;
+	int fileOpens = 0;
+
+	void StartWorker();
+	void WorkerLoop();
+	Track* FindTrack(const std::string& name);
+};
+
+// The music played by PlayMusic and StopMusic
+extern MusicManager musicManager;
+
+// "Game.exe -musiccheck" plays a track every frame for a second, then fades to another, and checks
+// each file was only opened once. Returns false if anything went wrong.
+bool RunMusicCheck();
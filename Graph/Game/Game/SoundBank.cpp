@@ -0,0 +1,246 @@
+#include <algorithm>
+#include "Helpers.h"
+#include "SoundBank.h"
+
+SoundBank soundBank;
+
+SoundBank::SoundBank(int numVoices)
+{
+	this->numVoices = numVoices;
+}
+
+bool SoundBank::IsValid(SoundHandle sound)
+{
+	return sound >= 0 && sound < (int)sounds.size();
+}
+
+SoundHandle SoundBank::Load(const std::string& filePath)
+{
+	auto found = soundsByPath.find(filePath);
+	if (found != soundsByPath.end())
+	{
+		return found->second;
+	}
+
+	std::unique_ptr<LoadedSound> loaded(new LoadedSound());
+	if (!loaded->buffer.loadFromFile(filePath))
+	{
+		return NO_SOUND;
+	}
+	loaded->filePath = filePath;
+	sounds.push_back(std::move(loaded));
+
+	SoundHandle sound = (SoundHandle)sounds.size() - 1;
+	soundsByPath[filePath] = sound;
+	return sound;
+}
+
+void SoundBank::SetSettings(SoundHandle sound, const SoundSettings& settings)
+{
+	if (IsValid(sound))
+	{
+		sounds[sound]->settings = settings;
+	}
+}
+
+SoundSettings SoundBank::GetSettings(SoundHandle sound)
+{
+	return IsValid(sound) ? sounds[sound]->settings : SoundSettings();
+}
+
+const sf::SoundBuffer* SoundBank::GetBuffer(SoundHandle sound)
+{
+	return IsValid(sound) ? &sounds[sound]->buffer : NULL;
+}
+
+void SoundBank::StartVoice(Voice& voice, SoundHandle sound, float pitch, float now)
+{
+	LoadedSound& loaded = *sounds[sound];
+	voice.sound.stop();
+	if (voice.lastSound != sound)
+	{
+		voice.sound.setBuffer(loaded.buffer);
+	}
+	voice.sound.setVolume(loaded.settings.volume);
+	voice.sound.setPitch(pitch);
+	voice.sound.play();
+	voice.lastSound = sound;
+	voice.priority = loaded.settings.priority;
+	voice.startTime = now;
+	loaded.lastPlayTime = now;
+}
+
+bool SoundBank::Play(SoundHandle sound, float pitch)
+{
+	if (!IsValid(sound))
+	{
+		return false;
+	}
+	if (voices.empty())
+	{
+		voices.resize(numVoices);
+	}
+
+	LoadedSound& loaded = *sounds[sound];
+	float now = clock.getElapsedTime().asSeconds();
+	if (now - loaded.lastPlayTime < loaded.settings.cooldownSeconds)
+	{
+		stats.skippedCooldown++;
+		return false;
+	}
+
+	// Look through the voices once, for a free one, the oldest copy of this sound, and the voice
+	// that's least important to keep (lowest priority, then oldest)
+	Voice* freeVoice = NULL;
+	Voice* oldestCopy = NULL;
+	Voice* leastImportant = NULL;
+	int numCopies = 0;
+	int numPlaying = 0;
+	for (Voice& voice : voices)
+	{
+		if (voice.sound.getStatus() != sf::Sound::Playing)
+		{
+			if (freeVoice == NULL || voice.lastSound == sound)
+			{
+				// Reusing a voice which last played this sound saves setting its buffer again
+				freeVoice = &voice;
+			}
+			continue;
+		}
+
+		numPlaying++;
+		if (voice.lastSound == sound)
+		{
+			numCopies++;
+			if (oldestCopy == NULL || voice.startTime < oldestCopy->startTime)
+			{
+				oldestCopy = &voice;
+			}
+		}
+		if (leastImportant == NULL || voice.priority < leastImportant->priority ||
+			(voice.priority == leastImportant->priority && voice.startTime < leastImportant->startTime))
+		{
+			leastImportant = &voice;
+		}
+	}
+
+	Voice* voice = freeVoice;
+	if (numCopies >= loaded.settings.maxInstances && oldestCopy != NULL)
+	{
+		// Too many copies already, so start the oldest one again rather than adding another
+		voice = oldestCopy;
+		stats.restarted++;
+	}
+	else if (voice == NULL)
+	{
+		if (leastImportant == NULL || leastImportant->priority > loaded.settings.priority)
+		{
+			stats.skippedNoVoice++;
+			return false;
+		}
+		voice = leastImportant;
+		stats.stolen++;
+	}
+	else
+	{
+		numPlaying++;
+	}
+
+	StartVoice(*voice, sound, pitch, now);
+	stats.played++;
+	stats.mostVoicesPlaying = std::max(stats.mostVoicesPlaying, numPlaying);
+	return true;
+}
+
+void SoundBank::StopAll()
+{
+	for (Voice& voice : voices)
+	{
+		voice.sound.stop();
+	}
+}
+
+int SoundBank::GetVoiceCount()
+{
+	return numVoices;
+}
+
+int SoundBank::GetPlayingVoiceCount()
+{
+	int count = 0;
+	for (Voice& voice : voices)
+	{
+		if (voice.sound.getStatus() == sf::Sound::Playing)
+		{
+			count++;
+		}
+	}
+	return count;
+}
+
+int SoundBank::GetLoadedSoundCount()
+{
+	return (int)sounds.size();
+}
+
+SoundBankStats SoundBank::GetStats()
+{
+	return stats;
+}
+
+void RunSoundBenchmark()
+{
+	// Fewer voices than the sounds could use between them, so some have to be taken over
+	SoundBank bank(16);
+	const char* files[] = { "Explode1.wav", "Explode2.wav", "GunShot.wav", "Shoot1.wav", "Shoot2.wav" };
+	std::vector<SoundHandle> sounds;
+	for (const char* file : files)
+	{
+		// Loading every file twice should still only load it once
+		bank.Load(file);
+		SoundHandle sound = bank.Load(file);
+		if (sound == NO_SOUND)
+		{
+			printf("Couldn't load %s\n", file);
+			return;
+		}
+		sounds.push_back(sound);
+	}
+
+	// Explosions matter more than gunshots, so they can cut gunshots off
+	SoundSettings explosion;
+	explosion.priority = 1;
+	bank.SetSettings(sounds[0], explosion);
+	bank.SetSettings(sounds[1], explosion);
+
+	// 3 seconds at 60 frames a second, firing 8 sounds a frame (480 a second)
+	const int numFrames = 180;
+	const int soundsPerFrame = 8;
+	float totalPlaySeconds = 0;
+	float slowestPlaySeconds = 0;
+	unsigned int random = 1;
+	for (int frame = 0; frame < numFrames; frame++)
+	{
+		for (int i = 0; i < soundsPerFrame; i++)
+		{
+			random = random * 1664525u + 1013904223u;
+			SoundHandle sound = sounds[(random >> 16) % sounds.size()];
+			sf::Clock playClock;
+			bank.Play(sound, 0.8f + ((random >> 8) & 255) / 640.0f);
+			float playSeconds = playClock.getElapsedTime().asSeconds();
+			totalPlaySeconds += playSeconds;
+			slowestPlaySeconds = std::max(slowestPlaySeconds, playSeconds);
+		}
+		sf::sleep(sf::seconds(1.0f / 60));
+	}
+
+	SoundBankStats stats = bank.GetStats();
+	int numCalls = numFrames * soundsPerFrame;
+	printf("%d Play calls over %.0f seconds, %d sounds loaded, %d voices\n", numCalls, numFrames / 60.0f, bank.GetLoadedSoundCount(), bank.GetVoiceCount());
+	printf("  played %d (restarted %d, stole %d), skipped %d for cooldown and %d for no voice\n",
+		stats.played, stats.restarted, stats.stolen, stats.skippedCooldown, stats.skippedNoVoice);
+	printf("  most voices playing at once: %d\n", stats.mostVoicesPlaying);
+	printf("  Play: %.4f ms on average, %.4f ms at most, %.3f%% of a 60 Hz frame\n",
+		totalPlaySeconds * 1000 / numCalls, slowestPlaySeconds * 1000, totalPlaySeconds / numFrames * 60 * 100);
+	bank.StopAll();
+}
@@ -0,0 +1,102 @@
+#pragma once
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+#include <SFML\Audio.hpp>
+#include <SFML\System\Clock.hpp>
+
+// Which sound to play, from SoundBank::Load. Sounds are never unloaded, so a handle stays valid.
+typedef int SoundHandle;
+const SoundHandle NO_SOUND = -1;
+
+// How a sound behaves when it's played a lot
+struct SoundSettings
+{
+	int priority = 0;				// When every voice is busy, a sound can take over a voice of the same or lower priority
+	int maxInstances = 4;			// At most this many copies play at once. Playing another restarts the oldest.
+	float cooldownSeconds = 0.02f;	// Plays closer together than this are ignored
+	float volume = 100;				// 0 to 100
+};
+
+// Counts of what happened to every Play call
+struct SoundBankStats
+{
+	int played = 0;
+	int restarted = 0;			// Took over the oldest copy of the same sound, because of maxInstances
+	int stolen = 0;				// Took over another sound's voice, because every voice was busy
+	int skippedCooldown = 0;
+	int skippedNoVoice = 0;		// Every voice was busy with something more important
+	int mostVoicesPlaying = 0;
+};
+
+// Loads sound effects and plays them on a fixed number of 'voices'.
+//
+// Every playing sf::Sound needs one of the sound card's sources, and there are only so many.
+// So instead of an sf::Sound per effect, the bank keeps a fixed pool of them (the voices), and each
+// Play uses a free one. When they're all busy, the least important, oldest sound is cut off to make
+// room. Each file is only loaded once, however many times Load is called with it.
+//
+// Firing the same sound hundreds of times a second (like an explosion for every bullet) is kept
+// in check by each sound's maxInstances and cooldownSeconds, so one sound can't use every voice.
+class SoundBank
+{
+public:
+	SoundBank(int numVoices = 32);
+
+	// Loads a sound file, or returns the handle it already has. Returns NO_SOUND if it fails to load.
+	SoundHandle Load(const std::string& filePath);
+
+	void SetSettings(SoundHandle sound, const SoundSettings& settings);
+	SoundSettings GetSettings(SoundHandle sound);
+
+	// Plays the sound on a free voice, if it's allowed to. Returns false if it was skipped.
+	// pitch 1 is normal, 2 is an octave higher and twice as fast.
+	bool Play(SoundHandle sound, float pitch = 1);
+
+	void StopAll();
+
+	// The sound's samples, e.g. to give to your own sf::Sound
+	const sf::SoundBuffer* GetBuffer(SoundHandle sound);
+
+	int GetVoiceCount();
+	int GetPlayingVoiceCount();
+	int GetLoadedSoundCount();
+	SoundBankStats GetStats();
+
+private:
+	struct LoadedSound
+	{
+		std::string filePath;
+		sf::SoundBuffer buffer;
+		SoundSettings settings;
+		float lastPlayTime = -1000;
+	};
+
+	struct Voice
+	{
+		sf::Sound sound;
+		SoundHandle lastSound = NO_SOUND;	// The sound whose buffer it has, which may have finished playing
+		int priority = 0;
+		float startTime = 0;
+	};
+
+	// unique_ptr, so the buffers never move while sf::Sounds are using them
+	std::vector<std::unique_ptr<LoadedSound>> sounds;
+	std::map<std::string, SoundHandle> soundsByPath;
+
+	int numVoices;
+	std::vector<Voice> voices;	// Made the first time a sound is played, rather than when the program starts
+	sf::Clock clock;
+	SoundBankStats stats;
+
+	bool IsValid(SoundHandle sound);
+	void StartVoice(Voice& voice, SoundHandle sound, float pitch, float now);
+};
+
+// The sound bank used by LoadSound
+extern SoundBank soundBank;
+
+// "Game.exe -soundbench" fires the sounds in GameData hundreds of times a second for a few seconds,
+// and prints how many voices were used and how long each Play took
+void RunSoundBenchmark();
@@ -0,0 +1,775 @@
+#include <SFML\System\Clock.hpp>
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <fstream>
+#include <thread>
+#include <emmintrin.h>
+#include "Helpers.h"
+#include "SoundMixer.h"
+
+// How many frames are mixed at a time. This is also how much SFML is given each time it asks,
+// so it's a trade between delay (512 frames is 12 ms at 44100 Hz) and how often the audio thread wakes up.
+const int mixBlockFrames = 512;
+
+// A power of 2, so the ring's counters can wrap around past 4 billion and still land on the right slot
+const int commandQueueSize = 1024;
+
+SoundMixer::SoundMixer(int maxVoices, int maxSounds, unsigned int sampleRate)
+	: soundCount(0), commandWrite(0), commandRead(0), droppedCommands(0), activeVoices(0), startedVoices(0), useSimd(true)
+{
+	this->sampleRate = sampleRate;
+
+	// Allocate everything now, so the audio thread never has to allocate memory
+	sounds.resize(maxSounds);
+	commands.resize(commandQueueSize);
+	voices.resize(maxVoices);
+	left.resize(mixBlockFrames);
+	right.resize(mixBlockFrames);
+	chunk.resize(mixBlockFrames * 2);
+
+	initialize(2, sampleRate);
+}
+
+SoundMixer::~SoundMixer()
+{
+	// The audio thread calls onGetData, so it has to be stopped before this object goes away
+	stop();
+}
+
+int SoundMixer::AddSound(const std::string& filePath)
+{
+	// InputSoundFile just reads the file, without needing a sound card like sf::SoundBuffer does
+	sf::InputSoundFile file;
+	if (!file.openFromFile(filePath))
+	{
+		return -1;
+	}
+	int channelCount = (int)file.getChannelCount();
+	if (channelCount != 1 && channelCount != 2)
+	{
+		printf("%s has %d channels, but the mixer only plays mono and stereo sounds\n", filePath.c_str(), channelCount);
+		return -1;
+	}
+
+	std::vector<sf::Int16> fileSamples((size_t)file.getSampleCount());
+	fileSamples.resize((size_t)file.read(fileSamples.data(), fileSamples.size()));
+
+	std::vector<float> samples(fileSamples.size());
+	for (size_t i = 0; i < samples.size(); i++)
+	{
+		samples[i] = fileSamples[i] / 32768.0f;
+	}
+	return AddSound(samples, channelCount, file.getSampleRate());
+}
+
+int SoundMixer::AddSound(const std::vector<float>& samples, int channelCount, unsigned int soundSampleRate)
+{
+	if ((channelCount != 1 && channelCount != 2) || samples.size() < (size_t)channelCount)
+	{
+		printf("The mixer only plays mono and stereo sounds with at least one frame (this has %d channels and %d samples)\n",
+			channelCount, (int)samples.size());
+		return -1;
+	}
+
+	int sound = soundCount.load(std::memory_order_relaxed);
+	if (sound >= (int)sounds.size())
+	{
+		printf("The mixer already has %d sounds\n", (int)sounds.size());
+		return -1;
+	}
+
+	// The audio thread doesn't look at this sound until soundCount says it's there, so it's safe to fill in
+	MixerSound& mixerSound = sounds[sound];
+	mixerSound.samples = samples;
+	mixerSound.channelCount = channelCount;
+	mixerSound.frameCount = (int)samples.size() / channelCount;
+	mixerSound.sampleRate = soundSampleRate;
+	soundCount.store(sound + 1, std::memory_order_release);
+	return sound;
+}
+
+bool SoundMixer::PushCommand(const Command& command)
+{
+	unsigned int write = commandWrite.load(std::memory_order_relaxed);
+	unsigned int read = commandRead.load(std::memory_order_acquire);
+	if (write - read >= (unsigned int)commands.size())
+	{
+		// The audio thread hasn't caught up (or isn't running), so there's nowhere to put it
+		droppedCommands++;
+		return false;
+	}
+	commands[write % commands.size()] = command;
+
+	// Release makes sure the command is all written before the audio thread can see the new count
+	commandWrite.store(write + 1, std::memory_order_release);
+	return true;
+}
+
+MixerVoiceId SoundMixer::Play(int sound, float volume, float pan, float pitch, bool loop)
+{
+	if (sound < 0 || sound >= soundCount.load(std::memory_order_relaxed))
+	{
+		return NO_MIXER_VOICE;
+	}
+
+	// The game thread hands out the ids, so it can change the voice before the audio thread has started it
+	MixerVoiceId id = nextVoiceId++;
+	if (nextVoiceId == NO_MIXER_VOICE)
+	{
+		nextVoiceId++;
+	}
+
+	Command command = { COMMAND_PLAY, id, sound, volume, pan, pitch, loop };
+	return PushCommand(command) ? id : NO_MIXER_VOICE;
+}
+
+void SoundMixer::SetVoice(MixerVoiceId voice, float volume, float pan, float pitch)
+{
+	Command command = { COMMAND_SET, voice, 0, volume, pan, pitch, false };
+	PushCommand(command);
+}
+
+void SoundMixer::StopVoice(MixerVoiceId voice)
+{
+	Command command = { COMMAND_STOP, voice, 0, 0, 0, 0, false };
+	PushCommand(command);
+}
+
+void SoundMixer::StopAll()
+{
+	Command command = { COMMAND_STOP_ALL, NO_MIXER_VOICE, 0, 0, 0, 0, false };
+	PushCommand(command);
+}
+
+void SoundMixer::SetUseSimd(bool newUseSimd)
+{
+	useSimd = newUseSimd;
+}
+
+int SoundMixer::GetActiveVoiceCount()
+{
+	return activeVoices;
+}
+
+int SoundMixer::GetStartedVoiceCount()
+{
+	return startedVoices;
+}
+
+int SoundMixer::GetDroppedCommandCount()
+{
+	return droppedCommands;
+}
+
+unsigned int SoundMixer::GetOutputSampleRate()
+{
+	return sampleRate;
+}
+
+SoundMixer::Voice* SoundMixer::FindVoice(MixerVoiceId id)
+{
+	for (Voice& voice : voices)
+	{
+		if (voice.active && voice.id == id)
+		{
+			return &voice;
+		}
+	}
+	return NULL;
+}
+
+// Turns a volume and pan into a gain for each speaker. The gains are cos and sin of an angle (a
+// 'constant power' pan), so a sound is as loud panned to the middle as to one side. In the middle,
+// each side gets 0.71 of the volume.
+static void PanGains(float volume, float pan, float& leftGain, float& rightGain)
+{
+	pan = std::min(std::max(pan, -1.0f), 1.0f);
+	float angle = (pan + 1) * 0.78539816f;
+	leftGain = volume * cosf(angle);
+	rightGain = volume * sinf(angle);
+}
+
+void SoundMixer::RunCommands()
+{
+	unsigned int read = commandRead.load(std::memory_order_relaxed);
+	unsigned int write = commandWrite.load(std::memory_order_acquire);
+	int numSounds = soundCount.load(std::memory_order_acquire);
+	for (; read != write; read++)
+	{
+		const Command& command = commands[read % commands.size()];
+		if (command.type == COMMAND_PLAY)
+		{
+			if (command.sound >= numSounds)
+			{
+				continue;
+			}
+
+			// Use a free voice, or cut off the one that was started longest ago
+			Voice* voice = NULL;
+			for (Voice& candidate : voices)
+			{
+				if (!candidate.active)
+				{
+					voice = &candidate;
+					break;
+				}
+				if (voice == NULL || candidate.startOrder < voice->startOrder)
+				{
+					voice = &candidate;
+				}
+			}
+
+			const MixerSound& sound = sounds[command.sound];
+			voice->id = command.voice;
+			voice->active = true;
+			voice->loop = command.loop;
+			voice->stopping = false;
+			voice->sound = command.sound;
+			voice->position = 0;
+			voice->step = (double)std::max(command.pitch, 0.0f) * sound.sampleRate / sampleRate;
+			voice->startOrder = startedVoices;
+			PanGains(command.volume, command.pan, voice->targetLeftGain, voice->targetRightGain);
+			voice->leftGain = voice->targetLeftGain;
+			voice->rightGain = voice->targetRightGain;
+			startedVoices++;
+		}
+		else if (command.type == COMMAND_SET)
+		{
+			Voice* voice = FindVoice(command.voice);
+			if (voice != NULL && !voice->stopping)
+			{
+				voice->step = (double)std::max(command.pitch, 0.0f) * sounds[voice->sound].sampleRate / sampleRate;
+				PanGains(command.volume, command.pan, voice->targetLeftGain, voice->targetRightGain);
+			}
+		}
+		else
+		{
+			// Stopping fades out over the next mix, rather than cutting off with a click
+			for (Voice& voice : voices)
+			{
+				if (voice.active && (command.type == COMMAND_STOP_ALL || voice.id == command.voice))
+				{
+					voice.stopping = true;
+					voice.targetLeftGain = 0;
+					voice.targetRightGain = 0;
+				}
+			}
+		}
+	}
+
+	// Lets the game thread reuse those slots
+	commandRead.store(read, std::memory_order_release);
+}
+
+// Adds four frames at a time of one voice to the mix, for as long as all four are inside the sound.
+// The sound's samples have to be looked up one by one, since with a pitch the positions aren't whole
+// numbers, but blending between them, the volume and pan, and adding to the mix are done four at once.
+void SoundMixer::MixVoiceSimd(Voice& voice, const MixerSound& sound, const float gainStart[2], const float gainStep[2], int& frame, int frameCount)
+{
+	const float* data = sound.samples.data();
+	const __m128 leftStart = _mm_set1_ps(gainStart[0]);
+	const __m128 rightStart = _mm_set1_ps(gainStart[1]);
+	const __m128 leftStep = _mm_set1_ps(gainStep[0]);
+	const __m128 rightStep = _mm_set1_ps(gainStep[1]);
+
+	// Playing at its own rate, from a whole sample, there's nothing to blend, so the samples can be loaded four at a time
+	bool exact = voice.step == 1.0 && voice.position == floor(voice.position);
+
+	while (frame + 4 <= frameCount && (int)(voice.position + voice.step * 4) + 1 < sound.frameCount)
+	{
+		__m128 frames = _mm_set_ps((float)(frame + 3), (float)(frame + 2), (float)(frame + 1), (float)frame);
+		__m128 leftGain = _mm_add_ps(leftStart, _mm_mul_ps(leftStep, frames));
+		__m128 rightGain = _mm_add_ps(rightStart, _mm_mul_ps(rightStep, frames));
+
+		__m128 leftSample, rightSample;
+		if (exact)
+		{
+			int index = (int)voice.position;
+			if (sound.channelCount == 1)
+			{
+				leftSample = _mm_loadu_ps(data + index);
+				rightSample = leftSample;
+			}
+			else
+			{
+				// L0 R0 L1 R1 and L2 R2 L3 R3, split into L0 L1 L2 L3 and R0 R1 R2 R3
+				__m128 first = _mm_loadu_ps(data + index * 2);
+				__m128 second = _mm_loadu_ps(data + index * 2 + 4);
+				leftSample = _mm_shuffle_ps(first, second, _MM_SHUFFLE(2, 0, 2, 0));
+				rightSample = _mm_shuffle_ps(first, second, _MM_SHUFFLE(3, 1, 3, 1));
+			}
+			voice.position += 4;
+		}
+		else
+		{
+			// Each output frame falls between two of the sound's frames, 'fraction' of the way along.
+			// Measured from the whole frame before the first one, the four positions are small enough
+			// for floats to hold exactly enough, so they can be worked out together.
+			int baseIndex = (int)voice.position;
+			__m128 offsets = _mm_add_ps(_mm_set1_ps((float)(voice.position - baseIndex)), _mm_mul_ps(_mm_set1_ps((float)voice.step), _mm_set_ps(3, 2, 1, 0)));
+			__m128i wholeOffsets = _mm_cvttps_epi32(offsets);
+			__m128 blend = _mm_sub_ps(offsets, _mm_cvtepi32_ps(wholeOffsets));
+			int index[4];
+			_mm_storeu_si128((__m128i*)index, _mm_add_epi32(wholeOffsets, _mm_set1_epi32(baseIndex)));
+			voice.position += voice.step * 4;
+
+			int channels = sound.channelCount;
+			const int* i = index;
+			__m128 leftA = _mm_set_ps(data[i[3] * channels], data[i[2] * channels], data[i[1] * channels], data[i[0] * channels]);
+			__m128 leftB = _mm_set_ps(data[(i[3] + 1) * channels], data[(i[2] + 1) * channels], data[(i[1] + 1) * channels], data[(i[0] + 1) * channels]);
+			leftSample = _mm_add_ps(leftA, _mm_mul_ps(_mm_sub_ps(leftB, leftA), blend));
+			if (channels == 1)
+			{
+				rightSample = leftSample;
+			}
+			else
+			{
+				__m128 rightA = _mm_set_ps(data[i[3] * 2 + 1], data[i[2] * 2 + 1], data[i[1] * 2 + 1], data[i[0] * 2 + 1]);
+				__m128 rightB = _mm_set_ps(data[i[3] * 2 + 3], data[i[2] * 2 + 3], data[i[1] * 2 + 3], data[i[0] * 2 + 3]);
+				rightSample = _mm_add_ps(rightA, _mm_mul_ps(_mm_sub_ps(rightB, rightA), blend));
+			}
+		}
+
+		_mm_storeu_ps(&left[frame], _mm_add_ps(_mm_loadu_ps(&left[frame]), _mm_mul_ps(leftSample, leftGain)));
+		_mm_storeu_ps(&right[frame], _mm_add_ps(_mm_loadu_ps(&right[frame]), _mm_mul_ps(rightSample, rightGain)));
+		frame += 4;
+	}
+}
+
+void SoundMixer::MixVoice(Voice& voice, int frameCount)
+{
+	const MixerSound& sound = sounds[voice.sound];
+	const float* data = sound.samples.data();
+	int channels = sound.channelCount;
+
+	// A change of volume or pan slides from the old gains to the new ones over this mix
+	float gainStart[2] = { voice.leftGain, voice.rightGain };
+	float gainStep[2] = { (voice.targetLeftGain - voice.leftGain) / frameCount, (voice.targetRightGain - voice.rightGain) / frameCount };
+
+	int frame = 0;
+	while (frame < frameCount)
+	{
+		if (useSimd)
+		{
+			MixVoiceSimd(voice, sound, gainStart, gainStep, frame, frameCount);
+			if (frame >= frameCount)
+			{
+				break;
+			}
+		}
+
+		// One frame at a time near the end of the sound, where it loops or stops (or always, without SSE)
+		int index = (int)voice.position;
+		if (index >= sound.frameCount)
+		{
+			if (!voice.loop)
+			{
+				voice.active = false;
+				return;
+			}
+			// fmod rather than one subtraction, since at a high pitch a short sound can be stepped past more than once
+			voice.position = fmod(voice.position, (double)sound.frameCount);
+			index = (int)voice.position;
+		}
+		int nextIndex = index + 1;
+		if (nextIndex >= sound.frameCount)
+		{
+			// Past the last sample, blend towards the start if looping, or silence if not
+			nextIndex = voice.loop ? 0 : -1;
+		}
+		float fraction = (float)(voice.position - index);
+		float leftGain = gainStart[0] + gainStep[0] * (float)frame;
+		float rightGain = gainStart[1] + gainStep[1] * (float)frame;
+
+		float leftA = data[index * channels];
+		float leftB = nextIndex >= 0 ? data[nextIndex * channels] : 0;
+		float leftSample = leftA + (leftB - leftA) * fraction;
+		float rightSample = leftSample;
+		if (channels == 2)
+		{
+			float rightA = data[index * 2 + 1];
+			float rightB = nextIndex >= 0 ? data[nextIndex * 2 + 1] : 0;
+			rightSample = rightA + (rightB - rightA) * fraction;
+		}
+		left[frame] += leftSample * leftGain;
+		right[frame] += rightSample * rightGain;
+
+		voice.position += voice.step;
+		frame++;
+	}
+
+	voice.leftGain = voice.targetLeftGain;
+	voice.rightGain = voice.targetRightGain;
+	if (voice.stopping)
+	{
+		voice.active = false;
+	}
+}
+
+void SoundMixer::MixBlock(sf::Int16* samples, int frameCount)
+{
+	std::fill(left.begin(), left.begin() + frameCount, 0.0f);
+	std::fill(right.begin(), right.begin() + frameCount, 0.0f);
+	for (Voice& voice : voices)
+	{
+		if (voice.active)
+		{
+			MixVoice(voice, frameCount);
+		}
+	}
+
+	// Turn the mix into 16 bit samples, with left and right interleaved, clipping anything too loud
+	int frame = 0;
+	if (useSimd)
+	{
+		const __m128 scale = _mm_set1_ps(32767);
+		const __m128 lowest = _mm_set1_ps(-32768);
+		for (; frame + 4 <= frameCount; frame += 4)
+		{
+			__m128 l = _mm_min_ps(_mm_max_ps(_mm_mul_ps(_mm_loadu_ps(&left[frame]), scale), lowest), scale);
+			__m128 r = _mm_min_ps(_mm_max_ps(_mm_mul_ps(_mm_loadu_ps(&right[frame]), scale), lowest), scale);
+			__m128i li = _mm_cvtps_epi32(l);
+			__m128i ri = _mm_cvtps_epi32(r);
+			__m128i firstTwo = _mm_unpacklo_epi32(li, ri);	// L0 R0 L1 R1
+			__m128i lastTwo = _mm_unpackhi_epi32(li, ri);	// L2 R2 L3 R3
+			_mm_storeu_si128((__m128i*)(samples + frame * 2), _mm_packs_epi32(firstTwo, lastTwo));
+		}
+	}
+	for (; frame < frameCount; frame++)
+	{
+		samples[frame * 2] = (sf::Int16)lrintf(std::min(std::max(left[frame] * 32767, -32768.0f), 32767.0f));
+		samples[frame * 2 + 1] = (sf::Int16)lrintf(std::min(std::max(right[frame] * 32767, -32768.0f), 32767.0f));
+	}
+}
+
+void SoundMixer::Mix(sf::Int16* samples, int frameCount)
+{
+	RunCommands();
+	for (int frame = 0; frame < frameCount; frame += mixBlockFrames)
+	{
+		MixBlock(samples + frame * 2, std::min(mixBlockFrames, frameCount - frame));
+	}
+
+	int count = 0;
+	for (Voice& voice : voices)
+	{
+		count += voice.active ? 1 : 0;
+	}
+	activeVoices = count;
+}
+
+bool SoundMixer::onGetData(Chunk& data)
+{
+	Mix(chunk.data(), mixBlockFrames);
+	data.samples = chunk.data();
+	data.sampleCount = chunk.size();
+
+	// Returning true keeps the stream going forever, with silence when nothing is playing
+	return true;
+}
+
+void SoundMixer::onSeek(sf::Time timeOffset)
+{
+	// The mix is made as it goes, so there's nowhere to seek to
+}
+
+// WAV files store numbers lowest byte first, whatever the computer does
+static void WriteLittleEndian(char* bytes, unsigned int value, int byteCount)
+{
+	for (int i = 0; i < byteCount; i++)
+	{
+		bytes[i] = (char)((value >> (i * 8)) & 255);
+	}
+}
+
+static void WriteLittleEndian(std::ofstream& file, unsigned int value, int byteCount)
+{
+	char bytes[4];
+	WriteLittleEndian(bytes, value, byteCount);
+	file.write(bytes, byteCount);
+}
+
+bool SoundMixer::RenderToWav(const std::string& filePath, float seconds)
+{
+	std::ofstream file(filePath, std::ios::binary);
+	if (!file)
+	{
+		printf("Couldn't write %s\n", filePath.c_str());
+		return false;
+	}
+
+	// The header of a plain WAV file: 16 bit samples, 2 channels
+	unsigned int frameCount = (unsigned int)(seconds * sampleRate);
+	unsigned int dataBytes = frameCount * 4;
+	file.write("RIFF", 4);
+	WriteLittleEndian(file, 36 + dataBytes, 4);
+	file.write("WAVEfmt ", 8);
+	WriteLittleEndian(file, 16, 4);				// Size of the format
+	WriteLittleEndian(file, 1, 2);				// PCM, i.e. not compressed
+	WriteLittleEndian(file, 2, 2);				// Channels
+	WriteLittleEndian(file, sampleRate, 4);
+	WriteLittleEndian(file, sampleRate * 4, 4);	// Bytes a second
+	WriteLittleEndian(file, 4, 2);				// Bytes a frame
+	WriteLittleEndian(file, 16, 2);				// Bits a sample
+	file.write("data", 4);
+	WriteLittleEndian(file, dataBytes, 4);
+
+	// Mix it a block at a time, the same as when it's playing, so commands are picked up at the same points
+	std::vector<sf::Int16> block(mixBlockFrames * 2);
+	std::vector<char> bytes(mixBlockFrames * 4);
+	for (unsigned int frame = 0; frame < frameCount; frame += mixBlockFrames)
+	{
+		int count = (int)std::min((unsigned int)mixBlockFrames, frameCount - frame);
+		Mix(block.data(), count);
+		for (int i = 0; i < count * 2; i++)
+		{
+			WriteLittleEndian(&bytes[i * 2], (unsigned short)block[i], 2);
+		}
+		file.write(bytes.data(), count * 4);
+	}
+	return (bool)file;
+}
+
+// Checks a sample is within 1 of what it should be (rounding can go either way)
+static bool Near(const char* what, int sample, float expected, bool& ok)
+{
+	if (fabsf(sample - expected) <= 1)
+	{
+		return true;
+	}
+	printf("  %s: got %d, should be %.0f\n", what, sample, expected);
+	ok = false;
+	return false;
+}
+
+bool RunMixerCheck()
+{
+	bool ok = true;
+	std::vector<sf::Int16> out(4096 * 2);
+
+	// A steady half volume tone, 1000 frames long
+	SoundMixer mixer(8);
+	int flat = mixer.AddSound(std::vector<float>(1000, 0.5f), 1, 44100);
+
+	// Panned to the middle, each side gets cos(45 degrees) of it
+	mixer.Play(flat);
+	mixer.Mix(out.data(), 1001);
+	Near("middle, left", out[0], 0.5f * 0.70710678f * 32767, ok);
+	Near("middle, right", out[1], 0.5f * 0.70710678f * 32767, ok);
+	Near("middle, last frame", out[999 * 2], 0.5f * 0.70710678f * 32767, ok);
+	Near("middle, after the end", out[1000 * 2], 0, ok);
+	Near("voices after the end", mixer.GetActiveVoiceCount(), 0, ok);
+
+	mixer.Play(flat, 1, -1);
+	mixer.Mix(out.data(), 100);
+	Near("left pan, left", out[50 * 2], 0.5f * 32767, ok);
+	Near("left pan, right", out[50 * 2 + 1], 0, ok);
+	mixer.StopAll();
+	mixer.Mix(out.data(), 100);
+
+	mixer.Play(flat, 0.5f, 1);
+	mixer.Mix(out.data(), 100);
+	Near("right pan at half volume, left", out[50 * 2], 0, ok);
+	Near("right pan at half volume, right", out[50 * 2 + 1], 0.25f * 32767, ok);
+	mixer.StopAll();
+	mixer.Mix(out.data(), 100);
+	printf("Volume and pan: %s\n", ok ? "ok" : "WRONG");
+
+	// A ramp from 0 to 1, so each sample says where in the sound it came from
+	std::vector<float> rampSamples(2000);
+	for (int i = 0; i < 2000; i++)
+	{
+		rampSamples[i] = i / 2000.0f;
+	}
+	int ramp = mixer.AddSound(rampSamples, 1, 44100);
+	int halfRateRamp = mixer.AddSound(rampSamples, 1, 22050);
+
+	// Twice the pitch skips every other sample, and finishes in half the time
+	mixer.Play(ramp, 1, -1, 2);
+	mixer.Mix(out.data(), 1001);
+	bool pitchOk = true;
+	for (int frame = 0; frame < 1000; frame += 37)
+	{
+		Near("pitch 2", out[frame * 2], frame * 2 / 2000.0f * 32767, pitchOk);
+	}
+	Near("pitch 2, after the end", out[1000 * 2], 0, pitchOk);
+
+	// A 22050 Hz sound is stretched to 44100 Hz, with the frames in between blended from their neighbours
+	mixer.Play(halfRateRamp, 1, -1);
+	mixer.Mix(out.data(), 3000);
+	for (int frame = 1; frame < 3000; frame += 50)
+	{
+		Near("22050 Hz", out[frame * 2], frame * 0.5f / 2000.0f * 32767, pitchOk);
+	}
+	mixer.StopAll();
+	mixer.Mix(out.data(), 100);
+	pitchOk = pitchOk && mixer.GetActiveVoiceCount() == 0;
+	ok = ok && pitchOk;
+	printf("Pitch and sample rates: %s\n", pitchOk ? "ok" : "WRONG");
+
+	// Stopping fades out over one mix instead of clicking
+	bool stopOk = true;
+	MixerVoiceId looping = mixer.Play(flat, 1, -1, 1, true);
+	mixer.Mix(out.data(), 512);
+	mixer.StopVoice(looping);
+	mixer.Mix(out.data(), 512);
+	stopOk = stopOk && out[0] > out[256 * 2] && out[256 * 2] > out[511 * 2] && out[511 * 2] < 200;
+	stopOk = stopOk && mixer.GetActiveVoiceCount() == 0;
+	ok = ok && stopOk;
+	printf("Looping, then stopping with a fade: %s\n", stopOk ? "ok" : "WRONG");
+
+	// A tiny looping sound at a high pitch steps past its end several times a frame, and has to wrap
+	// back inside it rather than reading past the samples. Sounds that can't be played are refused.
+	bool edgeOk = true;
+	int tiny = mixer.AddSound(std::vector<float>(3, 0.25f), 1, 44100);
+	MixerVoiceId tinyVoice = mixer.Play(tiny, 1, -1, 8, true);
+	mixer.Mix(out.data(), 1000);
+	Near("3 frame loop at pitch 8", out[999 * 2], 0.25f * 32767, edgeOk);
+	mixer.StopVoice(tinyVoice);
+	mixer.Mix(out.data(), 512);
+	edgeOk = edgeOk && mixer.AddSound(std::vector<float>(), 1, 44100) == -1;
+	edgeOk = edgeOk && mixer.AddSound(std::vector<float>(100, 0.5f), 0, 44100) == -1;
+	edgeOk = edgeOk && mixer.AddSound(std::vector<float>(100, 0.5f), 3, 44100) == -1;
+	ok = ok && edgeOk;
+	printf("Short loops at high pitches, and empty sounds: %s\n", edgeOk ? "ok" : "WRONG");
+
+	// The same voices mixed with SSE and without should come out the same
+	SoundMixer simdMixer(64), plainMixer(64);
+	plainMixer.SetUseSimd(false);
+	const char* files[] = { "Explode1.wav", "Explode2.wav", "GunShot.wav", "Shoot1.wav", "Shoot2.wav" };
+	for (const char* file : files)
+	{
+		if (simdMixer.AddSound(file) < 0 || plainMixer.AddSound(file) < 0)
+		{
+			printf("Couldn't load %s\n", file);
+			return false;
+		}
+	}
+	std::vector<sf::Int16> simdOut(44100 * 2), plainOut(44100 * 2);
+	unsigned int random = 1;
+	int mostDifferent = 0;
+	for (int block = 0; block < 20; block++)
+	{
+		for (int i = 0; i < 4; i++)
+		{
+			random = random * 1664525u + 1013904223u;
+			int sound = (random >> 16) % 5;
+			float volume = 0.05f + ((random >> 4) & 255) / 1024.0f;
+			float pan = ((random >> 12) & 255) / 127.5f - 1;
+			float pitch = 0.5f + ((random >> 20) & 255) / 170.0f;
+			if (i == 0)
+			{
+				pitch = 1;	// Some at their own rate, for the quicker way of loading samples
+			}
+			simdMixer.Play(sound, volume, pan, pitch, i == 1);
+			plainMixer.Play(sound, volume, pan, pitch, i == 1);
+		}
+		simdMixer.Mix(simdOut.data(), 44100);
+		plainMixer.Mix(plainOut.data(), 44100);
+		for (size_t i = 0; i < simdOut.size(); i++)
+		{
+			mostDifferent = std::max(mostDifferent, abs(simdOut[i] - plainOut[i]));
+		}
+	}
+	bool sameOk = mostDifferent <= 1;
+	ok = ok && sameOk;
+	printf("SSE against plain, 20 seconds of up to 64 voices: most different sample %d: %s\n", mostDifferent, sameOk ? "ok" : "WRONG");
+
+	// The game thread queues commands while another thread mixes, like SFML's audio thread would.
+	// Every Play should either be started or counted as dropped.
+	SoundMixer threadedMixer(32);
+	int tick = threadedMixer.AddSound(std::vector<float>(100, 0.1f), 1, 44100);
+	std::atomic<bool> mixing(true);
+	std::thread audioThread([&]()
+	{
+		std::vector<sf::Int16> block(mixBlockFrames * 2);
+		while (mixing)
+		{
+			threadedMixer.Mix(block.data(), mixBlockFrames);
+		}
+		threadedMixer.Mix(block.data(), mixBlockFrames);
+	});
+	// 500 Plays a frame for 400 frames, so the queue mostly keeps up, with nothing but the atomics between the threads
+	const int numPlays = 200000;
+	int queued = 0;
+	for (int i = 0; i < numPlays; i++)
+	{
+		queued += threadedMixer.Play(tick, 1, 0, 1 + (i & 7) * 0.1f) != NO_MIXER_VOICE ? 1 : 0;
+		if (i % 500 == 499)
+		{
+			sf::sleep(sf::milliseconds(1));
+		}
+	}
+	mixing = false;
+	audioThread.join();
+	bool threadOk = queued == threadedMixer.GetStartedVoiceCount() && queued + threadedMixer.GetDroppedCommandCount() == numPlays;
+	ok = ok && threadOk;
+	printf("%d Plays from another thread: %d started, %d dropped because the queue was full: %s\n",
+		numPlays, threadedMixer.GetStartedVoiceCount(), threadedMixer.GetDroppedCommandCount(), threadOk ? "ok" : "WRONG");
+
+	printf(ok ? "Mixer check passed\n" : "Mixer check FAILED\n");
+	return ok;
+}
+
+// Mixes the given number of seconds of whatever is playing, and returns how long that took
+static float TimeMix(SoundMixer& mixer, float seconds, const char* wavPath)
+{
+	sf::Clock clock;
+	if (wavPath != NULL)
+	{
+		mixer.RenderToWav(wavPath, seconds);
+	}
+	else
+	{
+		std::vector<sf::Int16> block(mixBlockFrames * 2);
+		int frameCount = (int)(seconds * mixer.GetOutputSampleRate());
+		for (int frame = 0; frame < frameCount; frame += mixBlockFrames)
+		{
+			mixer.Mix(block.data(), mixBlockFrames);
+		}
+	}
+	return clock.getElapsedTime().asSeconds();
+}
+
+void RunMixerBenchmark()
+{
+	const int numVoices = 256;
+	const float seconds = 10;
+	const char* files[] = { "Explode1.wav", "Explode2.wav", "GunShot.wav", "Shoot1.wav", "Shoot2.wav" };
+
+	for (int resampled = 0; resampled < 2; resampled++)
+	{
+		for (int simd = 1; simd >= 0; simd--)
+		{
+			SoundMixer mixer(numVoices);
+			mixer.SetUseSimd(simd != 0);
+			for (const char* file : files)
+			{
+				if (mixer.AddSound(file) < 0)
+				{
+					printf("Couldn't load %s\n", file);
+					return;
+				}
+			}
+
+			// Every voice loops for the whole time, quietly enough that they don't clip when added up
+			unsigned int random = 1;
+			for (int i = 0; i < numVoices; i++)
+			{
+				random = random * 1664525u + 1013904223u;
+				float pan = ((random >> 12) & 255) / 127.5f - 1;
+				float pitch = resampled ? 0.5f + ((random >> 20) & 255) / 170.0f : 1;
+				mixer.Play(i % 5, 0.02f, pan, pitch, true);
+			}
+
+			// The SSE mix with every voice resampled is saved, to listen to
+			const char* wavPath = simd && resampled ? "mixbench.wav" : NULL;
+			float mixSeconds = TimeMix(mixer, seconds, wavPath);
+			printf("%d voices, %s, %s: %.0f seconds mixed in %.2f seconds, %.0fx real time, %.2f ns per voice per frame%s%s\n",
+				mixer.GetActiveVoiceCount(), resampled ? "random pitches" : "pitch 1", simd ? "SSE  " : "plain",
+				seconds, mixSeconds, seconds / mixSeconds, mixSeconds * 1e9f / (seconds * mixer.GetOutputSampleRate() * numVoices),
+				wavPath != NULL ? ", saved to " : "", wavPath != NULL ? wavPath : "");
+		}
+	}
+}
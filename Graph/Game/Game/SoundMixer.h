@@ -0,0 +1,150 @@
+#pragma once
+#include <atomic>
+#include <string>
+#include <vector>
+#include <SFML\Audio.hpp>
+
+// Which playing copy of a sound to change or stop, from SoundMixer::Play
+typedef unsigned int MixerVoiceId;
+const MixerVoiceId NO_MIXER_VOICE = 0;
+
+// Mixes any number of sounds together in software, and plays the result as one sf::SoundStream.
+//
+// sf::Sound (and SoundBank) give every playing sound its own source on the sound card, and there are
+// only so many of them. The mixer only ever uses one: SFML's audio thread asks it for the next bit of
+// sound (onGetData), and it adds up every playing voice, with its own volume, pan and pitch, four
+// samples at a time with SSE.
+//
+// The game never touches the voices itself. Play, SetVoice and StopVoice put a command in a queue,
+// which the audio thread reads the next time it mixes, so neither thread ever waits for the other.
+// Only one thread (the game's) should call them.
+//
+// Like any sf::SoundStream, call play() once to start it, then Play sounds on it for as long as you like.
+//
+// The mix can also be made without playing it (RenderToWav), which is how "-mixcheck" and
+// "-mixbench" test it without a sound card.
+class SoundMixer : public sf::SoundStream
+{
+public:
+	// Sounds are at most maxSounds files, and at most maxVoices of them play at once.
+	// Playing one more than that cuts off the oldest.
+	SoundMixer(int maxVoices = 256, int maxSounds = 64, unsigned int sampleRate = 44100);
+	~SoundMixer();
+
+	// Loads a mono or stereo sound file, and returns its number, or -1 if it can't be loaded.
+	// Sounds can be added while the mixer is playing.
+	int AddSound(const std::string& filePath);
+
+	// Adds a sound from samples which are already in memory, e.g. to make test tones.
+	// Returns -1 unless it has 1 or 2 channels and at least one frame.
+	int AddSound(const std::vector<float>& samples, int channelCount, unsigned int sampleRate);
+
+	// Starts a sound. volume 1 is as loud as the file, pan -1 is fully left and 1 fully right, and
+	// pitch 2 plays it an octave higher and twice as fast. Returns NO_MIXER_VOICE if the queue is full.
+	MixerVoiceId Play(int sound, float volume = 1, float pan = 0, float pitch = 1, bool loop = false);
+
+	// Changes a voice that's playing. Volume changes fade over one mix, so they don't click.
+	void SetVoice(MixerVoiceId voice, float volume, float pan, float pitch);
+	void StopVoice(MixerVoiceId voice);
+	void StopAll();
+
+	// Mixes the next frameCount frames (a frame is a left and a right sample) into samples.
+	// The audio thread calls this while the mixer is playing, so only call it yourself when it isn't.
+	void Mix(sf::Int16* samples, int frameCount);
+
+	// Mixes the given number of seconds without playing them, and saves them as a 16 bit stereo WAV file.
+	// Also only while the mixer isn't playing.
+	bool RenderToWav(const std::string& filePath, float seconds);
+
+	// Plain C++ instead of SSE, one sample at a time, to check the SSE version against
+	void SetUseSimd(bool useSimd);
+
+	int GetActiveVoiceCount();
+	int GetStartedVoiceCount();		// How many Play commands the audio thread has carried out
+	int GetDroppedCommandCount();
+	unsigned int GetOutputSampleRate();
+
+protected:
+	virtual bool onGetData(Chunk& data);
+	virtual void onSeek(sf::Time timeOffset);
+
+private:
+	struct MixerSound
+	{
+		std::vector<float> samples;		// -1 to 1, left and right interleaved for stereo
+		int channelCount = 1;
+		int frameCount = 0;
+		unsigned int sampleRate = 44100;
+	};
+
+	struct Voice
+	{
+		MixerVoiceId id = NO_MIXER_VOICE;
+		bool active = false;
+		bool loop = false;
+		bool stopping = false;			// Fading to silence, then stops
+		int sound = 0;
+		double position = 0;			// In the sound's frames. Not a whole number when the pitch isn't 1.
+		double step = 1;				// How far position moves each output frame
+		int startOrder = 0;				// Which voice to cut off first, when they're all busy
+		float leftGain = 0, rightGain = 0;
+		float targetLeftGain = 0, targetRightGain = 0;
+	};
+
+	enum CommandType
+	{
+		COMMAND_PLAY,
+		COMMAND_SET,
+		COMMAND_STOP,
+		COMMAND_STOP_ALL
+	};
+
+	struct Command
+	{
+		CommandType type;
+		MixerVoiceId voice;
+		int sound;
+		float volume, pan, pitch;
+		bool loop;
+	};
+
+	unsigned int sampleRate;
+
+	// Sounds are written by the game thread, then published by bumping soundCount,
+	// so the audio thread only ever reads ones which are finished
+	std::vector<MixerSound> sounds;
+	std::atomic<int> soundCount;
+
+	// A ring of commands with one writer (the game) and one reader (the audio thread).
+	// The writer only moves commandWrite and the reader only moves commandRead, so no lock is needed.
+	std::vector<Command> commands;
+	std::atomic<unsigned int> commandWrite;
+	std::atomic<unsigned int> commandRead;
+	MixerVoiceId nextVoiceId = 1;
+	std::atomic<int> droppedCommands;
+
+	// Only used by whichever thread is mixing
+	std::vector<Voice> voices;
+	std::vector<float> left, right;		// The mix, before it's turned into 16 bit samples
+	std::vector<sf::Int16> chunk;		// What onGetData hands to SFML
+
+	// Written while mixing, and read by the game
+	std::atomic<int> activeVoices;
+	std::atomic<int> startedVoices;
+	std::atomic<bool> useSimd;
+
+	bool PushCommand(const Command& command);
+	void RunCommands();
+	Voice* FindVoice(MixerVoiceId id);
+	void MixVoice(Voice& voice, int frameCount);
+	void MixVoiceSimd(Voice& voice, const MixerSound& sound, const float gainStart[2], const float gainStep[2], int& frame, int frameCount);
+	void MixBlock(sf::Int16* samples, int frameCount);
+};
+
+// "Game.exe -mixcheck" mixes test tones and checks the volumes, pans and pitches come out right,
+// and that the SSE mix matches the plain one. Returns false if anything is wrong.
+bool RunMixerCheck();
+
+// "Game.exe -mixbench" mixes hundreds of the GameData sounds at once, saves it as mixbench.wav,
+// and prints how much faster than real time that was, with and without SSE
+void RunMixerBenchmark();
@@ -0,0 +1,219 @@
+#include <math.h>
+#include <stdio.h>
+#include "Main.h"
+#include "Axes.h"
+
+const unsigned int LABEL_SIZE = 12;		// Height of the numbers, in pixels
+const float TICK_HALF_LENGTH = 5;
+const float SMALLEST_TICK_GAP = 40;		// Pixels. Ticks are never closer than this...
+const float LABEL_GAP = 12;				// ...or than the numbers' width plus this.
+
+double NiceNumberAbove(double smallest)
+{
+	if (!(smallest > 0))
+	{
+		return 1;
+	}
+	double powerOfTen = pow(10.0, floor(log10(smallest)));
+	const double multiples[] = { 1, 2, 5, 10 };
+	for (double multiple : multiples)
+	{
+		// A tiny allowance, in case log10 came out a touch low
+		if (multiple * powerOfTen >= smallest * (1 - 1e-9))
+		{
+			return multiple * powerOfTen;
+		}
+	}
+	return 10 * powerOfTen;
+}
+
+void FormatTickLabel(double value, double spacing, char* text, int textSize)
+{
+	// Something like 3e-17 is just 0 with a rounding error
+	if (fabs(value) < spacing * 0.001)
+	{
+		snprintf(text, textSize, "0");
+		return;
+	}
+
+	// Enough decimal places to tell neighbouring ticks apart. Very big and very small numbers
+	// are written like 1.5e+09 instead, to keep them short.
+	int decimals = spacing >= 1 ? 0 : (int)ceil(-log10(spacing) - 1e-9);
+	if (fabs(value) >= 1e7 || decimals > 5)
+	{
+		int digits = (int)ceil(log10(fabs(value) / spacing + 1)) + 1;
+		snprintf(text, textSize, "%.*g", digits, value);
+	}
+	else
+	{
+		snprintf(text, textSize, "%.*f", decimals, value);
+	}
+}
+
+// The width of some text, in pixels, from how far along each letter moves the next one
+static float GetTextWidth(const char* text)
+{
+	float width = 0;
+	for (const char* c = text; *c != 0; c++)
+	{
+		width += defaultFont.getGlyph(*c, LABEL_SIZE, false).advance;
+	}
+	return width;
+}
+
+void Axes::Update(const GraphView& view)
+{
+	bool changed = !built ||
+		view.originX != builtView.originX || view.originY != builtView.originY || view.scale != builtView.scale ||
+		view.screenWidth != builtView.screenWidth || view.screenHeight != builtView.screenHeight;
+	if (changed)
+	{
+		Build(view);
+		builtView = view;
+		built = true;
+		rebuilds++;
+	}
+}
+
+// Adds the letters' rectangles (as two triangles each) to the labels' vertices. alignX is 0 for the
+// text to start at x, 0.5 to be centred on it and 1 to end at it.
+void Axes::AddLabel(const char* text, float x, float top, float alignX)
+{
+	const sf::Color color(0, 160, 160);
+	float penX = floorf(x - GetTextWidth(text) * alignX);
+	float baseline = floorf(top + LABEL_SIZE);
+	for (const char* c = text; *c != 0; c++)
+	{
+		const sf::Glyph& glyph = defaultFont.getGlyph(*c, LABEL_SIZE, false);
+		float left = penX + glyph.bounds.left;
+		float right = left + glyph.bounds.width;
+		float glyphTop = baseline + glyph.bounds.top;
+		float bottom = glyphTop + glyph.bounds.height;
+		float u1 = (float)glyph.textureRect.left;
+		float v1 = (float)glyph.textureRect.top;
+		float u2 = u1 + glyph.textureRect.width;
+		float v2 = v1 + glyph.textureRect.height;
+
+		labels.append(sf::Vertex(sf::Vector2f(left, glyphTop), color, sf::Vector2f(u1, v1)));
+		labels.append(sf::Vertex(sf::Vector2f(right, glyphTop), color, sf::Vector2f(u2, v1)));
+		labels.append(sf::Vertex(sf::Vector2f(left, bottom), color, sf::Vector2f(u1, v2)));
+		labels.append(sf::Vertex(sf::Vector2f(left, bottom), color, sf::Vector2f(u1, v2)));
+		labels.append(sf::Vertex(sf::Vector2f(right, glyphTop), color, sf::Vector2f(u2, v1)));
+		labels.append(sf::Vertex(sf::Vector2f(right, bottom), color, sf::Vector2f(u2, v2)));
+		penX += glyph.advance;
+	}
+}
+
+void Axes::Build(const GraphView& view)
+{
+	const sf::Color color = sf::Color::Cyan;
+	lines.clear();
+	labels.clear();
+	tickCount = 0;
+
+	float width = view.screenWidth;
+	float height = view.screenHeight;
+	double left = view.GetLeftX();
+	double right = view.GetRightX();
+	double bottom = view.GetBottomY();
+	double top = view.GetTopY();
+
+	// The axes themselves, if they're on the screen
+	if (view.originX >= 0 && view.originX <= width)
+	{
+		lines.append(sf::Vertex(sf::Vector2f(view.originX, 0), color));
+		lines.append(sf::Vertex(sf::Vector2f(view.originX, height), color));
+	}
+	if (view.originY >= 0 && view.originY <= height)
+	{
+		lines.append(sf::Vertex(sf::Vector2f(0, view.originY), color));
+		lines.append(sf::Vertex(sf::Vector2f(width, view.originY), color));
+	}
+
+	// Pick the tick spacing. The widest numbers are the ones furthest from 0, at the screen edges,
+	// and a wider spacing can need more room, so it's checked twice.
+	double spacing = NiceNumberAbove(SMALLEST_TICK_GAP / view.scale);
+	for (int attempt = 0; attempt < 2; attempt++)
+	{
+		const double edges[] = { left, right, bottom, top };
+		float widest = 0;
+		for (double edge : edges)
+		{
+			char text[32];
+			FormatTickLabel(floor(edge / spacing) * spacing, spacing, text, sizeof(text));
+			float textWidth = GetTextWidth(text);
+			widest = textWidth > widest ? textWidth : widest;
+		}
+		if ((widest + LABEL_GAP) / view.scale <= spacing)
+		{
+			break;
+		}
+		spacing = NiceNumberAbove((widest + LABEL_GAP) / view.scale);
+	}
+	tickSpacing = (float)spacing;
+
+	// When an axis is off the screen, its ticks and numbers stay along the nearest edge
+	float xAxisY = view.originY < 0 ? 0 : view.originY;
+	float lowestXAxisY = height - LABEL_SIZE - TICK_HALF_LENGTH - 6;
+	xAxisY = xAxisY > lowestXAxisY ? lowestXAxisY : xAxisY;
+	float yAxisX = view.originX < 0 ? 0 : view.originX;
+	yAxisX = yAxisX > width ? width : yAxisX;
+	bool yLabelsOnRight = yAxisX < 60;	// No room for them on the left
+
+	char text[32];
+	long long firstX = (long long)ceil(left / spacing);
+	long long lastX = (long long)floor(right / spacing);
+	for (long long i = firstX; i <= lastX; i++)
+	{
+		float x = view.ToScreenX((float)(i * spacing));
+		lines.append(sf::Vertex(sf::Vector2f(x, xAxisY - TICK_HALF_LENGTH), color));
+		lines.append(sf::Vertex(sf::Vector2f(x, xAxisY + TICK_HALF_LENGTH), color));
+		FormatTickLabel(i * spacing, spacing, text, sizeof(text));
+		AddLabel(text, x, xAxisY + TICK_HALF_LENGTH + 2, 0.5f);
+		tickCount++;
+	}
+
+	long long firstY = (long long)ceil(bottom / spacing);
+	long long lastY = (long long)floor(top / spacing);
+	for (long long i = firstY; i <= lastY; i++)
+	{
+		// 0 is already written on the x axis
+		if (i == 0)
+		{
+			continue;
+		}
+		float y = view.ToScreenY((float)(i * spacing));
+		lines.append(sf::Vertex(sf::Vector2f(yAxisX - TICK_HALF_LENGTH, y), color));
+		lines.append(sf::Vertex(sf::Vector2f(yAxisX + TICK_HALF_LENGTH, y), color));
+		FormatTickLabel(i * spacing, spacing, text, sizeof(text));
+		if (yLabelsOnRight)
+		{
+			AddLabel(text, yAxisX + TICK_HALF_LENGTH + 3, y - LABEL_SIZE / 2.0f - 2, 0);
+		}
+		else
+		{
+			AddLabel(text, yAxisX - TICK_HALF_LENGTH - 3, y - LABEL_SIZE / 2.0f - 2, 1);
+		}
+		tickCount++;
+	}
+}
+
+void Axes::Draw()
+{
+	window->draw(lines);
+
+	// The numbers' vertices point into the font's picture of its letters
+	sf::RenderStates states;
+	states.texture = &defaultFont.getTexture(LABEL_SIZE);
+	window->draw(labels, states);
+}
+
+float Axes::GetTickSpacing()
+{
+	return tickSpacing;
+}
+
+int Axes::GetTickCount()
+{
+	return tickCount;
+}
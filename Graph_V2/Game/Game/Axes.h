@@ -0,0 +1,42 @@
+#pragma once
+#include <SFML\Graphics.hpp>
+#include "GraphView.h"
+
+// The x and y axes, with ticks and numbers along them.
+//
+// Everything is built once into two vertex arrays, one for the lines and one for the numbers,
+// and only built again when the graph is moved or zoomed. So each frame the axes are just two
+// draws, however many ticks there are.
+//
+// The gap between ticks is always a 'nice' number: 1, 2 or 5 times a power of ten. It's the
+// smallest one which leaves room for the numbers, so zooming in or out never squashes the
+// numbers together or leaves the axes bare.
+class Axes
+{
+public:
+	// Builds the vertices again, if the view has changed since last time
+	void Update(const GraphView& view);
+	void Draw();
+
+	float GetTickSpacing();		// In world units
+	int GetTickCount();
+	int rebuilds = 0;
+
+private:
+	GraphView builtView;
+	bool built = false;
+	float tickSpacing = 1;
+	int tickCount = 0;
+	sf::VertexArray lines{ sf::Lines };
+	sf::VertexArray labels{ sf::Triangles };
+
+	void Build(const GraphView& view);
+	void AddLabel(const char* text, float x, float y, float alignX);
+};
+
+// The smallest nice number (1, 2 or 5 times a power of ten) which is at least 'smallest'
+double NiceNumberAbove(double smallest);
+
+// Writes a tick's number with as many decimal places as the tick spacing needs, so 0.1 + 0.2
+// comes out as "0.3" rather than "0.30000001"
+void FormatTickLabel(double value, double spacing, char* text, int textSize);
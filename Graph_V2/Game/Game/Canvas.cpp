@@ -0,0 +1,161 @@
+#include <math.h>
+#include <string.h>
+#include "Canvas.h"
+
+// The built in font. Each character is 7 rows of 5 pixels, one row per number, where the
+// lowest 5 bits are the pixels from left to right.
+struct TinyGlyph
+{
+	char character;
+	unsigned char rows[7];
+};
+
+const TinyGlyph tinyFont[] =
+{
+	{ '0', { 0x0E, 0x11, 0x13, 0x15, 0x19, 0x11, 0x0E } },
+	{ '1', { 0x04, 0x0C, 0x04, 0x04, 0x04, 0x04, 0x0E } },
+	{ '2', { 0x0E, 0x11, 0x01, 0x02, 0x04, 0x08, 0x1F } },
+	{ '3', { 0x1F, 0x02, 0x04, 0x02, 0x01, 0x11, 0x0E } },
+	{ '4', { 0x02, 0x06, 0x0A, 0x12, 0x1F, 0x02, 0x02 } },
+	{ '5', { 0x1F, 0x10, 0x1E, 0x01, 0x01, 0x11, 0x0E } },
+	{ '6', { 0x06, 0x08, 0x10, 0x1E, 0x11, 0x11, 0x0E } },
+	{ '7', { 0x1F, 0x01, 0x02, 0x04, 0x08, 0x08, 0x08 } },
+	{ '8', { 0x0E, 0x11, 0x11, 0x0E, 0x11, 0x11, 0x0E } },
+	{ '9', { 0x0E, 0x11, 0x11, 0x0F, 0x01, 0x02, 0x0C } },
+	{ '.', { 0x00, 0x00, 0x00, 0x00, 0x00, 0x0C, 0x0C } },
+	{ '-', { 0x00, 0x00, 0x00, 0x1F, 0x00, 0x00, 0x00 } },
+	{ '+', { 0x00, 0x04, 0x04, 0x1F, 0x04, 0x04, 0x00 } },
+	{ 'e', { 0x00, 0x00, 0x0E, 0x11, 0x1F, 0x10, 0x0E } },
+};
+const int TINY_GLYPH_ADVANCE = 6;	// 5 pixels and a gap
+
+void Canvas::Create(int newWidth, int newHeight, sf::Color background)
+{
+	width = newWidth;
+	height = newHeight;
+	pixels.resize(width * height * 4);
+	for (int i = 0; i < width * height; i++)
+	{
+		pixels[i * 4 + 0] = background.r;
+		pixels[i * 4 + 1] = background.g;
+		pixels[i * 4 + 2] = background.b;
+		pixels[i * 4 + 3] = background.a;
+	}
+}
+
+void Canvas::BlendPixel(int x, int y, sf::Color color, float amount)
+{
+	if (x < 0 || y < 0 || x >= width || y >= height)
+	{
+		return;
+	}
+	float a = amount * color.a / 255.0f;
+	sf::Uint8* pixel = &pixels[(y * width + x) * 4];
+	pixel[0] = (sf::Uint8)(pixel[0] + (color.r - pixel[0]) * a + 0.5f);
+	pixel[1] = (sf::Uint8)(pixel[1] + (color.g - pixel[1]) * a + 0.5f);
+	pixel[2] = (sf::Uint8)(pixel[2] + (color.b - pixel[2]) * a + 0.5f);
+	pixel[3] = (sf::Uint8)(pixel[3] + (255 - pixel[3]) * a + 0.5f);
+}
+
+// Xiaolin Wu's line drawing. The line is stepped along one pixel at a time in whichever direction
+// it's longest, and at each step the two pixels either side of it share out the colour, by how far
+// the line is from each of their centres.
+void Canvas::DrawLine(float x1, float y1, float x2, float y2, sf::Color color)
+{
+	if (!(fabsf(x1) < 1e6f && fabsf(y1) < 1e6f && fabsf(x2) < 1e6f && fabsf(y2) < 1e6f))
+	{
+		return;
+	}
+
+	// Steep lines are drawn with x and y swapped, so the stepping is always along 'x'
+	bool steep = fabsf(y2 - y1) > fabsf(x2 - x1);
+	if (steep)
+	{
+		float swap = x1; x1 = y1; y1 = swap;
+		swap = x2; x2 = y2; y2 = swap;
+	}
+	if (x1 > x2)
+	{
+		float swap = x1; x1 = x2; x2 = swap;
+		swap = y1; y1 = y2; y2 = swap;
+	}
+	float gradient = x2 > x1 ? (y2 - y1) / (x2 - x1) : 0;
+
+	// The pixels whose centres (at +0.5) are from the start of the line up to its end. The end's
+	// own pixel is left for the next line along, so joined lines don't blend it in twice.
+	int limit = steep ? height : width;
+	int first = (int)ceilf(x1 - 0.5f);
+	int last = (int)ceilf(x2 - 0.5f) - 1;
+	first = first < 0 ? 0 : first;
+	last = last > limit - 1 ? limit - 1 : last;
+	for (int step = first; step <= last; step++)
+	{
+		float across = y1 + gradient * (step + 0.5f - x1) - 0.5f;
+		int pixel = (int)floorf(across);
+		float fraction = across - pixel;
+		if (steep)
+		{
+			BlendPixel(pixel, step, color, 1 - fraction);
+			BlendPixel(pixel + 1, step, color, fraction);
+		}
+		else
+		{
+			BlendPixel(step, pixel, color, 1 - fraction);
+			BlendPixel(step, pixel + 1, color, fraction);
+		}
+	}
+}
+
+float Canvas::GetTextWidth(const char* text)
+{
+	return (float)(strlen(text) * TINY_GLYPH_ADVANCE - 1);
+}
+
+void Canvas::DrawText(const char* text, float x, float y, float alignX, sf::Color color)
+{
+	int penX = (int)floorf(x - GetTextWidth(text) * alignX + 0.5f);
+	int top = (int)floorf(y + 0.5f);
+	for (const char* c = text; *c != 0; c++, penX += TINY_GLYPH_ADVANCE)
+	{
+		for (const TinyGlyph& glyph : tinyFont)
+		{
+			if (glyph.character != *c)
+			{
+				continue;
+			}
+			for (int row = 0; row < 7; row++)
+			{
+				for (int column = 0; column < 5; column++)
+				{
+					if (glyph.rows[row] & (0x10 >> column))
+					{
+						BlendPixel(penX + column, top + row, color, 1);
+					}
+				}
+			}
+		}
+	}
+}
+
+int Canvas::GetWidth()
+{
+	return width;
+}
+
+int Canvas::GetHeight()
+{
+	return height;
+}
+
+const sf::Uint8* Canvas::GetPixels()
+{
+	return pixels.data();
+}
+
+bool Canvas::SaveToFile(const std::string& path)
+{
+	// sf::Image is only pixels in memory too, so it's fine without a window
+	sf::Image image;
+	image.create(width, height, pixels.data());
+	return image.saveToFile(path);
+}
@@ -0,0 +1,41 @@
+#pragma once
+#include <string>
+#include <vector>
+#include <SFML\Graphics.hpp>
+
+// A picture drawn by the CPU into an array of pixels, with no window or graphics card needed.
+// So it can be used on a server, and on as many threads at once as wanted (one Canvas each).
+//
+// Lines are 'anti-aliased': each pixel a line passes near is blended in by how close the line is
+// to its centre, so lines look smooth instead of like staircases.
+//
+// Text only has the characters needed for numbers (0-9 . - + e), from a tiny built in font,
+// as there's no font file to read letters from.
+class Canvas
+{
+public:
+	void Create(int width, int height, sf::Color background);
+
+	void DrawLine(float x1, float y1, float x2, float y2, sf::Color color);
+
+	// alignX is 0 for the text to start at x, 0.5 to be centred on it and 1 to end at it.
+	// y is the top of the text.
+	void DrawText(const char* text, float x, float y, float alignX, sf::Color color);
+	static float GetTextWidth(const char* text);
+	static const int TEXT_HEIGHT = 7;
+
+	int GetWidth();
+	int GetHeight();
+	const sf::Uint8* GetPixels();	// 4 bytes per pixel: red, green, blue, alpha
+
+	// Saves as .png, .bmp, .tga or .jpg, depending on the end of the file name
+	bool SaveToFile(const std::string& path);
+
+private:
+	int width = 0;
+	int height = 0;
+	std::vector<sf::Uint8> pixels;
+
+	// Mixes color into a pixel. amount is from 0 (no change) to 1 (just color).
+	void BlendPixel(int x, int y, sf::Color color, float amount);
+};
@@ -0,0 +1,281 @@
+#include <SFML\System\Clock.hpp>
+#include <cmath>
+#include "Main.h"
+#include "Helpers.h"
+#include "CurveKernels.h"
+#include "CurveCache.h"
+
+bool CurveCache::Update(Expression& curve, float newTime, const GraphView& view, sf::Color newColor)
+{
+	float speed;
+	if (curve.GetScrollSpeed(speed))
+	{
+		return UpdateScrolling(curve, newTime, speed, view, newColor);
+	}
+	pointsWorkedOut = 0;
+
+	// The world area on the screen right now
+	float screenLeft = view.GetLeftX();
+	float screenRight = view.GetRightX();
+	float screenTop = view.ToWorldY(0);
+	float screenBottom = view.ToWorldY(view.screenHeight);
+
+	float zoom = view.scale / sampledScale;
+	bool needed = !valid ||
+		text != curve.GetText() ||
+		(curve.UsesTime() && newTime != time) ||
+		screenLeft < left || screenRight > right || screenTop > top || screenBottom < bottom ||
+		zoom > 1.5f || zoom < 0.5f;
+
+	if (!needed && !scrolling)
+	{
+		SetColor(newColor);
+		return false;
+	}
+
+	// Cover a screen's worth more on every side, so the graph can be moved that far before
+	// anything needs working out again. Curves which move with time are worked out every
+	// frame anyway, so for them that would just be wasted work.
+	GraphView cacheView = view;
+	if (!curve.UsesTime())
+	{
+		cacheView.originX += view.screenWidth;
+		cacheView.originY += view.screenHeight;
+		cacheView.screenWidth *= 3;
+		cacheView.screenHeight *= 3;
+	}
+	sampler.Sample(curve, newTime, cacheView, newColor, vertices);
+	pointsWorkedOut = sampler.evaluations;
+
+	// The sampler makes screen positions, so turn them back into world positions
+	for (sf::Vertex& vertex : vertices)
+	{
+		vertex.position = sf::Vector2f(cacheView.ToWorldX(vertex.position.x), cacheView.ToWorldY(vertex.position.y));
+	}
+
+	valid = true;
+	text = curve.GetText();
+	time = newTime;
+	sampledScale = view.scale;
+	left = cacheView.GetLeftX();
+	right = cacheView.GetRightX();
+	top = cacheView.ToWorldY(0);
+	bottom = cacheView.ToWorldY(cacheView.screenHeight);
+	color = newColor;
+	scrolling = false;
+	rebuilds++;
+	return true;
+}
+
+// A new color doesn't need new points. Keep the alpha, as it's used for gaps in the line.
+void CurveCache::SetColor(sf::Color newColor)
+{
+	if (newColor == color)
+	{
+		return;
+	}
+	for (sf::Vertex& vertex : vertices)
+	{
+		vertex.color = sf::Color(newColor.r, newColor.g, newColor.b, vertex.color.a);
+	}
+	for (Chunk& chunk : chunks)
+	{
+		for (sf::Vertex& vertex : chunk.vertices)
+		{
+			vertex.color = sf::Color(newColor.r, newColor.g, newColor.b, vertex.color.a);
+		}
+	}
+	color = newColor;
+}
+
+bool CurveCache::UpdateScrolling(Expression& curve, float newTime, float speed, const GraphView& view, sf::Color newColor)
+{
+	// Every slice has to be worked out again if the curve changes, the graph is zoomed like
+	// above, or moved up or down off the part of the curve worked out
+	float zoom = view.scale / sampledScale;
+	bool restart = !valid || !scrolling ||
+		text != curve.GetText() ||
+		view.GetTopY() > top || view.GetBottomY() < bottom ||
+		zoom > 1.5f || zoom < 0.5f ||
+		view.screenWidth != sampledWidth;
+	if (restart)
+	{
+		// A screen's worth more above and below, and enough slices to cover the screen when
+		// zoomed out to half the scale
+		sampledScale = view.scale;
+		sampledWidth = view.screenWidth;
+		top = view.ToWorldY(-view.screenHeight);
+		bottom = view.ToWorldY(view.screenHeight * 2);
+		chunks.assign((int)(view.screenWidth * 2 / CHUNK_PIXELS) + 3, Chunk());
+		firstChunk = 0;
+		lastChunk = -1;
+		valid = true;
+		scrolling = true;
+		text = curve.GetText();
+		color = newColor;
+		rebuilds++;
+	}
+	SetColor(newColor);
+
+	// The slices of the t = 0 curve which are on the screen now
+	float chunkWidth = CHUNK_PIXELS / sampledScale;
+	scrollOffset = speed * newTime;
+	long long first = (long long)std::floor((view.GetLeftX() - scrollOffset) / chunkWidth);
+	long long last = (long long)std::floor((view.GetRightX() - scrollOffset) / chunkWidth);
+	time = newTime;
+	pointsWorkedOut = 0;
+	if (first == firstChunk && last == lastChunk)
+	{
+		return false;
+	}
+
+	// Work out the new slices
+	GraphView chunkView;
+	chunkView.scale = sampledScale;
+	chunkView.screenWidth = (float)CHUNK_PIXELS;
+	chunkView.originY = top * sampledScale;
+	chunkView.screenHeight = (top - bottom) * sampledScale;
+	int numChunks = (int)chunks.size();
+	for (long long i = first; i <= last; i++)
+	{
+		Chunk& chunk = chunks[(int)(((i % numChunks) + numChunks) % numChunks)];
+		if (chunk.valid && chunk.index == i)
+		{
+			continue;
+		}
+		chunkView.originX = -(float)(i * CHUNK_PIXELS);
+		sampler.Sample(curve, 0, chunkView, color, chunk.vertices);
+		pointsWorkedOut += sampler.evaluations;
+		for (sf::Vertex& vertex : chunk.vertices)
+		{
+			vertex.position = sf::Vector2f(chunkView.ToWorldX(vertex.position.x), chunkView.ToWorldY(vertex.position.y));
+		}
+		chunk.index = i;
+		chunk.valid = true;
+	}
+
+	// Join the slices into one line. The sampler goes a pixel past each end of a slice, so they
+	// overlap a little, and are joined with an invisible piece, the same way it breaks the line.
+	vertices.clear();
+	for (long long i = first; i <= last; i++)
+	{
+		const std::vector<sf::Vertex>& chunkVertices = chunks[(int)(((i % numChunks) + numChunks) % numChunks)].vertices;
+		if (chunkVertices.empty())
+		{
+			continue;
+		}
+		if (!vertices.empty())
+		{
+			sf::Vertex end = vertices.back();
+			sf::Vertex start = chunkVertices.front();
+			end.color.a = 0;
+			start.color.a = 0;
+			vertices.push_back(end);
+			vertices.push_back(start);
+		}
+		vertices.insert(vertices.end(), chunkVertices.begin(), chunkVertices.end());
+	}
+	firstChunk = first;
+	lastChunk = last;
+	return true;
+}
+
+void CurveCache::Draw(const GraphView& view)
+{
+	if (vertices.empty())
+	{
+		return;
+	}
+
+	// World to screen: scale (flipping y, as world y goes up), then move to the origin
+	sf::Transform transform;
+	transform.translate(view.originX, view.originY);
+	transform.scale(view.scale, -view.scale);
+	if (scrolling)
+	{
+		// The points are for t = 0, so move them along to where the curve is now
+		transform.translate(scrollOffset, 0);
+	}
+	window->draw(&vertices[0], vertices.size(), sf::LineStrip, sf::RenderStates(transform));
+}
+
+int CurveCache::GetVertexCount()
+{
+	return (int)vertices.size();
+}
+
+void RunCacheBenchmark()
+{
+	const int numFrames = 600;
+	const int numCurves = 4;	// The first 4 curves don't use t
+	Expression curves[numCurves];
+	CurveCache caches[numCurves];
+	std::string error;
+	for (int i = 0; i < numCurves; i++)
+	{
+		curves[i].Compile(shippedCurveText[i], error);
+	}
+
+	// Moves the graph 2 pixels right and 1 down every frame, like someone dragging it slowly
+	CurveSampler sampler;
+	std::vector<sf::Vertex> vertices;
+	sf::Clock clock;
+	for (int frame = 0; frame < numFrames; frame++)
+	{
+		GraphView view;
+		view.originX += frame * 2;
+		view.originY += frame;
+		for (int i = 0; i < numCurves; i++)
+		{
+			sampler.Sample(curves[i], 0, view, sf::Color::White, vertices);
+		}
+	}
+	float uncachedSeconds = clock.restart().asSeconds();
+
+	for (int frame = 0; frame < numFrames; frame++)
+	{
+		GraphView view;
+		view.originX += frame * 2;
+		view.originY += frame;
+		for (int i = 0; i < numCurves; i++)
+		{
+			caches[i].Update(curves[i], 0, view, sf::Color::White);
+		}
+	}
+	float cachedSeconds = clock.restart().asSeconds();
+
+	int rebuilds = 0;
+	for (int i = 0; i < numCurves; i++)
+	{
+		rebuilds += caches[i].rebuilds;
+	}
+	printf("%d frames of moving curves 1 to 4:\n", numFrames);
+	printf("  Sampled every frame: %.4f ms per frame\n", uncachedSeconds * 1000 / numFrames);
+	printf("  Cached:              %.4f ms per frame, %d rebuilds in total\n", cachedSeconds * 1000 / numFrames, rebuilds);
+
+	// Curve 5 scrolls along x, so only the slices coming onto the screen need working out
+	Expression scrollingCurve;
+	scrollingCurve.Compile(shippedCurveText[4], error);
+	CurveCache scrollingCache;
+	GraphView view;
+	long long sampledPoints = 0;
+	long long cachedPoints = 0;
+	clock.restart();
+	for (int frame = 0; frame < numFrames; frame++)
+	{
+		sampler.Sample(scrollingCurve, frame / 60.0f, view, sf::Color::White, vertices);
+		sampledPoints += sampler.evaluations;
+	}
+	float sampledSeconds = clock.restart().asSeconds();
+	for (int frame = 0; frame < numFrames; frame++)
+	{
+		scrollingCache.Update(scrollingCurve, frame / 60.0f, view, sf::Color::White);
+		cachedPoints += scrollingCache.pointsWorkedOut;
+	}
+	float scrolledSeconds = clock.restart().asSeconds();
+	printf("%d frames of curve 5, %s, scrolling at 60 Hz:\n", numFrames, shippedCurveText[4]);
+	printf("  Sampled every frame: %.4f ms per frame, %.0f points worked out per frame\n",
+		sampledSeconds * 1000 / numFrames, (float)sampledPoints / numFrames);
+	printf("  Slices reused:       %.4f ms per frame, %.0f points worked out per frame\n",
+		scrolledSeconds * 1000 / numFrames, (float)cachedPoints / numFrames);
+}
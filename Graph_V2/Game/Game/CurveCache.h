@@ -0,0 +1,76 @@
+#pragma once
+#include <string>
+#include <vector>
+#include <SFML\Graphics.hpp>
+#include "CurveSampler.h"
+#include "Expression.h"
+#include "GraphView.h"
+
+// Remembers the points along one curve, so they don't have to be worked out again every frame.
+//
+// The points are kept in world positions, not screen positions. Moving or zooming the graph
+// only changes how world positions map to the screen, so instead of moving every point, the
+// points are drawn with an sf::Transform which does the mapping on the graphics card.
+// The points are only worked out again when:
+// - the curve is changed,
+// - the curve uses t, and the time has changed (unless it just scrolls, see below),
+// - the graph is moved far enough that part of the screen isn't covered by the points,
+// - or the graph is zoomed enough that the points would be too far apart (or wastefully close).
+//
+// Curves which just slide along x as time goes on, like sin((x + t) * 2), are the same shape at
+// every time (see Expression::GetScrollSpeed). For them, the curve at t = 0 is worked out in
+// slices CHUNK_PIXELS wide, and drawn moved along by however far it has scrolled. Each frame only
+// the slices which have just come onto the screen are worked out. The slices are kept in a ring,
+// so slice i (from x = i * the slice width) goes in chunks[i % chunks.size()], in place of one which
+// has gone off the other side of the screen.
+class CurveCache
+{
+public:
+	// Statistics
+	int rebuilds = 0;
+	int pointsWorkedOut = 0;	// By the last Update
+
+	// Works the points out again if they need to be. Returns true if they were.
+	bool Update(Expression& curve, float time, const GraphView& view, sf::Color color);
+
+	// Draws the points, moved and scaled to where the view puts them
+	void Draw(const GraphView& view);
+
+	int GetVertexCount();
+
+private:
+	bool valid = false;
+	std::string text;			// The curve the points are for
+	float time = 0;				// Only checked for curves which use t
+	float sampledScale = 0;		// The view's scale when the points were worked out
+	float left = 0;				// The world area the points cover
+	float right = 0;
+	float top = 0;
+	float bottom = 0;
+	sf::Color color;
+
+	std::vector<sf::Vertex> vertices;
+	CurveSampler sampler;
+
+	// For curves which scroll
+	static const int CHUNK_PIXELS = 64;
+	struct Chunk
+	{
+		long long index = 0;
+		bool valid = false;
+		std::vector<sf::Vertex> vertices;	// World positions, at t = 0
+	};
+	bool scrolling = false;
+	float scrollOffset = 0;		// How far right the curve has moved since t = 0
+	float sampledWidth = 0;		// The view's screen width when the chunks were made
+	std::vector<Chunk> chunks;
+	long long firstChunk = 0;	// The slices in 'vertices'
+	long long lastChunk = -1;
+
+	bool UpdateScrolling(Expression& curve, float time, float speed, const GraphView& view, sf::Color color);
+	void SetColor(sf::Color newColor);
+};
+
+// "Game.exe -cachebench" times slowly moving the graph around with and without the cache, and
+// drawing a scrolling curve with and without reusing its slices
+void RunCacheBenchmark();
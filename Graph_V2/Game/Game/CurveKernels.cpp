@@ -0,0 +1,170 @@
+#include <SFML\System\Clock.hpp>
+#include <cmath>
+#include <vector>
+#include <xmmintrin.h>
+#include "Helpers.h"
+#include "CurveKernels.h"
+#include "FastMath.h"
+
+const char* shippedCurveText[NUM_CURVE_TYPES] =
+{
+	"x^2",
+	"x^3",
+	"2^x",
+	"sin(x)",
+	"sin((x + t) * 2)"
+};
+
+float CalcGraphY(int curveType, float time, float x)
+{
+	float y = -9999;
+	switch (curveType)
+	{
+	case 1:
+		y = x * x;		// Y = X^2
+		break;
+	case 2:
+		y = x * x * x;	// Y = X^3
+		break;
+	case 3:
+		y = powf(2, x);	// Exponential
+		break;
+	case 4:
+		y = sin(x);		// Sin
+		break;
+	case 5:
+		y = sin((x + time) * 2);	// Sin for (x+time), scaled by 2 to make the frequency higher
+		break;
+	}
+	return y;
+}
+
+// Y = X^2, 4 at a time
+static void EvaluateSquare(const float* x, float* y, int count)
+{
+	int i = 0;
+	for (; i + 4 <= count; i += 4)
+	{
+		__m128 x4 = _mm_loadu_ps(x + i);
+		_mm_storeu_ps(y + i, _mm_mul_ps(x4, x4));
+	}
+
+	// The last few, if count isn't a multiple of 4
+	for (; i < count; i++)
+	{
+		y[i] = x[i] * x[i];
+	}
+}
+
+// Y = X^3, 4 at a time
+static void EvaluateCube(const float* x, float* y, int count)
+{
+	int i = 0;
+	for (; i + 4 <= count; i += 4)
+	{
+		__m128 x4 = _mm_loadu_ps(x + i);
+		_mm_storeu_ps(y + i, _mm_mul_ps(_mm_mul_ps(x4, x4), x4));
+	}
+	for (; i < count; i++)
+	{
+		y[i] = x[i] * x[i] * x[i];
+	}
+}
+
+// There are no SSE instructions for powers or sines, so these use FastMath's, which build them
+// out of multiplies and adds, 4 at a time. Plot accuracy is far less than a pixel out.
+static void EvaluateExp2(const float* x, float* y, int count)
+{
+	FastExp2(x, y, count, MATH_PLOT);
+}
+
+static void EvaluateSin(const float* x, float* y, int count)
+{
+	FastSin(x, y, count, MATH_PLOT);
+}
+
+static void EvaluateMovingSin(float time, const float* x, float* y, int count)
+{
+	for (int i = 0; i < count; i++)
+	{
+		y[i] = (x[i] + time) * 2;
+	}
+	FastSin(y, y, count, MATH_PLOT);
+}
+
+void EvaluateCurve(int curveType, float time, const float* x, float* y, int count)
+{
+	switch (curveType)
+	{
+	case 1:
+		EvaluateSquare(x, y, count);
+		break;
+	case 2:
+		EvaluateCube(x, y, count);
+		break;
+	case 3:
+		EvaluateExp2(x, y, count);
+		break;
+	case 4:
+		EvaluateSin(x, y, count);
+		break;
+	case 5:
+		EvaluateMovingSin(time, x, y, count);
+		break;
+	default:
+		for (int i = 0; i < count; i++)
+		{
+			y[i] = -9999;
+		}
+		break;
+	}
+}
+
+void RunCurveBenchmark()
+{
+	// The same points DrawCurve uses, repeated lots of times
+	const int numPoints = 401;
+	const int repeats = 20000;
+	std::vector<float> x(numPoints);
+	std::vector<float> y(numPoints);
+	for (int i = 0; i < numPoints; i++)
+	{
+		x[i] = -20.0f + i * 0.1f;
+	}
+	const float time = 1.5f;
+
+	printf("Curve   CalcGraphY ns/point   EvaluateCurve ns/point   Speedup   Biggest difference\n");
+	for (int curveType = 1; curveType <= NUM_CURVE_TYPES; curveType++)
+	{
+		sf::Clock clock;
+		float total = 0;	// Added up so the compiler can't skip the work
+		for (int repeat = 0; repeat < repeats; repeat++)
+		{
+			for (int i = 0; i < numPoints; i++)
+			{
+				total += CalcGraphY(curveType, time, x[i]);
+			}
+		}
+		float oneSeconds = clock.restart().asSeconds();
+
+		for (int repeat = 0; repeat < repeats; repeat++)
+		{
+			EvaluateCurve(curveType, time, &x[0], &y[0], numPoints);
+			total += y[repeat % numPoints];
+		}
+		float batchSeconds = clock.restart().asSeconds();
+
+		// Compare, relative to the size of the number, as 2^20 is about a million
+		float biggestDifference = 0;
+		for (int i = 0; i < numPoints; i++)
+		{
+			float expected = CalcGraphY(curveType, time, x[i]);
+			float difference = std::abs(y[i] - expected) / std::fmax(1.0f, std::abs(expected));
+			biggestDifference = std::fmax(biggestDifference, difference);
+		}
+
+		float samples = (float)numPoints * repeats;
+		printf("%5d %21.2f %24.2f %8.1fx %20g%s\n", curveType, oneSeconds * 1e9f / samples, batchSeconds * 1e9f / samples,
+			oneSeconds / batchSeconds, biggestDifference, total == 12345 ? " " : "");
+	}
+}
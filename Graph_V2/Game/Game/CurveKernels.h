@@ -0,0 +1,21 @@
+#pragma once
+
+// Works out lots of points on a curve at once.
+//
+// CalcGraphY works out one point at a time, and has to check which curve it's drawing (the
+// switch) for every single point. EvaluateCurve does the check once, then runs a loop made just
+// for that curve, which can work on 4 points at a time with SSE instructions.
+
+const int NUM_CURVE_TYPES = 5;	// Curves 1 to 5, the same as CalcGraphY
+
+// Sets y[i] to the curve's value at x[i], for count points
+void EvaluateCurve(int curveType, float time, const float* x, float* y, int count);
+
+// The same curves, written as text for Expression
+extern const char* shippedCurveText[NUM_CURVE_TYPES];
+
+// Works out one point, the simple way. EvaluateCurve should give (almost) the same answers.
+float CalcGraphY(int curveType, float time, float x);
+
+// "Game.exe -curvebench" times CalcGraphY against EvaluateCurve for every curve
+void RunCurveBenchmark();
@@ -0,0 +1,397 @@
+#include <SFML\System\Clock.hpp>
+#include <algorithm>
+#include <cmath>
+#include "Helpers.h"
+#include "CurveKernels.h"
+#include "CurveSampler.h"
+
+// Lines are cut off this many pixels past the top and bottom of the screen, so the cut isn't seen
+const float clipMargin = 2;
+
+// However wide the screen is, never start with more pieces than this
+const float maxStartPieces = 65536;
+
+void CurveSampler::Sample(Expression& curve, float time, const GraphView& view, sf::Color color, std::vector<sf::Vertex>& vertices)
+{
+	Sample(curve, time, view, view.scale, color, vertices);
+}
+
+void CurveSampler::Sample(Expression& curve, float time, const GraphView& view, float yScale, sf::Color color, std::vector<sf::Vertex>& vertices)
+{
+	this->yScale = yScale;
+	vertices.clear();
+	evaluations = 0;
+	breaks = 0;
+
+	// Only sample what's on the screen, plus a pixel either side, so the number of points
+	// depends on the size of the screen and not on how far the graph is zoomed out
+	float xStart = view.GetLeftX() - 1 / view.scale;
+	float xEnd = view.GetRightX() + 1 / view.scale;
+
+	// Start with evenly spaced points. The count is limited before it's made an int, which it might not fit in.
+	float startPieces = std::ceil((xEnd - xStart) * view.scale / startSpacing);
+	if (!(startPieces < maxStartPieces))
+	{
+		startPieces = maxStartPieces;
+	}
+	int numPieces = std::max(1, (int)startPieces);
+	x.resize(numPieces + 1);
+	y.resize(numPieces + 1);
+	for (int i = 0; i <= numPieces; i++)
+	{
+		x[i] = xStart + (xEnd - xStart) * i / numPieces;
+	}
+	curve.Evaluate(time, &x[0], &y[0], numPieces + 1);
+	evaluations += numPieces + 1;
+	pieces.assign(numPieces, PIECE_CUTTING);
+	middleKnown.assign(numPieces, 0);
+	middleY.resize(numPieces);
+
+	for (int round = 0; round < maxRounds; round++)
+	{
+		// Work out the middle of every piece which isn't finished, all in one go.
+		// (The first half of a piece which was checked at its quarter point already knows its middle.)
+		midX.clear();
+		for (int i = 0; i < numPieces; i++)
+		{
+			if (pieces[i] == PIECE_CUTTING && !middleKnown[i])
+			{
+				midX.push_back((x[i] + x[i + 1]) / 2);
+			}
+		}
+		if (midX.empty() && std::find(pieces.begin(), pieces.end(), (char)PIECE_CUTTING) == pieces.end())
+		{
+			break;
+		}
+		midY.resize(midX.size());
+		if (!midX.empty())
+		{
+			curve.Evaluate(time, &midX[0], &midY[0], (int)midX.size());
+			evaluations += (int)midX.size();
+		}
+		int middle = 0;
+		for (int i = 0; i < numPieces; i++)
+		{
+			if (pieces[i] == PIECE_CUTTING && !middleKnown[i])
+			{
+				middleY[i] = midY[middle++];
+			}
+		}
+
+		// Pieces which look straight at the middle are checked a quarter of the way along too, again all
+		// in one go. The middle alone isn't enough: across a bend one way then the other (like x^3 at 0),
+		// it can be right on the straight line while the rest of the curve isn't. Then the two halves
+		// bend away from the line by about the same amount, so checking one of them is enough.
+		quarterX.clear();
+		checks.assign(numPieces, PIECE_DONE);
+		for (int i = 0; i < numPieces; i++)
+		{
+			if (pieces[i] != PIECE_CUTTING)
+			{
+				continue;
+			}
+			float middleX = (x[i] + x[i + 1]) / 2;
+			checks[i] = (char)CheckPiece(view, x[i], y[i], x[i + 1], y[i + 1], &middleX, &middleY[i], 1);
+			if (checks[i] == PIECE_STRAIGHT)
+			{
+				quarterX.push_back((x[i] + middleX) / 2);
+			}
+		}
+		quarterY.resize(quarterX.size());
+		if (!quarterX.empty())
+		{
+			curve.Evaluate(time, &quarterX[0], &quarterY[0], (int)quarterX.size());
+			evaluations += (int)quarterX.size();
+		}
+
+		// Build the next list of points, with the middles added where pieces need cutting
+		nextX.clear();
+		nextY.clear();
+		nextPieces.clear();
+		nextMiddleKnown.clear();
+		nextMiddleY.clear();
+		int quarter = 0;
+		for (int i = 0; i < numPieces; i++)
+		{
+			nextX.push_back(x[i]);
+			nextY.push_back(y[i]);
+			if (pieces[i] != PIECE_CUTTING)
+			{
+				nextPieces.push_back(pieces[i]);
+				nextMiddleKnown.push_back(0);
+				nextMiddleY.push_back(0);
+				continue;
+			}
+
+			float middleX = (x[i] + x[i + 1]) / 2;
+			PieceState state = (PieceState)checks[i];
+			bool quarterKnown = state == PIECE_STRAIGHT;
+			if (quarterKnown)
+			{
+				float checkX[2] = { quarterX[quarter], middleX };
+				float checkY[2] = { quarterY[quarter], middleY[i] };
+				state = CheckPiece(view, x[i], y[i], x[i + 1], y[i + 1], checkX, checkY, 2);
+			}
+			if (state == PIECE_CUTTING)
+			{
+				// If the quarter point was worked out, it's the middle of the first half
+				nextX.push_back(middleX);
+				nextY.push_back(middleY[i]);
+				nextPieces.push_back(PIECE_CUTTING);
+				nextPieces.push_back(PIECE_CUTTING);
+				nextMiddleKnown.push_back(quarterKnown ? 1 : 0);
+				nextMiddleKnown.push_back(0);
+				nextMiddleY.push_back(quarterKnown ? quarterY[quarter] : 0);
+				nextMiddleY.push_back(0);
+			}
+			else
+			{
+				nextPieces.push_back((char)(state == PIECE_BROKEN ? PIECE_BROKEN : PIECE_DONE));
+				nextMiddleKnown.push_back(0);
+				nextMiddleY.push_back(0);
+			}
+			if (quarterKnown)
+			{
+				quarter++;
+			}
+		}
+		nextX.push_back(x[numPieces]);
+		nextY.push_back(y[numPieces]);
+
+		x.swap(nextX);
+		y.swap(nextY);
+		pieces.swap(nextPieces);
+		middleKnown.swap(nextMiddleKnown);
+		middleY.swap(nextMiddleY);
+		numPieces = (int)pieces.size();
+	}
+
+	// Pieces which still aren't straight after every round are either very steep, or a jump.
+	// Less than a pixel wide and more than half the screen high is treated as a jump.
+	for (int i = 0; i < numPieces; i++)
+	{
+		if (pieces[i] == PIECE_CUTTING)
+		{
+			float width = (x[i + 1] - x[i]) * view.scale;
+			float height = std::abs(y[i + 1] - y[i]) * yScale;
+			if (width < 1 && height > view.screenHeight / 2)
+			{
+				pieces[i] = PIECE_BROKEN;
+			}
+		}
+	}
+
+	MakeVertices(view, color, vertices);
+}
+
+// Decides whether a piece of the curve is straight enough to draw as one line, given where the
+// curve really is at numChecks places along it. PIECE_STRAIGHT means it's close enough to the line
+// at all of them, and PIECE_DONE that it doesn't need drawing or cutting because it's off the screen.
+CurveSampler::PieceState CurveSampler::CheckPiece(const GraphView& view, float x1, float y1, float x2, float y2,
+	const float* checkX, const float* checkY, int numChecks)
+{
+	// No value at all (like the square root of a negative number) means nothing to draw.
+	// If only some of the points have values, keep cutting to find where the values stop.
+	int numFinite = (std::isfinite(y1) ? 1 : 0) + (std::isfinite(y2) ? 1 : 0);
+	for (int i = 0; i < numChecks; i++)
+	{
+		numFinite += std::isfinite(checkY[i]) ? 1 : 0;
+	}
+	if (numFinite == 0)
+	{
+		return PIECE_BROKEN;
+	}
+	if (numFinite < numChecks + 2)
+	{
+		return PIECE_CUTTING;
+	}
+
+	float screenX1 = view.ToScreenX(x1);
+	float screenY1 = ToScreenY(view, y1);
+	float screenX2 = view.ToScreenX(x2);
+	float screenY2 = ToScreenY(view, y2);
+
+	// Pieces completely above or below the screen won't be seen, so there's no point cutting them
+	float top = -clipMargin;
+	float bottom = view.screenHeight + clipMargin;
+	bool allAbove = screenY1 < top && screenY2 < top;
+	bool allBelow = screenY1 > bottom && screenY2 > bottom;
+	for (int i = 0; i < numChecks; i++)
+	{
+		float checkScreenY = ToScreenY(view, checkY[i]);
+		allAbove = allAbove && checkScreenY < top;
+		allBelow = allBelow && checkScreenY > bottom;
+	}
+	if (allAbove || allBelow)
+	{
+		return PIECE_DONE;
+	}
+
+	// Distance from each checked point to the straight line between the ends
+	float dx = screenX2 - screenX1;
+	float dy = screenY2 - screenY1;
+	float length = std::sqrt(dx * dx + dy * dy);
+	for (int i = 0; i < numChecks; i++)
+	{
+		float distance = std::abs(dx * (ToScreenY(view, checkY[i]) - screenY1) - dy * (view.ToScreenX(checkX[i]) - screenX1)) / length;
+		if (distance > tolerance)
+		{
+			return PIECE_CUTTING;
+		}
+	}
+	return PIECE_STRAIGHT;
+}
+
+// Adds the start of a piece to the line strip, breaking the line first if needed.
+// When the piece joins on to the last one, its start is already the last vertex, so nothing is added.
+// A line strip can't have gaps, so a gap is made with see-through vertices: the line from
+// the last point to a see-through copy of the new point can't be seen.
+static void AddPoint(std::vector<sf::Vertex>& vertices, sf::Vector2f position, sf::Color color, bool joinToLast)
+{
+	if (joinToLast)
+	{
+		return;
+	}
+	if (!vertices.empty())
+	{
+		sf::Color invisible = color;
+		invisible.a = 0;
+		vertices.push_back(sf::Vertex(vertices.back().position, invisible));
+		vertices.push_back(sf::Vertex(position, invisible));
+	}
+	vertices.push_back(sf::Vertex(position, color));
+}
+
+void CurveSampler::MakeVertices(const GraphView& view, sf::Color color, std::vector<sf::Vertex>& vertices)
+{
+	float top = -clipMargin;
+	float bottom = view.screenHeight + clipMargin;
+	bool lineGoing = false;	// Whether the last vertex is the end of the last piece
+	int numPieces = (int)pieces.size();
+
+	for (int i = 0; i < numPieces; i++)
+	{
+		if (pieces[i] == PIECE_BROKEN || !std::isfinite(y[i]) || !std::isfinite(y[i + 1]))
+		{
+			if (lineGoing)
+			{
+				breaks++;
+			}
+			lineGoing = false;
+			continue;
+		}
+
+		sf::Vector2f start(view.ToScreenX(x[i]), ToScreenY(view, y[i]));
+		sf::Vector2f end(view.ToScreenX(x[i + 1]), ToScreenY(view, y[i + 1]));
+		if ((start.y < top && end.y < top) || (start.y > bottom && end.y > bottom))
+		{
+			lineGoing = false;
+			continue;
+		}
+
+		// Cut the line off at the top and bottom of the screen.
+		// 'along' goes from 0 at the start of the piece to 1 at the end. It's a double, because a very
+		// steep piece can go millions of pixels past the screen, and then the part on the screen is
+		// too small a fraction of it for a float.
+		double alongStart = 0;
+		double alongEnd = 1;
+		double dx = (double)end.x - start.x;
+		double dy = (double)end.y - start.y;
+		if (dy != 0)
+		{
+			double alongTop = ((double)top - start.y) / dy;
+			double alongBottom = ((double)bottom - start.y) / dy;
+			alongStart = std::max(alongStart, std::min(alongTop, alongBottom));
+			alongEnd = std::min(alongEnd, std::max(alongTop, alongBottom));
+		}
+		sf::Vector2f clippedStart((float)(start.x + dx * alongStart), (float)(start.y + dy * alongStart));
+		sf::Vector2f clippedEnd((float)(start.x + dx * alongEnd), (float)(start.y + dy * alongEnd));
+
+		AddPoint(vertices, clippedStart, color, lineGoing && alongStart == 0);
+		vertices.push_back(sf::Vertex(clippedEnd, color));
+		lineGoing = alongEnd == 1;
+	}
+}
+
+// The biggest distance, in pixels, between the real curve and the lines drawn for it,
+// checked at 16 places along every line which is on the screen
+static float MeasureError(Expression& curve, float time, const GraphView& view, const std::vector<sf::Vertex>& vertices)
+{
+	float biggest = 0;
+	for (int i = 0; i + 1 < (int)vertices.size(); i++)
+	{
+		sf::Vector2f start = vertices[i].position;
+		sf::Vector2f end = vertices[i + 1].position;
+		if (vertices[i].color.a == 0 || vertices[i + 1].color.a == 0 || end.x <= start.x)
+		{
+			continue;
+		}
+
+		float dx = end.x - start.x;
+		float dy = end.y - start.y;
+		float length = std::sqrt(dx * dx + dy * dy);
+		for (int j = 1; j < 16; j++)
+		{
+			float screenX = start.x + dx * j / 16;
+			float screenY = view.ToScreenY(curve.Evaluate(time, view.ToWorldX(screenX)));
+			if (screenY < 0 || screenY > view.screenHeight)
+			{
+				continue;
+			}
+			float distance = std::abs(dx * (screenY - start.y) - dy * (screenX - start.x)) / length;
+			biggest = std::max(biggest, distance);
+		}
+	}
+	return biggest;
+}
+
+void RunSampleBenchmark()
+{
+	const float time = 1.5f;
+	const int repeats = 1000;
+	const float scales[] = { 6, 60, 600 };
+	CurveSampler sampler;
+	std::vector<sf::Vertex> vertices;
+	std::vector<float> fixedX;
+	std::vector<float> fixedY;
+
+	printf("Scale Curve | Fixed: points  error px | Sampler: vertices  evaluations  breaks  error px  us per curve\n");
+	for (float scale : scales)
+	{
+		GraphView view;
+		view.scale = scale;
+
+		for (int curveType = 1; curveType <= NUM_CURVE_TYPES; curveType++)
+		{
+			Expression curve;
+			std::string error;
+			curve.Compile(shippedCurveText[curveType - 1], error);
+
+			// The old way: every 0.1 from -20 to 20
+			fixedX.resize(401);
+			fixedY.resize(401);
+			for (int i = 0; i <= 400; i++)
+			{
+				fixedX[i] = -20.0f + i * 0.1f;
+			}
+			EvaluateCurve(curveType, time, &fixedX[0], &fixedY[0], 401);
+			vertices.clear();
+			for (int i = 0; i <= 400; i++)
+			{
+				vertices.push_back(sf::Vertex(sf::Vector2f(view.ToScreenX(fixedX[i]), view.ToScreenY(fixedY[i]))));
+			}
+			float fixedError = MeasureError(curve, time, view, vertices);
+
+			sf::Clock clock;
+			for (int repeat = 0; repeat < repeats; repeat++)
+			{
+				sampler.Sample(curve, time, view, sf::Color::White, vertices);
+			}
+			float seconds = clock.getElapsedTime().asSeconds();
+			float sampledError = MeasureError(curve, time, view, vertices);
+
+			printf("%5g %5d | %13d %9.2f | %17d %12d %7d %9.2f %13.1f\n", scale, curveType, 401, fixedError,
+				(int)vertices.size(), sampler.evaluations, sampler.breaks, sampledError, seconds * 1e6f / repeats);
+		}
+	}
+}
@@ -0,0 +1,79 @@
+#pragma once
+#include <vector>
+#include <SFML\Graphics.hpp>
+#include "GraphView.h"
+#include "Expression.h"
+
+// Chooses where to put the points along a curve.
+//
+// Stepping along x by a fixed amount wastes points on the nearly straight parts of a curve, and
+// isn't enough on steep parts like 2^x, where one step can jump thousands of pixels. Instead,
+// this starts with a point every few pixels, and keeps cutting each piece of the curve in half
+// while the real curve is more than 'tolerance' pixels away from the straight line drawn for it.
+// A piece is checked at its middle, and if that looks straight, a quarter of the way along too. The
+// middles for a whole round of cutting are worked out with one Evaluate call, and the quarters with another.
+//
+// Only the part of the curve on the screen is sampled. Lines are cut off just past the top and
+// bottom of the screen. Where the curve jumps (like 1/x at 0) or has no value, the line is broken
+// instead of joining the two sides with a line that isn't on the curve.
+class CurveSampler
+{
+public:
+	float tolerance = 0.25f;	// Pixels
+	float startSpacing = 8;		// Pixels between the first points, before any pieces are cut
+	int maxRounds = 12;			// Each round halves the pieces which aren't straight enough yet
+
+	// Statistics for the last Sample
+	int evaluations = 0;	// Points worked out
+	int breaks = 0;			// Gaps in the line
+
+	// Fills 'vertices' with a line strip for the part of the curve on the view's screen
+	void Sample(Expression& curve, float time, const GraphView& view, sf::Color color, std::vector<sf::Vertex>& vertices);
+
+	// The same, but with yScale pixels for each unit of y instead of view.scale, for a picture whose
+	// x and y ranges aren't the same shape as it is (like an exported plot)
+	void Sample(Expression& curve, float time, const GraphView& view, float yScale, sf::Color color, std::vector<sf::Vertex>& vertices);
+
+private:
+	enum PieceState
+	{
+		PIECE_CUTTING,	// Not straight enough yet
+		PIECE_DONE,
+		PIECE_BROKEN,	// Not drawn
+		PIECE_STRAIGHT	// Only while checking: close enough to a straight line where it was checked
+	};
+
+	// Points along the curve, in order. pieces[i] is the state of the piece from point i to point i + 1.
+	std::vector<float> x;
+	std::vector<float> y;
+	std::vector<char> pieces;
+
+	// Reused each round, so sampling doesn't allocate memory once they're big enough
+	std::vector<float> nextX;
+	std::vector<float> nextY;
+	std::vector<char> nextPieces;
+	std::vector<char> middleKnown;	// Whether middleY has the curve half way along the piece already
+	std::vector<float> middleY;
+	std::vector<char> nextMiddleKnown;
+	std::vector<float> nextMiddleY;
+	std::vector<char> checks;
+	std::vector<float> midX;
+	std::vector<float> midY;
+	std::vector<float> quarterX;
+	std::vector<float> quarterY;
+
+	float yScale = 60;	// For the Sample being worked out
+
+	float ToScreenY(const GraphView& view, float worldY) const
+	{
+		return view.originY - worldY * yScale;
+	}
+
+	PieceState CheckPiece(const GraphView& view, float x1, float y1, float x2, float y2, const float* checkX, const float* checkY, int numChecks);
+	void MakeVertices(const GraphView& view, sf::Color color, std::vector<sf::Vertex>& vertices);
+};
+
+// "Game.exe -samplebench" compares the fixed step DrawCurve used to use with the sampler,
+// at a few zoom levels. The sampler's error can be a little over the tolerance (0.26 px on curve 5
+// zoomed out), where a piece bends more between its checked points than at them.
+void RunSampleBenchmark();
@@ -0,0 +1,204 @@
+#include <SFML\System\Clock.hpp>
+#include <math.h>
+#include "Main.h"
+#include "Helpers.h"
+#include "CurveSweep.h"
+
+const float SWEEP_POINT_SPACING = 2;	// Pixels between the points of each curve
+const int SWEEP_CHUNK = 256;			// Points in each piece of work
+
+// Colours going round the rainbow, for 'amount' from 0 to 1
+static sf::Color RainbowColor(float amount)
+{
+	float hue = amount * 5;		// Red, yellow, green, cyan, blue, magenta
+	int section = (int)hue;
+	float along = hue - section;
+	sf::Uint8 up = (sf::Uint8)(255 * along);
+	sf::Uint8 down = (sf::Uint8)(255 * (1 - along));
+	switch (section)
+	{
+	case 0: return sf::Color(255, up, 0);
+	case 1: return sf::Color(down, 255, 0);
+	case 2: return sf::Color(0, 255, up);
+	case 3: return sf::Color(0, down, 255);
+	case 4: return sf::Color(up, 0, 255);
+	default: return sf::Color(255, 0, 255);
+	}
+}
+
+bool CurveSweep::Compile(const std::string& text, float firstK, float lastK, int numCurves, std::string& error)
+{
+	if (!curve.CompileCurve(text, error))
+	{
+		return false;
+	}
+	parameters.resize(numCurves);
+	colors.resize(numCurves);
+	for (int c = 0; c < numCurves; c++)
+	{
+		float amount = numCurves > 1 ? (float)c / (numCurves - 1) : 0;
+		parameters[c] = firstK + (lastK - firstK) * amount;
+		colors[c] = RainbowColor(amount);
+	}
+
+	// The old workspaces were for the old expression
+	workspaces.clear();
+	return true;
+}
+
+void CurveSweep::Update(float time, const GraphView& view, ThreadPool& pool)
+{
+	int numCurves = (int)parameters.size();
+	numPoints = (int)(view.screenWidth / SWEEP_POINT_SPACING) + 1;
+
+	// Each curve has its points, and an invisible vertex at each end so the line from one curve
+	// to the next can't be seen
+	int verticesPerCurve = numPoints + 2;
+	vertices.resize(numCurves * verticesPerCurve);
+	worldX.resize(numPoints);
+	for (int i = 0; i < numPoints; i++)
+	{
+		worldX[i] = view.ToWorldX(i * SWEEP_POINT_SPACING);
+	}
+
+	int numThreads = pool.GetThreadCount();
+	if ((int)workspaces.size() != numThreads)
+	{
+		workspaces.assign(numThreads, ExpressionWorkspace());
+		worldY.assign(numThreads, std::vector<float>(SWEEP_CHUNK + 2));
+		screenY.assign(numThreads, std::vector<float>(SWEEP_CHUNK + 2));
+	}
+
+	// One task per chunk of points of each curve
+	int chunksPerCurve = (numPoints + SWEEP_CHUNK - 1) / SWEEP_CHUNK;
+	pool.Run(numCurves * chunksPerCurve, [&](int task, int thread)
+	{
+		int c = task / chunksPerCurve;
+		int first = (task % chunksPerCurve) * SWEEP_CHUNK;
+		int count = numPoints - first < SWEEP_CHUNK ? numPoints - first : SWEEP_CHUNK;
+
+		// Also work out the point either side of the chunk, as where an invisible point goes depends on its neighbours
+		int evaluateFirst = first > 0 ? first - 1 : 0;
+		int evaluateEnd = first + count < numPoints ? first + count + 1 : numPoints;
+		float* y = worldY[thread].data();
+		curve.Evaluate(time, parameters[c], &worldX[evaluateFirst], y, evaluateEnd - evaluateFirst, workspaces[thread]);
+
+		// Points which aren't numbers, or are miles off the screen, aren't drawn. They're NaN from here on.
+		float* pointY = screenY[thread].data() - evaluateFirst;	// So pointY[i] is point i's
+		for (int i = evaluateFirst; i < evaluateEnd; i++)
+		{
+			float screen = view.ToScreenY(y[i - evaluateFirst]);
+			pointY[i] = screen > -1000000 && screen < 1000000 ? screen : NAN;
+		}
+
+		// Straight into this task's own part of the vertices
+		sf::Vertex* curveVertices = &vertices[c * verticesPerCurve];
+		sf::Color color = colors[c];
+		sf::Color invisible = color;
+		invisible.a = 0;
+		for (int i = first; i < first + count; i++)
+		{
+			sf::Vertex& vertex = curveVertices[1 + i];
+			if (!isnan(pointY[i]))
+			{
+				vertex.position = sf::Vector2f(i * SWEEP_POINT_SPACING, pointY[i]);
+				vertex.color = color;
+				continue;
+			}
+
+			// A see-through vertex still has lines to it from both sides, which fade in or out along
+			// their length. Putting it on top of a visible neighbour makes the line to that neighbour
+			// have no length, so nothing is drawn. (The line to its other neighbour is see-through
+			// if that one's invisible too, so it only shows across a single missing point, where it
+			// joins up the points either side.)
+			int neighbour = i;
+			if (i > 0 && !isnan(pointY[i - 1]))
+			{
+				neighbour = i - 1;
+			}
+			else if (i + 1 < numPoints && !isnan(pointY[i + 1]))
+			{
+				neighbour = i + 1;
+			}
+			float neighbourY = isnan(pointY[neighbour]) ? 0 : pointY[neighbour];
+			vertex.position = sf::Vector2f(neighbour * SWEEP_POINT_SPACING, neighbourY);
+			vertex.color = invisible;
+		}
+		if (first == 0)
+		{
+			curveVertices[0] = sf::Vertex(curveVertices[1].position, invisible);
+		}
+		if (first + count == numPoints)
+		{
+			curveVertices[numPoints + 1] = sf::Vertex(curveVertices[numPoints].position, invisible);
+		}
+	});
+}
+
+void CurveSweep::Draw()
+{
+	if (!vertices.empty())
+	{
+		window->draw(vertices.data(), vertices.size(), sf::LineStrip);
+	}
+}
+
+int CurveSweep::GetCurveCount()
+{
+	return (int)parameters.size();
+}
+
+const std::vector<sf::Vertex>& CurveSweep::GetVertices()
+{
+	return vertices;
+}
+
+void RunSweepBenchmark(int numCurves)
+{
+	const int numFrames = 120;
+	CurveSweep sweep;
+	std::string error;
+	if (!sweep.Compile("sin((x + t) * k)", 0.5f, 10, numCurves, error))
+	{
+		printf("%s\n", error.c_str());
+		return;
+	}
+
+	// Double the threads each time, up to one per core (and at least 4, to see the cost of sharing
+	// out the work even on a computer with fewer cores)
+	int numCores = (int)std::thread::hardware_concurrency();
+	int mostThreads = numCores > 4 ? numCores : 4;
+	printf("%d curves of %s, %d cores\n", numCurves, "sin((x + t) * k)", numCores);
+
+	std::vector<sf::Vertex> oneThreadVertices;
+	float oneThreadMs = 0;
+	for (int numThreads = 1; numThreads <= mostThreads; numThreads *= 2)
+	{
+		ThreadPool pool(numThreads);
+		GraphView view;
+		sf::Clock clock;
+		for (int frame = 0; frame < numFrames; frame++)
+		{
+			sweep.Update(frame / 60.0f, view, pool);
+		}
+		float ms = clock.getElapsedTime().asSeconds() * 1000 / numFrames;
+
+		// Every thread count should give exactly the same vertices
+		const std::vector<sf::Vertex>& vertices = sweep.GetVertices();
+		bool same = true;
+		if (numThreads == 1)
+		{
+			oneThreadVertices = vertices;
+			oneThreadMs = ms;
+		}
+		else
+		{
+			for (size_t i = 0; i < vertices.size() && same; i++)
+			{
+				same = vertices[i].position == oneThreadVertices[i].position && vertices[i].color == oneThreadVertices[i].color;
+			}
+		}
+		printf("  %2d threads: %.3f ms per frame, %.2fx faster than 1 thread, %d vertices%s\n", numThreads, ms, oneThreadMs / ms,
+			(int)vertices.size(), same ? "" : ", DIFFERENT from 1 thread");
+	}
+}
@@ -0,0 +1,45 @@
+#pragma once
+#include <vector>
+#include <SFML\Graphics.hpp>
+#include "Expression.h"
+#include "GraphView.h"
+#include "ThreadPool.h"
+
+// A whole family of curves from one expression, like "sin((x + t) * k)" for hundreds of values of k
+// (a 'parameter sweep').
+//
+// Every curve is worked out at fixed steps across the screen, and all of them go into one big
+// list of vertices, drawn with a single draw call. Each curve always has the same number of
+// vertices, so where any piece of any curve goes in the list is known in advance. That lets the
+// work be cut into pieces (one curve, one stretch of x) and shared between a ThreadPool's threads,
+// with each piece written straight into its own part of the list: no two threads ever write to
+// the same place, so they never need to wait for each other.
+class CurveSweep
+{
+public:
+	// Draws 'text' for numCurves values of k, evenly spaced from firstK to lastK
+	bool Compile(const std::string& text, float firstK, float lastK, int numCurves, std::string& error);
+
+	// Works out every curve across the view, shared between the pool's threads
+	void Update(float time, const GraphView& view, ThreadPool& pool);
+	void Draw();
+
+	int GetCurveCount();
+	const std::vector<sf::Vertex>& GetVertices();
+
+private:
+	Expression curve;
+	std::vector<float> parameters;	// k for each curve
+	std::vector<sf::Color> colors;
+	int numPoints = 0;				// Per curve
+	std::vector<float> worldX;		// The x of each point, the same for every curve
+	std::vector<sf::Vertex> vertices;
+
+	// Things of their own for each thread
+	std::vector<ExpressionWorkspace> workspaces;
+	std::vector<std::vector<float>> worldY;
+	std::vector<std::vector<float>> screenY;
+};
+
+// "Game.exe -sweepbench [curves]" times a sweep of sin((x + t) * k) with different numbers of threads
+void RunSweepBenchmark(int numCurves);
@@ -0,0 +1,1219 @@
+#include <SFML\System\Clock.hpp>
+#include <cctype>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <xmmintrin.h>
+#include "Helpers.h"
+#include "CurveKernels.h"
+#include "CurveSampler.h"
+#include "Expression.h"
+
+// How many x values each register holds. Big enough that choosing the next instruction costs
+// almost nothing, small enough that all the registers stay in the CPU's fastest memory.
+const int BLOCK_SIZE = 256;
+const int MAX_REGISTERS = 64;
+const int X_REGISTER = 0;
+
+enum Op
+{
+	OP_CONST,
+	OP_X,
+	OP_T,
+	OP_K,
+	OP_Y,
+	OP_COPY,
+	OP_ADD,
+	OP_SUB,
+	OP_MUL,
+	OP_DIV,
+	OP_NEG,
+	OP_POW,
+	OP_SQUARE,
+	OP_CUBE,
+	OP_SIN,
+	OP_COS,
+	OP_TAN,
+	OP_SQRT,
+	OP_ABS,
+	OP_EXP,
+	OP_EXP2,
+	OP_LOG,
+	OP_FLOOR,
+	OP_MIN,
+	OP_MAX
+};
+
+const char* opNames[] =
+{
+	"const", "x", "t", "k", "y", "copy", "add", "sub", "mul", "div", "neg", "pow", "square", "cube",
+	"sin", "cos", "tan", "sqrt", "abs", "exp", "exp2", "log", "floor", "min", "max"
+};
+
+// The functions which can be typed in, and how many numbers they take
+struct FunctionName
+{
+	const char* name;
+	int op;
+	int numArguments;
+};
+
+const FunctionName functionNames[] =
+{
+	{ "sin", OP_SIN, 1 },
+	{ "cos", OP_COS, 1 },
+	{ "tan", OP_TAN, 1 },
+	{ "sqrt", OP_SQRT, 1 },
+	{ "abs", OP_ABS, 1 },
+	{ "exp", OP_EXP, 1 },
+	{ "exp2", OP_EXP2, 1 },
+	{ "log", OP_LOG, 1 },
+	{ "floor", OP_FLOOR, 1 },
+	{ "min", OP_MIN, 2 },
+	{ "max", OP_MAX, 2 },
+	{ "pow", OP_POW, 2 },
+};
+
+enum TokenType
+{
+	TOKEN_NUMBER,
+	TOKEN_NAME,
+	TOKEN_SYMBOL,	// One of + - * / ^ ( ) , kept in 'name'
+	TOKEN_END
+};
+
+// Works out one operation on single numbers. Used for constant folding, so the answers
+// match what the instructions would have worked out.
+static float ApplyOp(int op, float a, float b)
+{
+	switch (op)
+	{
+	case OP_ADD: return a + b;
+	case OP_SUB: return a - b;
+	case OP_MUL: return a * b;
+	case OP_DIV: return a / b;
+	case OP_NEG: return -a;
+	case OP_POW: return powf(a, b);
+	case OP_SQUARE: return a * a;
+	case OP_CUBE: return a * a * a;
+	case OP_SIN: return sinf(a);
+	case OP_COS: return cosf(a);
+	case OP_TAN: return tanf(a);
+	case OP_SQRT: return sqrtf(a);
+	case OP_ABS: return fabsf(a);
+	case OP_EXP: return expf(a);
+	case OP_EXP2: return exp2f(a);
+	case OP_LOG: return logf(a);
+	case OP_FLOOR: return floorf(a);
+	case OP_MIN: return fminf(a, b);
+	case OP_MAX: return fmaxf(a, b);
+	}
+	return a;
+}
+
+static bool IsBinary(int op)
+{
+	return op == OP_ADD || op == OP_SUB || op == OP_MUL || op == OP_DIV || op == OP_POW || op == OP_MIN || op == OP_MAX;
+}
+
+/////////////////////////////////////////////////////////////////////////////
+// COMPILING
+
+bool Expression::Compile(const std::string& newText, std::string& error)
+{
+	compiled = false;
+	usesTime = false;
+	usesParameter = false;
+	usesY = false;
+	scrolls = false;
+	scrollSpeed = 0;
+	compileError.clear();
+	nodes.clear();
+	instructions.clear();
+
+	// Text to tokens
+	if (!Tokenize(newText))
+	{
+		error = compileError;
+		return false;
+	}
+
+	// Tokens to a tree
+	nextToken = 0;
+	int root = ParseSum();
+	if (root >= 0 && tokens[nextToken].type != TOKEN_END)
+	{
+		Fail("Unexpected '" + tokens[nextToken].name + "'", tokens[nextToken].position);
+		root = -1;
+	}
+	if (root < 0)
+	{
+		error = compileError;
+		return false;
+	}
+
+	// Work out everything which doesn't depend on x or t
+	root = Fold(root);
+
+	// Tree to instructions. Register 0 is always x.
+	std::vector<bool> registerFree(MAX_REGISTERS, true);
+	registerFree[X_REGISTER] = false;
+	constants.assign(MAX_REGISTERS, 0.0f);
+	isConstant.assign(MAX_REGISTERS, false);
+	timeRegister = -1;
+	parameterRegister = -1;
+	yRegister = -1;
+	numRegisters = 1;
+	AllocateInputs(root, registerFree);
+	resultRegister = compileError.empty() ? Generate(root, registerFree) : -1;
+	if (resultRegister < 0)
+	{
+		error = compileError;
+		return false;
+	}
+
+	// The answer has to end up in a register of its own, as Evaluate writes it straight into y
+	if (IsInput(resultRegister))
+	{
+		int dest = AllocateRegister(registerFree);
+		if (dest < 0)
+		{
+			error = compileError;
+			return false;
+		}
+		Instruction copy = { OP_COPY, (unsigned char)dest, (unsigned char)resultRegister, 0 };
+		instructions.push_back(copy);
+		resultRegister = dest;
+	}
+
+	// Fill the constant registers now, so Evaluate doesn't have to
+	registers.assign(numRegisters * BLOCK_SIZE, 0.0f);
+	for (int r = 0; r < numRegisters; r++)
+	{
+		if (isConstant[r])
+		{
+			for (int i = 0; i < BLOCK_SIZE; i++)
+			{
+				registers[r * BLOCK_SIZE + i] = constants[r];
+			}
+		}
+	}
+	registerTime = NAN;
+
+	// k is 1, except when given by the caller
+	if (parameterRegister >= 0)
+	{
+		for (int i = 0; i < BLOCK_SIZE; i++)
+		{
+			registers[parameterRegister * BLOCK_SIZE + i] = 1;
+		}
+	}
+
+	// A curve which only uses x and t together, as a * x + b * t, is some function of
+	// x + (b / a) * t. So it's the same shape at any time, moved left by (b / a) * t.
+	scrollFound = false;
+	scrollBroken = false;
+	AddScrollPart(FindScroll(root));
+	if (usesTime && scrollFound && !scrollBroken && scrollRatio != 0)
+	{
+		scrolls = true;
+		scrollSpeed = -scrollRatio;
+	}
+
+	text = newText;
+	compiled = true;
+	tokens.clear();
+	nodes.clear();
+	return true;
+}
+
+bool Expression::CompileCurve(const std::string& newText, std::string& error)
+{
+	if (!Compile(newText, error))
+	{
+		return false;
+	}
+	if (usesY)
+	{
+		// Otherwise a mistyped y would quietly be 0
+		compiled = false;
+		error = "y is only for fields, like Game.exe -field \"sin(x * y)\"";
+		return false;
+	}
+	return true;
+}
+
+bool Expression::Fail(const std::string& message, int position)
+{
+	// Only keep the first error, as later ones are usually caused by it
+	if (compileError.empty())
+	{
+		compileError = message + " (at character " + std::to_string(position + 1) + ")";
+	}
+	return false;
+}
+
+bool Expression::Tokenize(const std::string& source)
+{
+	tokens.clear();
+	int i = 0;
+	int length = (int)source.size();
+	while (i < length)
+	{
+		char c = source[i];
+		Token token;
+		token.position = i;
+		token.value = 0;
+
+		if (isspace((unsigned char)c))
+		{
+			i++;
+			continue;
+		}
+		else if (isdigit((unsigned char)c) || c == '.')
+		{
+			char* end;
+			token.type = TOKEN_NUMBER;
+			token.value = strtof(source.c_str() + i, &end);
+			int numberLength = (int)(end - (source.c_str() + i));
+			if (numberLength == 0)
+			{
+				return Fail("Bad number", i);
+			}
+			token.name = source.substr(i, numberLength);
+			i += numberLength;
+		}
+		else if (isalpha((unsigned char)c))
+		{
+			token.type = TOKEN_NAME;
+			while (i < length && (isalnum((unsigned char)source[i]) || source[i] == '_'))
+			{
+				token.name += (char)tolower((unsigned char)source[i]);
+				i++;
+			}
+		}
+		else if (strchr("+-*/^(),", c) != NULL)
+		{
+			token.type = TOKEN_SYMBOL;
+			token.name = c;
+			i++;
+		}
+		else
+		{
+			return Fail(std::string("Unknown character '") + c + "'", i);
+		}
+		tokens.push_back(token);
+	}
+
+	Token end;
+	end.type = TOKEN_END;
+	end.name = "end";
+	end.value = 0;
+	end.position = length;
+	tokens.push_back(end);
+	return true;
+}
+
+int Expression::AddNode(int op, int left, int right, float value)
+{
+	Node node;
+	node.op = op;
+	node.left = left;
+	node.right = right;
+	node.value = value;
+	nodes.push_back(node);
+	return (int)nodes.size() - 1;
+}
+
+// Each Parse function returns the number of the node it made, or -1 if there was an error.
+// They call each other in order of precedence, so 1 + 2 * 3 is 1 + (2 * 3).
+
+// sum: product, with + or - between them
+int Expression::ParseSum()
+{
+	int left = ParseProduct();
+	while (left >= 0 && tokens[nextToken].type == TOKEN_SYMBOL && (tokens[nextToken].name == "+" || tokens[nextToken].name == "-"))
+	{
+		int op = tokens[nextToken].name == "+" ? OP_ADD : OP_SUB;
+		nextToken++;
+		int right = ParseProduct();
+		if (right < 0)
+		{
+			return -1;
+		}
+		left = AddNode(op, left, right, 0);
+	}
+	return left;
+}
+
+// product: unary, with * or / between them
+int Expression::ParseProduct()
+{
+	int left = ParseUnary();
+	while (left >= 0 && tokens[nextToken].type == TOKEN_SYMBOL && (tokens[nextToken].name == "*" || tokens[nextToken].name == "/"))
+	{
+		int op = tokens[nextToken].name == "*" ? OP_MUL : OP_DIV;
+		nextToken++;
+		int right = ParseUnary();
+		if (right < 0)
+		{
+			return -1;
+		}
+		left = AddNode(op, left, right, 0);
+	}
+	return left;
+}
+
+// unary: a power, with any number of - in front. -x^2 is -(x^2), like in maths.
+int Expression::ParseUnary()
+{
+	if (tokens[nextToken].type == TOKEN_SYMBOL && tokens[nextToken].name == "-")
+	{
+		nextToken++;
+		int operand = ParseUnary();
+		return operand < 0 ? -1 : AddNode(OP_NEG, operand, -1, 0);
+	}
+	if (tokens[nextToken].type == TOKEN_SYMBOL && tokens[nextToken].name == "+")
+	{
+		nextToken++;
+		return ParseUnary();
+	}
+	return ParsePower();
+}
+
+// power: primary, optionally followed by ^ and a unary. 2^3^2 is 2^(3^2), like in maths.
+int Expression::ParsePower()
+{
+	int base = ParsePrimary();
+	if (base >= 0 && tokens[nextToken].type == TOKEN_SYMBOL && tokens[nextToken].name == "^")
+	{
+		nextToken++;
+		int exponent = ParseUnary();
+		return exponent < 0 ? -1 : AddNode(OP_POW, base, exponent, 0);
+	}
+	return base;
+}
+
+// primary: a number, x, t, a constant, a function call, or a sum in brackets
+int Expression::ParsePrimary()
+{
+	Token& token = tokens[nextToken];
+	if (token.type == TOKEN_NUMBER)
+	{
+		nextToken++;
+		return AddNode(OP_CONST, -1, -1, token.value);
+	}
+
+	if (token.type == TOKEN_SYMBOL && token.name == "(")
+	{
+		nextToken++;
+		int inside = ParseSum();
+		if (inside < 0)
+		{
+			return -1;
+		}
+		if (tokens[nextToken].name != ")")
+		{
+			Fail("Missing ')'", tokens[nextToken].position);
+			return -1;
+		}
+		nextToken++;
+		return inside;
+	}
+
+	if (token.type == TOKEN_NAME)
+	{
+		nextToken++;
+		if (token.name == "x")
+		{
+			return AddNode(OP_X, -1, -1, 0);
+		}
+		if (token.name == "t")
+		{
+			return AddNode(OP_T, -1, -1, 0);
+		}
+		if (token.name == "k")
+		{
+			return AddNode(OP_K, -1, -1, 0);
+		}
+		if (token.name == "y")
+		{
+			return AddNode(OP_Y, -1, -1, 0);
+		}
+		if (token.name == "pi")
+		{
+			return AddNode(OP_CONST, -1, -1, 3.14159265f);
+		}
+		if (token.name == "e")
+		{
+			return AddNode(OP_CONST, -1, -1, 2.71828183f);
+		}
+
+		for (const FunctionName& function : functionNames)
+		{
+			if (token.name != function.name)
+			{
+				continue;
+			}
+			if (tokens[nextToken].name != "(")
+			{
+				Fail("Expected '(' after " + token.name, tokens[nextToken].position);
+				return -1;
+			}
+			nextToken++;
+
+			int arguments[2] = { -1, -1 };
+			for (int i = 0; i < function.numArguments; i++)
+			{
+				if (i > 0)
+				{
+					if (tokens[nextToken].name != ",")
+					{
+						Fail(token.name + " needs " + std::to_string(function.numArguments) + " numbers", tokens[nextToken].position);
+						return -1;
+					}
+					nextToken++;
+				}
+				arguments[i] = ParseSum();
+				if (arguments[i] < 0)
+				{
+					return -1;
+				}
+			}
+			if (tokens[nextToken].name != ")")
+			{
+				Fail("Missing ')' after " + token.name, tokens[nextToken].position);
+				return -1;
+			}
+			nextToken++;
+			return AddNode(function.op, arguments[0], arguments[1], 0);
+		}
+
+		Fail("Unknown name '" + token.name + "'", token.position);
+		return -1;
+	}
+
+	Fail(token.type == TOKEN_END ? "Unexpected end" : "Unexpected '" + token.name + "'", token.position);
+	return -1;
+}
+
+// Works out every part of the tree which doesn't depend on x or t, and swaps some operations
+// for quicker ones. Returns the node to use instead of 'index'.
+int Expression::Fold(int index)
+{
+	if (nodes[index].left >= 0)
+	{
+		int left = Fold(nodes[index].left);
+		nodes[index].left = left;
+	}
+	if (nodes[index].right >= 0)
+	{
+		int right = Fold(nodes[index].right);
+		nodes[index].right = right;
+	}
+
+	// Copy, as AddNode can move the nodes around in memory
+	Node node = nodes[index];
+	bool leftConstant = node.left >= 0 && nodes[node.left].op == OP_CONST;
+	bool rightConstant = node.right >= 0 && nodes[node.right].op == OP_CONST;
+	float leftValue = leftConstant ? nodes[node.left].value : 0;
+	float rightValue = rightConstant ? nodes[node.right].value : 0;
+
+	// Everything it needs is already known
+	if (leftConstant && (node.right < 0 || rightConstant))
+	{
+		return AddNode(OP_CONST, -1, -1, ApplyOp(node.op, leftValue, rightValue));
+	}
+
+	if (node.op == OP_POW)
+	{
+		if (rightConstant && rightValue == 1)
+		{
+			return node.left;
+		}
+		if (rightConstant && rightValue == 2)
+		{
+			return AddNode(OP_SQUARE, node.left, -1, 0);
+		}
+		if (rightConstant && rightValue == 3)
+		{
+			return AddNode(OP_CUBE, node.left, -1, 0);
+		}
+		if (rightConstant && rightValue == 0.5f)
+		{
+			return AddNode(OP_SQRT, node.left, -1, 0);
+		}
+		if (leftConstant && leftValue == 2)
+		{
+			return AddNode(OP_EXP2, node.right, -1, 0);
+		}
+	}
+	if ((node.op == OP_ADD || node.op == OP_SUB) && rightConstant && rightValue == 0)
+	{
+		return node.left;
+	}
+	if ((node.op == OP_MUL || node.op == OP_DIV) && rightConstant && rightValue == 1)
+	{
+		return node.left;
+	}
+	if (node.op == OP_MUL && leftConstant && leftValue == 1)
+	{
+		return node.right;
+	}
+	return index;
+}
+
+// Works out how the part of the tree at 'index' uses x and t. Parts like x + t * 2 are 'linear',
+// and are passed on up the tree, so 2 * x + 3 * t and (x + t) * 2 + t can be found. The linear
+// parts used by anything else (like sin) are given to AddScrollPart.
+Expression::XTUse Expression::FindScroll(int index)
+{
+	const Node& node = nodes[index];
+	XTUse use;
+	if (node.op == OP_X || node.op == OP_T)
+	{
+		use.usesXOrT = true;
+		use.a = node.op == OP_X ? 1.0f : 0.0f;
+		use.b = node.op == OP_T ? 1.0f : 0.0f;
+		return use;
+	}
+	if (node.left < 0)
+	{
+		// A constant, k or y
+		return use;
+	}
+
+	XTUse left = FindScroll(node.left);
+	XTUse right;
+	if (node.right >= 0)
+	{
+		right = FindScroll(node.right);
+	}
+	use.usesXOrT = left.usesXOrT || right.usesXOrT;
+	if (!use.usesXOrT)
+	{
+		return use;
+	}
+
+	bool bothLinear = left.linear && right.linear;
+	bool rightConstant = node.right >= 0 && nodes[node.right].op == OP_CONST;
+	bool leftConstant = nodes[node.left].op == OP_CONST;
+	if (bothLinear && (node.op == OP_ADD || node.op == OP_SUB))
+	{
+		float sign = node.op == OP_ADD ? 1.0f : -1.0f;
+		use.a = left.a + sign * right.a;
+		use.b = left.b + sign * right.b;
+	}
+	else if (left.linear && node.op == OP_NEG)
+	{
+		use.a = -left.a;
+		use.b = -left.b;
+	}
+	else if (node.op == OP_MUL && left.linear && rightConstant)
+	{
+		use.a = left.a * nodes[node.right].value;
+		use.b = left.b * nodes[node.right].value;
+	}
+	else if (node.op == OP_MUL && right.linear && leftConstant)
+	{
+		use.a = right.a * nodes[node.left].value;
+		use.b = right.b * nodes[node.left].value;
+	}
+	else if (node.op == OP_DIV && left.linear && rightConstant)
+	{
+		use.a = left.a / nodes[node.right].value;
+		use.b = left.b / nodes[node.right].value;
+	}
+	else
+	{
+		// Something which isn't linear, like sin, uses its linear parts as they are
+		use.linear = false;
+		AddScrollPart(left);
+		AddScrollPart(right);
+	}
+	return use;
+}
+
+void Expression::AddScrollPart(const XTUse& part)
+{
+	if (!part.usesXOrT || !part.linear)
+	{
+		return;
+	}
+	if (part.a == 0)
+	{
+		// Uses t without x, so the shape changes
+		scrollBroken = true;
+		return;
+	}
+	float ratio = part.b / part.a;
+	if (!scrollFound)
+	{
+		scrollFound = true;
+		scrollRatio = ratio;
+	}
+	else if (fabsf(ratio - scrollRatio) > 1e-6f * fabsf(scrollRatio))
+	{
+		scrollBroken = true;
+	}
+}
+
+// Whether a register holds x, t, k, y or a constant, rather than a working out
+bool Expression::IsInput(int r)
+{
+	return r == X_REGISTER || r == timeRegister || r == parameterRegister || r == yRegister || isConstant[r];
+}
+
+int Expression::AllocateRegister(std::vector<bool>& registerFree)
+{
+	for (int r = 0; r < MAX_REGISTERS; r++)
+	{
+		if (registerFree[r])
+		{
+			registerFree[r] = false;
+			if (r >= numRegisters)
+			{
+				numRegisters = r + 1;
+			}
+			return r;
+		}
+	}
+	Fail("Too complicated", 0);
+	return -1;
+}
+
+// Gives t, k, y and each different constant a register of its own, before any instructions are made.
+// They're filled in once, so they must never be used for anything else.
+void Expression::AllocateInputs(int index, std::vector<bool>& registerFree)
+{
+	const Node& node = nodes[index];
+	if (node.op == OP_T && timeRegister < 0)
+	{
+		usesTime = true;
+		timeRegister = AllocateRegister(registerFree);
+	}
+	if (node.op == OP_K && parameterRegister < 0)
+	{
+		usesParameter = true;
+		parameterRegister = AllocateRegister(registerFree);
+	}
+	if (node.op == OP_Y && yRegister < 0)
+	{
+		usesY = true;
+		yRegister = AllocateRegister(registerFree);
+	}
+	if (node.op == OP_CONST && FindConstant(node.value) < 0)
+	{
+		int r = AllocateRegister(registerFree);
+		if (r >= 0)
+		{
+			constants[r] = node.value;
+			isConstant[r] = true;
+		}
+	}
+	if (node.left >= 0)
+	{
+		AllocateInputs(node.left, registerFree);
+	}
+	if (node.right >= 0)
+	{
+		AllocateInputs(node.right, registerFree);
+	}
+}
+
+int Expression::FindConstant(float value)
+{
+	for (int r = 0; r < numRegisters; r++)
+	{
+		// NaN isn't equal to anything, even itself, so it has to be checked for separately
+		if (isConstant[r] && (constants[r] == value || (std::isnan(constants[r]) && std::isnan(value))))
+		{
+			return r;
+		}
+	}
+	return -1;
+}
+
+// Adds the instructions for a node (after the instructions for its children), and returns the
+// register its answer will be in. Children's registers are freed once they've been used, so
+// the same few registers get used over and over.
+int Expression::Generate(int index, std::vector<bool>& registerFree)
+{
+	Node node = nodes[index];
+	if (node.op == OP_X)
+	{
+		return X_REGISTER;
+	}
+	if (node.op == OP_T)
+	{
+		return timeRegister;
+	}
+	if (node.op == OP_K)
+	{
+		return parameterRegister;
+	}
+	if (node.op == OP_Y)
+	{
+		return yRegister;
+	}
+	if (node.op == OP_CONST)
+	{
+		return FindConstant(node.value);
+	}
+
+	int a = Generate(node.left, registerFree);
+	int b = node.right >= 0 ? Generate(node.right, registerFree) : 0;
+	if (a < 0 || b < 0)
+	{
+		return -1;
+	}
+
+	// x, t, k, y and constants keep their registers. Anything else can be reused now.
+	if (!IsInput(a))
+	{
+		registerFree[a] = true;
+	}
+	if (node.right >= 0 && !IsInput(b))
+	{
+		registerFree[b] = true;
+	}
+
+	int dest = AllocateRegister(registerFree);
+	if (dest < 0)
+	{
+		return -1;
+	}
+	Instruction instruction = { (unsigned char)node.op, (unsigned char)dest, (unsigned char)a, (unsigned char)b };
+	instructions.push_back(instruction);
+	return dest;
+}
+
+/////////////////////////////////////////////////////////////////////////////
+// RUNNING
+
+// The simple operations have SSE versions, 4 numbers at a time. Each has a plain loop
+// at the end for the last few numbers, if count isn't a multiple of 4.
+#define BINARY_KERNEL(name, sseOp, plainOp) \
+	static void name(float* d, const float* a, const float* b, int count) \
+	{ \
+		int i = 0; \
+		for (; i + 4 <= count; i += 4) \
+		{ \
+			_mm_storeu_ps(d + i, sseOp(_mm_loadu_ps(a + i), _mm_loadu_ps(b + i))); \
+		} \
+		for (; i < count; i++) \
+		{ \
+			d[i] = plainOp; \
+		} \
+	}
+
+BINARY_KERNEL(AddKernel, _mm_add_ps, a[i] + b[i])
+BINARY_KERNEL(SubKernel, _mm_sub_ps, a[i] - b[i])
+BINARY_KERNEL(MulKernel, _mm_mul_ps, a[i] * b[i])
+BINARY_KERNEL(DivKernel, _mm_div_ps, a[i] / b[i])
+BINARY_KERNEL(MinKernel, _mm_min_ps, fminf(a[i], b[i]))
+BINARY_KERNEL(MaxKernel, _mm_max_ps, fmaxf(a[i], b[i]))
+
+static void SquareKernel(float* d, const float* a, int count)
+{
+	int i = 0;
+	for (; i + 4 <= count; i += 4)
+	{
+		__m128 a4 = _mm_loadu_ps(a + i);
+		_mm_storeu_ps(d + i, _mm_mul_ps(a4, a4));
+	}
+	for (; i < count; i++)
+	{
+		d[i] = a[i] * a[i];
+	}
+}
+
+static void CubeKernel(float* d, const float* a, int count)
+{
+	int i = 0;
+	for (; i + 4 <= count; i += 4)
+	{
+		__m128 a4 = _mm_loadu_ps(a + i);
+		_mm_storeu_ps(d + i, _mm_mul_ps(_mm_mul_ps(a4, a4), a4));
+	}
+	for (; i < count; i++)
+	{
+		d[i] = a[i] * a[i] * a[i];
+	}
+}
+
+static void NegKernel(float* d, const float* a, int count)
+{
+	// Flipping the sign bit
+	__m128 signBit = _mm_set1_ps(-0.0f);
+	int i = 0;
+	for (; i + 4 <= count; i += 4)
+	{
+		_mm_storeu_ps(d + i, _mm_xor_ps(_mm_loadu_ps(a + i), signBit));
+	}
+	for (; i < count; i++)
+	{
+		d[i] = -a[i];
+	}
+}
+
+static void AbsKernel(float* d, const float* a, int count)
+{
+	// Clearing the sign bit
+	__m128 signBit = _mm_set1_ps(-0.0f);
+	int i = 0;
+	for (; i + 4 <= count; i += 4)
+	{
+		_mm_storeu_ps(d + i, _mm_andnot_ps(signBit, _mm_loadu_ps(a + i)));
+	}
+	for (; i < count; i++)
+	{
+		d[i] = fabsf(a[i]);
+	}
+}
+
+static void SqrtKernel(float* d, const float* a, int count)
+{
+	int i = 0;
+	for (; i + 4 <= count; i += 4)
+	{
+		_mm_storeu_ps(d + i, _mm_sqrt_ps(_mm_loadu_ps(a + i)));
+	}
+	for (; i < count; i++)
+	{
+		d[i] = sqrtf(a[i]);
+	}
+}
+
+// sin, cos, exp, log and pow are the slowest instructions, so they use FastMath's versions,
+// which do 4 numbers at once
+static void PowKernel(float* d, const float* a, const float* b, int count, MathAccuracy accuracy)
+{
+	FastPow(a, b, d, count, accuracy);
+}
+
+static void ScalarKernel(int op, float* d, const float* a, int count, MathAccuracy accuracy)
+{
+	switch (op)
+	{
+	case OP_SIN:
+		FastSin(a, d, count, accuracy);
+		break;
+	case OP_COS:
+		FastCos(a, d, count, accuracy);
+		break;
+	case OP_TAN:
+		for (int i = 0; i < count; i++) d[i] = tanf(a[i]);
+		break;
+	case OP_EXP:
+		FastExp(a, d, count, accuracy);
+		break;
+	case OP_EXP2:
+		FastExp2(a, d, count, accuracy);
+		break;
+	case OP_LOG:
+		FastLog(a, d, count, accuracy);
+		break;
+	case OP_FLOOR:
+		for (int i = 0; i < count; i++) d[i] = floorf(a[i]);
+		break;
+	}
+}
+
+void Expression::Evaluate(float time, const float* x, float* y, int count)
+{
+	if (!compiled)
+	{
+		for (int i = 0; i < count; i++)
+		{
+			y[i] = NAN;
+		}
+		return;
+	}
+
+	// t is the same for every x, so its register only needs filling when it changes
+	if (timeRegister >= 0 && time != registerTime)
+	{
+		for (int i = 0; i < BLOCK_SIZE; i++)
+		{
+			registers[timeRegister * BLOCK_SIZE + i] = time;
+		}
+		registerTime = time;
+	}
+
+	RunInstructions(registers.data(), x, y, count);
+}
+
+void Expression::Evaluate(float time, float parameter, const float* x, float* y, int count, ExpressionWorkspace& workspace) const
+{
+	if (!compiled)
+	{
+		for (int i = 0; i < count; i++)
+		{
+			y[i] = NAN;
+		}
+		return;
+	}
+	FillWorkspace(time, parameter, 0, workspace);
+	RunInstructions(workspace.registers.data(), x, y, count);
+}
+
+void Expression::EvaluateRow(float time, float rowY, const float* x, float* z, int count, ExpressionWorkspace& workspace) const
+{
+	if (!compiled)
+	{
+		for (int i = 0; i < count; i++)
+		{
+			z[i] = NAN;
+		}
+		return;
+	}
+	FillWorkspace(time, 1, rowY, workspace);
+	RunInstructions(workspace.registers.data(), x, z, count);
+}
+
+// t, k and y are the same for every x, so their registers only need filling when they change
+void Expression::FillWorkspace(float time, float parameter, float rowY, ExpressionWorkspace& workspace) const
+{
+	// The first time, the workspace gets its own copy of the constants
+	if (workspace.registers.size() != registers.size())
+	{
+		workspace.registers = registers;
+		workspace.time = NAN;
+		workspace.parameter = NAN;
+		workspace.rowY = NAN;
+	}
+	if (timeRegister >= 0 && time != workspace.time)
+	{
+		for (int i = 0; i < BLOCK_SIZE; i++)
+		{
+			workspace.registers[timeRegister * BLOCK_SIZE + i] = time;
+		}
+		workspace.time = time;
+	}
+	if (parameterRegister >= 0 && parameter != workspace.parameter)
+	{
+		for (int i = 0; i < BLOCK_SIZE; i++)
+		{
+			workspace.registers[parameterRegister * BLOCK_SIZE + i] = parameter;
+		}
+		workspace.parameter = parameter;
+	}
+	if (yRegister >= 0 && rowY != workspace.rowY)
+	{
+		for (int i = 0; i < BLOCK_SIZE; i++)
+		{
+			workspace.registers[yRegister * BLOCK_SIZE + i] = rowY;
+		}
+		workspace.rowY = rowY;
+	}
+}
+
+void Expression::RunInstructions(float* registerBlocks, const float* x, float* y, int count) const
+{
+	// Where each register's numbers are. x is read straight from the caller's array,
+	// and the answer is written straight into theirs.
+	float* registerData[MAX_REGISTERS];
+	for (int r = 0; r < numRegisters; r++)
+	{
+		registerData[r] = &registerBlocks[r * BLOCK_SIZE];
+	}
+
+	for (int start = 0; start < count; start += BLOCK_SIZE)
+	{
+		int blockCount = count - start < BLOCK_SIZE ? count - start : BLOCK_SIZE;
+		registerData[X_REGISTER] = (float*)(x + start);
+		registerData[resultRegister] = y + start;
+
+		for (const Instruction& instruction : instructions)
+		{
+			float* d = registerData[instruction.dest];
+			const float* a = registerData[instruction.a];
+			const float* b = registerData[instruction.b];
+			switch (instruction.op)
+			{
+			case OP_COPY:
+				memcpy(d, a, blockCount * sizeof(float));
+				break;
+			case OP_ADD: AddKernel(d, a, b, blockCount); break;
+			case OP_SUB: SubKernel(d, a, b, blockCount); break;
+			case OP_MUL: MulKernel(d, a, b, blockCount); break;
+			case OP_DIV: DivKernel(d, a, b, blockCount); break;
+			case OP_MIN: MinKernel(d, a, b, blockCount); break;
+			case OP_MAX: MaxKernel(d, a, b, blockCount); break;
+			case OP_POW: PowKernel(d, a, b, blockCount, accuracy); break;
+			case OP_SQUARE: SquareKernel(d, a, blockCount); break;
+			case OP_CUBE: CubeKernel(d, a, blockCount); break;
+			case OP_NEG: NegKernel(d, a, blockCount); break;
+			case OP_ABS: AbsKernel(d, a, blockCount); break;
+			case OP_SQRT: SqrtKernel(d, a, blockCount); break;
+			default: ScalarKernel(instruction.op, d, a, blockCount, accuracy); break;
+			}
+		}
+	}
+}
+
+float Expression::Evaluate(float time, float x)
+{
+	float y;
+	Evaluate(time, &x, &y, 1);
+	return y;
+}
+
+bool Expression::IsCompiled()
+{
+	return compiled;
+}
+
+bool Expression::GetScrollSpeed(float& speed)
+{
+	speed = scrollSpeed;
+	return scrolls;
+}
+
+bool Expression::UsesTime()
+{
+	return usesTime;
+}
+
+bool Expression::UsesParameter()
+{
+	return usesParameter;
+}
+
+bool Expression::UsesY()
+{
+	return usesY;
+}
+
+void Expression::SetAccuracy(MathAccuracy newAccuracy)
+{
+	accuracy = newAccuracy;
+}
+
+const std::string& Expression::GetText()
+{
+	return text;
+}
+
+int Expression::GetInstructionCount()
+{
+	return (int)instructions.size();
+}
+
+void Expression::PrintInstructions()
+{
+	printf("%s\n", text.c_str());
+	for (int r = 0; r < numRegisters; r++)
+	{
+		if (isConstant[r])
+		{
+			printf("  r%d = %g\n", r, constants[r]);
+		}
+	}
+	if (timeRegister >= 0)
+	{
+		printf("  r%d = t\n", timeRegister);
+	}
+	if (parameterRegister >= 0)
+	{
+		printf("  r%d = k\n", parameterRegister);
+	}
+	if (yRegister >= 0)
+	{
+		printf("  r%d = y\n", yRegister);
+	}
+	for (const Instruction& instruction : instructions)
+	{
+		if (IsBinary(instruction.op))
+		{
+			printf("  r%d = %s r%d, r%d\n", instruction.dest, opNames[instruction.op], instruction.a, instruction.b);
+		}
+		else
+		{
+			printf("  r%d = %s r%d\n", instruction.dest, opNames[instruction.op], instruction.a);
+		}
+	}
+	printf("  answer in r%d\n", resultRegister);
+}
+
+/////////////////////////////////////////////////////////////////////////////
+// BENCHMARK
+
+void RunExpressionBenchmark()
+{
+	const int numPoints = 401;
+	const int repeats = 20000;
+	std::vector<float> x(numPoints);
+	std::vector<float> handY(numPoints);
+	std::vector<float> expressionY(numPoints);
+	for (int i = 0; i < numPoints; i++)
+	{
+		x[i] = -20.0f + i * 0.1f;
+	}
+	const float time = 1.5f;
+	std::string error;
+
+	printf("Curve                 Hand written ns/point   Expression ns/point   Slower by   Biggest difference\n");
+	for (int curveType = 1; curveType <= NUM_CURVE_TYPES; curveType++)
+	{
+		Expression expression;
+		expression.Compile(shippedCurveText[curveType - 1], error);
+
+		sf::Clock clock;
+		for (int repeat = 0; repeat < repeats; repeat++)
+		{
+			EvaluateCurve(curveType, time, &x[0], &handY[0], numPoints);
+		}
+		float handSeconds = clock.restart().asSeconds();
+		for (int repeat = 0; repeat < repeats; repeat++)
+		{
+			expression.Evaluate(time, &x[0], &expressionY[0], numPoints);
+		}
+		float expressionSeconds = clock.restart().asSeconds();
+
+		float biggestDifference = 0;
+		for (int i = 0; i < numPoints; i++)
+		{
+			float difference = std::abs(expressionY[i] - handY[i]) / std::fmax(1.0f, std::abs(handY[i]));
+			biggestDifference = std::fmax(biggestDifference, difference);
+		}
+
+		float samples = (float)numPoints * repeats;
+		printf("%-20s %23.2f %21.2f %10.2fx %20g\n", shippedCurveText[curveType - 1], handSeconds * 1e9f / samples,
+			expressionSeconds * 1e9f / samples, expressionSeconds / handSeconds, biggestDifference);
+	}
+
+	// Lots of user curves at once, sampled for the screen like GameLoop does
+	const int numCurves = 48;
+	const int numFrames = 120;
+	std::vector<Expression> curves(numCurves);
+	for (int i = 0; i < numCurves; i++)
+	{
+		float k = 0.5f + i * 0.1f;
+		std::string curveText = "sin(x * " + std::to_string(k) + " + t) * " + std::to_string(k) + " + cos(x / 3) - x^2 / 50";
+		if (!curves[i].Compile(curveText, error))
+		{
+			printf("Failed to compile %s: %s\n", curveText.c_str(), error.c_str());
+			return;
+		}
+	}
+	curves[numCurves - 1].PrintInstructions();
+
+	GraphView view;
+	CurveSampler sampler;
+	std::vector<sf::Vertex> vertices;
+	long long totalVertices = 0;
+	sf::Clock clock;
+	for (int frame = 0; frame < numFrames; frame++)
+	{
+		for (int i = 0; i < numCurves; i++)
+		{
+			sampler.Sample(curves[i], frame / 60.0f, view, sf::Color::White, vertices);
+			totalVertices += vertices.size();
+		}
+	}
+	float seconds = clock.getElapsedTime().asSeconds();
+	printf("%d curves: %.3f ms per frame (%.1f%% of a 60 Hz frame), %lld vertices per frame\n", numCurves,
+		seconds * 1000 / numFrames, seconds / numFrames * 60 * 100, totalVertices / numFrames);
+}
@@ -0,0 +1,166 @@
+#pragma once
+#include <string>
+#include <vector>
+#include "FastMath.h"
+
+// A function of x and t typed in by the user, like "sin((x + t) * 2)" or "x^3 - 2*x".
+//
+// The text is only read once, by Compile:
+// 1. It's split into 'tokens' (numbers, names, + - * / ^ and brackets).
+// 2. The tokens are turned into a tree of operations, where each operation has the operations
+//    it needs the answers of as its children (the 'parser').
+// 3. Any part of the tree which doesn't use x or t is worked out straight away ('constant folding'),
+//    and a few things are swapped for quicker versions (x^2 becomes x*x, 2^x becomes exp2(x)).
+// 4. The tree is turned into a list of simple instructions ('bytecode'), each of which reads one
+//    or two 'registers' and writes its answer to another.
+//
+// Evaluate then runs the instructions on a whole block of x values at a time. Each register holds
+// a block of numbers rather than a single number, so working out which instruction comes next only
+// happens once per block, and each instruction is a tight loop the computer can do 4 at a time.
+//
+// Supported: numbers, x, t, k, y, pi, e, + - * / ^, brackets, and the functions
+// sin cos tan sqrt abs exp exp2 log floor min max pow.
+// k is a 'parameter' for drawing a whole family of curves from one expression. It's 1, except
+// when given to Evaluate.
+// y is for fields, z = f(x, y, t), which are worked out a row at a time by EvaluateRow. It's 0
+// everywhere else.
+// sin, cos, exp, exp2, log and pow are worked out to MATH_PLOT accuracy (see FastMath.h), unless
+// SetAccuracy says otherwise. Parts folded into constants by Compile use the standard library.
+
+// The registers for evaluating an Expression on a thread of its own, as the Expression's own
+// registers can only be used by one thread at a time. Each thread needs its own workspace.
+// Use a new one after compiling the Expression again.
+struct ExpressionWorkspace
+{
+	std::vector<float> registers;
+	float time = 0;
+	float parameter = 0;
+	float rowY = 0;
+};
+
+class Expression
+{
+public:
+	// Returns false if the text isn't a valid expression, and puts the reason in 'error'
+	bool Compile(const std::string& text, std::string& error);
+
+	// Compile, for a curve: y isn't allowed, as it's only for fields
+	bool CompileCurve(const std::string& text, std::string& error);
+
+	// Sets y[i] to the expression's value at x[i], with t = time, for count values
+	void Evaluate(float time, const float* x, float* y, int count);
+
+	// One value, for when there's only one to work out
+	float Evaluate(float time, float x);
+
+	// Like the first Evaluate, with k = parameter, using the workspace's registers instead of the
+	// Expression's. So any number of threads can use it at once, each with their own workspace.
+	void Evaluate(float time, float parameter, const float* x, float* y, int count, ExpressionWorkspace& workspace) const;
+
+	// For fields: sets z[i] to the expression's value at (x[i], rowY), for count values along a row
+	// which all have the same y. Any number of threads can use it at once, like the one above.
+	void EvaluateRow(float time, float rowY, const float* x, float* z, int count, ExpressionWorkspace& workspace) const;
+
+	bool IsCompiled();
+	bool UsesTime();	// Whether the curve moves as time goes on
+	bool UsesParameter();	// Whether k is used
+	bool UsesY();			// Whether y is used, so it's a field rather than a curve
+
+	// Whether the curve just slides along x as time goes on, like sin((x + t) * 2), without
+	// changing shape. If so, 'speed' is how far it moves right each second, so the curve at time t
+	// is the one at time 0 moved right by speed * t.
+	bool GetScrollSpeed(float& speed);
+	void SetAccuracy(MathAccuracy newAccuracy);
+	const std::string& GetText();
+	int GetInstructionCount();
+
+	// Prints the instructions, for seeing what Compile made
+	void PrintInstructions();
+
+private:
+	// A node in the tree made by the parser
+	struct Node
+	{
+		int op;
+		int left = -1;		// Child node numbers. -1 if the node doesn't have one.
+		int right = -1;
+		float value = 0;	// For constants
+	};
+
+	struct Instruction
+	{
+		unsigned char op;
+		unsigned char dest;		// Register the answer goes in
+		unsigned char a;		// Registers the inputs come from
+		unsigned char b;
+	};
+
+	std::string text;
+	bool compiled = false;
+	bool usesTime = false;
+	bool usesParameter = false;
+	bool usesY = false;
+	bool scrolls = false;
+	float scrollSpeed = 0;
+	MathAccuracy accuracy = MATH_PLOT;
+
+	std::vector<Instruction> instructions;
+	int numRegisters = 0;
+	int resultRegister = 0;
+	int timeRegister = -1;		// -1 if t isn't used
+	int parameterRegister = -1;	// -1 if k isn't used
+	int yRegister = -1;			// -1 if y isn't used
+	float registerTime = 0;		// The time the time register was last filled with
+	std::vector<float> constants;	// Value of each constant register, by register number
+	std::vector<bool> isConstant;
+	std::vector<float> registers;	// numRegisters blocks of numbers, one after the other
+
+	void RunInstructions(float* registerBlocks, const float* x, float* y, int count) const;
+	void FillWorkspace(float time, float parameter, float rowY, ExpressionWorkspace& workspace) const;
+
+	// Used while compiling
+	struct Token
+	{
+		int type;
+		std::string name;
+		float value;
+		int position;
+	};
+	std::vector<Token> tokens;
+	int nextToken = 0;
+	std::vector<Node> nodes;
+	std::string compileError;
+
+	// How a part of the tree uses x and t, for finding curves which scroll
+	struct XTUse
+	{
+		bool usesXOrT = false;
+		bool linear = true;		// Whether it's a * x + b * t + (something without x or t)
+		float a = 0;
+		float b = 0;
+	};
+	bool scrollFound = false;	// Whether some part has given a speed yet
+	bool scrollBroken = false;	// Whether some part can't scroll, or has a different speed
+	float scrollRatio = 0;		// b / a of the parts so far
+
+	bool Tokenize(const std::string& text);
+	int ParseSum();
+	int ParseProduct();
+	int ParseUnary();
+	int ParsePower();
+	int ParsePrimary();
+	int AddNode(int op, int left, int right, float value);
+	int Fold(int node);
+	XTUse FindScroll(int node);
+	void AddScrollPart(const XTUse& part);
+	void AllocateInputs(int node, std::vector<bool>& registerFree);
+	int FindConstant(float value);
+	int Generate(int node, std::vector<bool>& registerFree);
+	int AllocateRegister(std::vector<bool>& registerFree);
+	bool IsInput(int r);
+	bool Fail(const std::string& message, int position);
+};
+
+// "Game.exe -exprbench" compares the shipped curves, typed in as expressions, with the hand written
+// ones in CurveKernels, and times drawing dozens of curves at once
+void RunExpressionBenchmark();
@@ -0,0 +1,667 @@
+#include <SFML\System\Clock.hpp>
+#include <emmintrin.h>
+#include <float.h>
+#include <math.h>
+#include <vector>
+#include "Helpers.h"
+#include "FastMath.h"
+
+// sin and cos. x is made smaller by taking off the nearest whole number (j) of pi/2s. pi/2 is
+// split into pieces, so j * (each piece) is exact (PIO2_A only uses the first 8 bits of a float)
+// and the small leftover isn't lost in rounding.
+const float TWO_OVER_PI = 0.636619772f;
+const float TRIG_LIMIT = 8192;		// Past this, j * the pieces aren't exact any more
+const float PIO2_A = 1.5703125f;
+const float PIO2_B = 4.8382679233e-4f;				// The rest of pi/2, for MATH_PLOT
+const float PIO2_B_SHORT = 4.8375129699707031e-4f;	// For MATH_PRECISE, the rest is split twice
+const float PIO2_C_SHORT = 7.549533620476723e-8f;	// more, so near multiples of pi/2, where sin
+const float PIO2_D = 2.5633440682570896e-12f;		// or cos is tiny, it's still within an ulp
+
+// ln 2, split so e * LN2_HI is exact for any float exponent e
+const float LN2_HI = 0.693359375f;
+const float LN2_LO = -2.1219444005e-4f;
+const float LOG2E = 1.44269504f;
+const double LN2_DOUBLE = 0.69314718055994531;
+const double LOG2E_DOUBLE = 1.4426950408889634;
+
+static inline __m128 Set(float value)
+{
+	return _mm_set1_ps(value);
+}
+
+// a * b + c
+static inline __m128 MulAdd(__m128 a, __m128 b, __m128 c)
+{
+	return _mm_add_ps(_mm_mul_ps(a, b), c);
+}
+
+static inline __m128d MulAdd(__m128d a, __m128d b, __m128d c)
+{
+	return _mm_add_pd(_mm_mul_pd(a, b), c);
+}
+
+// Picks a where mask is set, and b where it isn't
+static inline __m128 Select(__m128 mask, __m128 a, __m128 b)
+{
+	return _mm_or_ps(_mm_and_ps(mask, a), _mm_andnot_ps(mask, b));
+}
+
+static inline __m128 Abs(__m128 x)
+{
+	return _mm_andnot_ps(Set(-0.0f), x);
+}
+
+// Calls four() on each 4 numbers of x. The last few, if count isn't a multiple of 4, are padded
+// out with 1s.
+template <typename Four>
+static void ForEachFour(const float* x, float* y, int count, Four four)
+{
+	int i = 0;
+	for (; i + 4 <= count; i += 4)
+	{
+		_mm_storeu_ps(y + i, four(_mm_loadu_ps(x + i)));
+	}
+	if (i < count)
+	{
+		float in[4] = { 1, 1, 1, 1 };
+		float out[4];
+		for (int j = 0; i + j < count; j++)
+		{
+			in[j] = x[i + j];
+		}
+		_mm_storeu_ps(out, four(_mm_loadu_ps(in)));
+		for (int j = 0; i + j < count; j++)
+		{
+			y[i + j] = out[j];
+		}
+	}
+}
+
+// Gives the numbers picked by 'mask' to the standard library instead. They're rare, so it
+// doesn't matter that it's slow.
+static __m128 UseLibrary(__m128 mask, __m128 x, __m128 result, float (*library)(float))
+{
+	int lanes = _mm_movemask_ps(mask);
+	if (lanes == 0)
+	{
+		return result;
+	}
+	float in[4];
+	float out[4];
+	_mm_storeu_ps(in, x);
+	_mm_storeu_ps(out, result);
+	for (int i = 0; i < 4; i++)
+	{
+		if (lanes & (1 << i))
+		{
+			out[i] = library(in[i]);
+		}
+	}
+	return _mm_loadu_ps(out);
+}
+
+// quadrantOffset is 0 for sin and 1 for cos
+static __m128 SinCos4(__m128 x, int quadrantOffset, MathAccuracy accuracy)
+{
+	// j is the nearest whole number of pi/2s to x, and r what's left, from -pi/4 to pi/4
+	__m128i j = _mm_cvtps_epi32(_mm_mul_ps(x, Set(TWO_OVER_PI)));
+	__m128 jf = _mm_cvtepi32_ps(j);
+	__m128 r = _mm_sub_ps(x, _mm_mul_ps(jf, Set(PIO2_A)));
+	__m128 sinR;
+	__m128 cosR;
+	if (accuracy == MATH_PLOT)
+	{
+		r = _mm_sub_ps(r, _mm_mul_ps(jf, Set(PIO2_B)));
+		__m128 r2 = _mm_mul_ps(r, r);
+		sinR = MulAdd(_mm_mul_ps(r, r2), MulAdd(r2, Set(0.00815299197f), Set(-0.166628338f)), r);
+		cosR = MulAdd(r2, MulAdd(r2, Set(0.0404889368f), Set(-0.499776308f)), Set(1));
+	}
+	else
+	{
+		r = _mm_sub_ps(r, _mm_mul_ps(jf, Set(PIO2_B_SHORT)));
+		r = _mm_sub_ps(r, _mm_mul_ps(jf, Set(PIO2_C_SHORT)));
+		r = _mm_sub_ps(r, _mm_mul_ps(jf, Set(PIO2_D)));
+		__m128 r2 = _mm_mul_ps(r, r);
+		__m128 sinP = MulAdd(MulAdd(r2, Set(-1.9515295891e-4f), Set(8.3321608736e-3f)), r2, Set(-1.6666654611e-1f));
+		sinR = MulAdd(_mm_mul_ps(r, r2), sinP, r);
+		__m128 cosP = MulAdd(MulAdd(r2, Set(2.443315711809948e-5f), Set(-1.388731625493765e-3f)), r2, Set(4.166664568298827e-2f));
+		cosR = MulAdd(_mm_mul_ps(r2, r2), cosP, MulAdd(r2, Set(-0.5f), Set(1)));
+	}
+
+	// As j goes 0, 1, 2, 3, sin(j * pi/2 + r) is sin r, cos r, -sin r, -cos r.
+	// cos is the same, one quadrant on.
+	__m128i quadrant = _mm_add_epi32(j, _mm_set1_epi32(quadrantOffset));
+	__m128i one = _mm_set1_epi32(1);
+	__m128 useCos = _mm_castsi128_ps(_mm_cmpeq_epi32(_mm_and_si128(quadrant, one), one));
+	__m128 flipSign = _mm_castsi128_ps(_mm_slli_epi32(_mm_and_si128(quadrant, _mm_set1_epi32(2)), 30));
+	__m128 result = _mm_xor_ps(Select(useCos, cosR, sinR), flipSign);
+
+	// Too big for the pieces of pi/2, or not a number
+	__m128 tooBig = _mm_cmpnle_ps(Abs(x), Set(TRIG_LIMIT));
+	return UseLibrary(tooBig, x, result, quadrantOffset == 0 ? sinf : cosf);
+}
+
+// p * 2^n, for n from -160 to 160. 2^n is a float with n in its exponent bits. It's done in two
+// halves, so answers like 2^127.6 (where n is 128, one too big for the exponent) and tiny answers
+// still come out right.
+static __m128 TimesPowerOf2(__m128 p, __m128i n)
+{
+	__m128i half = _mm_srai_epi32(n, 1);
+	__m128i rest = _mm_sub_epi32(n, half);
+	__m128 scale1 = _mm_castsi128_ps(_mm_slli_epi32(_mm_add_epi32(half, _mm_set1_epi32(127)), 23));
+	__m128 scale2 = _mm_castsi128_ps(_mm_slli_epi32(_mm_add_epi32(rest, _mm_set1_epi32(127)), 23));
+	return _mm_mul_ps(_mm_mul_ps(p, scale1), scale2);
+}
+
+static __m128 Exp2Float4(__m128 x, MathAccuracy accuracy)
+{
+	// Past these, the answer is 0 or infinity anyway. n is the nearest whole number to x, and
+	// f what's left, from -0.5 to 0.5.
+	__m128 clamped = _mm_min_ps(_mm_max_ps(x, Set(-160)), Set(160));
+	__m128i n = _mm_cvtps_epi32(clamped);
+	__m128 f = _mm_sub_ps(clamped, _mm_cvtepi32_ps(n));
+
+	// 2^f
+	__m128 p;
+	if (accuracy == MATH_PLOT)
+	{
+		p = MulAdd(MulAdd(MulAdd(f, Set(0.0550089031f), Set(0.242210968f)), f, Set(0.693282933f)), f, Set(1));
+	}
+	else
+	{
+		p = MulAdd(f, Set(1.535336188319500e-4f), Set(1.339887440266574e-3f));
+		p = MulAdd(p, f, Set(9.618437357674640e-3f));
+		p = MulAdd(p, f, Set(5.550332471162809e-2f));
+		p = MulAdd(p, f, Set(2.402264791363012e-1f));
+		p = MulAdd(p, f, Set(6.931472028550421e-1f));
+		p = MulAdd(p, f, Set(1));
+	}
+
+	// min and max turn 'not a number' into a number, so put it back
+	return Select(_mm_cmpunord_ps(x, x), x, TimesPowerOf2(p, n));
+}
+
+static __m128 LogFloat4(__m128 x, MathAccuracy accuracy)
+{
+	// x is m * 2^e, with m from 1 to 2
+	__m128i bits = _mm_castps_si128(x);
+	__m128 e = _mm_cvtepi32_ps(_mm_sub_epi32(_mm_srli_epi32(bits, 23), _mm_set1_epi32(127)));
+	__m128 m = _mm_castsi128_ps(_mm_or_si128(_mm_and_si128(bits, _mm_set1_epi32(0x007fffff)), _mm_set1_epi32(0x3f800000)));
+
+	// Halving the big ones puts m from 0.707 to 1.414, either side of 1, where the polynomial is best
+	__m128 big = _mm_cmpgt_ps(m, Set(1.41421356f));
+	m = Select(big, _mm_mul_ps(m, Set(0.5f)), m);
+	e = _mm_add_ps(e, _mm_and_ps(big, Set(1)));
+
+	// ln m = 2 * (u + u^3/3 + u^5/5 + ...), where u = (m - 1) / (m + 1) is at most 0.172
+	__m128 u = _mm_div_ps(_mm_sub_ps(m, Set(1)), _mm_add_ps(m, Set(1)));
+	__m128 u2 = _mm_mul_ps(u, u);
+	__m128 p;
+	if (accuracy == MATH_PLOT)
+	{
+		p = MulAdd(u2, Set(0.681734037f), Set(1.99988805f));
+	}
+	else
+	{
+		p = MulAdd(u2, Set(2 / 9.0f), Set(2 / 7.0f));
+		p = MulAdd(p, u2, Set(2 / 5.0f));
+		p = MulAdd(p, u2, Set(2 / 3.0f));
+		p = MulAdd(p, u2, Set(2));
+	}
+	__m128 lnM = _mm_mul_ps(u, p);
+
+	// ln x = e * ln 2 + ln m
+	__m128 result = MulAdd(e, Set(LN2_HI), MulAdd(e, Set(LN2_LO), lnM));
+
+	// Zero, negative, tiny ('denormal'), infinite and not-a-number inputs
+	__m128 special = _mm_or_ps(_mm_cmpnge_ps(x, Set(FLT_MIN)), _mm_cmpeq_ps(x, Set(INFINITY)));
+	return UseLibrary(special, x, result, logf);
+}
+
+// The precise pow works in doubles (2 at a time), as rounding b * log2(a) to a float would
+// already be several ulps out for big answers.
+
+// 2^t, for t from -200 to 200
+static __m128d Exp2Double2(__m128d t)
+{
+	__m128i n = _mm_cvtpd_epi32(t);
+	__m128d g = _mm_mul_pd(_mm_sub_pd(t, _mm_cvtepi32_pd(n)), _mm_set1_pd(LN2_DOUBLE));
+
+	// e^g, with g from -0.35 to 0.35: 1 + g + g^2/2! + ... + g^8/8!, which is far more accurate
+	// than a float needs
+	__m128d p = _mm_set1_pd(1 / 40320.0);
+	const double factorials[] = { 5040.0, 720.0, 120.0, 24.0, 6.0, 2.0, 1.0, 1.0 };
+	for (double factorial : factorials)
+	{
+		p = MulAdd(p, g, _mm_set1_pd(1 / factorial));
+	}
+
+	// 2^n, from n + 1023 in the exponent bits of each double
+	__m128i biased = _mm_add_epi32(n, _mm_set1_epi32(1023));
+	__m128i wide = _mm_unpacklo_epi32(biased, _mm_setzero_si128());
+	return _mm_mul_pd(p, _mm_castsi128_pd(_mm_slli_epi64(wide, 52)));
+}
+
+// log2(a), for positive, finite a
+static __m128d Log2Double2(__m128d a)
+{
+	// a is m * 2^e. The exponent bits are turned into a double by putting them at the bottom of
+	// 2^52, whose last bit is worth exactly 1, and taking 2^52 (and the exponent's bias) off again.
+	__m128i bits = _mm_castpd_si128(a);
+	__m128d twoTo52 = _mm_set1_pd(4503599627370496.0);
+	__m128d e = _mm_sub_pd(_mm_castsi128_pd(_mm_or_si128(_mm_srli_epi64(bits, 52), _mm_castpd_si128(twoTo52))), _mm_set1_pd(4503599627370496.0 + 1023));
+	__m128i mantissaBits = _mm_set_epi32(0x000fffff, 0xffffffff, 0x000fffff, 0xffffffff);
+	__m128i oneBits = _mm_castpd_si128(_mm_set1_pd(1.0));
+	__m128d m = _mm_castsi128_pd(_mm_or_si128(_mm_and_si128(bits, mantissaBits), oneBits));
+
+	__m128d big = _mm_cmpgt_pd(m, _mm_set1_pd(1.4142135623730951));
+	m = _mm_or_pd(_mm_and_pd(big, _mm_mul_pd(m, _mm_set1_pd(0.5))), _mm_andnot_pd(big, m));
+	e = _mm_add_pd(e, _mm_and_pd(big, _mm_set1_pd(1)));
+
+	// The same series as LogFloat4, with enough terms for b * log2(a) to be right to about 1e-9
+	__m128d u = _mm_div_pd(_mm_sub_pd(m, _mm_set1_pd(1)), _mm_add_pd(m, _mm_set1_pd(1)));
+	__m128d u2 = _mm_mul_pd(u, u);
+	__m128d p = _mm_set1_pd(2 / 13.0);
+	for (int k = 11; k >= 1; k -= 2)
+	{
+		p = MulAdd(p, u2, _mm_set1_pd(2.0 / k));
+	}
+	return MulAdd(_mm_mul_pd(u, p), _mm_set1_pd(LOG2E_DOUBLE), e);
+}
+
+static __m128d ClampDouble(__m128d t)
+{
+	return _mm_min_pd(_mm_max_pd(t, _mm_set1_pd(-200)), _mm_set1_pd(200));
+}
+
+static __m128 ExpPrecise4(__m128 x)
+{
+	// e^x = 2^n * e^r, with n the nearest whole number to x / ln 2. r = x - n * ln 2 is worked
+	// out with ln 2 in two pieces, like sin's pi/2, so it's exact enough to stay within an ulp.
+	__m128 clamped = _mm_min_ps(_mm_max_ps(x, Set(-110)), Set(110));
+	__m128i n = _mm_cvtps_epi32(_mm_mul_ps(clamped, Set(LOG2E)));
+	__m128 nf = _mm_cvtepi32_ps(n);
+	__m128 r = _mm_sub_ps(clamped, _mm_mul_ps(nf, Set(LN2_HI)));
+	r = _mm_sub_ps(r, _mm_mul_ps(nf, Set(LN2_LO)));
+
+	// e^r = 1 + r + r^2 * p(r), with r from -0.35 to 0.35
+	__m128 p = MulAdd(r, Set(1.9875691500e-4f), Set(1.3981999507e-3f));
+	p = MulAdd(p, r, Set(8.3334519073e-3f));
+	p = MulAdd(p, r, Set(4.1665795894e-2f));
+	p = MulAdd(p, r, Set(1.6666665459e-1f));
+	p = MulAdd(p, r, Set(5.0000001201e-1f));
+	p = _mm_add_ps(MulAdd(_mm_mul_ps(r, r), p, r), Set(1));
+
+	return Select(_mm_cmpunord_ps(x, x), x, TimesPowerOf2(p, n));
+}
+
+static __m128 Pow4(__m128 a, __m128 b, MathAccuracy accuracy)
+{
+	// a^b = 2^(b * log2(a))
+	__m128 result;
+	if (accuracy == MATH_PLOT)
+	{
+		__m128 log2A = _mm_mul_ps(LogFloat4(a, MATH_PLOT), Set(LOG2E));
+		result = Exp2Float4(_mm_mul_ps(b, log2A), MATH_PLOT);
+	}
+	else
+	{
+		__m128d aLow = _mm_cvtps_pd(a);
+		__m128d aHigh = _mm_cvtps_pd(_mm_movehl_ps(a, a));
+		__m128d bLow = _mm_cvtps_pd(b);
+		__m128d bHigh = _mm_cvtps_pd(_mm_movehl_ps(b, b));
+		__m128d low = Exp2Double2(ClampDouble(_mm_mul_pd(bLow, Log2Double2(aLow))));
+		__m128d high = Exp2Double2(ClampDouble(_mm_mul_pd(bHigh, Log2Double2(aHigh))));
+		result = _mm_movelh_ps(_mm_cvtpd_ps(low), _mm_cvtpd_ps(high));
+	}
+
+	// Negative numbers, zero, tiny numbers, infinity and not-a-number have lots of special rules
+	// (like (-2)^3 = -8 but (-2)^0.5 isn't a number), so they're left to the library
+	__m128 special = _mm_or_ps(_mm_cmpnge_ps(a, Set(FLT_MIN)), _mm_cmpeq_ps(a, Set(INFINITY)));
+	special = _mm_or_ps(special, _mm_cmpnlt_ps(Abs(b), Set(INFINITY)));
+	int lanes = _mm_movemask_ps(special);
+	if (lanes == 0)
+	{
+		return result;
+	}
+	float aIn[4];
+	float bIn[4];
+	float out[4];
+	_mm_storeu_ps(aIn, a);
+	_mm_storeu_ps(bIn, b);
+	_mm_storeu_ps(out, result);
+	for (int i = 0; i < 4; i++)
+	{
+		if (lanes & (1 << i))
+		{
+			out[i] = powf(aIn[i], bIn[i]);
+		}
+	}
+	return _mm_loadu_ps(out);
+}
+
+void FastSin(const float* x, float* y, int count, MathAccuracy accuracy)
+{
+	ForEachFour(x, y, count, [accuracy](__m128 x4) { return SinCos4(x4, 0, accuracy); });
+}
+
+void FastCos(const float* x, float* y, int count, MathAccuracy accuracy)
+{
+	ForEachFour(x, y, count, [accuracy](__m128 x4) { return SinCos4(x4, 1, accuracy); });
+}
+
+void FastExp2(const float* x, float* y, int count, MathAccuracy accuracy)
+{
+	ForEachFour(x, y, count, [accuracy](__m128 x4) { return Exp2Float4(x4, accuracy); });
+}
+
+void FastExp(const float* x, float* y, int count, MathAccuracy accuracy)
+{
+	if (accuracy == MATH_PLOT)
+	{
+		ForEachFour(x, y, count, [](__m128 x4) { return Exp2Float4(_mm_mul_ps(x4, Set(LOG2E)), MATH_PLOT); });
+	}
+	else
+	{
+		ForEachFour(x, y, count, [](__m128 x4) { return ExpPrecise4(x4); });
+	}
+}
+
+void FastLog(const float* x, float* y, int count, MathAccuracy accuracy)
+{
+	ForEachFour(x, y, count, [accuracy](__m128 x4) { return LogFloat4(x4, accuracy); });
+}
+
+void FastPow(const float* a, const float* b, float* y, int count, MathAccuracy accuracy)
+{
+	int i = 0;
+	for (; i + 4 <= count; i += 4)
+	{
+		_mm_storeu_ps(y + i, Pow4(_mm_loadu_ps(a + i), _mm_loadu_ps(b + i), accuracy));
+	}
+	if (i < count)
+	{
+		float aIn[4] = { 1, 1, 1, 1 };
+		float bIn[4] = { 1, 1, 1, 1 };
+		float out[4];
+		for (int j = 0; i + j < count; j++)
+		{
+			aIn[j] = a[i + j];
+			bIn[j] = b[i + j];
+		}
+		_mm_storeu_ps(out, Pow4(_mm_loadu_ps(aIn), _mm_loadu_ps(bIn), accuracy));
+		for (int j = 0; i + j < count; j++)
+		{
+			y[i + j] = out[j];
+		}
+	}
+}
+
+// The gap between the float nearest to v and the next one up. Errors are often counted in these
+// 'ulps', as even a perfect answer has to be rounded to a float, so can be half of one out.
+static double Ulp(double v)
+{
+	float nearest = (float)fabs(v);
+	return (double)nextafterf(nearest, INFINITY) - nearest;
+}
+
+// n numbers spread evenly from low to high
+static void AddEvenly(std::vector<float>& numbers, double low, double high, int n)
+{
+	for (int i = 0; i < n; i++)
+	{
+		numbers.push_back((float)(low + (high - low) * (i + 0.5) / n));
+	}
+}
+
+// n numbers from low to high, with as many from 1 to 10 as from 10 to 100 and so on. Both
+// signs too, if 'negativeToo'.
+static void AddLogSpaced(std::vector<float>& numbers, double low, double high, int n, bool negativeToo)
+{
+	for (int i = 0; i < n; i++)
+	{
+		float x = (float)exp(log(low) + (log(high) - log(low)) * (i + 0.5) / n);
+		numbers.push_back(x);
+		if (negativeToo)
+		{
+			numbers.push_back(-x);
+		}
+	}
+}
+
+struct Tolerance
+{
+	double absolute;
+	double relative;	// Of the size of the exact answer
+};
+
+struct MathErrors
+{
+	double worstError = 0;
+	double worstUlps = 0;
+	double worstAllowedUsed = 0;	// 1 means the error was as big as allowed
+	int worstIndex = 0;
+};
+
+// Compares result[i] against exact[i], allowing tolerance.absolute + tolerance.relative * |exact|
+static MathErrors Compare(const std::vector<float>& result, const std::vector<double>& exact, Tolerance tolerance)
+{
+	MathErrors errors;
+	for (int i = 0; i < (int)result.size(); i++)
+	{
+		double allowedUsed;
+		double error = 0;
+		double ulps = 0;
+		if (isnan(exact[i]) || isinf((float)exact[i]))
+		{
+			// Not a number and infinity have to match exactly (and answers which only become
+			// infinity when rounded to a float)
+			bool same = isnan(exact[i]) ? isnan(result[i]) != 0 : result[i] == (float)exact[i];
+			allowedUsed = same ? 0 : INFINITY;
+		}
+		else
+		{
+			error = fabs(result[i] - exact[i]);
+			ulps = error / Ulp(exact[i]);
+			allowedUsed = error / (tolerance.absolute + tolerance.relative * fabs(exact[i]));
+		}
+		errors.worstError = fmax(errors.worstError, error);
+		errors.worstUlps = fmax(errors.worstUlps, ulps);
+		if (!(allowedUsed <= errors.worstAllowedUsed))
+		{
+			errors.worstAllowedUsed = allowedUsed;
+			errors.worstIndex = i;
+		}
+	}
+	return errors;
+}
+
+// Checks one function at both accuracies against 'exact', and prints how the library does
+// for comparison. fast(accuracy, result) works out every input, and library(i) and exact(i)
+// work out input i.
+template <typename Fast, typename Library, typename Exact>
+static bool CheckFunction(const char* name, const std::vector<float>& a, const std::vector<float>& b,
+	Fast fast, Library library, Exact exact, Tolerance plot, Tolerance precise)
+{
+	int count = (int)a.size();
+	std::vector<double> exactResult(count);
+	std::vector<float> result(count);
+	for (int i = 0; i < count; i++)
+	{
+		exactResult[i] = exact(i);
+		result[i] = library(i);
+	}
+	MathErrors libraryErrors = Compare(result, exactResult, Tolerance{ 1, 1 });
+
+	bool passed = true;
+	const char* accuracyNames[] = { "plot", "precise" };
+	Tolerance tolerances[] = { plot, precise };
+	for (int accuracy = MATH_PLOT; accuracy <= MATH_PRECISE; accuracy++)
+	{
+		fast((MathAccuracy)accuracy, result);
+		MathErrors errors = Compare(result, exactResult, tolerances[accuracy]);
+		bool ok = errors.worstAllowedUsed <= 1;
+		passed = passed && ok;
+
+		char worstInput[64];
+		if (b.empty())
+		{
+			snprintf(worstInput, sizeof(worstInput), "%.9g", a[errors.worstIndex]);
+		}
+		else
+		{
+			snprintf(worstInput, sizeof(worstInput), "%.9g, %.9g", a[errors.worstIndex], b[errors.worstIndex]);
+		}
+		printf("%-5s %-8s %9d %11.3g %10.2f %12.2f %12.0f%%   %-4s (at %s)\n", name, accuracyNames[accuracy], count,
+			errors.worstError, errors.worstUlps, libraryErrors.worstUlps, errors.worstAllowedUsed * 100, ok ? "ok" : "FAIL", worstInput);
+	}
+	return passed;
+}
+
+bool RunMathCheck()
+{
+	const int n = 1000000;
+
+	// Lots of inputs from the ranges curves use, and the ranges each function is good for, then
+	// far beyond them and special values, to check the library is used for those
+	std::vector<float> angles;
+	AddEvenly(angles, -10, 10, n);
+	AddEvenly(angles, -TRIG_LIMIT, TRIG_LIMIT, n);
+	AddLogSpaced(angles, 1e-30, 1e7, n / 10, true);
+	const float specialAngles[] = { 0, -0.0f, TRIG_LIMIT, nextafterf(TRIG_LIMIT, INFINITY), 1e30f, INFINITY, -INFINITY, NAN };
+	angles.insert(angles.end(), specialAngles, specialAngles + 8);
+
+	std::vector<float> powers;
+	AddEvenly(powers, -20, 20, n);
+	AddEvenly(powers, -155, 135, n);
+	const float specialPowers[] = { 0, -0.0f, 127.9f, 128, -126, -149, -150, 1e30f, -1e30f, INFINITY, -INFINITY, NAN };
+	powers.insert(powers.end(), specialPowers, specialPowers + 12);
+
+	std::vector<float> logInputs;
+	AddEvenly(logInputs, 0.5, 2, n);
+	AddLogSpaced(logInputs, 1e-45, 3e38, n, false);
+	const float specialLogInputs[] = { 1, FLT_MIN, FLT_MAX, 0, -0.0f, -1, INFINITY, -INFINITY, NAN };
+	logInputs.insert(logInputs.end(), specialLogInputs, specialLogInputs + 9);
+
+	// pow's plot accuracy is relative to b * log2(a), so most of its checks keep that below 40
+	std::vector<float> bases;
+	std::vector<float> exponents;
+	for (int i = 0; i < n; i++)
+	{
+		bases.push_back((float)exp(log(1e-3) + log(1e6) * (i + 0.5) / n));
+		exponents.push_back((float)(-4 + 8 * ((i * 7919LL) % n + 0.5) / n));
+	}
+	const float specialBases[] = { 0, 0, -0.0f, -2, -2, -2, 1, 1, 2, 2, INFINITY, -INFINITY, NAN, 1e-40f, 3 };
+	const float specialExponents[] = { 2, -1, 3, 3, 0.5f, -2, INFINITY, NAN, INFINITY, -INFINITY, 0.5f, 3, 0, 0.5f, NAN };
+	bases.insert(bases.end(), specialBases, specialBases + 15);
+	exponents.insert(exponents.end(), specialExponents, specialExponents + 15);
+
+	// Plot errors are about a millionth of a pixel on a 60 pixels per unit graph, and precise ones
+	// are a couple of ulps
+	const std::vector<float> none;
+	const Tolerance plotAbsolute = { 2e-5, 0 };
+	const Tolerance plotRelative = { 1e-45, 2e-4 };
+	const Tolerance precise = { 1e-45, 2.5e-7 };
+	const Tolerance preciseTrig = { 6e-8, 2.5e-7 };
+	const Tolerance plotLog = { 1e-5, 1e-6 };
+	const Tolerance plotPow = { 1e-45, 4e-4 };
+
+	printf("Function          Inputs Worst error Worst ulps Library ulps Allowed used\n");
+	bool passed = true;
+	passed &= CheckFunction("sin", angles, none,
+		[&](MathAccuracy accuracy, std::vector<float>& y) { FastSin(&angles[0], &y[0], (int)y.size(), accuracy); },
+		[&](int i) { return sinf(angles[i]); }, [&](int i) { return sin((double)angles[i]); }, plotAbsolute, preciseTrig);
+	passed &= CheckFunction("cos", angles, none,
+		[&](MathAccuracy accuracy, std::vector<float>& y) { FastCos(&angles[0], &y[0], (int)y.size(), accuracy); },
+		[&](int i) { return cosf(angles[i]); }, [&](int i) { return cos((double)angles[i]); }, plotAbsolute, preciseTrig);
+	passed &= CheckFunction("exp2", powers, none,
+		[&](MathAccuracy accuracy, std::vector<float>& y) { FastExp2(&powers[0], &y[0], (int)y.size(), accuracy); },
+		[&](int i) { return exp2f(powers[i]); }, [&](int i) { return exp2((double)powers[i]); }, plotRelative, precise);
+	passed &= CheckFunction("exp", powers, none,
+		[&](MathAccuracy accuracy, std::vector<float>& y) { FastExp(&powers[0], &y[0], (int)y.size(), accuracy); },
+		[&](int i) { return expf(powers[i]); }, [&](int i) { return exp((double)powers[i]); }, plotRelative, precise);
+	passed &= CheckFunction("log", logInputs, none,
+		[&](MathAccuracy accuracy, std::vector<float>& y) { FastLog(&logInputs[0], &y[0], (int)y.size(), accuracy); },
+		[&](int i) { return logf(logInputs[i]); }, [&](int i) { return log((double)logInputs[i]); }, plotLog, precise);
+	passed &= CheckFunction("pow", bases, exponents,
+		[&](MathAccuracy accuracy, std::vector<float>& y) { FastPow(&bases[0], &exponents[0], &y[0], (int)y.size(), accuracy); },
+		[&](int i) { return powf(bases[i], exponents[i]); }, [&](int i) { return pow((double)bases[i], (double)exponents[i]); }, plotPow, precise);
+
+	printf(passed ? "All within their accuracy\n" : "Some errors were too big\n");
+	return passed;
+}
+
+void RunMathBenchmark()
+{
+	// Inputs like a graph's, worked out over and over
+	const int count = 4096;
+	const int repeats = 2000;
+	std::vector<float> x(count);
+	std::vector<float> positive(count);
+	std::vector<float> b(count);
+	std::vector<float> y(count);
+	for (int i = 0; i < count; i++)
+	{
+		x[i] = -20.0f + 40.0f * i / count;
+		positive[i] = 0.01f + 10.0f * i / count;
+		b[i] = -3.0f + 6.0f * ((i * 37) % count) / count;
+	}
+
+	struct Function
+	{
+		const char* name;
+		void (*fast)(const float*, float*, int, MathAccuracy);
+		float (*library)(float);
+		const float* input;
+	};
+	const Function functions[] =
+	{
+		{ "sin", FastSin, sinf, &x[0] },
+		{ "cos", FastCos, cosf, &x[0] },
+		{ "exp2", FastExp2, exp2f, &x[0] },
+		{ "exp", FastExp, expf, &x[0] },
+		{ "log", FastLog, logf, &positive[0] },
+		{ "pow", NULL, NULL, &positive[0] },
+	};
+
+	printf("Function   Library M/s   Plot M/s (speedup)   Precise M/s (speedup)\n");
+	float total = 0;	// Added up so the compiler can't skip the work
+	for (const Function& function : functions)
+	{
+		float millionsPerSecond[3];
+		for (int kind = 0; kind < 3; kind++)
+		{
+			sf::Clock clock;
+			for (int repeat = 0; repeat < repeats; repeat++)
+			{
+				if (kind == 0 && function.library != NULL)
+				{
+					for (int i = 0; i < count; i++)
+					{
+						y[i] = function.library(function.input[i]);
+					}
+				}
+				else if (kind == 0)
+				{
+					for (int i = 0; i < count; i++)
+					{
+						y[i] = powf(function.input[i], b[i]);
+					}
+				}
+				else if (function.fast != NULL)
+				{
+					function.fast(function.input, &y[0], count, kind == 1 ? MATH_PLOT : MATH_PRECISE);
+				}
+				else
+				{
+					FastPow(function.input, &b[0], &y[0], count, kind == 1 ? MATH_PLOT : MATH_PRECISE);
+				}
+				total += y[repeat % count];
+			}
+			millionsPerSecond[kind] = count * (float)repeats / clock.getElapsedTime().asSeconds() / 1e6f;
+		}
+		printf("%-8s %11.1f %10.1f (%4.1fx) %12.1f (%4.1fx)%s\n", function.name, millionsPerSecond[0],
+			millionsPerSecond[1], millionsPerSecond[1] / millionsPerSecond[0],
+			millionsPerSecond[2], millionsPerSecond[2] / millionsPerSecond[0], total == 12345 ? " " : "");
+	}
+}
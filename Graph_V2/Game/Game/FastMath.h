@@ -0,0 +1,44 @@
+#pragma once
+
+// Quick sin, cos, exp2, exp, log and pow for whole arrays of numbers, 4 at a time with SSE.
+//
+// The standard library's sinf, powf and so on work on one number at a time, and are careful
+// about every possible input, which makes them the slowest part of drawing most curves. These
+// work the same way the library does inside, but on 4 numbers at once:
+// 1. 'Range reduction' turns the input into a small number the answer can be worked out from,
+//    e.g. sin(x) is +-sin or +-cos of x minus the nearest multiple of pi/2, and 2^x is
+//    2^(whole part) times 2^(fraction), where 2^(whole part) is just the float's exponent.
+// 2. A short polynomial (like a + b*r + c*r^2) works out the small part. Its numbers were chosen
+//    to make the biggest error over the small range as small as possible.
+//
+// There are two accuracies:
+//   MATH_PLOT     Errors of about 1e-5 (1e-4 of the answer for exp2, exp and pow). Far less than
+//                 a pixel when drawing, and the quickest.
+//   MATH_PRECISE  Within a couple of 'ulps' (the gap between one float and the next) of the exact
+//                 answer, for working things out. pow works in doubles inside to manage it.
+//
+// Inputs the quick methods can't do (like sin of more than 8192, or pow of a negative number)
+// go to the standard library instead, so every input gets an answer as good as the library's.
+// "Game.exe -mathcheck" checks the errors against the library, and "-mathbench" times them.
+enum MathAccuracy
+{
+	MATH_PLOT,
+	MATH_PRECISE
+};
+
+// Sets y[i] to the function of x[i], for count numbers. x and y can be the same array.
+void FastSin(const float* x, float* y, int count, MathAccuracy accuracy);
+void FastCos(const float* x, float* y, int count, MathAccuracy accuracy);
+void FastExp2(const float* x, float* y, int count, MathAccuracy accuracy);
+void FastExp(const float* x, float* y, int count, MathAccuracy accuracy);
+void FastLog(const float* x, float* y, int count, MathAccuracy accuracy);
+
+// Sets y[i] to a[i] to the power of b[i]
+void FastPow(const float* a, const float* b, float* y, int count, MathAccuracy accuracy);
+
+// "Game.exe -mathcheck" compares every function at both accuracies against the standard library
+// (worked out in doubles), over millions of inputs. Returns false if any error is too big.
+bool RunMathCheck();
+
+// "Game.exe -mathbench" times every function at both accuracies, and the standard library
+void RunMathBenchmark();
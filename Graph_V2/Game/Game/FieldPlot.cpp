@@ -0,0 +1,422 @@
+#include <SFML\System\Clock.hpp>
+#include <math.h>
+#include "Main.h"
+#include "Helpers.h"
+#include "FieldPlot.h"
+
+const int FIELD_TILE_SIZE = 64;		// Pixels. 64 x 64 values is 16KB, which fits in the fastest cache.
+const int FIELD_FIRST_STEP = 8;		// Pixels between the values of the first, blockiest step
+const sf::Color FIELD_NAN_COLOR(40, 40, 40);	// Where z isn't a number, like sqrt(-1)
+
+// Rounds down, unlike /, which rounds towards 0 (so -1 / 64 is 0, but this gives -1)
+static int FloorDivide(int a, int b)
+{
+	return a >= 0 ? a / b : -((-a + b - 1) / b);
+}
+
+static long long TileKey(int tileX, int tileY)
+{
+	return ((long long)tileX << 32) | (unsigned int)tileY;
+}
+
+bool FieldPlot::Compile(const std::string& text, std::string& error)
+{
+	if (!field.Compile(text, error))
+	{
+		return false;
+	}
+	tiles.clear();
+	workspaces.clear();
+
+	// Dark blue, through teal and green, to yellow. Each colour is brighter than the one before,
+	// so bigger always looks bigger, even printed in black and white.
+	const sf::Color stops[] = { sf::Color(68, 1, 84), sf::Color(59, 82, 139), sf::Color(33, 145, 140), sf::Color(94, 201, 98), sf::Color(253, 231, 37) };
+	const int numGaps = sizeof(stops) / sizeof(stops[0]) - 1;
+	for (int i = 0; i < 256; i++)
+	{
+		float along = i / 255.0f * numGaps;
+		int gap = (int)along < numGaps ? (int)along : numGaps - 1;
+		float amount = along - gap;
+		const sf::Color& from = stops[gap];
+		const sf::Color& to = stops[gap + 1];
+		colors[i] = sf::Color(
+			(sf::Uint8)(from.r + (to.r - from.r) * amount + 0.5f),
+			(sf::Uint8)(from.g + (to.g - from.g) * amount + 0.5f),
+			(sf::Uint8)(from.b + (to.b - from.b) * amount + 0.5f));
+	}
+	return true;
+}
+
+void FieldPlot::SetRange(float newLow, float newHigh)
+{
+	low = newLow;
+	high = newHigh > newLow ? newHigh : newLow + 1;
+}
+
+void FieldPlot::FitRange()
+{
+	float lowest = INFINITY;
+	float highest = -INFINITY;
+	for (Tile* tile : visible)
+	{
+		// Tiles only partly worked out still have old values in the rest
+		if (!tile->whole)
+		{
+			continue;
+		}
+		for (int b = 0; tile->step != 0 && b < FIELD_TILE_SIZE; b += tile->step)
+		{
+			for (int a = 0; a < FIELD_TILE_SIZE; a += tile->step)
+			{
+				float z = tile->values[b * FIELD_TILE_SIZE + a];
+				if (std::isfinite(z))
+				{
+					lowest = z < lowest ? z : lowest;
+					highest = z > highest ? z : highest;
+				}
+			}
+		}
+	}
+	if (lowest <= highest)
+	{
+		SetRange(lowest, highest);
+	}
+}
+
+void FieldPlot::SetTimeBudget(float ms)
+{
+	budgetMs = ms;
+}
+
+const std::vector<sf::Uint8>& FieldPlot::GetPixels()
+{
+	return pixels;
+}
+
+// Works out the values for one tile which are every 'step' pixels, but weren't worked out by
+// the tile's last step. Returns how many there were.
+int FieldPlot::WorkOutTile(int tileIndex, int step, float time, int thread)
+{
+	Tile& tile = *visible[tileIndex];
+	int tileX = firstTileX + tileIndex % tilesAcross;
+	int tileY = firstTileY + tileIndex / tilesAcross;
+	int previous = tile.step;
+	float* x = rowX[thread].data();
+	float* z = rowZ[thread].data();
+
+	// The pixels of the tile to work out, from (firstA, firstB) up to but not including (endA, endB).
+	// A field which changes with t has its tiles thrown away next frame anyway, so only the part
+	// on the screen is worked out. Starting on a multiple of the first step keeps every step's
+	// blocks lined up.
+	int firstA = 0;
+	int firstB = 0;
+	int endA = FIELD_TILE_SIZE;
+	int endB = FIELD_TILE_SIZE;
+	if (onlyOnScreen)
+	{
+		int tileLeft = originPixelX + tileX * FIELD_TILE_SIZE;
+		int tileTop = originPixelY + tileY * FIELD_TILE_SIZE;
+		firstA = tileLeft < 0 ? -tileLeft / FIELD_FIRST_STEP * FIELD_FIRST_STEP : 0;
+		firstB = tileTop < 0 ? -tileTop / FIELD_FIRST_STEP * FIELD_FIRST_STEP : 0;
+		endA = width - tileLeft < FIELD_TILE_SIZE ? width - tileLeft : FIELD_TILE_SIZE;
+		endB = height - tileTop < FIELD_TILE_SIZE ? height - tileTop : FIELD_TILE_SIZE;
+	}
+	bool whole = firstA == 0 && firstB == 0 && endA == FIELD_TILE_SIZE && endB == FIELD_TILE_SIZE;
+
+	int total = 0;
+	for (int b = firstB; b < endB; b += step)
+	{
+		// Rows the last step did already have every other value
+		bool rowStarted = previous != 0 && b % previous == 0;
+		int count = 0;
+		for (int a = firstA; a < endA; a += step)
+		{
+			if (!rowStarted || a % previous != 0)
+			{
+				// The middle of the pixel
+				x[count++] = (tileX * FIELD_TILE_SIZE + a + 0.5f - tileFractionX) / tileScale;
+			}
+		}
+		float y = (tileFractionY - (tileY * FIELD_TILE_SIZE + b + 0.5f)) / tileScale;
+		field.EvaluateRow(time, y, x, z, count, workspaces[thread]);
+
+		float* row = &tile.values[b * FIELD_TILE_SIZE];
+		int i = 0;
+		for (int a = firstA; a < endA; a += step)
+		{
+			if (!rowStarted || a % previous != 0)
+			{
+				row[a] = z[i++];
+			}
+		}
+		total += count;
+	}
+	tile.whole = previous == 0 ? whole : tile.whole && whole;
+	tile.step = step;
+	return total;
+}
+
+// Colours the tile's pixels on the screen. Where the tile only has a value every few pixels,
+// each value colours the block of pixels below and to the right of it.
+void FieldPlot::ColorTile(int tileIndex)
+{
+	const Tile& tile = *visible[tileIndex];
+	int tileLeft = originPixelX + (firstTileX + tileIndex % tilesAcross) * FIELD_TILE_SIZE;
+	int tileTop = originPixelY + (firstTileY + tileIndex / tilesAcross) * FIELD_TILE_SIZE;
+	int left = tileLeft > 0 ? tileLeft : 0;
+	int right = tileLeft + FIELD_TILE_SIZE < width ? tileLeft + FIELD_TILE_SIZE : width;
+	int top = tileTop > 0 ? tileTop : 0;
+	int bottom = tileTop + FIELD_TILE_SIZE < height ? tileTop + FIELD_TILE_SIZE : height;
+
+	// Steps are powers of 2, so rounding down to a multiple of the step is just clearing some bits
+	int mask = ~(tile.step - 1);
+	float toIndex = 256 / (high - low);
+	for (int screenY = top; screenY < bottom; screenY++)
+	{
+		const float* row = &tile.values[((screenY - tileTop) & mask) * FIELD_TILE_SIZE];
+		sf::Uint8* pixel = &pixels[(screenY * width + left) * 4];
+		for (int screenX = left; screenX < right; screenX++, pixel += 4)
+		{
+			float z = row[(screenX - tileLeft) & mask];
+			sf::Color color = FIELD_NAN_COLOR;
+			if (z == z)
+			{
+				float index = (z - low) * toIndex;
+				color = colors[index > 0 ? (index < 255 ? (int)index : 255) : 0];
+			}
+			pixel[0] = color.r;
+			pixel[1] = color.g;
+			pixel[2] = color.b;
+			pixel[3] = 255;
+		}
+	}
+}
+
+void FieldPlot::Update(float time, const GraphView& view, ThreadPool& pool)
+{
+	sf::Clock clock;
+	width = (int)view.screenWidth;
+	height = (int)view.screenHeight;
+	pixels.resize(width * height * 4);
+
+	int numThreads = pool.GetThreadCount();
+	if ((int)workspaces.size() != numThreads)
+	{
+		workspaces.assign(numThreads, ExpressionWorkspace());
+		rowX.assign(numThreads, std::vector<float>(FIELD_TILE_SIZE));
+		rowZ.assign(numThreads, std::vector<float>(FIELD_TILE_SIZE));
+		valuesByThread.assign(numThreads, 0);
+	}
+
+	// Tiles with only their part on the screen worked out can't be used once they've moved
+	int newOriginPixelX = (int)floorf(view.originX);
+	int newOriginPixelY = (int)floorf(view.originY);
+	if (newOriginPixelX != originPixelX || newOriginPixelY != originPixelY)
+	{
+		for (auto& entry : tiles)
+		{
+			entry.second.step = entry.second.whole ? entry.second.step : 0;
+		}
+	}
+	originPixelX = newOriginPixelX;
+	originPixelY = newOriginPixelY;
+	onlyOnScreen = field.UsesTime();
+
+	// Anything which changes where every value is, or what it is, means starting again
+	float fractionX = view.originX - originPixelX;
+	float fractionY = view.originY - originPixelY;
+	if (view.scale != tileScale || fractionX != tileFractionX || fractionY != tileFractionY || (field.UsesTime() && time != tileTime))
+	{
+		for (auto& entry : tiles)
+		{
+			entry.second.step = 0;
+		}
+		tileScale = view.scale;
+		tileFractionX = fractionX;
+		tileFractionY = fractionY;
+		tileTime = time;
+	}
+
+	// Which tiles are on the screen. Tile (0, 0) starts at the origin's pixel.
+	firstTileX = FloorDivide(-originPixelX, FIELD_TILE_SIZE);
+	firstTileY = FloorDivide(-originPixelY, FIELD_TILE_SIZE);
+	int lastTileX = FloorDivide(width - 1 - originPixelX, FIELD_TILE_SIZE);
+	int lastTileY = FloorDivide(height - 1 - originPixelY, FIELD_TILE_SIZE);
+	tilesAcross = lastTileX - firstTileX + 1;
+
+	// Forget tiles which have gone well off the screen. Ones just off it are kept, in case the
+	// graph is moved back.
+	for (auto entry = tiles.begin(); entry != tiles.end();)
+	{
+		int tileX = (int)(entry->first >> 32);
+		int tileY = (int)(unsigned int)entry->first;
+		if (tileX < firstTileX - 1 || tileX > lastTileX + 1 || tileY < firstTileY - 1 || tileY > lastTileY + 1)
+		{
+			entry = tiles.erase(entry);
+		}
+		else
+		{
+			++entry;
+		}
+	}
+
+	visible.clear();
+	tilesReused = 0;
+	for (int tileY = firstTileY; tileY <= lastTileY; tileY++)
+	{
+		for (int tileX = firstTileX; tileX <= lastTileX; tileX++)
+		{
+			Tile& tile = tiles[TileKey(tileX, tileY)];
+			if (tile.values.empty())
+			{
+				tile.values.resize(FIELD_TILE_SIZE * FIELD_TILE_SIZE);
+			}
+			tilesReused += tile.step != 0 ? 1 : 0;
+			visible.push_back(&tile);
+		}
+	}
+	tilesOnScreen = (int)visible.size();
+
+	// Coarse to fine. The first step is always done, so there's something to see. The finer ones
+	// are only done if they look like they'll fit in the time left, going by how long the values
+	// took last time.
+	valuesWorkedOut = 0;
+	for (int step = FIELD_FIRST_STEP; step >= 1; step /= 2)
+	{
+		work.clear();
+		int newValues = 0;
+		for (int i = 0; i < tilesOnScreen; i++)
+		{
+			int previous = visible[i]->step;
+			if (previous == 0 || previous > step)
+			{
+				work.push_back(i);
+				int perSide = FIELD_TILE_SIZE / step;
+				int previousPerSide = previous == 0 ? 0 : FIELD_TILE_SIZE / previous;
+				newValues += perSide * perSide - previousPerSide * previousPerSide;
+			}
+		}
+		if (work.empty())
+		{
+			continue;
+		}
+		float elapsedMs = clock.getElapsedTime().asSeconds() * 1000;
+		if (step != FIELD_FIRST_STEP && elapsedMs + newValues * msPerValue > budgetMs)
+		{
+			break;
+		}
+
+		sf::Clock stepClock;
+		valuesByThread.assign(numThreads, 0);
+		pool.Run((int)work.size(), [&](int task, int thread)
+		{
+			valuesByThread[thread] += WorkOutTile(work[task], step, time, thread);
+		});
+		int stepValues = 0;
+		for (int values : valuesByThread)
+		{
+			stepValues += values;
+		}
+		msPerValue = stepValues > 0 ? stepClock.getElapsedTime().asSeconds() * 1000 / stepValues : msPerValue;
+		valuesWorkedOut += stepValues;
+	}
+
+	coarsestStep = 1;
+	for (Tile* tile : visible)
+	{
+		coarsestStep = tile->step > coarsestStep ? tile->step : coarsestStep;
+	}
+
+	pool.Run(tilesOnScreen, [&](int task, int thread)
+	{
+		ColorTile(task);
+	});
+}
+
+void FieldPlot::Draw()
+{
+	if (pixels.empty())
+	{
+		return;
+	}
+	if ((int)texture.getSize().x != width || (int)texture.getSize().y != height)
+	{
+		texture.create(width, height);
+	}
+
+	// The whole field is one picture, so it's one draw
+	texture.update(pixels.data());
+	sf::Sprite sprite(texture);
+	window->draw(sprite);
+}
+
+void RunFieldBenchmark()
+{
+	const char* animated = "sin(x * y + t) * cos(x - 2 * t)";
+	const int numFrames = 60;
+	int numCores = (int)std::thread::hardware_concurrency();
+	int mostThreads = numCores > 4 ? numCores : 4;
+	printf("%s on 800 x 600, %d cores\n", animated, numCores);
+
+	// Every pixel, every frame, however long it takes
+	FieldPlot plot;
+	std::string error;
+	plot.Compile(animated, error);
+	plot.SetTimeBudget(1e9f);
+	GraphView view;
+	for (int numThreads = 1; numThreads <= mostThreads; numThreads *= 2)
+	{
+		ThreadPool pool(numThreads);
+		sf::Clock clock;
+		for (int frame = 0; frame < numFrames; frame++)
+		{
+			plot.Update(frame / 60.0f, view, pool);
+		}
+		printf("  %2d threads, every pixel: %.2f ms per frame (%d values a frame)\n", numThreads,
+			clock.getElapsedTime().asSeconds() * 1000 / numFrames, plot.valuesWorkedOut);
+	}
+
+	// With the normal time budget, on one thread per core, it gets blockier instead of slower
+	{
+		ThreadPool pool;
+		plot.SetTimeBudget(10);
+		int blockiest = 1;
+		sf::Clock clock;
+		for (int frame = 0; frame < numFrames; frame++)
+		{
+			plot.Update(frame / 60.0f, view, pool);
+			blockiest = plot.coarsestStep > blockiest ? plot.coarsestStep : blockiest;
+		}
+		printf("  %2d threads, 10 ms budget: %.2f ms per frame, blockiest %d x %d pixels\n", pool.GetThreadCount(),
+			clock.getElapsedTime().asSeconds() * 1000 / numFrames, blockiest, blockiest);
+	}
+
+	// A field which doesn't change with t, moved by whole pixels. Only the tiles coming onto the
+	// screen should be worked out, and the picture should be the same as drawing it from scratch.
+	const char* still = "sin(x) * cos(y) + 0.1 * x";
+	ThreadPool pool;
+	FieldPlot moved;
+	moved.Compile(still, error);
+	moved.SetTimeBudget(1e9f);
+	moved.Update(0, view, pool);
+	int allValues = moved.valuesWorkedOut;
+
+	GraphView movedView = view;
+	movedView.originX += 37;
+	movedView.originY -= 23;
+	sf::Clock clock;
+	moved.Update(0, movedView, pool);
+	float movedMs = clock.getElapsedTime().asSeconds() * 1000;
+
+	FieldPlot fresh;
+	fresh.Compile(still, error);
+	fresh.SetTimeBudget(1e9f);
+	clock.restart();
+	fresh.Update(0, movedView, pool);
+	float freshMs = clock.getElapsedTime().asSeconds() * 1000;
+
+	bool same = moved.GetPixels() == fresh.GetPixels();
+	printf("%s moved by (37, -23) pixels: %d of %d tiles reused, %d values instead of %d, %.2f ms instead of %.2f ms, %s\n",
+		still, moved.tilesReused, moved.tilesOnScreen, moved.valuesWorkedOut, allValues, movedMs, freshMs,
+		same ? "same picture as from scratch" : "DIFFERENT from drawing it from scratch");
+}
@@ -0,0 +1,100 @@
+#pragma once
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include <SFML\Graphics.hpp>
+#include "Expression.h"
+#include "GraphView.h"
+#include "ThreadPool.h"
+
+// Draws a 'field' z = f(x, y, t) as a picture behind the graph, with each pixel coloured by the
+// value of z there (a 'heatmap').
+//
+// The screen is split into square tiles, small enough for a tile's numbers to stay in the
+// processor's cache while it's worked on, and the tiles are shared out between the threads.
+//
+// Each tile is worked out in steps: first one value for every 8 x 8 pixels, then every 4 x 4,
+// 2 x 2 and finally every pixel. Each step only works out the pixels the last one didn't. When
+// there isn't time for the finer steps in one frame, the picture is drawn blocky rather than late,
+// and (if the field doesn't change with t) the finer steps carry on next frame.
+//
+// Tiles are kept while they're on the screen. Moving the graph by a whole number of pixels
+// doesn't change the values in a tile, only where it is, so only tiles coming onto the screen
+// are worked out. Zooming, or a field which changes with t, starts them all again.
+class FieldPlot
+{
+public:
+	bool Compile(const std::string& text, std::string& error);
+
+	// z from low to high is coloured from dark blue to yellow
+	void SetRange(float low, float high);
+	// Sets the range to the lowest and highest z on the screen
+	void FitRange();
+
+	// Milliseconds per frame to spend on finer steps, once every tile has its first step
+	void SetTimeBudget(float ms);
+
+	// Works out the tiles for the view, and colours the pixels
+	void Update(float time, const GraphView& view, ThreadPool& pool);
+	void Draw();
+
+	// Statistics for the last Update
+	int tilesOnScreen = 0;
+	int tilesReused = 0;		// Already had values from an earlier frame
+	int valuesWorkedOut = 0;
+	int coarsestStep = 0;		// Pixels between values in the blockiest tile on the screen. 1 when finished.
+
+	const std::vector<sf::Uint8>& GetPixels();	// 4 bytes per pixel: red, green, blue, alpha
+
+private:
+	struct Tile
+	{
+		int step = 0;				// Pixels between the values worked out so far. 0 if none are.
+		bool whole = true;			// False if only the part on the screen was worked out
+		std::vector<float> values;	// TILE_SIZE x TILE_SIZE, only filled every 'step' pixels
+	};
+
+	Expression field;
+	float low = -1;
+	float high = 1;
+	float budgetMs = 10;
+	sf::Color colors[256];		// Colour for each 256th of the range from low to high
+
+	// Tiles are numbered from the pixel the origin is in, so they keep their numbers while the
+	// graph is moved by whole pixels. The values in them were worked out for these:
+	std::unordered_map<long long, Tile> tiles;
+	float tileScale = 0;
+	float tileFractionX = 0;	// Part of the origin's position after the decimal point
+	float tileFractionY = 0;
+	float tileTime = 0;
+
+	// The tiles on the screen this frame, and where the first one is
+	std::vector<Tile*> visible;
+	int firstTileX = 0;
+	int firstTileY = 0;
+	int tilesAcross = 0;
+	int originPixelX = 0;
+	int originPixelY = 0;
+	bool onlyOnScreen = false;	// Whether to skip the parts of tiles off the edge of the screen
+
+	std::vector<int> work;		// Tiles which need the step being worked out
+	float msPerValue = 0;		// How long values took last time, for guessing how long a step will take
+
+	// Each thread's own things for working out values
+	std::vector<ExpressionWorkspace> workspaces;
+	std::vector<std::vector<float>> rowX;
+	std::vector<std::vector<float>> rowZ;
+	std::vector<int> valuesByThread;
+
+	int width = 0;
+	int height = 0;
+	std::vector<sf::Uint8> pixels;
+	sf::Texture texture;
+
+	int WorkOutTile(int tileIndex, int step, float time, int thread);
+	void ColorTile(int tileIndex);
+};
+
+// "Game.exe -fieldbench" times an animated field on more and more threads, and checks moving
+// the graph gives the same picture as starting again
+void RunFieldBenchmark();
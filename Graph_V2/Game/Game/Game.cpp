@@ -1,11 +1,42 @@
 #include "Main.h"
 #include "Helpers.h"
 #include "Game.h"
+#include "CurveKernels.h"
+#include "CurveCache.h"
+#include "Expression.h"
+#include "TimePlot.h"
+#include "StreamPlot.h"
+#include "CurveSweep.h"
+#include "FieldPlot.h"
+#include "Axes.h"
+#include <SFML\System\Clock.hpp>
+#include <vector>
+#include <math.h>
+#include <stdio.h>
+#include <string.h>
 
 // Define variables which determine how big the window will be
 int SCREEN_WIDTH = 800;
 int SCREEN_HEIGHT = 600;
 
+// Curves 1 to 5, drawn while their number key is held
+Expression shippedCurves[NUM_CURVE_TYPES];
+CurveCache shippedCurveCaches[NUM_CURVE_TYPES];
+
+// Curves typed in by the user. Press Enter, type a function of x and t, then press Enter again.
+const int MAX_USER_CURVES = 64;
+std::vector<Expression> userCurves;
+std::vector<CurveCache> userCurveCaches;
+bool typing = false;
+std::string typedText;
+std::string typingError;
+
+const sf::Color userCurveColors[] =
+{
+	sf::Color(255, 128, 0), sf::Color(0, 160, 255), sf::Color(255, 64, 160), sf::Color(160, 255, 64),
+	sf::Color(255, 255, 255), sf::Color(160, 96, 255), sf::Color(0, 255, 192), sf::Color(255, 200, 120)
+};
+
 // GameInit is called once, when the program starts. Its job is to do things which only happen once, at the start.
 // E.g.
 //		Create the window that the game runs in
@@ -15,87 +46,210 @@ void GameInit()
 	// Create a window for the game
 	// The numbers are the width and height in pixels. The text is the title of the window.
 	window = new sf::RenderWindow(sf::VideoMode(SCREEN_WIDTH, SCREEN_HEIGHT), "SFML works!");
+
+	// The number keys' curves are expressions too
+	for (int i = 0; i < NUM_CURVE_TYPES; i++)
+	{
+		std::string error;
+		if (!shippedCurves[i].Compile(shippedCurveText[i], error))
+		{
+			printf("Curve %d failed to compile: %s\n", i + 1, error.c_str());
+		}
+	}
 }
 
-float originX = SCREEN_WIDTH / 2.0f;
-float originY = SCREEN_HEIGHT / 2.0f;
-float scale = 60.0f;
+// Only set when plotting a recorded file, instead of the curves
+TimePlot* timePlot = NULL;
 
-void GraphDrawLine(float worldX1, float worldY1, float worldX2, float worldY2, sf::Color color)
+bool StartTimePlot(const char* path)
 {
-	float screenX1 = originX + (worldX1 * scale);
-	float screenY1 = originY - (worldY1 * scale);
-	float screenX2 = originX + (worldX2 * scale);
-	float screenY2 = originY - (worldY2 * scale);
-	DrawLine(screenX1, screenY1, screenX2, screenY2, color);
+	timePlot = new TimePlot();
+	std::string error;
+	if (!timePlot->Open(path, error))
+	{
+		printf("%s\n", error.c_str());
+		delete timePlot;
+		timePlot = NULL;
+		return false;
+	}
+	return true;
 }
 
-void DrawAxes()
+// Only set when plotting live samples, instead of the curves
+StreamPlot* streamPlot = NULL;
+
+bool StartStreamPlot(const char* kind, const char* name)
 {
-	// Draw axes
-	const sf::Color color = sf::Color::Cyan;
-	DrawLine(originX, 0, originX, (float)SCREEN_HEIGHT, color);
-	DrawLine(0, originY, (float)SCREEN_WIDTH, originY, color);
+	StreamKind streamKind = STREAM_TEST;
+	if (strcmp(kind, "stdin") == 0)
+	{
+		streamKind = STREAM_STDIN;
+	}
+	else if (strcmp(kind, "file") == 0)
+	{
+		streamKind = STREAM_FILE;
+	}
+	else if (strcmp(kind, "udp") == 0)
+	{
+		streamKind = STREAM_UDP;
+	}
 
-	// Draw ticks
-	int numTicks = 20;
-	float halfTickHeight = 0.1f;
-	for (float i = 1.0f; i <= (float)numTicks; i++)
+	streamPlot = new StreamPlot();
+	std::string error;
+	if (!streamPlot->Start(streamKind, name, SCREEN_WIDTH, error))
 	{
-		GraphDrawLine(i, halfTickHeight, i, -halfTickHeight, color);	// Right
-		GraphDrawLine(-i, halfTickHeight, -i, -halfTickHeight, color);	// Left
-		GraphDrawLine(-halfTickHeight, i, halfTickHeight, i, color);	// Up
-		GraphDrawLine(-halfTickHeight, -i, halfTickHeight, -i, color);	// Down
+		printf("%s\n", error.c_str());
+		delete streamPlot;
+		streamPlot = NULL;
+		return false;
 	}
+	return true;
 }
 
-float CalcGraphY(int curveType, float time, float x)
+// Only set when drawing a family of curves, as well as the others
+CurveSweep* sweep = NULL;
+ThreadPool* sweepThreads = NULL;
+float sweepMs = 0;
+
+bool StartSweep(const char* text, float firstK, float lastK, int numCurves)
 {
-	float y = -9999;
-	switch (curveType)
-	{
-	case 1:
-		y = x * x;		// Y = X^2
-		break;
-	case 2:
-		y = x * x * x;	// Y = X^3
-		break;
-	case 3:
-		y = powf(2, x);	// Exponential
-		break;
-	case 4:
-		y = sin(x);		// Sin
-		break;
-	case 5:
-		y = sin((x + time) * 2);	// Sin for (x+time), scaled by 2 to make the frequency higher
-		break;
-	}
-	return y;
+	sweep = new CurveSweep();
+	std::string error;
+	if (!sweep->Compile(text, firstK, lastK, numCurves, error))
+	{
+		printf("%s\n", error.c_str());
+		delete sweep;
+		sweep = NULL;
+		return false;
+	}
+	sweepThreads = new ThreadPool();
+	return true;
 }
 
-void DrawCurve(int curveType, float time, sf::Color lineColor)
+// Only set when drawing a field behind the curves
+FieldPlot* field = NULL;
+ThreadPool* fieldThreads = NULL;
+float fieldMs = 0;
+
+bool StartField(const char* text, float low, float high)
 {
-	// Where to start, end, and how much to step along the x axis (in world space)
-	float xStart = -20.0f;
-	float xEnd = 20.0f;
-	float step = 0.1f;
+	field = new FieldPlot();
+	std::string error;
+	if (!field->Compile(text, error))
+	{
+		printf("%s\n", error.c_str());
+		delete field;
+		field = NULL;
+		return false;
+	}
+	field->SetRange(low, high);
+	fieldThreads = new ThreadPool();
+	return true;
+}
 
-	// Calculate first point on graph, storing it as 'previous' position
-	float prevWorldX = xStart;
-	float prevWorldY = CalcGraphY(curveType, time, xStart);
+float originX = SCREEN_WIDTH / 2.0f;
+float originY = SCREEN_HEIGHT / 2.0f;
+float scale = 60.0f;
 
-	// Loop through all the remaining x values
-	for (float currWorldX = xStart + step; currWorldX <= xEnd; currWorldX += step)
-	{
-		// Calculate 'current' Y value
-		float currWorldY = CalcGraphY(curveType, time, currWorldX);
+// The view the globals above describe
+GraphView GetView()
+{
+	GraphView view;
+	view.originX = originX;
+	view.originY = originY;
+	view.scale = scale;
+	view.screenWidth = (float)SCREEN_WIDTH;
+	view.screenHeight = (float)SCREEN_HEIGHT;
+	return view;
+}
+
+// The axes are only built again when the graph moves or zooms
+Axes axes;
+
+void DrawAxes()
+{
+	axes.Update(GetView());
+	axes.Draw();
+}
 
-		// Draw graph line from 'previous' to 'current' position
-		GraphDrawLine(prevWorldX, prevWorldY, currWorldX, currWorldY, lineColor);
+void DrawCurve(Expression& curve, CurveCache& cache, float time, sf::Color lineColor)
+{
+	// The cache only works the curve out again when it has to. Moving the graph just changes
+	// where the cached points are drawn.
+	GraphView view = GetView();
+	cache.Update(curve, time, view, lineColor);
+	cache.Draw(view);
+}
+
+// GameEvent is called for each event from the window, such as a key being typed
+void GameEvent(const sf::Event& event)
+{
+	if (timePlot != NULL)
+	{
+		timePlot->Event(event);
+		return;
+	}
 
-		// Store current value as previous value, so we can use it next loop
-		prevWorldX = currWorldX;
-		prevWorldY = currWorldY;
+	if (event.type == sf::Event::KeyPressed && event.key.code == sf::Keyboard::Enter)
+	{
+		if (!typing)
+		{
+			typing = true;
+			typedText.clear();
+			typingError.clear();
+		}
+		else if (typedText.empty())
+		{
+			typing = false;
+		}
+		else
+		{
+			// Compile once, now, rather than reading the text every frame
+			Expression curve;
+			if (!curve.CompileCurve(typedText, typingError))
+			{
+				return;
+			}
+			if ((int)userCurves.size() >= MAX_USER_CURVES)
+			{
+				typingError = "Too many curves. Press Delete to remove them.";
+				return;
+			}
+			userCurves.push_back(curve);
+			userCurveCaches.push_back(CurveCache());
+			typing = false;
+		}
+	}
+	else if (event.type == sf::Event::MouseWheelScrolled)
+	{
+		// Each click of the wheel zooms by 10%, around the mouse
+		GraphView view = GetView();
+		view.ZoomAt((float)event.mouseWheelScroll.x, (float)event.mouseWheelScroll.y, powf(1.1f, event.mouseWheelScroll.delta));
+		originX = view.originX;
+		originY = view.originY;
+		scale = view.scale;
+	}
+	else if (event.type == sf::Event::KeyPressed && event.key.code == sf::Keyboard::R && !typing && field != NULL)
+	{
+		// Spread the field's colours over the values on the screen
+		field->FitRange();
+	}
+	else if (event.type == sf::Event::KeyPressed && event.key.code == sf::Keyboard::Delete && !typing)
+	{
+		userCurves.clear();
+		userCurveCaches.clear();
+	}
+	else if (event.type == sf::Event::TextEntered && typing)
+	{
+		if (event.text.unicode == 8 && !typedText.empty())
+		{
+			// Backspace
+			typedText.pop_back();
+		}
+		else if (event.text.unicode >= 32 && event.text.unicode < 127)
+		{
+			typedText += (char)event.text.unicode;
+		}
 	}
 }
 
@@ -106,6 +260,17 @@ void GameLoop(float elapsedSeconds)
 	// Keep a running total of how many seconds have passed since the program started
 	totalTime += elapsedSeconds;
 
+	if (timePlot != NULL)
+	{
+		timePlot->Draw();
+		return;
+	}
+	if (streamPlot != NULL)
+	{
+		streamPlot->Draw();
+		return;
+	}
+
 	// If mouse is clicked, move the graph origin to the mouse
 	if (IsMouseButtonPressed())
 	{
@@ -113,27 +278,74 @@ void GameLoop(float elapsedSeconds)
 		originY = (float)GetMouseY();
 	}
 
+	// Draw the field first, so everything else is on top of it
+	if (field != NULL)
+	{
+		sf::Clock fieldClock;
+		field->Update(totalTime, GetView(), *fieldThreads);
+		fieldMs = fieldClock.getElapsedTime().asSeconds() * 1000;
+		field->Draw();
+	}
+
 	DrawAxes();
 
+	// Draw the family of curves, if there is one, with the work shared between the threads
+	if (sweep != NULL)
+	{
+		sf::Clock sweepClock;
+		sweep->Update(totalTime, GetView(), *sweepThreads);
+		sweepMs = sweepClock.getElapsedTime().asSeconds() * 1000;
+		sweep->Draw();
+	}
+
 	// Draw graphs, if the number keys are pressed
 	if (IsKeyPressed(sf::Keyboard::Num1))
 	{
-		DrawCurve(1, totalTime, sf::Color::Green);
+		DrawCurve(shippedCurves[0], shippedCurveCaches[0], totalTime, sf::Color::Green);
 	}
 	if (IsKeyPressed(sf::Keyboard::Num2))
 	{
-		DrawCurve(2, totalTime, sf::Color::Yellow);
+		DrawCurve(shippedCurves[1], shippedCurveCaches[1], totalTime, sf::Color::Yellow);
 	}
 	if (IsKeyPressed(sf::Keyboard::Num3))
 	{
-		DrawCurve(3, totalTime, sf::Color::Red);
+		DrawCurve(shippedCurves[2], shippedCurveCaches[2], totalTime, sf::Color::Red);
 	}
 	if (IsKeyPressed(sf::Keyboard::Num4))
 	{
-		DrawCurve(4, totalTime, sf::Color::Magenta);
+		DrawCurve(shippedCurves[3], shippedCurveCaches[3], totalTime, sf::Color::Magenta);
 	}
 	if (IsKeyPressed(sf::Keyboard::Num5))
 	{
-		DrawCurve(5, totalTime, sf::Color(rand()%256, rand() % 256, rand() % 256));
+		DrawCurve(shippedCurves[4], shippedCurveCaches[4], totalTime, sf::Color(rand()%256, rand() % 256, rand() % 256));
+	}
+
+	// Draw the user's curves, all the time
+	for (int i = 0; i < (int)userCurves.size(); i++)
+	{
+		DrawCurve(userCurves[i], userCurveCaches[i], totalTime, userCurveColors[i % 8]);
+	}
+
+	if (typing)
+	{
+		DrawString("y = " + typedText + "_", 8, 8, 20, sf::Color::White);
+		DrawString(typingError, 8, 34, 16, sf::Color::Red);
+	}
+	else
+	{
+		DrawString("Enter: type a curve using x and t    Delete: remove typed curves    Wheel: zoom", 8, 8, 16, sf::Color(128, 128, 128));
+	}
+	if (sweep != NULL)
+	{
+		char text[128];
+		snprintf(text, sizeof(text), "%d curves on %d threads: %.2f ms", sweep->GetCurveCount(), sweepThreads->GetThreadCount(), sweepMs);
+		DrawString(text, 8, SCREEN_HEIGHT - 24.0f, 16, sf::Color(128, 128, 128));
+	}
+	if (field != NULL)
+	{
+		char text[160];
+		snprintf(text, sizeof(text), "Field: %d of %d tiles kept, %d values, %d px blocks, %.2f ms on %d threads    R: fit colours",
+			field->tilesReused, field->tilesOnScreen, field->valuesWorkedOut, field->coarsestStep, fieldMs, fieldThreads->GetThreadCount());
+		DrawString(text, 8, SCREEN_HEIGHT - 44.0f, 16, sf::Color(200, 200, 200));
 	}
 }
@@ -1,5 +1,20 @@
 #pragma once
+#include <SFML\Window.hpp>
 
 void GameInit();
 void DrawAxes();
 void GameLoop(float elapsedSeconds);
+void GameEvent(const sf::Event& event);
+
+// Plots a recorded file of samples instead of the curves. Call after GameInit.
+bool StartTimePlot(const char* path);
+
+// Plots live samples instead of the curves. 'kind' is "stdin", "file", "udp" or "test", and 'name' is
+// the file or port. Call after GameInit.
+bool StartStreamPlot(const char* kind, const char* name);
+
+// Also draws 'text' for numCurves values of k from firstK to lastK, shared across a thread per core
+bool StartSweep(const char* text, float firstK, float lastK, int numCurves);
+
+// Also draws a field z = f(x, y, t) behind the curves, coloured from z = low to z = high
+bool StartField(const char* text, float low, float high);
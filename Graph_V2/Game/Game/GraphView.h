@@ -0,0 +1,79 @@
+#pragma once
+
+// How far ZoomAt can zoom either way. Far enough that floats still have plenty of accuracy.
+const float MIN_GRAPH_SCALE = 0.01f;
+const float MAX_GRAPH_SCALE = 100000.0f;
+
+// How 'world' positions on the graph map to pixels on the screen.
+// The origin (0, 0) is at pixel (originX, originY), and one world unit is 'scale' pixels.
+// World y goes up, but screen y goes down, so y is flipped.
+class GraphView
+{
+public:
+	float originX = 400;
+	float originY = 300;
+	float scale = 60;
+	float screenWidth = 800;
+	float screenHeight = 600;
+
+	float ToScreenX(float worldX) const
+	{
+		return originX + worldX * scale;
+	}
+
+	float ToScreenY(float worldY) const
+	{
+		return originY - worldY * scale;
+	}
+
+	float ToWorldX(float screenX) const
+	{
+		return (screenX - originX) / scale;
+	}
+
+	float ToWorldY(float screenY) const
+	{
+		return (originY - screenY) / scale;
+	}
+
+	// The world x at the left and right edges of the screen
+	float GetLeftX() const
+	{
+		return ToWorldX(0);
+	}
+
+	float GetRightX() const
+	{
+		return ToWorldX(screenWidth);
+	}
+
+	// The world y at the top and bottom edges of the screen
+	float GetTopY() const
+	{
+		return ToWorldY(0);
+	}
+
+	float GetBottomY() const
+	{
+		return ToWorldY(screenHeight);
+	}
+
+	// Zooms in (factor above 1) or out (below 1), keeping the world position under the
+	// screen position (screenX, screenY) in the same place, like zooming a map
+	void ZoomAt(float screenX, float screenY, float factor)
+	{
+		float worldX = ToWorldX(screenX);
+		float worldY = ToWorldY(screenY);
+		scale *= factor;
+		if (scale < MIN_GRAPH_SCALE)
+		{
+			scale = MIN_GRAPH_SCALE;
+		}
+		if (scale > MAX_GRAPH_SCALE)
+		{
+			scale = MAX_GRAPH_SCALE;
+		}
+		originX = screenX - worldX * scale;
+		originY = screenY + worldY * scale;
+	}
+};
@@ -2,15 +2,169 @@
 #include "Main.h"
 #include "Game.h"
 #include "Helpers.h"
+#include "CurveKernels.h"
+#include "CurveSampler.h"
+#include "Expression.h"
+#include "CurveCache.h"
+#include "TimeSeries.h"
+#include "StreamPlot.h"
+#include "CurveSweep.h"
+#include "PlotExport.h"
+#include "FieldPlot.h"
+#include "FastMath.h"
+#include <cstdlib>
+#include <cstring>
 
 sf::RenderWindow* window = NULL;    // The window that the game will draw within
 sf::Font defaultFont;               // The font used for text within the window
 
-int main()
+int main(int argc, char** argv)
 {
+    // "Game.exe -curvebench" times working out the curves, without opening a window
+    if (argc >= 2 && strcmp(argv[1], "-curvebench") == 0)
+    {
+        RunCurveBenchmark();
+        return 0;
+    }
+
+    // "Game.exe -samplebench" compares fixed steps along the curves with the adaptive sampler
+    if (argc >= 2 && strcmp(argv[1], "-samplebench") == 0)
+    {
+        RunSampleBenchmark();
+        return 0;
+    }
+
+    // "Game.exe -exprbench" compares curves typed in as expressions with the hand written ones
+    if (argc >= 2 && strcmp(argv[1], "-exprbench") == 0)
+    {
+        RunExpressionBenchmark();
+        return 0;
+    }
+
+    // "Game.exe -cachebench" times moving the graph with and without cached curves
+    if (argc >= 2 && strcmp(argv[1], "-cachebench") == 0)
+    {
+        RunCacheBenchmark();
+        return 0;
+    }
+
+    // "Game.exe -seriesbench [millions]" times plotting a big file of samples, without opening a window
+    if (argc >= 2 && strcmp(argv[1], "-seriesbench") == 0)
+    {
+        int millions = argc >= 3 ? atoi(argv[2]) : 100;
+        RunTimeSeriesBenchmark(millions);
+        return 0;
+    }
+
+    // "Game.exe -streambench" checks the live plot keeps up with millions of samples a second
+    if (argc >= 2 && strcmp(argv[1], "-streambench") == 0)
+    {
+        RunStreamBenchmark();
+        return 0;
+    }
+
+    // "Game.exe -sweepbench [curves]" times drawing a family of curves on more and more threads
+    if (argc >= 2 && strcmp(argv[1], "-sweepbench") == 0)
+    {
+        int numCurves = argc >= 3 ? atoi(argv[2]) : 400;
+        RunSweepBenchmark(numCurves);
+        return 0;
+    }
+
+    // "Game.exe -export plots.txt [threads]" saves every plot listed in plots.txt as a .png or .svg, without opening a window
+    if (argc >= 3 && strcmp(argv[1], "-export") == 0)
+    {
+        int numThreads = argc >= 4 ? atoi(argv[3]) : 0;
+        return RunPlotExport(argv[2], numThreads) ? 0 : 1;
+    }
+
+    // "Game.exe -exportbench [plots]" times saving lots of plots on one thread and on every core
+    if (argc >= 2 && strcmp(argv[1], "-exportbench") == 0)
+    {
+        int numPlots = argc >= 3 ? atoi(argv[2]) : 200;
+        RunExportBenchmark(numPlots);
+        return 0;
+    }
+
+    // "Game.exe -capture frames/graph%05d.png 60 60 "sin((x + t) * 2)" [threads]" saves an animation of
+    // the curves as PNGs (or as raw pixels, if the name has no %d), without opening a window
+    if (argc >= 6 && strcmp(argv[1], "-capture") == 0)
+    {
+        int numThreads = argc >= 7 ? atoi(argv[6]) : 0;
+        return RunAnimationCapture(argv[2], (float)atof(argv[3]), atoi(argv[4]), argv[5], numThreads) ? 0 : 1;
+    }
+
+    // "Game.exe -capturebench [seconds]" times capturing an animation on one thread and on every core
+    if (argc >= 2 && strcmp(argv[1], "-capturebench") == 0)
+    {
+        RunCaptureBenchmark(argc >= 3 ? (float)atof(argv[2]) : 10);
+        return 0;
+    }
+
+    // "Game.exe -fieldbench" times drawing a field z = f(x, y, t) on more and more threads
+    if (argc >= 2 && strcmp(argv[1], "-fieldbench") == 0)
+    {
+        RunFieldBenchmark();
+        return 0;
+    }
+
+    // "Game.exe -mathcheck" checks the fast sin, cos, exp, log and pow against the standard library
+    if (argc >= 2 && strcmp(argv[1], "-mathcheck") == 0)
+    {
+        return RunMathCheck() ? 0 : 1;
+    }
+
+    // "Game.exe -mathbench" times the fast sin, cos, exp, log and pow against the standard library
+    if (argc >= 2 && strcmp(argv[1], "-mathbench") == 0)
+    {
+        RunMathBenchmark();
+        return 0;
+    }
+
     // Run our game initialization code
     GameInit();
 
+    // "Game.exe -plot data.bin" (or data.csv) plots a recorded file of samples instead of the curves
+    if (argc >= 3 && strcmp(argv[1], "-plot") == 0)
+    {
+        if (!StartTimePlot(argv[2]))
+        {
+            return 1;
+        }
+    }
+
+    // "Game.exe -sweep "sin((x + t) * k)" 0.5 10 400" also draws the expression for 400 values of k from 0.5 to 10
+    if (argc >= 3 && strcmp(argv[1], "-sweep") == 0)
+    {
+        float firstK = argc >= 4 ? (float)atof(argv[3]) : 0.5f;
+        float lastK = argc >= 5 ? (float)atof(argv[4]) : 10;
+        int numCurves = argc >= 6 ? atoi(argv[5]) : 400;
+        if (!StartSweep(argv[2], firstK, lastK, numCurves))
+        {
+            return 1;
+        }
+    }
+
+    // "Game.exe -field "sin(x * y + t)" -1 1" draws the field behind the graph, coloured from z = -1 to z = 1
+    if (argc >= 3 && strcmp(argv[1], "-field") == 0)
+    {
+        float low = argc >= 4 ? (float)atof(argv[3]) : -1;
+        float high = argc >= 5 ? (float)atof(argv[4]) : 1;
+        if (!StartField(argv[2], low, high))
+        {
+            return 1;
+        }
+    }
+
+    // "Game.exe -stream stdin", "-stream file log.txt", "-stream udp 5000" or "-stream test" plots live samples
+    if (argc >= 3 && strcmp(argv[1], "-stream") == 0)
+    {
+        if (!StartStreamPlot(argv[2], argc >= 4 ? argv[3] : "5000"))
+        {
+            return 1;
+        }
+    }
+
     // Load from a font file on disk
     // Note, you can use "Bangers.ttf" instead, for a different looking font
     if (!defaultFont.loadFromFile("arial.ttf"))
@@ -33,6 +187,9 @@ int main()
                 // The user has closed the application. Delete our window.
                 window->close();
             }
+
+            // Let the game see key presses and typing
+            GameEvent(event);
         }
 
         // Clear the screen from last time
@@ -0,0 +1,904 @@
+#include <SFML\System\Clock.hpp>
+#include <math.h>
+#include <cmath>
+#include <stdio.h>
+#include <string.h>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include "Helpers.h"
+#include "Axes.h"
+#include "Canvas.h"
+#include "CurveSampler.h"
+#include "Expression.h"
+#include "ThreadPool.h"
+#include "PlotExport.h"
+
+const int MAX_EXPORT_SIZE = 16384;		// Pixels, either way
+const float EXPORT_TICK_GAP = 50;		// Pixels. Ticks are never closer than this...
+const float EXPORT_LABEL_GAP = 12;		// ...or than the numbers' width plus this.
+const float EXPORT_TICK_HALF_LENGTH = 3;
+
+const sf::Color exportBackground(255, 255, 255);
+const sf::Color exportGrid(230, 230, 230);
+const sf::Color exportAxes(80, 80, 80);
+const sf::Color exportLabels(60, 60, 60);
+
+// Darker colours than the window's, which show up on white paper
+const sf::Color exportCurveColors[] =
+{
+	sf::Color(31, 119, 180),
+	sf::Color(214, 39, 40),
+	sf::Color(44, 160, 44),
+	sf::Color(148, 103, 189),
+	sf::Color(255, 127, 14),
+	sf::Color(23, 190, 207),
+};
+
+// Everything in a plot, in pixels, so the same plot can be drawn into a PNG or written as an SVG
+struct PlotLine
+{
+	sf::Vector2f start;
+	sf::Vector2f end;
+	sf::Color color;
+};
+
+struct PlotLabel
+{
+	char text[32];
+	float x;
+	float y;		// Top of the text
+	float alignX;	// 0 for the text to start at x, 0.5 to be centred on it and 1 to end at it
+};
+
+// Some joined up points of a curve, from points[first] to points[first + count - 1]
+struct PlotStrip
+{
+	int first;
+	int count;
+	sf::Color color;
+};
+
+struct PlotPicture
+{
+	int width = 0;
+	int height = 0;
+	std::vector<PlotLine> lines;		// Grid, axes and ticks
+	std::vector<sf::Vector2f> points;	// Of the curves
+	std::vector<PlotStrip> strips;
+	std::vector<PlotLabel> labels;
+};
+
+// Things each thread keeps for all the plots it does, so it isn't allocating memory for every plot
+struct ExportWorkspace
+{
+	Expression curve;
+	CurveSampler sampler;
+	std::vector<sf::Vertex> vertices;
+	PlotPicture picture;
+	Canvas canvas;
+};
+
+static bool EndsWith(const std::string& text, const char* ending)
+{
+	size_t length = strlen(ending);
+	return text.size() >= length && text.compare(text.size() - length, length, ending) == 0;
+}
+
+// Removes spaces from both ends
+static std::string Trim(const std::string& text)
+{
+	size_t start = text.find_first_not_of(" \t\r\n");
+	if (start == std::string::npos)
+	{
+		return "";
+	}
+	size_t end = text.find_last_not_of(" \t\r\n");
+	return text.substr(start, end - start + 1);
+}
+
+// The expressions are split by ;
+static void SplitExpressions(const std::string& text, std::vector<std::string>& expressions)
+{
+	size_t start = 0;
+	while (start <= text.size())
+	{
+		size_t end = text.find(';', start);
+		end = end == std::string::npos ? text.size() : end;
+		std::string expression = Trim(text.substr(start, end - start));
+		if (!expression.empty())
+		{
+			expressions.push_back(expression);
+		}
+		start = end + 1;
+	}
+}
+
+// Whether a range can be spread over 'pixels' pixels: both ends are numbers (not "inf"), and
+// neither the pixels for each unit nor the pixel positions of the ends come out as infinity
+static bool IsDrawableRange(float low, float high, int pixels)
+{
+	float scale = pixels / (high - low);
+	return std::isfinite(low) && std::isfinite(high) && std::isfinite(scale) && std::isfinite(low * scale) && std::isfinite(high * scale);
+}
+
+bool ParsePlotJobs(const std::string& jobFile, std::vector<PlotJob>& jobs, std::string& error)
+{
+	FILE* file = fopen(jobFile.c_str(), "r");
+	if (file == NULL)
+	{
+		error = "Can't open " + jobFile;
+		return false;
+	}
+
+	jobs.clear();
+	char line[4096];
+	int lineNumber = 0;
+	bool ok = true;
+	while (ok && fgets(line, sizeof(line), file) != NULL)
+	{
+		lineNumber++;
+		std::string text = Trim(line);
+		if (text.empty() || text[0] == '#')
+		{
+			continue;
+		}
+
+		PlotJob job;
+		job.lineNumber = lineNumber;
+		char path[1024];
+		int used = 0;
+		if (sscanf(text.c_str(), "%1023s %d %d %f %f %f %f %n", path, &job.width, &job.height,
+			&job.left, &job.right, &job.bottom, &job.top, &used) != 7 || used == 0)
+		{
+			error = "Line " + std::to_string(lineNumber) + ": expected <file> <width> <height> <left x> <right x> <bottom y> <top y> <expressions>";
+			ok = false;
+			break;
+		}
+		job.path = path;
+
+		SplitExpressions(text.substr(used), job.expressions);
+
+		if (job.expressions.empty())
+		{
+			error = "Line " + std::to_string(lineNumber) + ": no expressions to plot";
+			ok = false;
+		}
+		else if (job.width <= 0 || job.height <= 0 || job.width > MAX_EXPORT_SIZE || job.height > MAX_EXPORT_SIZE)
+		{
+			error = "Line " + std::to_string(lineNumber) + ": the size must be from 1 to " + std::to_string(MAX_EXPORT_SIZE);
+			ok = false;
+		}
+		else if (!(job.right > job.left) || !(job.top > job.bottom))
+		{
+			error = "Line " + std::to_string(lineNumber) + ": right x must be more than left x, and top y more than bottom y";
+			ok = false;
+		}
+		else if (!IsDrawableRange(job.left, job.right, job.width) || !IsDrawableRange(job.bottom, job.top, job.height))
+		{
+			error = "Line " + std::to_string(lineNumber) + ": the x and y ranges are too big or too small to draw";
+			ok = false;
+		}
+		else
+		{
+			jobs.push_back(job);
+		}
+	}
+	fclose(file);
+	return ok;
+}
+
+// Puts a line along the middle of a row or column of pixels, so it's sharp instead of smudged
+// over two rows. Lines right on the edge are moved just inside, so they can still be seen.
+static float PixelCentre(float position, float size)
+{
+	float centre = floorf(position) + 0.5f;
+	centre = centre < 0.5f ? 0.5f : centre;
+	return centre > size - 0.5f ? size - 0.5f : centre;
+}
+
+static void AddLine(PlotPicture& picture, float x1, float y1, float x2, float y2, sf::Color color)
+{
+	PlotLine line;
+	line.start = sf::Vector2f(x1, y1);
+	line.end = sf::Vector2f(x2, y2);
+	line.color = color;
+	picture.lines.push_back(line);
+}
+
+static void AddLabel(PlotPicture& picture, double value, double spacing, float x, float y, float alignX)
+{
+	PlotLabel label;
+	FormatTickLabel(value, spacing, label.text, sizeof(label.text));
+
+	// Numbers at the very edges are moved in, instead of being cut off
+	float textWidth = Canvas::GetTextWidth(label.text);
+	float left = x - textWidth * alignX;
+	left = left + textWidth > picture.width - 1 ? picture.width - 1 - textWidth : left;
+	left = left < 1 ? 1 : left;
+	float lowest = (float)(picture.height - 1 - Canvas::TEXT_HEIGHT);
+	y = y > lowest ? lowest : y;
+	label.x = left + textWidth * alignX;
+	label.y = y < 1 ? 1 : y;
+	label.alignX = alignX;
+	picture.labels.push_back(label);
+}
+
+// Like Axes::Build, but x and y can have different scales, and there's a light grid behind the curves
+static void AddAxes(const PlotJob& job, float xScale, float yScale, PlotPicture& picture)
+{
+	float width = (float)job.width;
+	float height = (float)job.height;
+	float originX = -job.left * xScale;
+	float originY = job.top * yScale;
+
+	// The x spacing has to leave room for the numbers, which are widest at the ends
+	double xSpacing = NiceNumberAbove(EXPORT_TICK_GAP / xScale);
+	for (int attempt = 0; attempt < 2; attempt++)
+	{
+		const double edges[] = { job.left, job.right };
+		float widest = 0;
+		for (double edge : edges)
+		{
+			char text[32];
+			FormatTickLabel(floor(edge / xSpacing) * xSpacing, xSpacing, text, sizeof(text));
+			float textWidth = Canvas::GetTextWidth(text);
+			widest = textWidth > widest ? textWidth : widest;
+		}
+		if ((widest + EXPORT_LABEL_GAP) / xScale <= xSpacing)
+		{
+			break;
+		}
+		xSpacing = NiceNumberAbove((widest + EXPORT_LABEL_GAP) / xScale);
+	}
+	double ySpacing = NiceNumberAbove(EXPORT_TICK_GAP / yScale);
+
+	long long firstX = (long long)ceil(job.left / xSpacing);
+	long long lastX = (long long)floor(job.right / xSpacing);
+	long long firstY = (long long)ceil(job.bottom / ySpacing);
+	long long lastY = (long long)floor(job.top / ySpacing);
+
+	for (long long i = firstX; i <= lastX; i++)
+	{
+		float x = PixelCentre((float)((i * xSpacing - job.left) * xScale), width);
+		AddLine(picture, x, 0, x, height, exportGrid);
+	}
+	for (long long i = firstY; i <= lastY; i++)
+	{
+		float y = PixelCentre((float)((job.top - i * ySpacing) * yScale), height);
+		AddLine(picture, 0, y, width, y, exportGrid);
+	}
+
+	if (originX >= 0 && originX <= width)
+	{
+		AddLine(picture, PixelCentre(originX, width), 0, PixelCentre(originX, width), height, exportAxes);
+	}
+	if (originY >= 0 && originY <= height)
+	{
+		AddLine(picture, 0, PixelCentre(originY, height), width, PixelCentre(originY, height), exportAxes);
+	}
+
+	// When an axis is off the plot, its ticks and numbers stay along the nearest edge
+	float xAxisY = originY < 0 ? 0 : originY;
+	float lowestXAxisY = height - Canvas::TEXT_HEIGHT - EXPORT_TICK_HALF_LENGTH - 4;
+	xAxisY = PixelCentre(xAxisY > lowestXAxisY ? lowestXAxisY : xAxisY, height);
+	float yAxisX = originX < 0 ? 0 : originX;
+	yAxisX = PixelCentre(yAxisX, width);
+	bool yLabelsOnRight = yAxisX < 40;
+
+	float xLabelsTop = xAxisY + EXPORT_TICK_HALF_LENGTH + 3;
+	for (long long i = firstX; i <= lastX; i++)
+	{
+		float x = PixelCentre((float)((i * xSpacing - job.left) * xScale), width);
+		AddLine(picture, x, xAxisY - EXPORT_TICK_HALF_LENGTH, x, xAxisY + EXPORT_TICK_HALF_LENGTH + 1, exportAxes);
+		AddLabel(picture, i * xSpacing, xSpacing, x, xLabelsTop, 0.5f);
+	}
+	for (long long i = firstY; i <= lastY; i++)
+	{
+		// 0 is already written on the x axis
+		if (i == 0 && originY >= 0 && originY <= height)
+		{
+			continue;
+		}
+		float y = PixelCentre((float)((job.top - i * ySpacing) * yScale), height);
+		AddLine(picture, yAxisX - EXPORT_TICK_HALF_LENGTH, y, yAxisX + EXPORT_TICK_HALF_LENGTH + 1, y, exportAxes);
+
+		// Numbers which would be on top of the x axis' numbers are left out
+		float labelY = y - Canvas::TEXT_HEIGHT / 2.0f;
+		if (fabsf(labelY - xLabelsTop) < Canvas::TEXT_HEIGHT + 2)
+		{
+			continue;
+		}
+		if (yLabelsOnRight)
+		{
+			AddLabel(picture, i * ySpacing, ySpacing, yAxisX + EXPORT_TICK_HALF_LENGTH + 4, labelY, 0);
+		}
+		else
+		{
+			AddLabel(picture, i * ySpacing, ySpacing, yAxisX - EXPORT_TICK_HALF_LENGTH - 3, labelY, 1);
+		}
+	}
+}
+
+// Works out where everything in the plot goes
+static bool BuildPicture(const PlotJob& job, ExportWorkspace& workspace, std::string& error)
+{
+	PlotPicture& picture = workspace.picture;
+	picture.width = job.width;
+	picture.height = job.height;
+	picture.lines.clear();
+	picture.points.clear();
+	picture.strips.clear();
+	picture.labels.clear();
+
+	// x and y usually have different scales here, so the view's scale is x's, and the sampler is
+	// given y's separately. That way the curves are sampled right on the picture's own pixels.
+	float xScale = job.width / (job.right - job.left);
+	float yScale = job.height / (job.top - job.bottom);
+	GraphView view;
+	view.scale = xScale;
+	view.originX = -job.left * xScale;
+	view.originY = job.top * yScale;
+	view.screenWidth = (float)job.width;
+	view.screenHeight = (float)job.height;
+
+	AddAxes(job, xScale, yScale, picture);
+
+	for (size_t e = 0; e < job.expressions.size(); e++)
+	{
+		std::string compileError;
+		if (!workspace.curve.CompileCurve(job.expressions[e], compileError))
+		{
+			error = "\"" + job.expressions[e] + "\": " + compileError;
+			return false;
+		}
+		sf::Color color = exportCurveColors[e % (sizeof(exportCurveColors) / sizeof(exportCurveColors[0]))];
+		workspace.sampler.Sample(workspace.curve, job.time, view, yScale, color, workspace.vertices);
+
+		// The sampler breaks its line strip with see-through vertices. Here, each unbroken part
+		// becomes a strip of its own.
+		PlotStrip strip = { (int)picture.points.size(), 0, color };
+		for (const sf::Vertex& vertex : workspace.vertices)
+		{
+			if (vertex.color.a != 0)
+			{
+				picture.points.push_back(vertex.position);
+				strip.count++;
+				continue;
+			}
+			if (strip.count >= 2)
+			{
+				picture.strips.push_back(strip);
+			}
+			else
+			{
+				picture.points.resize(strip.first);
+			}
+			strip.first = (int)picture.points.size();
+			strip.count = 0;
+		}
+		if (strip.count >= 2)
+		{
+			picture.strips.push_back(strip);
+		}
+		else
+		{
+			picture.points.resize(strip.first);
+		}
+	}
+	return true;
+}
+
+static void DrawPicture(const PlotPicture& picture, Canvas& canvas)
+{
+	canvas.Create(picture.width, picture.height, exportBackground);
+	for (const PlotLine& line : picture.lines)
+	{
+		canvas.DrawLine(line.start.x, line.start.y, line.end.x, line.end.y, line.color);
+	}
+	for (const PlotStrip& strip : picture.strips)
+	{
+		const sf::Vector2f* points = &picture.points[strip.first];
+		for (int i = 0; i + 1 < strip.count; i++)
+		{
+			canvas.DrawLine(points[i].x, points[i].y, points[i + 1].x, points[i + 1].y, strip.color);
+		}
+	}
+	for (const PlotLabel& label : picture.labels)
+	{
+		canvas.DrawText(label.text, label.x, label.y, label.alignX, exportLabels);
+	}
+}
+
+static bool SavePng(const PlotPicture& picture, Canvas& canvas, const std::string& path)
+{
+	DrawPicture(picture, canvas);
+	return canvas.SaveToFile(path);
+}
+
+static bool SaveSvg(const PlotPicture& picture, const std::string& path)
+{
+	FILE* file = fopen(path.c_str(), "w");
+	if (file == NULL)
+	{
+		return false;
+	}
+
+	fprintf(file, "<svg xmlns=\"http://www.w3.org/2000/svg\" width=\"%d\" height=\"%d\" viewBox=\"0 0 %d %d\">\n",
+		picture.width, picture.height, picture.width, picture.height);
+	fprintf(file, "<rect width=\"100%%\" height=\"100%%\" fill=\"#%02x%02x%02x\"/>\n",
+		exportBackground.r, exportBackground.g, exportBackground.b);
+
+	// Lines of the same colour next to each other go in one path, to keep the file small
+	for (size_t i = 0; i < picture.lines.size(); i++)
+	{
+		const PlotLine& line = picture.lines[i];
+		if (i == 0 || line.color != picture.lines[i - 1].color)
+		{
+			fprintf(file, "%s<path fill=\"none\" stroke=\"#%02x%02x%02x\" d=\"", i == 0 ? "" : "\"/>\n", line.color.r, line.color.g, line.color.b);
+		}
+		fprintf(file, "M%.1f %.1fL%.1f %.1f", line.start.x, line.start.y, line.end.x, line.end.y);
+	}
+	if (!picture.lines.empty())
+	{
+		fprintf(file, "\"/>\n");
+	}
+
+	for (const PlotStrip& strip : picture.strips)
+	{
+		fprintf(file, "<polyline fill=\"none\" stroke=\"#%02x%02x%02x\" stroke-width=\"1.5\" points=\"",
+			strip.color.r, strip.color.g, strip.color.b);
+		const sf::Vector2f* points = &picture.points[strip.first];
+		for (int i = 0; i < strip.count; i++)
+		{
+			fprintf(file, i == 0 ? "%.2f,%.2f" : " %.2f,%.2f", points[i].x, points[i].y);
+		}
+		fprintf(file, "\"/>\n");
+	}
+
+	fprintf(file, "<g font-family=\"sans-serif\" font-size=\"10\" fill=\"#%02x%02x%02x\">\n", exportLabels.r, exportLabels.g, exportLabels.b);
+	for (const PlotLabel& label : picture.labels)
+	{
+		const char* anchor = label.alignX == 0 ? "start" : label.alignX == 1 ? "end" : "middle";
+		fprintf(file, "<text x=\"%.1f\" y=\"%.1f\" text-anchor=\"%s\">%s</text>\n",
+			label.x, label.y + Canvas::TEXT_HEIGHT, anchor, label.text);
+	}
+	fprintf(file, "</g>\n</svg>\n");
+
+	bool ok = ferror(file) == 0;
+	ok = fclose(file) == 0 && ok;
+	return ok;
+}
+
+int ExportPlots(const std::vector<PlotJob>& jobs, int numThreads, PlotExportTimes* times)
+{
+	ThreadPool pool(numThreads);
+	std::vector<ExportWorkspace> workspaces(pool.GetThreadCount());
+	std::vector<std::string> errors(jobs.size());
+	std::mutex timesMutex;
+
+	// One task per plot. There's no waiting between drawing and saving: a thread saves its plot
+	// straight after drawing it, while the other threads carry on drawing theirs.
+	pool.Run((int)jobs.size(), [&](int task, int thread)
+	{
+		const PlotJob& job = jobs[task];
+		ExportWorkspace& workspace = workspaces[thread];
+		sf::Clock clock;
+		std::string error;
+		bool ok = BuildPicture(job, workspace, error);
+		float sampleSeconds = clock.restart().asSeconds();
+
+		if (ok)
+		{
+			ok = EndsWith(job.path, ".svg") ? SaveSvg(workspace.picture, job.path) : SavePng(workspace.picture, workspace.canvas, job.path);
+			if (!ok)
+			{
+				error = "Couldn't save " + job.path;
+			}
+		}
+		if (!ok)
+		{
+			errors[task] = "Line " + std::to_string(job.lineNumber) + " (" + job.path + "): " + error;
+		}
+
+		if (times != NULL)
+		{
+			float saveSeconds = clock.getElapsedTime().asSeconds();
+			std::lock_guard<std::mutex> lock(timesMutex);
+			times->sampleSeconds += sampleSeconds;
+			times->saveSeconds += saveSeconds;
+		}
+	});
+
+	// Printed at the end, so they aren't mixed up by several threads printing at once
+	int failed = 0;
+	for (const std::string& error : errors)
+	{
+		if (!error.empty())
+		{
+			printf("%s\n", error.c_str());
+			failed++;
+		}
+	}
+	return failed;
+}
+
+bool RunPlotExport(const char* jobFile, int numThreads)
+{
+	std::vector<PlotJob> jobs;
+	std::string error;
+	if (!ParsePlotJobs(jobFile, jobs, error))
+	{
+		printf("%s\n", error.c_str());
+		return false;
+	}
+
+	sf::Clock clock;
+	int failed = ExportPlots(jobs, numThreads);
+	printf("Saved %d of %d plots in %.2f seconds\n", (int)jobs.size() - failed, (int)jobs.size(), clock.getElapsedTime().asSeconds());
+	return failed == 0;
+}
+
+void RunExportBenchmark(int numPlots)
+{
+	const char* expressions[] =
+	{
+		"sin(x)",
+		"x^3 - 2 * x",
+		"1 / x",
+		"sin(x * x); cos(x) * 0.5",
+		"2^x; log(x)",
+		"tan(x)",
+		"sqrt(abs(x)) * sin(10 * x)",
+		"exp(-x * x) * cos(5 * x)",
+	};
+	const int numExpressions = sizeof(expressions) / sizeof(expressions[0]);
+
+	// Every plot is different, so the threads get a mix of easy and hard ones
+	std::vector<PlotJob> jobs(numPlots);
+	for (int i = 0; i < numPlots; i++)
+	{
+		char path[64];
+		snprintf(path, sizeof(path), "exportbench_%04d.%s", i, i % 10 == 9 ? "svg" : "png");
+		PlotJob& job = jobs[i];
+		job.path = path;
+		job.left = -5.0f - i % 7;
+		job.right = 5.0f + i % 3;
+		job.bottom = -3.0f - i % 5;
+		job.top = 3.0f + i % 4;
+		job.lineNumber = i + 1;
+		std::string text = expressions[i % numExpressions];
+		size_t start = 0;
+		while (start <= text.size())
+		{
+			size_t end = text.find(';', start);
+			end = end == std::string::npos ? text.size() : end;
+			job.expressions.push_back(text.substr(start, end - start));
+			start = end + 1;
+		}
+	}
+
+	int numCores = (int)std::thread::hardware_concurrency();
+	printf("%d plots of 800 x 600 (1 in 10 as SVG), %d cores\n", numPlots, numCores);
+	const int threadCounts[] = { 1, 0 };
+	float oneThreadSeconds = 0;
+	for (int numThreads : threadCounts)
+	{
+		PlotExportTimes times;
+		sf::Clock clock;
+		int failed = ExportPlots(jobs, numThreads, &times);
+		float seconds = clock.getElapsedTime().asSeconds();
+		oneThreadSeconds = numThreads == 1 ? seconds : oneThreadSeconds;
+		printf("  %2d threads: %.2f s, %.1f plots a second, %.2fx faster than 1 thread (sampling %.2f s, drawing and saving %.2f s)%s\n",
+			numThreads == 0 ? (numCores > 0 ? numCores : 1) : numThreads, seconds, numPlots / seconds, oneThreadSeconds / seconds,
+			times.sampleSeconds, times.saveSeconds, failed == 0 ? "" : ", SOME FAILED");
+	}
+
+	// A plot where x is squashed and y stretched a long way, which the sampler should still do with
+	// a few points for each pixel across. The lines are checked against the real curve, in pixels.
+	PlotJob squashed;
+	squashed.left = -1000;
+	squashed.right = 1000;
+	squashed.bottom = -0.01f;
+	squashed.top = 0.01f;
+	squashed.expressions.push_back("sin(x)");
+	ExportWorkspace workspace;
+	std::string error;
+	bool built = BuildPicture(squashed, workspace, error);
+	float xScale = squashed.width / (squashed.right - squashed.left);
+	float yScale = squashed.height / (squashed.top - squashed.bottom);
+	float biggestError = 0;
+	const std::vector<sf::Vector2f>& points = workspace.picture.points;
+	for (const PlotStrip& strip : workspace.picture.strips)
+	{
+		for (int i = strip.first; i + 1 < strip.first + strip.count; i++)
+		{
+			sf::Vector2f start = points[i];
+			sf::Vector2f end = points[i + 1];
+			float dx = end.x - start.x;
+			float dy = end.y - start.y;
+			float length = std::sqrt(dx * dx + dy * dy);
+			if (length == 0)
+			{
+				continue;
+			}
+			for (int j = 1; j < 16; j++)
+			{
+				float screenX = start.x + dx * j / 16;
+				float screenY = (squashed.top - workspace.curve.Evaluate(squashed.time, squashed.left + screenX / xScale)) * yScale;
+				if (screenY < 0 || screenY > squashed.height)
+				{
+					continue;
+				}
+				float distance = std::abs(dx * (screenY - start.y) - dy * (screenX - start.x)) / length;
+				biggestError = std::max(biggestError, distance);
+			}
+		}
+	}
+	bool squashedOk = built && !points.empty() && points.size() < 20 * (size_t)squashed.width && biggestError < 0.5f;
+	printf("  Squashed plot (x -1000 to 1000, y -0.01 to 0.01): %d points, lines within %.2f px of the curve%s\n",
+		(int)points.size(), biggestError, squashedOk ? "" : ", FAILED");
+
+	for (const PlotJob& job : jobs)
+	{
+		remove(job.path.c_str());
+	}
+}
+
+// Frames drawn and waiting to be saved, and the Canvases free to draw more frames in
+struct CaptureQueue
+{
+	std::mutex mutex;
+	std::condition_variable changed;
+	std::vector<Canvas*> freeCanvases;
+	std::deque<std::pair<int, Canvas*>> drawn;	// Frame numbers and their pixels
+	int nextToWrite = 0;		// For a raw file, which has to be written in order
+	bool allDrawn = false;
+	std::string error;			// The first thing which went wrong
+};
+
+bool CaptureAnimation(const PlotJob& job, const std::string& output, float seconds, int framesPerSecond,
+	int numThreads, PlotExportTimes* times, std::string& error)
+{
+	int numFrames = (int)(seconds * framesPerSecond + 0.5f);
+	if (numFrames <= 0 || framesPerSecond <= 0)
+	{
+		error = "Nothing to capture";
+		return false;
+	}
+
+	// Check the expressions first, rather than finding out on every frame
+	Expression curve;
+	for (const std::string& expression : job.expressions)
+	{
+		std::string compileError;
+		if (!curve.CompileCurve(expression, compileError))
+		{
+			error = "\"" + expression + "\": " + compileError;
+			return false;
+		}
+	}
+
+	bool raw = output.find('%') == std::string::npos;
+	FILE* rawFile = NULL;
+	if (raw)
+	{
+		rawFile = fopen(output.c_str(), "wb");
+		if (rawFile == NULL)
+		{
+			error = "Can't write " + output;
+			return false;
+		}
+	}
+
+	ThreadPool pool(numThreads);
+	int numDrawThreads = pool.GetThreadCount();
+	std::vector<ExportWorkspace> workspaces(numDrawThreads);
+	std::vector<PlotJob> frameJobs(numDrawThreads, job);
+
+	// Squashing PNGs is slower than drawing, so gets as many threads again. A raw file is written
+	// by one thread, in order.
+	int numSaveThreads = raw ? 1 : numDrawThreads;
+
+	// Enough Canvases for every thread to have one, and a few waiting. For a raw file, drawing
+	// never gets more than this many frames ahead of writing, so the Canvases can't all fill up
+	// with later frames while the writer waits for an earlier one.
+	int numCanvases = numDrawThreads + numSaveThreads + 2;
+	std::vector<Canvas> canvases(numCanvases);
+	CaptureQueue queue;
+	for (Canvas& canvas : canvases)
+	{
+		queue.freeCanvases.push_back(&canvas);
+	}
+	double drawSeconds = 0;
+	double saveSeconds = 0;
+
+	std::vector<std::thread> saveThreads;
+	for (int i = 0; i < numSaveThreads; i++)
+	{
+		saveThreads.push_back(std::thread([&]()
+		{
+			while (true)
+			{
+				std::pair<int, Canvas*> frame;
+				{
+					std::unique_lock<std::mutex> lock(queue.mutex);
+					auto nextReady = [&]()
+					{
+						for (auto item = queue.drawn.begin(); item != queue.drawn.end(); ++item)
+						{
+							if (!raw || item->first == queue.nextToWrite)
+							{
+								return item;
+							}
+						}
+						return queue.drawn.end();
+					};
+					queue.changed.wait(lock, [&]() { return nextReady() != queue.drawn.end() || (queue.allDrawn && queue.drawn.empty()); });
+					if (queue.drawn.empty())
+					{
+						return;
+					}
+					auto item = nextReady();
+					frame = *item;
+					queue.drawn.erase(item);
+				}
+
+				sf::Clock clock;
+				bool ok;
+				std::string path;
+				if (raw)
+				{
+					size_t size = (size_t)frame.second->GetWidth() * frame.second->GetHeight() * 4;
+					ok = fwrite(frame.second->GetPixels(), 1, size, rawFile) == size;
+					path = output;
+				}
+				else
+				{
+					char name[1024];
+					snprintf(name, sizeof(name), output.c_str(), frame.first);
+					path = name;
+					ok = frame.second->SaveToFile(path);
+				}
+				float frameSeconds = clock.getElapsedTime().asSeconds();
+
+				std::lock_guard<std::mutex> lock(queue.mutex);
+				saveSeconds += frameSeconds;
+				if (!ok && queue.error.empty())
+				{
+					queue.error = "Couldn't save " + path;
+				}
+				queue.freeCanvases.push_back(frame.second);
+				queue.nextToWrite++;
+				queue.changed.notify_all();
+			}
+		}));
+	}
+
+	// The frames are handed out in order, but finish in any order
+	pool.Run(numFrames, [&](int frame, int thread)
+	{
+		Canvas* canvas;
+		{
+			std::unique_lock<std::mutex> lock(queue.mutex);
+			queue.changed.wait(lock, [&]() { return !queue.freeCanvases.empty() && (!raw || frame < queue.nextToWrite + numCanvases); });
+			canvas = queue.freeCanvases.back();
+			queue.freeCanvases.pop_back();
+		}
+
+		sf::Clock clock;
+		PlotJob& frameJob = frameJobs[thread];
+		frameJob.time = (float)(frame / (double)framesPerSecond);
+		std::string frameError;
+		bool ok = BuildPicture(frameJob, workspaces[thread], frameError);
+		DrawPicture(workspaces[thread].picture, *canvas);
+		float frameSeconds = clock.getElapsedTime().asSeconds();
+
+		std::lock_guard<std::mutex> lock(queue.mutex);
+		drawSeconds += frameSeconds;
+		if (!ok && queue.error.empty())
+		{
+			queue.error = frameError;
+		}
+		queue.drawn.push_back(std::make_pair(frame, canvas));
+		queue.changed.notify_all();
+	});
+
+	{
+		std::lock_guard<std::mutex> lock(queue.mutex);
+		queue.allDrawn = true;
+		queue.changed.notify_all();
+	}
+	for (std::thread& thread : saveThreads)
+	{
+		thread.join();
+	}
+	if (rawFile != NULL && fclose(rawFile) != 0 && queue.error.empty())
+	{
+		queue.error = "Couldn't save " + output;
+	}
+
+	if (times != NULL)
+	{
+		times->sampleSeconds += drawSeconds;
+		times->saveSeconds += saveSeconds;
+	}
+	error = queue.error;
+	return error.empty();
+}
+
+// The window's view when the program starts
+static PlotJob WindowJob(const std::vector<std::string>& expressions)
+{
+	GraphView view;
+	PlotJob job;
+	job.width = (int)view.screenWidth;
+	job.height = (int)view.screenHeight;
+	job.left = view.GetLeftX();
+	job.right = view.GetRightX();
+	job.bottom = view.GetBottomY();
+	job.top = view.GetTopY();
+	job.expressions = expressions;
+	return job;
+}
+
+bool RunAnimationCapture(const char* output, float seconds, int framesPerSecond, const char* expressions, int numThreads)
+{
+	std::vector<std::string> expressionList;
+	SplitExpressions(expressions, expressionList);
+	if (expressionList.empty())
+	{
+		printf("No expressions to capture\n");
+		return false;
+	}
+
+	sf::Clock clock;
+	std::string error;
+	bool ok = CaptureAnimation(WindowJob(expressionList), output, seconds, framesPerSecond, numThreads, NULL, error);
+	if (!ok)
+	{
+		printf("%s\n", error.c_str());
+		return false;
+	}
+	float wallSeconds = clock.getElapsedTime().asSeconds();
+	int numFrames = (int)(seconds * framesPerSecond + 0.5f);
+	printf("Saved %d frames in %.2f seconds (%.1f frames a second)\n", numFrames, wallSeconds, numFrames / wallSeconds);
+	return true;
+}
+
+void RunCaptureBenchmark(float seconds)
+{
+	std::vector<std::string> expressions;
+	SplitExpressions("sin((x + t) * 2); cos(x * 3 - t) * 0.5 * sin(t); x^3 / 20 - x * sin(t)", expressions);
+	PlotJob job = WindowJob(expressions);
+	const int framesPerSecond = 60;
+	int numFrames = (int)(seconds * framesPerSecond + 0.5f);
+
+	int numCores = (int)std::thread::hardware_concurrency();
+	printf("%.0f seconds at %d frames a second (%d frames of %d x %d), %d cores\n",
+		seconds, framesPerSecond, numFrames, job.width, job.height, numCores);
+	const char* outputs[] = { "capturebench_%05d.png", "capturebench.rgba" };
+	const int threadCounts[] = { 1, 0 };
+	for (const char* output : outputs)
+	{
+		for (int numThreads : threadCounts)
+		{
+			PlotExportTimes times;
+			std::string error;
+			sf::Clock clock;
+			bool ok = CaptureAnimation(job, output, seconds, framesPerSecond, numThreads, &times, error);
+			float wallSeconds = clock.getElapsedTime().asSeconds();
+			printf("  %-22s %2d threads: %.2f s, %.1f frames a second, a minute in %.1f s (drawing %.2f s, saving %.2f s)%s\n",
+				output, numThreads == 0 ? (numCores > 0 ? numCores : 1) : numThreads, wallSeconds, numFrames / wallSeconds,
+				wallSeconds * 60 / seconds, times.sampleSeconds, times.saveSeconds, ok ? "" : (", FAILED: " + error).c_str());
+		}
+	}
+
+	for (int i = 0; i < numFrames; i++)
+	{
+		char path[64];
+		snprintf(path, sizeof(path), outputs[0], i);
+		remove(path);
+	}
+	remove(outputs[1]);
+}
@@ -0,0 +1,79 @@
+#pragma once
+#include <string>
+#include <vector>
+
+// Draws plots straight to .png or .svg files, with no window, so lots of them can be made on a
+// computer with no screen or graphics card (like a server making plots for reports).
+//
+// The plots are listed in a text file, one per line:
+//
+//     <file> <width> <height> <left x> <right x> <bottom y> <top y> <expression>[; <expression>...]
+//
+// for example
+//
+//     wave.png 800 600 -10 10 -2 2 sin(x); 0.5 * cos(2 * x)
+//     fast.svg 400 300 0 5 0 40 2^x
+//
+// Lines starting with # are ignored. File names can't have spaces in. t is 0 for every plot.
+//
+// Each plot is sampled with the same CurveSampler as the window uses, and drawn by the CPU into
+// a Canvas (or written out as SVG lines). The plots are shared out over a ThreadPool, and each
+// thread saves its plot as soon as it's drawn, so one plot is being squashed into a PNG while
+// other threads are still drawing theirs.
+struct PlotJob
+{
+	std::string path;	// Ends in .svg for an SVG, otherwise anything sf::Image can save
+	int width = 800;
+	int height = 600;
+	float left = -5;
+	float right = 5;
+	float bottom = -4;
+	float top = 4;
+	std::vector<std::string> expressions;
+	float time = 0;			// t, for every expression
+	int lineNumber = 0;		// Where it was in the list of plots, for errors
+};
+
+// How long all the threads spent on each part, added together
+struct PlotExportTimes
+{
+	double sampleSeconds = 0;	// Working out the curves and axes
+	double saveSeconds = 0;		// Drawing the pixels (or writing the SVG) and saving the file
+};
+
+// Reads the list of plots. Returns false if the file can't be read or a line is wrong.
+bool ParsePlotJobs(const std::string& jobFile, std::vector<PlotJob>& jobs, std::string& error);
+
+// Draws and saves every plot, on numThreads threads (0 for one per core).
+// Returns how many couldn't be made, after printing why.
+int ExportPlots(const std::vector<PlotJob>& jobs, int numThreads, PlotExportTimes* times = NULL);
+
+// "Game.exe -export plots.txt [threads]"
+bool RunPlotExport(const char* jobFile, int numThreads);
+
+// Saves an animation of job's curves, from t = 0 for 'seconds', far quicker than recording the
+// window. Frame i shows t = i / framesPerSecond, the time GameLoop reaches when it's given
+// elapsedSeconds = 1 / framesPerSecond every frame. No frame depends on the one before, so
+// the frames are drawn on numThreads threads at once (0 for one per core), out of order.
+//
+// Squashing a frame into a PNG takes longer than drawing it, so that's done by another set of
+// threads, while the drawing threads carry on with the next frames. 'output' is either
+//     frames/graph%05d.png   a PNG per frame, numbered with printf's %d from 0
+//     graph.rgba             every frame's pixels (red, green, blue and alpha bytes) one after the
+//                            other, for video tools. E.g. for 800 x 600 at 60 frames a second:
+//                            ffmpeg -f rawvideo -pix_fmt rgba -s 800x600 -r 60 -i graph.rgba graph.mp4
+// job.path and job.time aren't used. times->sampleSeconds is the time spent drawing frames, and
+// times->saveSeconds saving them. Returns false, with the reason in 'error', if it fails.
+bool CaptureAnimation(const PlotJob& job, const std::string& output, float seconds, int framesPerSecond,
+	int numThreads, PlotExportTimes* times, std::string& error);
+
+// "Game.exe -capture <output> <seconds> <framesPerSecond> "<expression>[; <expression>...]" [threads]"
+// captures the window's starting view of the curves
+bool RunAnimationCapture(const char* output, float seconds, int framesPerSecond, const char* expressions, int numThreads);
+
+// "Game.exe -capturebench [seconds]" times capturing an animation as PNGs and as a raw file,
+// on 1 thread and on every core
+void RunCaptureBenchmark(float seconds);
+
+// "Game.exe -exportbench [plots]" times saving lots of plots on 1 thread and on every core
+void RunExportBenchmark(int numPlots);
@@ -0,0 +1,91 @@
+#pragma once
+#include <atomic>
+#include <vector>
+
+// A sample from a live stream: when it was measured, in seconds, and its value
+struct TimedSample
+{
+	double time;
+	float value;
+};
+
+// A 'ring buffer' for passing samples from one thread (the 'producer', which reads them in) to
+// another (the 'consumer', which draws them), without either of them ever waiting for the other.
+//
+// The samples go in a fixed size array which is used round and round. The producer writes at
+// 'head' and the consumer reads at 'tail'. Each is the only one to change its own position, so no
+// lock is needed: the positions are 'atomic', and the producer only moves head on once a sample
+// has been written (and the consumer only moves tail on once it's been read), so neither ever sees
+// a half written slot.
+//
+// Only one thread may Push, and only one may Pop.
+class SampleRing
+{
+public:
+	// capacity must be a power of 2, so positions can wrap round with & instead of %
+	explicit SampleRing(int capacity)
+		: slots(capacity), mask(capacity - 1)
+	{
+	}
+
+	// Returns false, straight away, if the ring is full
+	bool Push(const TimedSample& sample)
+	{
+		size_t position = head.load(std::memory_order_relaxed);
+		if (position - cachedTail >= slots.size())
+		{
+			// Looks full, but the consumer may have taken some since we last looked
+			cachedTail = tail.load(std::memory_order_acquire);
+			if (position - cachedTail >= slots.size())
+			{
+				return false;
+			}
+		}
+		slots[position & mask] = sample;
+		head.store(position + 1, std::memory_order_release);
+		return true;
+	}
+
+	// Takes up to maxSamples, oldest first, and returns how many it took
+	int Pop(TimedSample* samples, int maxSamples)
+	{
+		size_t position = tail.load(std::memory_order_relaxed);
+		if (cachedHead - position < (size_t)maxSamples)
+		{
+			cachedHead = head.load(std::memory_order_acquire);
+		}
+		size_t available = cachedHead - position;
+		int count = available < (size_t)maxSamples ? (int)available : maxSamples;
+		for (int i = 0; i < count; i++)
+		{
+			samples[i] = slots[(position + i) & mask];
+		}
+		tail.store(position + count, std::memory_order_release);
+		return count;
+	}
+
+	// Only a rough answer, as the other thread may be changing it
+	int GetCount()
+	{
+		return (int)(head.load(std::memory_order_relaxed) - tail.load(std::memory_order_relaxed));
+	}
+
+	int GetCapacity()
+	{
+		return (int)slots.size();
+	}
+
+private:
+	std::vector<TimedSample> slots;
+	size_t mask;
+
+	std::atomic<size_t> head{ 0 };	// Only written by the producer
+	size_t cachedTail = 0;			// The producer's last look at tail
+
+	// Keeps head and tail more than 64 bytes (a 'cache line') apart, so the two threads writing
+	// them don't keep taking the same piece of memory off each other
+	char padding[64];
+
+	std::atomic<size_t> tail{ 0 };	// Only written by the consumer
+	size_t cachedHead = 0;			// The consumer's last look at head
+};
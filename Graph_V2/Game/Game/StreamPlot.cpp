@@ -0,0 +1,245 @@
+#include <SFML\System\Sleep.hpp>
+#include <limits>
+#include <math.h>
+#include <stdio.h>
+#include "Main.h"
+#include "Helpers.h"
+#include "StreamPlot.h"
+
+const float STREAM_PLOT_TOP = 56;	// Room for the text at the top
+const float STREAM_PLOT_BOTTOM_GAP = 10;
+
+bool StreamPlot::Start(StreamKind kind, const std::string& name, int width, std::string& error)
+{
+	numColumns = width;
+	columnsPerSecond = width / secondsShown;
+	columns.resize(numColumns);
+	batch.resize(4096);
+	return source.Start(kind, name, error);
+}
+
+// Where column number 'column' is kept. Works for times before 0 too.
+int StreamPlot::GetSlot(long long column)
+{
+	return (int)(((column % numColumns) + numColumns) % numColumns);
+}
+
+void StreamPlot::Add(const TimedSample& sample)
+{
+	const float infinity = std::numeric_limits<float>::infinity();
+	long long column = (long long)floor(sample.time * columnsPerSecond);
+
+	// Nearly every sample goes in the same column as the one before
+	if (column == newestColumn && anySamples)
+	{
+		SampleRange& range = columns[newestSlot];
+		range.min = sample.value < range.min ? sample.value : range.min;
+		range.max = sample.value > range.max ? sample.value : range.max;
+		return;
+	}
+
+	if (!anySamples)
+	{
+		for (SampleRange& range : columns)
+		{
+			range.min = infinity;
+			range.max = -infinity;
+		}
+		newestColumn = column;
+		newestSlot = GetSlot(column);
+		anySamples = true;
+	}
+
+	if (column > newestColumn)
+	{
+		// The screen scrolls on. Empty the columns being reused for the new times.
+		long long first = newestColumn + 1 > column - numColumns + 1 ? newestColumn + 1 : column - numColumns + 1;
+		for (long long c = first; c <= column; c++)
+		{
+			SampleRange& range = columns[GetSlot(c)];
+			range.min = infinity;
+			range.max = -infinity;
+		}
+		newestColumn = column;
+		newestSlot = GetSlot(column);
+	}
+	else if (column <= newestColumn - numColumns)
+	{
+		late++;
+		return;
+	}
+
+	SampleRange& range = columns[GetSlot(column)];
+	range.min = sample.value < range.min ? sample.value : range.min;
+	range.max = sample.value > range.max ? sample.value : range.max;
+}
+
+int StreamPlot::Drain()
+{
+	// At most one ringful, so a producer which never stops can't keep the drawing here forever
+	int taken = 0;
+	while (taken < source.ring.GetCapacity())
+	{
+		int count = source.ring.Pop(batch.data(), (int)batch.size());
+		if (count == 0)
+		{
+			break;
+		}
+		for (int i = 0; i < count; i++)
+		{
+			Add(batch[i]);
+		}
+		taken += count;
+	}
+	return taken;
+}
+
+void StreamPlot::BuildVertices(float top, float bottom, sf::Color color)
+{
+	vertices.clear();
+	if (!anySamples)
+	{
+		return;
+	}
+
+	// The oldest column on the screen is at the left
+	long long oldestColumn = newestColumn - numColumns + 1;
+	yMin = std::numeric_limits<float>::infinity();
+	yMax = -yMin;
+	for (long long c = oldestColumn; c <= newestColumn; c++)
+	{
+		const SampleRange& range = columns[GetSlot(c)];
+		if (range.min <= range.max)
+		{
+			yMin = range.min < yMin ? range.min : yMin;
+			yMax = range.max > yMax ? range.max : yMax;
+		}
+	}
+	if (yMin > yMax)
+	{
+		return;
+	}
+	if (yMax - yMin < 1e-6f * (fabsf(yMax) + 1))
+	{
+		yMin -= 0.5f;
+		yMax += 0.5f;
+	}
+
+	// Going up one column and down the next keeps the joining lines short
+	float pixelsPerValue = (bottom - top) / (yMax - yMin);
+	for (long long c = oldestColumn; c <= newestColumn; c++)
+	{
+		const SampleRange& range = columns[GetSlot(c)];
+		if (range.min > range.max)
+		{
+			continue;
+		}
+		float x = (c - oldestColumn) + 0.5f;
+		float from = c % 2 == 0 ? range.min : range.max;
+		float to = c % 2 == 0 ? range.max : range.min;
+		vertices.push_back(sf::Vertex(sf::Vector2f(x, bottom - (from - yMin) * pixelsPerValue), color));
+		vertices.push_back(sf::Vertex(sf::Vector2f(x, bottom - (to - yMin) * pixelsPerValue), color));
+	}
+}
+
+int StreamPlot::GetVertexCount()
+{
+	return (int)vertices.size();
+}
+
+void StreamPlot::Draw()
+{
+	Drain();
+	BuildVertices(STREAM_PLOT_TOP, window->getSize().y - STREAM_PLOT_BOTTOM_GAP, sf::Color::Green);
+	if (!vertices.empty())
+	{
+		window->draw(vertices.data(), vertices.size(), sf::LineStrip);
+	}
+
+	// Work out the arrival rate once a second
+	long long received = source.received;
+	if (rateClock.getElapsedTime().asSeconds() >= 1)
+	{
+		rate = (received - rateReceived) / rateClock.restart().asSeconds();
+		rateReceived = received;
+	}
+
+	char text[256];
+	snprintf(text, sizeof(text), "Last %.0f seconds    Values %g to %g    %s", secondsShown, yMin, yMax,
+		source.finished ? "Input ended" : "");
+	DrawString(text, 8, 4, 16, sf::Color::White);
+	snprintf(text, sizeof(text), "Received %lld (%.0f per second)    Ring %d%% full    Dropped %lld    Late %lld",
+		received, rate, source.ring.GetCount() * 100 / source.ring.GetCapacity(), (long long)source.dropped, late);
+	DrawString(text, 8, 20, 16, source.dropped > 0 ? sf::Color::Yellow : sf::Color(128, 128, 128));
+	snprintf(text, sizeof(text), "Input waited for room %lld times (%.0f ms)", (long long)source.stalls, source.stalledMicroseconds / 1000.0);
+	DrawString(text, 8, 36, 16, source.stalls > 0 ? sf::Color::Yellow : sf::Color(128, 128, 128));
+}
+
+void RunStreamBenchmark()
+{
+	const int width = 800;
+	const float frameSeconds = 1 / 60.0f;
+	std::string error;
+
+	// 1. The test wave as fast as it can go, waiting whenever the ring is full, with a frame drawn
+	//    every 60th of a second
+	{
+		StreamPlot plot;
+		plot.source.testRate = 0;
+		plot.source.overflow = OVERFLOW_WAIT;
+		plot.Start(STREAM_TEST, "", width, error);
+		sf::Clock clock;
+		long long taken = 0;
+		int numFrames = 0;
+		float slowestFrame = 0;
+		float totalWork = 0;
+		while (clock.getElapsedTime().asSeconds() < 3)
+		{
+			sf::Clock frameClock;
+			taken += plot.Drain();
+			plot.BuildVertices(0, 600, sf::Color::White);
+			float workSeconds = frameClock.getElapsedTime().asSeconds();
+			slowestFrame = workSeconds > slowestFrame ? workSeconds : slowestFrame;
+			totalWork += workSeconds;
+			numFrames++;
+			sf::sleep(sf::seconds(frameSeconds - workSeconds > 0 ? frameSeconds - workSeconds : 0));
+		}
+		float seconds = clock.getElapsedTime().asSeconds();
+		plot.source.Stop();
+		printf("Flat out, waiting when full: %.2f million samples per second drawn, %d frames\n", taken / seconds / 1000000, numFrames);
+		printf("  Draining and vertices: %.2f ms per frame, slowest %.2f ms, %d vertices. Dropped %lld.\n",
+			totalWork * 1000 / numFrames, slowestFrame * 1000, plot.GetVertexCount(), (long long)plot.source.dropped);
+		printf("  The input waited for room %lld times, %.0f ms altogether\n",
+			(long long)plot.source.stalls, plot.source.stalledMicroseconds / 1000.0);
+	}
+
+	// 2. 2 million samples per second, dropping when full, with the drawing stalled for half a second
+	{
+		StreamPlot plot;
+		plot.source.testRate = 2000000;
+		plot.source.overflow = OVERFLOW_DROP;
+		plot.Start(STREAM_TEST, "", width, error);
+		sf::Clock clock;
+		long long taken = 0;
+		bool stalled = false;
+		while (clock.getElapsedTime().asSeconds() < 2)
+		{
+			float time = clock.getElapsedTime().asSeconds();
+			if (time > 0.75f && !stalled)
+			{
+				sf::sleep(sf::seconds(0.5f));
+				stalled = true;
+			}
+			taken += plot.Drain();
+			plot.BuildVertices(0, 600, sf::Color::White);
+			sf::sleep(sf::seconds(frameSeconds));
+		}
+		plot.source.Stop();
+		taken += plot.Drain();
+		long long received = plot.source.received;
+		long long dropped = plot.source.dropped;
+		printf("2 million per second, dropping when full, drawing stalled for 0.5 s:\n");
+		printf("  Made %lld, received %lld, dropped %lld, drawn %lld: %s\n", received + dropped, received, dropped, taken,
+			taken == received ? "every received sample drawn" : "SAMPLES LOST");
+	}
+}
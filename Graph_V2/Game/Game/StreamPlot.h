@@ -0,0 +1,58 @@
+#pragma once
+#include <vector>
+#include <SFML\Graphics.hpp>
+#include "StreamSource.h"
+#include "TimeSeries.h"
+
+// A plot of live samples, scrolling left as new ones arrive, with the newest at the right edge.
+//
+// A StreamSource reads the samples on its own thread. Each frame, the drawing takes everything that
+// has arrived out of the ring and drops each sample straight into its pixel column, which just
+// keeps the smallest and largest value. So however many samples arrive, drawing is one line per
+// column, and the samples themselves aren't kept.
+class StreamPlot
+{
+public:
+	StreamSource source;
+	double secondsShown = 10;
+
+	// Samples too old for the screen by the time they arrived, so not drawn
+	long long late = 0;
+
+	bool Start(StreamKind kind, const std::string& name, int width, std::string& error);
+
+	// Takes the waiting samples out of the ring and adds them to the columns. Returns how many it took.
+	int Drain();
+
+	// Fills in the vertices for the columns, between y = top and y = bottom
+	void BuildVertices(float top, float bottom, sf::Color color);
+
+	void Draw();
+
+	int GetVertexCount();
+
+private:
+	int numColumns = 0;
+	double columnsPerSecond = 1;
+	std::vector<SampleRange> columns;	// Used round and round: column c is at c % numColumns
+	long long newestColumn = 0;
+	int newestSlot = 0;
+	bool anySamples = false;
+	float yMin = 0;
+	float yMax = 0;
+
+	std::vector<TimedSample> batch;
+	std::vector<sf::Vertex> vertices;
+
+	// For showing how fast samples are arriving
+	sf::Clock rateClock;
+	long long rateReceived = 0;
+	float rate = 0;
+
+	int GetSlot(long long column);
+	void Add(const TimedSample& sample);
+};
+
+// "Game.exe -streambench" times the ring and the drawing with the test wave flat out, then stalls
+// the drawing to check that overflowing samples are all counted
+void RunStreamBenchmark();
@@ -0,0 +1,225 @@
+#include <SFML\System\Sleep.hpp>
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+#include "StreamSource.h"
+
+StreamSource::~StreamSource()
+{
+	Stop();
+}
+
+bool StreamSource::Start(StreamKind kind, const std::string& name, std::string& error)
+{
+	clock.restart();
+	if (kind == STREAM_STDIN)
+	{
+		overflow = OVERFLOW_WAIT;
+		file = stdin;
+		thread = std::thread(&StreamSource::ReadLines, this, false);
+	}
+	else if (kind == STREAM_FILE)
+	{
+		file = fopen(name.c_str(), "r");
+		if (file == NULL)
+		{
+			error = "Can't open " + name;
+			return false;
+		}
+		overflow = OVERFLOW_WAIT;
+		thread = std::thread(&StreamSource::ReadLines, this, true);
+	}
+	else if (kind == STREAM_UDP)
+	{
+		unsigned short port = (unsigned short)atoi(name.c_str());
+		if (socket.bind(port) != sf::Socket::Done)
+		{
+			error = "Can't listen on UDP port " + name;
+			return false;
+		}
+		// Not waiting for packets means the thread can see when it's time to stop
+		socket.setBlocking(false);
+		overflow = OVERFLOW_DROP;
+		thread = std::thread(&StreamSource::ReadUdp, this);
+	}
+	else
+	{
+		thread = std::thread(&StreamSource::MakeTestWave, this);
+	}
+	return true;
+}
+
+void StreamSource::Stop()
+{
+	stopping = true;
+	if (thread.joinable())
+	{
+		thread.join();
+	}
+	if (file != NULL && file != stdin)
+	{
+		fclose(file);
+	}
+	file = NULL;
+}
+
+double StreamSource::GetTime()
+{
+	return clock.getElapsedTime().asMicroseconds() / 1000000.0;
+}
+
+void StreamSource::Add(const TimedSample& sample)
+{
+	if (ring.Push(sample))
+	{
+		received.fetch_add(1, std::memory_order_relaxed);
+		return;
+	}
+	if (overflow == OVERFLOW_DROP)
+	{
+		dropped.fetch_add(1, std::memory_order_relaxed);
+		return;
+	}
+
+	// Waiting slows the input down, so it's counted too, like dropping is
+	sf::Clock waitClock;
+	bool pushed = false;
+	while (!stopping && !(pushed = ring.Push(sample)))
+	{
+		sf::sleep(sf::microseconds(100));
+	}
+	stalls.fetch_add(1, std::memory_order_relaxed);
+	stalledMicroseconds.fetch_add(waitClock.getElapsedTime().asMicroseconds(), std::memory_order_relaxed);
+	if (pushed)
+	{
+		received.fetch_add(1, std::memory_order_relaxed);
+	}
+}
+
+// "value" or "time value". Anything else is skipped.
+void StreamSource::ReadLine(const char* line)
+{
+	char* end;
+	double first = strtod(line, &end);
+	if (end == line)
+	{
+		return;
+	}
+	while (*end == ' ' || *end == '\t' || *end == ',')
+	{
+		end++;
+	}
+	char* secondEnd;
+	double second = strtod(end, &secondEnd);
+
+	TimedSample sample;
+	if (secondEnd == end)
+	{
+		sample.time = GetTime();
+		sample.value = (float)first;
+	}
+	else
+	{
+		sample.time = first;
+		sample.value = (float)second;
+	}
+	Add(sample);
+}
+
+// Runs on the thread, for stdin and files. When following a file, reaching the end just means
+// waiting for more to be written.
+void StreamSource::ReadLines(bool follow)
+{
+	char buffer[256];
+	std::string line;
+	while (!stopping)
+	{
+		if (fgets(buffer, sizeof(buffer), file) == NULL)
+		{
+			if (!follow)
+			{
+				break;
+			}
+			clearerr(file);
+			sf::sleep(sf::milliseconds(10));
+			continue;
+		}
+
+		// The writer may be half way through a line, so only whole lines are read
+		line += buffer;
+		if (line.back() == '\n')
+		{
+			ReadLine(line.c_str());
+			line.clear();
+		}
+	}
+	if (!line.empty())
+	{
+		ReadLine(line.c_str());
+	}
+	finished = true;
+}
+
+// Runs on the thread. Each packet holds one or more lines.
+void StreamSource::ReadUdp()
+{
+	char packet[65536];
+	while (!stopping)
+	{
+		size_t size;
+		sf::IpAddress sender;
+		unsigned short senderPort;
+		if (socket.receive(packet, sizeof(packet) - 1, size, sender, senderPort) != sf::Socket::Done)
+		{
+			sf::sleep(sf::milliseconds(1));
+			continue;
+		}
+
+		// Split the packet into lines
+		packet[size] = 0;
+		char* line = packet;
+		while (*line != 0)
+		{
+			char* lineEnd = strchr(line, '\n');
+			if (lineEnd != NULL)
+			{
+				*lineEnd = 0;
+			}
+			ReadLine(line);
+			if (lineEnd == NULL)
+			{
+				break;
+			}
+			line = lineEnd + 1;
+		}
+	}
+	finished = true;
+}
+
+// Runs on the thread. A slow wave with some noise on it.
+void StreamSource::MakeTestWave()
+{
+	unsigned int random = 1;
+	long long made = 0;
+	while (!stopping)
+	{
+		// Make however many samples are due by now (or a batch at a time, if going flat out)
+		double now = GetTime();
+		long long due = testRate > 0 ? (long long)(now * testRate) : made + 1024;
+		if (due <= made)
+		{
+			sf::sleep(sf::milliseconds(1));
+			continue;
+		}
+		for (; made < due && !stopping; made++)
+		{
+			TimedSample sample;
+			sample.time = testRate > 0 ? made / testRate : now;
+			random = random * 1664525 + 1013904223;
+			float noise = (random >> 8) / 16777216.0f - 0.5f;
+			sample.value = sinf((float)sample.time * 3.14159265f) + noise * 0.2f;
+			Add(sample);
+		}
+	}
+	finished = true;
+}
@@ -0,0 +1,70 @@
+#pragma once
+#include <atomic>
+#include <stdio.h>
+#include <string>
+#include <thread>
+#include <SFML\Network.hpp>
+#include <SFML\System\Clock.hpp>
+#include "SampleRing.h"
+
+enum StreamKind
+{
+	STREAM_STDIN,	// Lines typed or piped into the program
+	STREAM_FILE,	// Lines added to the end of a file, by another program, as it runs
+	STREAM_UDP,		// Lines sent to a UDP port on this computer, several to a packet if wanted
+	STREAM_TEST,	// A made up wave, for trying things out
+};
+
+// What to do with a new sample when the ring is full, because the drawing has fallen behind
+enum OverflowPolicy
+{
+	OVERFLOW_WAIT,	// Wait for room. Nothing is lost, and the input is slowed down instead ('backpressure').
+	OVERFLOW_DROP,	// Throw the new sample away, and count it. For inputs which can't be slowed down.
+};
+
+// Reads samples on its own thread and puts them in a SampleRing for the drawing to take out.
+//
+// Each line is either "value", or "time value" (with a space or comma between them). Lines without
+// a time get the time they were read, in seconds since Start.
+//
+// Stdin and files wait when the ring is full, as the rest of their input just waits for them.
+// UDP drops samples instead: a sender won't wait for us, so holding up the reading would only
+// lose them in the network instead, without them being counted. The test wave uses 'overflow'
+// as it was set before Start.
+class StreamSource
+{
+public:
+	SampleRing ring{ 1 << 18 };
+	OverflowPolicy overflow = OVERFLOW_DROP;
+	double testRate = 1000000;			// Samples per second made by STREAM_TEST. 0 for as fast as possible.
+
+	std::atomic<long long> received{ 0 };	// Samples put into the ring
+	std::atomic<long long> dropped{ 0 };	// Samples thrown away because the ring was full
+	std::atomic<long long> stalls{ 0 };		// Times the input had to wait for room in the ring
+	std::atomic<long long> stalledMicroseconds{ 0 };	// How long it waited altogether
+	std::atomic<bool> finished{ false };	// The input has ended
+
+	~StreamSource();
+
+	// 'name' is the file to read for STREAM_FILE, or the port number for STREAM_UDP
+	bool Start(StreamKind kind, const std::string& name, std::string& error);
+
+	// Stops the thread. (A thread reading stdin only notices at the next line or the end of the input.)
+	void Stop();
+
+	// Seconds since Start, from the same clock the samples are timed with
+	double GetTime();
+
+private:
+	std::thread thread;
+	std::atomic<bool> stopping{ false };
+	sf::Clock clock;
+	FILE* file = NULL;
+	sf::UdpSocket socket;
+
+	void ReadLines(bool follow);
+	void ReadUdp();
+	void MakeTestWave();
+	void ReadLine(const char* line);
+	void Add(const TimedSample& sample);
+};
@@ -0,0 +1,87 @@
+#include "ThreadPool.h"
+
+ThreadPool::ThreadPool(int numThreads)
+{
+	if (numThreads <= 0)
+	{
+		numThreads = (int)std::thread::hardware_concurrency();
+	}
+
+	// The thread calling Run is thread 0, so only the others are started
+	for (int t = 1; t < numThreads; t++)
+	{
+		threads.push_back(std::thread(&ThreadPool::ThreadLoop, this, t));
+	}
+}
+
+ThreadPool::~ThreadPool()
+{
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		quitting = true;
+	}
+	wake.notify_all();
+	for (std::thread& thread : threads)
+	{
+		thread.join();
+	}
+}
+
+int ThreadPool::GetThreadCount()
+{
+	return (int)threads.size() + 1;
+}
+
+void ThreadPool::Run(int numTasks, const std::function<void(int, int)>& task)
+{
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		job = &task;
+		this->numTasks = numTasks;
+		nextTask = 0;
+		jobNumber++;
+		busyThreads = (int)threads.size();
+	}
+	wake.notify_all();
+
+	DoTasks(0);
+
+	// Wait for the other threads to finish the tasks they took
+	std::unique_lock<std::mutex> lock(mutex);
+	finished.wait(lock, [this]() { return busyThreads == 0; });
+	job = NULL;
+}
+
+void ThreadPool::DoTasks(int threadIndex)
+{
+	for (int task = nextTask++; task < numTasks; task = nextTask++)
+	{
+		(*job)(task, threadIndex);
+	}
+}
+
+void ThreadPool::ThreadLoop(int threadIndex)
+{
+	int lastJob = 0;
+	while (true)
+	{
+		{
+			std::unique_lock<std::mutex> lock(mutex);
+			wake.wait(lock, [&]() { return quitting || jobNumber != lastJob; });
+			if (quitting)
+			{
+				return;
+			}
+			lastJob = jobNumber;
+		}
+
+		DoTasks(threadIndex);
+
+		std::lock_guard<std::mutex> lock(mutex);
+		busyThreads--;
+		if (busyThreads == 0)
+		{
+			finished.notify_one();
+		}
+	}
+}
@@ -0,0 +1,43 @@
+#pragma once
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// A few threads which are started once and then wait for work, so work can be shared out every
+// frame without paying to start new threads each time.
+//
+// Run splits a job into numbered 'tasks'. Whichever thread is free takes the next task number, so
+// threads which get easy tasks just take more of them, and they all finish at about the same time.
+// The thread which calls Run takes tasks too, rather than sitting waiting.
+class ThreadPool
+{
+public:
+	// numThreads includes the thread calling Run. 0 means one per core.
+	explicit ThreadPool(int numThreads = 0);
+	~ThreadPool();
+
+	int GetThreadCount();
+
+	// Calls task(taskIndex, threadIndex) for every taskIndex from 0 to numTasks - 1, and returns once
+	// they've all finished. threadIndex goes from 0 to GetThreadCount() - 1, so each thread can be
+	// given things of its own to use. The tasks must not change anything another task uses.
+	void Run(int numTasks, const std::function<void(int, int)>& task);
+
+private:
+	std::vector<std::thread> threads;
+	std::mutex mutex;
+	std::condition_variable wake;		// Tells the threads there's a new job
+	std::condition_variable finished;	// Tells Run the threads have finished it
+	const std::function<void(int, int)>* job = NULL;
+	int numTasks = 0;
+	std::atomic<int> nextTask{ 0 };
+	int jobNumber = 0;			// Goes up by one for every job, so the threads can tell a new one has started
+	int busyThreads = 0;
+	bool quitting = false;
+
+	void ThreadLoop(int threadIndex);
+	void DoTasks(int threadIndex);
+};
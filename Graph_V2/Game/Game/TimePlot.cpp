@@ -0,0 +1,167 @@
+#include <math.h>
+#include <stdio.h>
+#include "Main.h"
+#include "Helpers.h"
+#include "TimePlot.h"
+
+const float PLOT_TOP = 40;			// Room for the text at the top
+const float PLOT_BOTTOM_GAP = 10;
+const double LEAST_SAMPLES_PER_PIXEL = 1.0 / 64;
+
+bool TimePlot::Open(const std::string& path, std::string& error)
+{
+	if (!series.Open(path, error))
+	{
+		return false;
+	}
+	ShowAll();
+	return true;
+}
+
+// Zoomed out far enough to see every sample
+double TimePlot::GetMostSamplesPerPixel()
+{
+	double mostSamplesPerPixel = (double)series.GetCount() / window->getSize().x;
+	return mostSamplesPerPixel > 1 ? mostSamplesPerPixel : 1;
+}
+
+void TimePlot::ShowAll()
+{
+	samplesPerPixel = GetMostSamplesPerPixel();
+	firstSample = 0;
+}
+
+// Stops the samples being moved right off the screen
+void TimePlot::KeepOnScreen()
+{
+	double halfScreen = window->getSize().x * samplesPerPixel / 2;
+	if (firstSample < -halfScreen)
+	{
+		firstSample = -halfScreen;
+	}
+	if (firstSample > series.GetCount() - halfScreen)
+	{
+		firstSample = series.GetCount() - halfScreen;
+	}
+}
+
+void TimePlot::Event(const sf::Event& event)
+{
+	if (event.type == sf::Event::MouseWheelScrolled)
+	{
+		// Zoom by 10% per click, keeping the sample under the mouse where it is
+		double mouseX = event.mouseWheelScroll.x;
+		double sampleUnderMouse = firstSample + mouseX * samplesPerPixel;
+		samplesPerPixel /= pow(1.1, event.mouseWheelScroll.delta);
+		double mostSamplesPerPixel = GetMostSamplesPerPixel();
+		samplesPerPixel = samplesPerPixel < LEAST_SAMPLES_PER_PIXEL ? LEAST_SAMPLES_PER_PIXEL : samplesPerPixel;
+		samplesPerPixel = samplesPerPixel > mostSamplesPerPixel ? mostSamplesPerPixel : samplesPerPixel;
+		firstSample = sampleUnderMouse - mouseX * samplesPerPixel;
+		KeepOnScreen();
+	}
+	else if (event.type == sf::Event::MouseButtonPressed && event.mouseButton.button == sf::Mouse::Left)
+	{
+		dragging = true;
+		dragX = event.mouseButton.x;
+	}
+	else if (event.type == sf::Event::MouseButtonReleased && event.mouseButton.button == sf::Mouse::Left)
+	{
+		dragging = false;
+	}
+	else if (event.type == sf::Event::MouseMoved && dragging)
+	{
+		// The samples follow the mouse
+		firstSample -= (event.mouseMove.x - dragX) * samplesPerPixel;
+		dragX = event.mouseMove.x;
+		KeepOnScreen();
+	}
+	else if (event.type == sf::Event::KeyPressed && event.key.code == sf::Keyboard::Home)
+	{
+		ShowAll();
+	}
+}
+
+void TimePlot::Draw()
+{
+	int width = (int)window->getSize().x;
+	float plotBottom = window->getSize().y - PLOT_BOTTOM_GAP;
+	long long count = series.GetCount();
+	const sf::Color color = sf::Color::Green;
+
+	// Zoomed in to less than a sample per pixel, the samples themselves are joined up.
+	// Otherwise each column is a line from its smallest value to its largest.
+	float yMin = INFINITY;
+	float yMax = -INFINITY;
+	vertices.clear();
+	if (samplesPerPixel <= 1)
+	{
+		long long first = (long long)floor(firstSample);
+		long long last = (long long)ceil(firstSample + width * samplesPerPixel) + 1;
+		first = first < 0 ? 0 : first;
+		last = last > count ? count : last;
+		for (long long i = first; i < last; i++)
+		{
+			float value = series.GetSample(i);
+			yMin = value < yMin ? value : yMin;
+			yMax = value > yMax ? value : yMax;
+			vertices.push_back(sf::Vertex(sf::Vector2f((float)((i - firstSample) / samplesPerPixel), value)));
+		}
+	}
+	else
+	{
+		series.GetColumns(firstSample, samplesPerPixel, width, columns);
+		for (int c = 0; c < width; c++)
+		{
+			const SampleRange& column = columns[c];
+			if (column.min > column.max)
+			{
+				continue;
+			}
+			yMin = column.min < yMin ? column.min : yMin;
+			yMax = column.max > yMax ? column.max : yMax;
+
+			// Going up one column and down the next keeps the joining lines short
+			float x = c + 0.5f;
+			float from = c % 2 == 0 ? column.min : column.max;
+			float to = c % 2 == 0 ? column.max : column.min;
+			vertices.push_back(sf::Vertex(sf::Vector2f(x, from)));
+			vertices.push_back(sf::Vertex(sf::Vector2f(x, to)));
+		}
+	}
+
+	// Fit the value axis to what's on the screen, then turn values into pixels
+	if (!vertices.empty())
+	{
+		if (yMax - yMin < 1e-6f * (fabsf(yMax) + 1))
+		{
+			yMin -= 0.5f;
+			yMax += 0.5f;
+		}
+		float pixelsPerValue = (plotBottom - PLOT_TOP) / (yMax - yMin);
+		for (sf::Vertex& vertex : vertices)
+		{
+			vertex.position.y = plotBottom - (vertex.position.y - yMin) * pixelsPerValue;
+			vertex.color = color;
+		}
+		window->draw(vertices.data(), vertices.size(), sf::LineStrip);
+	}
+	else
+	{
+		yMin = 0;
+		yMax = 0;
+	}
+
+	char text[256];
+	snprintf(text, sizeof(text), "Samples %.0f to %.0f of %lld (%.3g per pixel)    Values %g to %g",
+		firstSample > 0 ? firstSample : 0.0, fmin(firstSample + width * samplesPerPixel, (double)count), count, samplesPerPixel, yMin, yMax);
+	DrawString(text, 8, 4, 16, sf::Color::White);
+	if (!series.IsPyramidReady())
+	{
+		snprintf(text, sizeof(text), "Summarising the samples: %d%%", (int)(series.GetPyramidProgress() * 100));
+		DrawString(text, 8, 20, 16, sf::Color::Yellow);
+	}
+	else
+	{
+		DrawString("Wheel: zoom    Drag: move    Home: show everything", 8, 20, 16, sf::Color(128, 128, 128));
+	}
+}
@@ -0,0 +1,32 @@
+#pragma once
+#include <vector>
+#include <SFML\Graphics.hpp>
+#include "TimeSeries.h"
+
+// Plots a recorded TimeSeries, with sample number going across the screen and the value going up.
+// Scroll the mouse wheel to zoom, drag with the mouse to move along, and press Home to see it all.
+//
+// Each frame only works out one smallest and largest value per pixel column, and draws a line
+// between them, so it takes about the same time whether the screen shows a hundred samples or a
+// billion. The value axis fits itself to whatever is on the screen.
+class TimePlot
+{
+public:
+	bool Open(const std::string& path, std::string& error);
+	void Event(const sf::Event& event);
+	void Draw();
+
+private:
+	TimeSeries series;
+	double firstSample = 0;			// The sample at the left edge of the screen
+	double samplesPerPixel = 1;
+	bool dragging = false;
+	int dragX = 0;
+
+	std::vector<SampleRange> columns;
+	std::vector<sf::Vertex> vertices;
+
+	double GetMostSamplesPerPixel();
+	void ShowAll();
+	void KeepOnScreen();
+};
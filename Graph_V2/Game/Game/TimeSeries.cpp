@@ -0,0 +1,512 @@
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+#include <SFML\System\Clock.hpp>
+#include <SFML\System\Sleep.hpp>
+#include <limits>
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+#include "Helpers.h"
+#include "TimeSeries.h"
+
+const float INFINITE_VALUE = std::numeric_limits<float>::infinity();
+
+// How many blocks a thread summarises between checks for being told to stop
+const int BLOCKS_PER_BATCH = 1024;
+
+TimeSeries::~TimeSeries()
+{
+	Close();
+}
+
+bool TimeSeries::Open(const std::string& path, std::string& error)
+{
+	Close();
+
+	// A .csv is converted the first time, and the converted file used after that
+	std::string floatPath = path;
+	std::string extension = path.size() >= 4 ? path.substr(path.size() - 4) : "";
+	if (extension == ".csv" || extension == ".CSV")
+	{
+		floatPath = path + ".bin";
+		FILE* converted = fopen(floatPath.c_str(), "rb");
+		if (converted != NULL)
+		{
+			fclose(converted);
+		}
+		else if (!ConvertCsvToFloats(path, floatPath, error))
+		{
+			return false;
+		}
+	}
+
+	if (!Map(floatPath, error))
+	{
+		return false;
+	}
+
+	// Make every level of the pyramid now, so the builder never has to resize them
+	long long numBlocks = (count + PYRAMID_BLOCK - 1) / PYRAMID_BLOCK;
+	levels.push_back(std::vector<SampleRange>((size_t)numBlocks));
+	while (numBlocks > 1)
+	{
+		numBlocks = (numBlocks + PYRAMID_FACTOR - 1) / PYRAMID_FACTOR;
+		levels.push_back(std::vector<SampleRange>((size_t)numBlocks));
+	}
+	builder = std::thread(&TimeSeries::BuildPyramid, this);
+	return true;
+}
+
+bool TimeSeries::Map(const std::string& path, std::string& error)
+{
+	long long bytes = 0;
+#ifdef _WIN32
+	HANDLE fileHandle = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+	if (fileHandle == INVALID_HANDLE_VALUE)
+	{
+		error = "Can't open " + path;
+		return false;
+	}
+	file = fileHandle;
+	LARGE_INTEGER size;
+	GetFileSizeEx(fileHandle, &size);
+	bytes = size.QuadPart;
+	if (bytes < (long long)sizeof(float))
+	{
+		error = path + " has no samples in it";
+		Close();
+		return false;
+	}
+	if ((unsigned long long)bytes > (size_t)-1)
+	{
+		error = path + " is too big to map in a 32 bit program. Build the x64 version.";
+		Close();
+		return false;
+	}
+	mapping = CreateFileMappingA(fileHandle, NULL, PAGE_READONLY, 0, 0, NULL);
+	if (mapping != NULL)
+	{
+		samples = (const float*)MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+	}
+#else
+	file = open(path.c_str(), O_RDONLY);
+	if (file < 0)
+	{
+		error = "Can't open " + path;
+		return false;
+	}
+	struct stat status;
+	fstat(file, &status);
+	bytes = status.st_size;
+	if (bytes < (long long)sizeof(float))
+	{
+		error = path + " has no samples in it";
+		Close();
+		return false;
+	}
+	void* address = mmap(NULL, (size_t)bytes, PROT_READ, MAP_SHARED, file, 0);
+	if (address != MAP_FAILED)
+	{
+		samples = (const float*)address;
+	}
+#endif
+	if (samples == NULL)
+	{
+		error = "Can't map " + path + " into memory";
+		Close();
+		return false;
+	}
+	count = bytes / sizeof(float);
+	return true;
+}
+
+void TimeSeries::Close()
+{
+	// The builder has to finish before the samples it's reading go away
+	stopBuilding = true;
+	if (builder.joinable())
+	{
+		builder.join();
+	}
+	stopBuilding = false;
+	pyramidReady = false;
+	blocksBuilt = 0;
+	levels.clear();
+
+#ifdef _WIN32
+	if (samples != NULL)
+	{
+		UnmapViewOfFile(samples);
+	}
+	if (mapping != NULL)
+	{
+		CloseHandle(mapping);
+	}
+	if (file != NULL)
+	{
+		CloseHandle(file);
+	}
+	mapping = NULL;
+	file = NULL;
+#else
+	if (samples != NULL)
+	{
+		munmap((void*)samples, (size_t)(count * sizeof(float)));
+	}
+	if (file >= 0)
+	{
+		close(file);
+	}
+	file = -1;
+#endif
+	samples = NULL;
+	count = 0;
+}
+
+long long TimeSeries::GetCount()
+{
+	return count;
+}
+
+float TimeSeries::GetSample(long long index)
+{
+	return samples[index];
+}
+
+bool TimeSeries::IsPyramidReady()
+{
+	return pyramidReady;
+}
+
+float TimeSeries::GetPyramidProgress()
+{
+	if (pyramidReady)
+	{
+		return 1;
+	}
+	// Level 0 is nearly all of the work
+	return levels.empty() ? 0 : (float)blocksBuilt / levels[0].size();
+}
+
+long long TimeSeries::GetPyramidBytes()
+{
+	long long bytes = 0;
+	for (const std::vector<SampleRange>& level : levels)
+	{
+		bytes += level.size() * sizeof(SampleRange);
+	}
+	return bytes;
+}
+
+// The smallest and largest of every step'th sample from first up to (not including) last.
+// Samples which aren't numbers (NaN) fail both comparisons, so they're left out.
+SampleRange TimeSeries::ScanSamples(long long first, long long last, long long step)
+{
+	SampleRange range = { INFINITE_VALUE, -INFINITE_VALUE };
+	for (long long i = first; i < last; i += step)
+	{
+		float value = samples[i];
+		if (value < range.min)
+		{
+			range.min = value;
+		}
+		if (value > range.max)
+		{
+			range.max = value;
+		}
+	}
+	return range;
+}
+
+// Runs on its own thread, started by Open
+void TimeSeries::BuildPyramid()
+{
+	// Level 0 needs every sample read, so it's shared out between threads, a run of blocks each
+	int numThreads = (int)std::thread::hardware_concurrency();
+	if (numThreads < 1)
+	{
+		numThreads = 1;
+	}
+	std::vector<SampleRange>& level0 = levels[0];
+	long long numBlocks = (long long)level0.size();
+	std::vector<std::thread> threads;
+	for (int t = 0; t < numThreads; t++)
+	{
+		threads.push_back(std::thread([&, t]()
+		{
+			long long first = numBlocks * t / numThreads;
+			long long last = numBlocks * (t + 1) / numThreads;
+			for (long long batch = first; batch < last && !stopBuilding; batch += BLOCKS_PER_BATCH)
+			{
+				long long batchEnd = batch + BLOCKS_PER_BATCH < last ? batch + BLOCKS_PER_BATCH : last;
+				for (long long block = batch; block < batchEnd; block++)
+				{
+					long long end = (block + 1) * PYRAMID_BLOCK;
+					level0[(size_t)block] = ScanSamples(block * PYRAMID_BLOCK, end < count ? end : count, 1);
+				}
+				blocksBuilt += batchEnd - batch;
+			}
+		}));
+	}
+	for (std::thread& thread : threads)
+	{
+		thread.join();
+	}
+	if (stopBuilding)
+	{
+		return;
+	}
+
+	// Each higher level only needs the one below, which is small enough to do on this thread
+	for (size_t l = 1; l < levels.size(); l++)
+	{
+		const std::vector<SampleRange>& below = levels[l - 1];
+		std::vector<SampleRange>& level = levels[l];
+		for (size_t i = 0; i < level.size(); i++)
+		{
+			SampleRange range = { INFINITE_VALUE, -INFINITE_VALUE };
+			for (size_t j = i * PYRAMID_FACTOR; j < (i + 1) * PYRAMID_FACTOR && j < below.size(); j++)
+			{
+				range.min = below[j].min < range.min ? below[j].min : range.min;
+				range.max = below[j].max > range.max ? below[j].max : range.max;
+			}
+			level[i] = range;
+		}
+	}
+
+	// Only now can the levels be read by other threads
+	pyramidReady = true;
+}
+
+void TimeSeries::GetColumns(double firstSample, double samplesPerColumn, int width, std::vector<SampleRange>& columns)
+{
+	columns.resize(width);
+
+	// Columns of up to 8 blocks are read straight from the samples. Wider ones use the coarsest
+	// level whose blocks still fit in a column 8 times.
+	const double mostSamplesToRead = 8.0 * PYRAMID_BLOCK;
+	int level = -1;
+	double blockSize = PYRAMID_BLOCK;
+	bool ready = pyramidReady;
+	if (ready && samplesPerColumn > mostSamplesToRead)
+	{
+		level = 0;
+		while (level + 1 < (int)levels.size() && blockSize * PYRAMID_FACTOR * 8 <= samplesPerColumn)
+		{
+			level++;
+			blockSize *= PYRAMID_FACTOR;
+		}
+	}
+
+	for (int c = 0; c < width; c++)
+	{
+		double start = firstSample + c * samplesPerColumn;
+		double end = start + samplesPerColumn;
+		SampleRange range = { INFINITE_VALUE, -INFINITE_VALUE };
+
+		if (level >= 0)
+		{
+			// The column is moved to the nearest block edges. Neighbouring columns move their shared
+			// edge the same way, so no block is missed or used twice, and each edge moves by less
+			// than a 16th of a column.
+			const std::vector<SampleRange>& blocks = levels[level];
+			long long numBlocks = (long long)blocks.size();
+			long long first = (long long)floor(start / blockSize + 0.5);
+			long long last = (long long)floor(end / blockSize + 0.5);
+			first = first < 0 ? 0 : first;
+			last = last > numBlocks ? numBlocks : last;
+			for (long long b = first; b < last; b++)
+			{
+				range.min = blocks[(size_t)b].min < range.min ? blocks[(size_t)b].min : range.min;
+				range.max = blocks[(size_t)b].max > range.max ? blocks[(size_t)b].max : range.max;
+			}
+		}
+		else
+		{
+			long long first = (long long)floor(start);
+			long long last = (long long)floor(end);
+			if (last <= first)
+			{
+				last = first + 1;
+			}
+			first = first < 0 ? 0 : first;
+			last = last > count ? count : last;
+
+			// Without the pyramid, a wide column is guessed from 64 of its samples, so the first
+			// frames don't have to wait for the disk
+			long long step = 1;
+			if (last - first > mostSamplesToRead)
+			{
+				step = (last - first) / 64;
+			}
+			range = ScanSamples(first, last, step);
+		}
+		columns[c] = range;
+	}
+}
+
+bool ConvertCsvToFloats(const std::string& csvPath, const std::string& floatPath, std::string& error)
+{
+	FILE* in = fopen(csvPath.c_str(), "r");
+	if (in == NULL)
+	{
+		error = "Can't open " + csvPath;
+		return false;
+	}
+	FILE* out = fopen(floatPath.c_str(), "wb");
+	if (out == NULL)
+	{
+		fclose(in);
+		error = "Can't write " + floatPath;
+		return false;
+	}
+
+	printf("Converting %s to %s...\n", csvPath.c_str(), floatPath.c_str());
+	std::vector<float> buffer;
+	buffer.reserve(65536);
+	long long numSamples = 0;
+	char line[256];
+	while (fgets(line, sizeof(line), in) != NULL)
+	{
+		// Lines which don't start with a number, like a heading, are skipped
+		char* end;
+		float value = strtof(line, &end);
+		if (end != line)
+		{
+			buffer.push_back(value);
+		}
+
+		// Skip the rest of a line that was too long to fit
+		size_t length = strlen(line);
+		if (length > 0 && line[length - 1] != '\n')
+		{
+			int c;
+			while ((c = fgetc(in)) != EOF && c != '\n')
+			{
+			}
+		}
+
+		if (buffer.size() == buffer.capacity())
+		{
+			fwrite(buffer.data(), sizeof(float), buffer.size(), out);
+			numSamples += buffer.size();
+			buffer.clear();
+		}
+	}
+	fwrite(buffer.data(), sizeof(float), buffer.size(), out);
+	numSamples += buffer.size();
+	fclose(in);
+	fclose(out);
+
+	if (numSamples == 0)
+	{
+		remove(floatPath.c_str());
+		error = "No numbers found in " + csvPath;
+		return false;
+	}
+	printf("Converted %lld samples\n", numSamples);
+	return true;
+}
+
+void RunTimeSeriesBenchmark(int millions)
+{
+	long long count = (long long)millions * 1000000;
+	const char* path = "seriesbench.bin";
+
+	// A random walk with a wave on top, so there's something to see at every zoom
+	sf::Clock clock;
+	FILE* file = fopen(path, "wb");
+	if (file == NULL)
+	{
+		printf("Can't write %s\n", path);
+		return;
+	}
+	std::vector<float> buffer(1 << 20);
+	unsigned int random = 1;
+	float walk = 0;
+	for (long long written = 0; written < count; written += buffer.size())
+	{
+		size_t numToWrite = count - written < (long long)buffer.size() ? (size_t)(count - written) : buffer.size();
+		for (size_t i = 0; i < numToWrite; i++)
+		{
+			random = random * 1664525 + 1013904223;
+			walk += (random >> 8) / 16777216.0f - 0.5f;
+			buffer[i] = walk * 0.01f + sinf(((written + i) % 6283) * 0.001f);
+		}
+		fwrite(buffer.data(), sizeof(float), numToWrite, file);
+	}
+	fclose(file);
+	printf("Wrote %lld samples (%.0f MB) in %.1f s\n", count, count * 4 / 1048576.0, clock.restart().asSeconds());
+
+	TimeSeries series;
+	std::string error;
+	if (!series.Open(path, error))
+	{
+		printf("%s\n", error.c_str());
+		remove(path);
+		return;
+	}
+	printf("Opened in %.3f ms\n", clock.restart().asSeconds() * 1000);
+	while (!series.IsPyramidReady())
+	{
+		sf::sleep(sf::milliseconds(1));
+	}
+	printf("Pyramid built in %.2f s on %d threads, %.1f MB\n", clock.restart().asSeconds(),
+		(int)std::thread::hardware_concurrency(), series.GetPyramidBytes() / 1048576.0);
+
+	// Jump about at random, from 16 pixels per sample to the whole series on the screen
+	const int width = 800;
+	const int numFrames = 1000;
+	std::vector<SampleRange> columns;
+	double mostZoom = log2(1.0 / 16);
+	double leastZoom = log2((double)count / width);
+	float slowestFrame = 0;
+	for (int frame = 0; frame < numFrames; frame++)
+	{
+		random = random * 1664525 + 1013904223;
+		double samplesPerColumn = pow(2.0, mostZoom + (leastZoom - mostZoom) * (random >> 8) / 16777216.0);
+		random = random * 1664525 + 1013904223;
+		double firstSample = (count - width * samplesPerColumn) * (random >> 8) / 16777216.0;
+
+		sf::Clock frameClock;
+		series.GetColumns(firstSample, samplesPerColumn, width, columns);
+		float frameSeconds = frameClock.getElapsedTime().asSeconds();
+		slowestFrame = frameSeconds > slowestFrame ? frameSeconds : slowestFrame;
+	}
+	float seconds = clock.restart().asSeconds();
+	printf("%d frames of %d columns at random zooms: %.3f ms per frame, slowest %.3f ms\n",
+		numFrames, width, seconds * 1000 / numFrames, slowestFrame * 1000);
+
+	// The whole series on the screen, from the pyramid and then by reading every sample
+	double samplesPerColumn = (double)count / width;
+	series.GetColumns(0, samplesPerColumn, width, columns);
+	float pyramidMs = clock.restart().asSeconds() * 1000;
+	SampleRange pyramidTotal = { INFINITE_VALUE, -INFINITE_VALUE };
+	for (const SampleRange& column : columns)
+	{
+		pyramidTotal.min = column.min < pyramidTotal.min ? column.min : pyramidTotal.min;
+		pyramidTotal.max = column.max > pyramidTotal.max ? column.max : pyramidTotal.max;
+	}
+	SampleRange sampleTotal = { INFINITE_VALUE, -INFINITE_VALUE };
+	for (long long i = 0; i < count; i++)
+	{
+		float value = series.GetSample(i);
+		sampleTotal.min = value < sampleTotal.min ? value : sampleTotal.min;
+		sampleTotal.max = value > sampleTotal.max ? value : sampleTotal.max;
+	}
+	float samplesMs = clock.restart().asSeconds() * 1000;
+	printf("Whole series: %.3f ms from the pyramid, %.1f ms reading every sample\n", pyramidMs, samplesMs);
+	printf("Range %g to %g, %s\n", pyramidTotal.min, pyramidTotal.max,
+		pyramidTotal.min == sampleTotal.min && pyramidTotal.max == sampleTotal.max ? "the same both ways" : "DIFFERENT from reading every sample");
+
+	series.Close();
+	remove(path);
+}
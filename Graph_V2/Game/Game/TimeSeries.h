@@ -0,0 +1,87 @@
+#pragma once
+#include <atomic>
+#include <string>
+#include <thread>
+#include <vector>
+
+// A long list of recorded numbers ('samples'), like a sensor logged a thousand times a second for
+// a week, which can be far too big to load into memory.
+//
+// The file holds nothing but the samples, as 4 byte floats one after the other. It's 'memory
+// mapped': the operating system makes the file look like one big array, and only reads the parts
+// of it that are actually looked at (and throws them away again if memory gets short). So opening
+// a file of a billion samples is instant and uses almost no memory.
+//
+// Zoomed right out, one pixel column can cover millions of samples, which would take far too long
+// to read every frame. So, in the background, a 'pyramid' of summaries is built: level 0 holds the
+// smallest and largest sample of each block of 256 samples, level 1 the smallest and largest of
+// each 4 blocks of level 0, and so on until one block covers everything. A column is then worked
+// out from the level whose blocks are about an eighth of a column wide, so it only ever needs a
+// handful of numbers, whatever the zoom.
+//
+// The pyramid is about a 96th of the size of the file (40 MB for a billion samples), so it does
+// fit in memory. The level 0 blocks are split between several threads to build it quickly.
+
+const int PYRAMID_BLOCK = 256;		// Samples in each level 0 block
+const int PYRAMID_FACTOR = 4;		// Blocks of one level in each block of the next
+
+struct SampleRange
+{
+	float min;
+	float max;
+};
+
+class TimeSeries
+{
+public:
+	~TimeSeries();
+
+	// Opens a file of floats, or a .csv file with one number per line (the first number on each
+	// line is used). A .csv is converted to floats once, into a file called <path>.bin, which is
+	// used from then on. Starts building the pyramid in the background.
+	// Returns false, and puts the reason in 'error', if the file can't be used.
+	bool Open(const std::string& path, std::string& error);
+	void Close();
+
+	long long GetCount();
+	float GetSample(long long index);
+
+	// Whether the pyramid has been finished, and how much of it has (from 0 to 1)
+	bool IsPyramidReady();
+	float GetPyramidProgress();
+	long long GetPyramidBytes();
+
+	// Fills in the smallest and largest sample in each of 'width' columns, where column c covers
+	// the samples from firstSample + c * samplesPerColumn up to the next column. Columns with
+	// no samples get min > max. Until the pyramid is ready, zoomed out columns are only
+	// estimated, from a few of their samples.
+	void GetColumns(double firstSample, double samplesPerColumn, int width, std::vector<SampleRange>& columns);
+
+private:
+	const float* samples = NULL;	// The whole file, mapped into memory
+	long long count = 0;
+#ifdef _WIN32
+	void* file = NULL;
+	void* mapping = NULL;
+#else
+	int file = -1;
+#endif
+
+	// levels[0] is the finest. They're only read once pyramidReady is set.
+	std::vector<std::vector<SampleRange>> levels;
+	std::thread builder;
+	std::atomic<bool> pyramidReady{ false };
+	std::atomic<bool> stopBuilding{ false };
+	std::atomic<long long> blocksBuilt{ 0 };
+
+	bool Map(const std::string& path, std::string& error);
+	void BuildPyramid();
+	SampleRange ScanSamples(long long first, long long last, long long step);
+};
+
+// Converts a .csv file to a file of floats, with the first number from each line
+bool ConvertCsvToFloats(const std::string& csvPath, const std::string& floatPath, std::string& error);
+
+// "Game.exe -seriesbench [millions]" writes a file of random samples (100 million by default), then
+// times opening it, building the pyramid, and working out the columns while zooming and panning
+void RunTimeSeriesBenchmark(int millions);